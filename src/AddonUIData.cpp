@@ -30,10 +30,13 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cfloat>
 #include <format>
 #include <functional>
 #include "AddonUIData.h"
 #include "RenderingManager.h"
+#include "Profiling.h"
 
 using namespace AddonImGui;
 using namespace reshade::api;
@@ -91,11 +94,14 @@ void AddonUIData::AssignPreferredGroupTechniques(std::unordered_map<std::string,
     }
 }
 
-const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForPixelShaderHash(uint32_t hash)
+const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForShaderHash(uint32_t stage, uint32_t hash)
 {
-    const auto& it = _pixelShaderHashToToggleGroups.find(hash);
+    PROFILE_EVENT(EVENT_TOGGLE_GROUP_LOOKUP);
+
+    const auto& groups = (*_activeShaderGroupIndex.load(std::memory_order_acquire))[stage];
+    const auto& it = groups.find(hash);
 
-    if (it != _pixelShaderHashToToggleGroups.end())
+    if (it != groups.end())
     {
         return &it->second;
     }
@@ -103,74 +109,204 @@ const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForPixelShaderHash(uint3
     return nullptr;
 }
 
-const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForVertexShaderHash(uint32_t hash)
+const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForPixelShaderHash(uint32_t hash)
 {
-    const auto& it = _vertexShaderHashToToggleGroups.find(hash);
-
-    if (it != _vertexShaderHashToToggleGroups.end())
-    {
-        return &it->second;
-    }
+    return GetToggleGroupsForShaderHash(STAGE_INDEX_PIXEL, hash);
+}
 
-    return nullptr;
+const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForVertexShaderHash(uint32_t hash)
+{
+    return GetToggleGroupsForShaderHash(STAGE_INDEX_VERTEX, hash);
 }
 
 const vector<ToggleGroup*>* AddonUIData::GetToggleGroupsForComputeShaderHash(uint32_t hash)
 {
-    const auto& it = _computeShaderHashToToggleGroups.find(hash);
-
-    if (it != _computeShaderHashToToggleGroups.end())
-    {
-        return &it->second;
-    }
-
-    return nullptr;
+    return GetToggleGroupsForShaderHash(STAGE_INDEX_COMPUTE, hash);
 }
 
+/// <summary>
+/// Brings the shader hash to group index in line with the groups' current hashes. Only the hashes that changed since the
+/// last update are added or removed, the changes become visible to the render threads once they're published.
+/// </summary>
 void AddonUIData::UpdateToggleGroupsForShaderHashes()
 {
-    _pixelShaderHashToToggleGroups.clear();
-    _vertexShaderHashToToggleGroups.clear();
-    _computeShaderHashToToggleGroups.clear();
+    const array<ShaderManager*, STAGE_INDEX_COUNT> managers = { _pixelShaderManager, _vertexShaderManager, _computeShaderManager };
+    const bool isHunting = _pixelShaderManager->isInHuntingMode() || _vertexShaderManager->isInHuntingMode() || _computeShaderManager->isInHuntingMode();
+
+    unordered_set<const ToggleGroup*> liveGroups;
+    liveGroups.reserve(_toggleGroups.size());
 
     for (auto& [_,group] : _toggleGroups)
     {
+        auto& indexed = _indexedGroupHashes[&group];
+        liveGroups.insert(&group);
+
         // Only consider the currently hunted hash for the group being edited
-        if (group.getId() == _toggleGroupIdShaderEditing && (_pixelShaderManager->isInHuntingMode() || _vertexShaderManager->isInHuntingMode() || _computeShaderManager->isInHuntingMode()))
+        if (group.getId() == _toggleGroupIdShaderEditing && isHunting)
         {
-            if (_pixelShaderManager->isInHuntingMode())
+            for (uint32_t stage = 0; stage < STAGE_INDEX_COUNT; stage++)
             {
-                _pixelShaderHashToToggleGroups[_pixelShaderManager->getActiveHuntedShaderHash()].push_back(&group);
-            }
+                const uint32_t huntedHash = managers[stage]->getActiveHuntedShaderHash();
+                const span<const uint32_t> hashes = managers[stage]->isInHuntingMode() ? span<const uint32_t>(&huntedHash, 1) : span<const uint32_t>();
 
-            if (_vertexShaderManager->isInHuntingMode())
-            {
-                _vertexShaderHashToToggleGroups[_vertexShaderManager->getActiveHuntedShaderHash()].push_back(&group);
+                QueueIndexChanges(&group, stage, indexed[stage], hashes);
             }
 
-            if (_computeShaderManager->isInHuntingMode())
+            continue;
+        }
+
+        QueueIndexChanges(&group, STAGE_INDEX_PIXEL, indexed[STAGE_INDEX_PIXEL], group.getPixelShaderHashes());
+        QueueIndexChanges(&group, STAGE_INDEX_VERTEX, indexed[STAGE_INDEX_VERTEX], group.getVertexShaderHashes());
+        QueueIndexChanges(&group, STAGE_INDEX_COMPUTE, indexed[STAGE_INDEX_COMPUTE], group.getComputeShaderHashes());
+    }
+
+    // Drop everything indexed for groups that were removed
+    for (auto it = _indexedGroupHashes.begin(); it != _indexedGroupHashes.end();)
+    {
+        if (liveGroups.contains(it->first))
+        {
+            it++;
+            continue;
+        }
+
+        for (uint32_t stage = 0; stage < STAGE_INDEX_COUNT; stage++)
+        {
+            QueueIndexChanges(const_cast<ToggleGroup*>(it->first), stage, it->second[stage], span<const uint32_t>());
+        }
+
+        it = _indexedGroupHashes.erase(it);
+    }
+
+    PublishShaderGroupIndex();
+}
+
+void AddonUIData::QueueIndexChanges(ToggleGroup* group, uint32_t stage, vector<uint32_t>& indexed, span<const uint32_t> hashes)
+{
+    if (std::equal(indexed.begin(), indexed.end(), hashes.begin(), hashes.end()))
+    {
+        return;
+    }
+
+    // Both lists are sorted, so a single merge pass finds the hashes that were added and removed
+    auto oldIt = indexed.begin();
+    auto newIt = hashes.begin();
+
+    while (oldIt != indexed.end() || newIt != hashes.end())
+    {
+        if (newIt == hashes.end() || (oldIt != indexed.end() && *oldIt < *newIt))
+        {
+            _pendingIndexChanges.push_back(ShaderGroupIndexChange{ stage, *oldIt, group, false });
+            oldIt++;
+        }
+        else if (oldIt == indexed.end() || *newIt < *oldIt)
+        {
+            _pendingIndexChanges.push_back(ShaderGroupIndexChange{ stage, *newIt, group, true });
+            newIt++;
+        }
+        else
+        {
+            oldIt++;
+            newIt++;
+        }
+    }
+
+    indexed.assign(hashes.begin(), hashes.end());
+}
+
+void AddonUIData::ApplyIndexChanges(ShaderGroupIndex& index, const vector<ShaderGroupIndexChange>& changes)
+{
+    for (const auto& change : changes)
+    {
+        auto& groups = index[change.stage];
+
+        if (change.add)
+        {
+            auto& hashGroups = groups[change.hash];
+            if (std::find(hashGroups.begin(), hashGroups.end(), change.group) == hashGroups.end())
             {
-                _computeShaderHashToToggleGroups[_computeShaderManager->getActiveHuntedShaderHash()].push_back(&group);
+                hashGroups.push_back(change.group);
             }
 
             continue;
         }
 
-        for (const auto& h : group.getPixelShaderHashes())
+        const auto& it = groups.find(change.hash);
+        if (it != groups.end())
         {
-            _pixelShaderHashToToggleGroups[h].push_back(&group);
+            std::erase(it->second, change.group);
+
+            if (it->second.empty())
+            {
+                groups.erase(it);
+            }
         }
+    }
+}
 
-        for (const auto& h : group.getVertexShaderHashes())
+void AddonUIData::PublishShaderGroupIndex()
+{
+    // The inactive index may still be in use by draws recorded right before the last swap
+    if (_pendingIndexChanges.empty() || _frame < _lastIndexSwapFrame + IndexRetireFrames)
+    {
+        return;
+    }
+
+    const ShaderGroupIndex* active = _activeShaderGroupIndex.load(std::memory_order_relaxed);
+    ShaderGroupIndex& inactive = active == &_shaderGroupIndices[0] ? _shaderGroupIndices[1] : _shaderGroupIndices[0];
+
+    ApplyIndexChanges(inactive, _inactiveIndexChanges);
+    ApplyIndexChanges(inactive, _pendingIndexChanges);
+
+    _activeShaderGroupIndex.store(&inactive, std::memory_order_release);
+
+    // The index that was just replaced lacks exactly the changes published now
+    _inactiveIndexChanges.swap(_pendingIndexChanges);
+    _pendingIndexChanges.clear();
+    _lastIndexSwapFrame = _frame;
+
+    for (auto& retired : _retiredToggleGroups)
+    {
+        if (retired.publishedFrame == UINT64_MAX)
         {
-            _vertexShaderHashToToggleGroups[h].push_back(&group);
+            retired.publishedFrame = _frame;
         }
+    }
+}
+
+/// <summary>
+/// Removes a group. It's kept alive until the render threads can't be referring to it through the shader hash index anymore.
+/// </summary>
+void AddonUIData::RemoveToggleGroup(ToggleGroup* group)
+{
+    auto node = _toggleGroups.extract(group->getId());
+
+    if (!node.empty())
+    {
+        _retiredToggleGroups.push_back(RetiredToggleGroup{ std::move(node) });
+    }
+}
+
+void AddonUIData::OnReshadePresent()
+{
+    _frame++;
+
+    PublishShaderGroupIndex();
 
-        for (const auto& h : group.getComputeShaderHashes())
+    // Groups removed while nothing was waiting to be published never were in the active index
+    if (_pendingIndexChanges.empty())
+    {
+        for (auto& retired : _retiredToggleGroups)
         {
-            _computeShaderHashToToggleGroups[h].push_back(&group);
+            if (retired.publishedFrame == UINT64_MAX)
+            {
+                retired.publishedFrame = _frame;
+            }
         }
     }
+
+    std::erase_if(_retiredToggleGroups, [&](const RetiredToggleGroup& retired) {
+        return retired.publishedFrame != UINT64_MAX && _frame >= retired.publishedFrame + IndexRetireFrames;
+        });
 }
 
 const atomic_int& AddonUIData::GetToggleGroupIdShaderEditing() const
@@ -236,6 +372,35 @@ void AddonUIData::LoadShaderTogglerIniFile(const string& fileName)
 
     _preventRuntimeReload = iniFile.GetBoolOrDefault("PreventRuntimeReload", "General", false);
 
+    _constBufferInterestSet = iniFile.GetBoolOrDefault("ConstantBufferInterestSet", "General", false);
+    _constBufferInterestFrames = iniFile.GetInt("ConstantBufferInterestFrames", "General");
+    if (_constBufferInterestFrames <= 0)
+    {
+        _constBufferInterestFrames = 120;
+    }
+
+    _governorEnabled = iniFile.GetBoolOrDefault("FrameBudgetGovernor", "General", false);
+    const float governorBudget = iniFile.GetFloat("FrameBudgetMs", "General");
+    if (governorBudget > 0.0f && governorBudget != FLT_MIN)
+    {
+        _governorBudgetMs = governorBudget;
+    }
+    const int shedInterval = iniFile.GetInt("FrameBudgetShedInterval", "General");
+    if (shedInterval > 0)
+    {
+        _governorShedInterval = shedInterval;
+    }
+    const string governorPriority = iniFile.GetValue("FrameBudgetShedOrder", "General");
+    if (governorPriority.size() > 0)
+    {
+        _governorPriority = governorPriority;
+    }
+
+    _groupCostTiming = iniFile.GetBoolOrDefault("GroupCostTiming", "General", false);
+    _skipUnchangedBindingCopies = iniFile.GetBoolOrDefault("SkipUnchangedBindingCopies", "General", false);
+    _deduplicateCollection = iniFile.GetBoolOrDefault("DeduplicateCollection", "General", false);
+    _extendCollection = iniFile.GetBoolOrDefault("ExtendCollection", "General", false);
+
     for (uint32_t i = 0; i < ARRAYSIZE(KeybindNames); i++)
     {
         uint32_t keybinding = iniFile.GetUInt(KeybindNames[i], "Keybindings");
@@ -265,58 +430,203 @@ void AddonUIData::LoadShaderTogglerIniFile(const string& fileName)
     {
         group.loadState(iniFile, groupCounter);		// groupCounter is normally 0 or greater. For when the old format is detected, it's -1 (and there's 1 group).
         groupCounter++;
+    }
 
-        for (const auto& h : group.getPixelShaderHashes())
-        {
-            _pixelShaderHashToToggleGroups[h].push_back(&group);
-        }
+    UpdateToggleGroupsForShaderHashes();
+}
 
-        for (const auto& h : group.getVertexShaderHashes())
-        {
-            _vertexShaderHashToToggleGroups[h].push_back(&group);
-        }
 
-        for (const auto& h : group.getComputeShaderHashes())
+/// <summary>
+/// Saves the currently known toggle groups with their shader hashes to the shadertoggler.ini file. Only a snapshot of the
+/// data is taken here, the file itself is written on a background thread.
+/// </summary>
+void AddonUIData::SaveShaderTogglerIniFile(const string& fileName)
+{
+    unique_ptr<ConfigSnapshot> snapshot = make_unique<ConfigSnapshot>();
+
+    snapshot->filePath = _basePath / fileName;
+    snapshot->resourceShim = _resourceShim;
+    snapshot->constHookType = _constHookType;
+    snapshot->constHookCopyType = _constHookCopyType;
+    snapshot->trackDescriptors = _trackDescriptors;
+    snapshot->preventRuntimeReload = _preventRuntimeReload;
+    snapshot->constBufferInterestSet = _constBufferInterestSet;
+    snapshot->constBufferInterestFrames = _constBufferInterestFrames;
+    snapshot->governorEnabled = _governorEnabled;
+    snapshot->governorBudgetMs = _governorBudgetMs;
+    snapshot->governorShedInterval = _governorShedInterval;
+    snapshot->governorPriority = _governorPriority;
+    snapshot->groupCostTiming = _groupCostTiming;
+    snapshot->skipUnchangedBindingCopies = _skipUnchangedBindingCopies;
+    snapshot->deduplicateCollection = _deduplicateCollection;
+    snapshot->extendCollection = _extendCollection;
+    std::copy(std::begin(_keyBindings), std::end(_keyBindings), std::begin(snapshot->keyBindings));
+
+    snapshot->toggleGroups.reserve(_toggleGroups.size());
+    for (const auto& [_, group] : _toggleGroups)
+    {
+        snapshot->toggleGroups.push_back(group);
+    }
+
+    unique_lock<mutex> lock(_saveMutex);
+
+    if (_saveThreadExit)
+    {
+        // The thread is shutting down, an older save it's still writing has to land first
+        lock.unlock();
+        unique_lock<mutex> writeLock(_saveWriteMutex);
+        WriteConfigSnapshot(*snapshot);
+        return;
+    }
+
+    _pendingSave = std::move(snapshot);
+
+    if (!_saveThread.joinable())
+    {
+        _saveThread = std::thread(&AddonUIData::SaveThreadProc, this);
+    }
+
+    lock.unlock();
+    _saveCondition.notify_one();
+}
+
+
+void AddonUIData::SaveThreadProc()
+{
+    unique_lock<mutex> lock(_saveMutex);
+
+    while (true)
+    {
+        _saveCondition.wait(lock, [&]() { return _pendingSave != nullptr || _saveThreadExit; });
+
+        if (_pendingSave == nullptr)
         {
-            _computeShaderHashToToggleGroups[h].push_back(&group);
+            break;
         }
+
+        unique_ptr<ConfigSnapshot> snapshot = std::move(_pendingSave);
+
+        // Taken before releasing the queue so a save written by DetachBackgroundSave can't be overtaken by this older one
+        unique_lock<mutex> writeLock(_saveWriteMutex);
+        lock.unlock();
+
+        WriteConfigSnapshot(*snapshot);
+
+        writeLock.unlock();
+        lock.lock();
     }
 }
 
 
-/// <summary>
-/// Saves the currently known toggle groups with their shader hashes to the shadertoggler.ini file
-/// </summary>
-void AddonUIData::SaveShaderTogglerIniFile(const string& fileName)
+void AddonUIData::StopBackgroundSave()
+{
+    unique_lock<mutex> lock(_saveMutex);
+
+    if (!_saveThread.joinable())
+    {
+        return;
+    }
+
+    // The thread writes what's still pending before it sees the exit flag
+    _saveThreadExit = true;
+
+    lock.unlock();
+    _saveCondition.notify_one();
+
+    _saveThread.join();
+
+    // Saves requested from here on start a new thread
+    lock.lock();
+    _saveThreadExit = false;
+}
+
+
+void AddonUIData::DetachBackgroundSave(bool writePending)
+{
+    // Called under the loader lock, where the save thread can't exit and any lock it holds would never be released
+    unique_lock<mutex> lock(_saveMutex, try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        return;
+    }
+
+    _saveThreadExit = true;
+    unique_ptr<ConfigSnapshot> snapshot = std::move(_pendingSave);
+
+    if (_saveThread.joinable())
+    {
+        _saveThread.detach();
+    }
+
+    lock.unlock();
+
+    // A write still in progress means the device wasn't torn down first, the pending save is dropped rather than waited for
+    unique_lock<mutex> writeLock(_saveWriteMutex, try_to_lock);
+
+    if (writePending && writeLock.owns_lock() && snapshot != nullptr)
+    {
+        WriteConfigSnapshot(*snapshot);
+    }
+}
+
+
+void AddonUIData::WriteConfigSnapshot(const ConfigSnapshot& snapshot)
 {
     // format: first section with # of groups, then per group a section with pixel and vertex shaders, as well as their name and key value.
     // groups are stored with "Group" + group counter, starting with 0.
     CDataFile iniFile;
 
-    iniFile.SetValue("ResourceShim", _resourceShim, "", "General");
-
-    iniFile.SetValue("ConstantBufferHookType", _constHookType, "", "General");
-    iniFile.SetValue("ConstantBufferHookCopyType", _constHookCopyType, "", "General");
-    iniFile.SetBool("TrackDescriptors", _trackDescriptors, "", "General");
-    iniFile.SetBool("PreventRuntimeReload", _preventRuntimeReload, "", "General");
+    iniFile.SetValue("ResourceShim", snapshot.resourceShim, "", "General");
+
+    iniFile.SetValue("ConstantBufferHookType", snapshot.constHookType, "", "General");
+    iniFile.SetValue("ConstantBufferHookCopyType", snapshot.constHookCopyType, "", "General");
+    iniFile.SetBool("TrackDescriptors", snapshot.trackDescriptors, "", "General");
+    iniFile.SetBool("PreventRuntimeReload", snapshot.preventRuntimeReload, "", "General");
+    iniFile.SetBool("ConstantBufferInterestSet", snapshot.constBufferInterestSet, "", "General");
+    iniFile.SetInt("ConstantBufferInterestFrames", snapshot.constBufferInterestFrames, "", "General");
+    iniFile.SetBool("FrameBudgetGovernor", snapshot.governorEnabled, "", "General");
+    iniFile.SetFloat("FrameBudgetMs", snapshot.governorBudgetMs, "", "General");
+    iniFile.SetInt("FrameBudgetShedInterval", snapshot.governorShedInterval, "", "General");
+    iniFile.SetValue("FrameBudgetShedOrder", snapshot.governorPriority, "", "General");
+    iniFile.SetBool("GroupCostTiming", snapshot.groupCostTiming, "", "General");
+    iniFile.SetBool("SkipUnchangedBindingCopies", snapshot.skipUnchangedBindingCopies, "", "General");
+    iniFile.SetBool("DeduplicateCollection", snapshot.deduplicateCollection, "", "General");
+    iniFile.SetBool("ExtendCollection", snapshot.extendCollection, "", "General");
 
     for (uint32_t i = 0; i < ARRAYSIZE(KeybindNames); i++)
     {
-        uint32_t keybinding = iniFile.SetUInt(KeybindNames[i], _keyBindings[i], "", "Keybindings");
+        iniFile.SetUInt(KeybindNames[i], snapshot.keyBindings[i], "", "Keybindings");
     }
 
-    iniFile.SetInt("AmountGroups", static_cast<int>(_toggleGroups.size()), "", "General");
+    iniFile.SetInt("AmountGroups", static_cast<int>(snapshot.toggleGroups.size()), "", "General");
 
     int groupCounter = 0;
-    for (const auto& [_,group] : _toggleGroups)
+    for (const auto& group : snapshot.toggleGroups)
     {
         group.saveState(iniFile, groupCounter);
         groupCounter++;
     }
-    reshade::log_message(reshade::log_level::info, std::format("Creating config file at \"{}\"", (_basePath / fileName).string()).c_str());
+    reshade::log_message(reshade::log_level::info, std::format("Creating config file at \"{}\"", snapshot.filePath.string()).c_str());
+
+    // Written next to the config first and moved over it afterwards, so a crash halfway never leaves a truncated config behind
+    filesystem::path tempPath = snapshot.filePath;
+    tempPath += ".tmp";
 
-    iniFile.SetFileName((_basePath / fileName).string());
-    iniFile.Save();
+    iniFile.SetFileName(tempPath.string());
+    if (!iniFile.Save())
+    {
+        reshade::log_message(reshade::log_level::error, std::format("Could not write config file at \"{}\"", tempPath.string()).c_str());
+        return;
+    }
+
+    error_code ec;
+    filesystem::rename(tempPath, snapshot.filePath, ec);
+    if (ec)
+    {
+        reshade::log_message(reshade::log_level::error, std::format("Could not replace config file at \"{}\": {}", snapshot.filePath.string(), ec.message()).c_str());
+        filesystem::remove(tempPath, ec);
+    }
 }
 
 
@@ -33,6 +33,13 @@
 
 #include <unordered_map>
 #include <filesystem>
+#include <array>
+#include <atomic>
+#include <span>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <reshade.hpp>
 #include "ShaderManager.h"
 #include "CDataFile.h"
@@ -88,6 +95,48 @@ namespace AddonImGui
         TAB_CONSTANT_BUFFER,
     };
 
+    enum ShaderStageIndex : uint32_t
+    {
+        STAGE_INDEX_PIXEL = 0,
+        STAGE_INDEX_VERTEX,
+        STAGE_INDEX_COMPUTE,
+        STAGE_INDEX_COUNT
+    };
+
+    // Per shader stage, the groups each shader hash belongs to
+    using ShaderGroupIndex = std::array<std::unordered_map<uint32_t, std::vector<ShaderToggler::ToggleGroup*>>, STAGE_INDEX_COUNT>;
+
+    struct ShaderGroupIndexChange
+    {
+        uint32_t stage;
+        uint32_t hash;
+        ShaderToggler::ToggleGroup* group;
+        bool add;
+    };
+
+    // Copy of everything that goes into the config file, taken on the present thread and written out on the save thread
+    struct ConfigSnapshot
+    {
+        std::filesystem::path filePath;
+        std::string resourceShim;
+        std::string constHookType;
+        std::string constHookCopyType;
+        bool trackDescriptors;
+        bool preventRuntimeReload;
+        bool constBufferInterestSet;
+        int constBufferInterestFrames;
+        bool governorEnabled;
+        float governorBudgetMs;
+        int governorShedInterval;
+        std::string governorPriority;
+        bool groupCostTiming;
+        bool skipUnchangedBindingCopies;
+        bool deduplicateCollection;
+        bool extendCollection;
+        uint32_t keyBindings[ARRAYSIZE(KeybindNames)];
+        std::vector<ShaderToggler::ToggleGroup> toggleGroups;
+    };
+
     class AddonUIData
     {
     private:
@@ -102,9 +151,26 @@ namespace AddonImGui
         std::atomic_int _toggleGroupIdEffectEditing = -1;
         std::atomic_int _toggleGroupIdConstantEditing = -1;
         std::unordered_map<int, ShaderToggler::ToggleGroup> _toggleGroups;
-        std::unordered_map<uint32_t, std::vector<ShaderToggler::ToggleGroup*>> _pixelShaderHashToToggleGroups;
-        std::unordered_map<uint32_t, std::vector<ShaderToggler::ToggleGroup*>> _vertexShaderHashToToggleGroups;
-        std::unordered_map<uint32_t, std::vector<ShaderToggler::ToggleGroup*>> _computeShaderHashToToggleGroups;
+        // The shader hash to group index is double buffered. The render threads only read the active index, changes go to the
+        // other one, which is made active afterwards. An index that was replaced is left alone for IndexRetireFrames frames
+        // before changes are applied to it again, so draws still using it never see a half updated map.
+        static constexpr uint64_t IndexRetireFrames = 3;
+        ShaderGroupIndex _shaderGroupIndices[2];
+        std::atomic<const ShaderGroupIndex*> _activeShaderGroupIndex = &_shaderGroupIndices[0];
+        // Changes not in any index yet, and changes the inactive index is missing compared to the active one
+        std::vector<ShaderGroupIndexChange> _pendingIndexChanges;
+        std::vector<ShaderGroupIndexChange> _inactiveIndexChanges;
+        std::unordered_map<const ShaderToggler::ToggleGroup*, std::array<std::vector<uint32_t>, STAGE_INDEX_COUNT>> _indexedGroupHashes;
+        uint64_t _frame = IndexRetireFrames;
+        uint64_t _lastIndexSwapFrame = 0;
+
+        // Removed groups are kept alive until no index handed to the render threads refers to them
+        struct RetiredToggleGroup
+        {
+            std::unordered_map<int, ShaderToggler::ToggleGroup>::node_type node;
+            uint64_t publishedFrame = UINT64_MAX;
+        };
+        std::vector<RetiredToggleGroup> _retiredToggleGroups;
         int _startValueFramecountCollectionPhase = FRAMECOUNT_COLLECTION_PHASE_DEFAULT;
         float _overlayOpacity = 0.2f;
         uint32_t _keyBindings[ARRAYSIZE(KeybindNames)];
@@ -113,10 +179,35 @@ namespace AddonImGui
         std::string _resourceShim = "none";
         bool _trackDescriptors = true;
         bool _preventRuntimeReload = false;
+        bool _constBufferInterestSet = false;
+        int _constBufferInterestFrames = 120;
+        bool _governorEnabled = false;
+        float _governorBudgetMs = 16.6f;
+        int _governorShedInterval = 4;
+        std::string _governorPriority = "preview,bindings,constants";
+        bool _groupCostTiming = false;
+        bool _skipUnchangedBindingCopies = false;
+        bool _deduplicateCollection = false;
+        bool _extendCollection = false;
         std::filesystem::path _basePath;
         TabType _currentTab = TabType::TAB_NONE;
 
         std::vector<std::function<void(reshade::api::effect_runtime*, ShaderToggler::ToggleGroup*)>> _removalCallbacks;
+
+        // Only the latest requested save is kept, older ones that weren't picked up yet are simply replaced
+        std::mutex _saveMutex;
+        std::mutex _saveWriteMutex;
+        std::condition_variable _saveCondition;
+        std::unique_ptr<ConfigSnapshot> _pendingSave;
+        std::thread _saveThread;
+        bool _saveThreadExit = false;
+
+        void QueueIndexChanges(ShaderToggler::ToggleGroup* group, uint32_t stage, std::vector<uint32_t>& indexed, std::span<const uint32_t> hashes);
+        void PublishShaderGroupIndex();
+        static void ApplyIndexChanges(ShaderGroupIndex& index, const std::vector<ShaderGroupIndexChange>& changes);
+        const std::vector<ShaderToggler::ToggleGroup*>* GetToggleGroupsForShaderHash(uint32_t stage, uint32_t hash);
+        void SaveThreadProc();
+        static void WriteConfigSnapshot(const ConfigSnapshot& snapshot);
     public:
         AddonUIData(ShaderToggler::ShaderManager* pixelShaderManager, ShaderToggler::ShaderManager* vertexShaderManager, ShaderToggler::ShaderManager* computeShaderManager, Shim::Constants::ConstantHandlerBase* constants, std::atomic_uint32_t* activeCollectorFrameCounter);
         std::unordered_map<int, ShaderToggler::ToggleGroup>& GetToggleGroups();
@@ -124,6 +215,8 @@ namespace AddonImGui
         const std::vector<ShaderToggler::ToggleGroup*>* GetToggleGroupsForVertexShaderHash(uint32_t hash);
         const std::vector<ShaderToggler::ToggleGroup*>* GetToggleGroupsForComputeShaderHash(uint32_t hash);
         void UpdateToggleGroupsForShaderHashes();
+        void RemoveToggleGroup(ShaderToggler::ToggleGroup* group);
+        void OnReshadePresent();
         void AddDefaultGroup();
         const std::atomic_int& GetToggleGroupIdShaderEditing() const;
         void EndShaderEditing(bool acceptCollectedShaderHashes, ShaderToggler::ToggleGroup& groupEditing);
@@ -136,6 +229,10 @@ namespace AddonImGui
         void SetBasePath(const std::filesystem::path& basePath) { _basePath = basePath; };
         std::filesystem::path GetBasePath() { return _basePath; };
         void SaveShaderTogglerIniFile(const std::string& fileName = HASH_FILE_NAME);
+        // Joins the save thread after it wrote the pending save. Call before the device goes away, never from DllMain.
+        void StopBackgroundSave();
+        // Releases the save thread from DllMain without waiting on it, writing a pending save only if that can't block
+        void DetachBackgroundSave(bool writePending);
         void LoadShaderTogglerIniFile(const std::string& fileName = HASH_FILE_NAME);
         std::atomic_int& GetToggleGroupIdShaderEditing() { return _toggleGroupIdShaderEditing; }
         std::atomic_int& GetToggleGroupIdEffectEditing() { return _toggleGroupIdEffectEditing; }
@@ -166,6 +263,23 @@ namespace AddonImGui
         void SignalToggleGroupRemoved(reshade::api::effect_runtime*, ShaderToggler::ToggleGroup*);
         bool GetPreventRuntimeReload() const { return _preventRuntimeReload; }
         void SetPreventRuntimeReload(bool reload) { _preventRuntimeReload = reload; }
+        bool GetConstBufferInterestSet() const { return _constBufferInterestSet; }
+        void SetConstBufferInterestSet(bool interestSet) { _constBufferInterestSet = interestSet; }
+        int* ConstBufferInterestFrames() { return &_constBufferInterestFrames; }
+        bool GetGovernorEnabled() const { return _governorEnabled; }
+        void SetGovernorEnabled(bool enabled) { _governorEnabled = enabled; }
+        float* GovernorBudgetMs() { return &_governorBudgetMs; }
+        int* GovernorShedInterval() { return &_governorShedInterval; }
+        const std::string& GetGovernorPriority() const { return _governorPriority; }
+        void SetGovernorPriority(const std::string& priority) { _governorPriority = priority; }
+        bool GetGroupCostTiming() const { return _groupCostTiming; }
+        void SetGroupCostTiming(bool timing) { _groupCostTiming = timing; }
+        bool GetSkipUnchangedBindingCopies() const { return _skipUnchangedBindingCopies; }
+        void SetSkipUnchangedBindingCopies(bool skip) { _skipUnchangedBindingCopies = skip; }
+        bool GetDeduplicateCollection() const { return _deduplicateCollection; }
+        void SetDeduplicateCollection(bool deduplicate) { _deduplicateCollection = deduplicate; }
+        bool GetExtendCollection() const { return _extendCollection; }
+        void SetExtendCollection(bool extend) { _extendCollection = extend; }
 
         void AssignPreferredGroupTechniques(std::unordered_map<std::string, EffectData>& allTechniques);
     };
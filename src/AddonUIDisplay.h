@@ -38,6 +38,11 @@
 #include "AddonUIConstants.h"
 #include "AddonUIAbout.h"
 #include "KeyData.h"
+#include "Profiling.h"
+#include "FrameBudgetGovernor.h"
+#include "GroupCostTracker.h"
+#include "RenderingBindingManager.h"
+#include "TraceCapture.h"
 #include "ResourceManager.h"
 #include "ConstantManager.h"
 
@@ -589,7 +594,7 @@ static void DisplayGroupView(AddonImGui::AddonUIData& instance, Rendering::Resou
         return;
     }
 
-    const std::unordered_set<uint32_t>& hashes = shaderManager->getCollectedShaderHashes();
+    const std::vector<uint32_t>& hashes = shaderManager->getCollectedShaderHashes();
     static int32_t selected = -1;
     uint32_t index = 0;
     ImGuiStyle style = ImGui::GetStyle();
@@ -601,7 +606,7 @@ static void DisplayGroupView(AddonImGui::AddonUIData& instance, Rendering::Resou
             ImGui::TableNextColumn();
 
             bool marked = false;
-            if (shaderManager->isHuntedShaderMarked(shaderManager->getCollectedShaderHash(index)))
+            if (shaderManager->isHuntedShaderMarked(h))
             {
                 marked = true;
                 ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
@@ -617,6 +622,20 @@ static void DisplayGroupView(AddonImGui::AddonUIData& instance, Rendering::Resou
                 ImGui::PopStyleColor();
             }
 
+            const ShaderToggler::CollectedShaderStats* stats = shaderManager->getCollectedShaderStats(h);
+            if (stats != nullptr && ImGui::IsItemHovered())
+            {
+                ImGui::BeginTooltip();
+                ImGui::Text("Binds: %u", stats->bindCount);
+                ImGui::Text("Draws: %u", stats->drawCount);
+                if (stats->drawCount > 0)
+                {
+                    ImGui::Text("First draw in frame: %u", stats->firstDrawIndex);
+                    ImGui::Text("Viewport: %ux%u", stats->width, stats->height);
+                }
+                ImGui::EndTooltip();
+            }
+
             if (ImGui::IsItemFocused())
             {
                 shaderManager->setActivedHuntedShaderIndex(index);
@@ -1121,7 +1140,7 @@ static void ShowHelpMarker(const char* desc)
 }
 
 
-static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::effect_runtime* runtime)
+static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::effect_runtime* runtime, Rendering::FrameBudgetGovernor& governor, Rendering::GroupCostTracker& costTracker, Rendering::RenderingBindingManager& bindingManager)
 {
     DisplayAbout();
 
@@ -1151,6 +1170,29 @@ static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::eff
         ImGui::SliderInt("# of frames to collect", instance.StartValueFramecountCollectionPhase(), 10, 1000);
         ImGui::SameLine();
         ShowHelpMarker("This is the number of frames the addon will collect active shaders. Set this to a high number if the shader you want to mark is only used occasionally. Only shaders that are used in the frames collected can be marked.");
+        ImGui::AlignTextToFramePadding();
+        static const char* collectedShaderOrderNames[] = { "First seen", "Draw order", "Draw count", "Viewport size" };
+        int collectedShaderOrder = static_cast<int>(instance.GetPixelShaderManager()->getCollectedShaderOrder());
+        if (ImGui::Combo("Collected shader order", &collectedShaderOrder, collectedShaderOrderNames, IM_ARRAYSIZE(collectedShaderOrderNames)))
+        {
+            instance.GetPixelShaderManager()->setCollectedShaderOrder(static_cast<ShaderToggler::CollectedShaderOrder>(collectedShaderOrder));
+            instance.GetVertexShaderManager()->setCollectedShaderOrder(static_cast<ShaderToggler::CollectedShaderOrder>(collectedShaderOrder));
+            instance.GetComputeShaderManager()->setCollectedShaderOrder(static_cast<ShaderToggler::CollectedShaderOrder>(collectedShaderOrder));
+        }
+        ImGui::SameLine();
+        ShowHelpMarker("The order in which collected shaders are stepped through when hunting. 'Draw order' follows the first draw of each shader within a frame, 'Draw count' puts the most used shaders first and 'Viewport size' puts shaders drawing to the largest viewports first.");
+        ImGui::AlignTextToFramePadding();
+        bool deduplicateCollection = instance.GetDeduplicateCollection();
+        ImGui::Checkbox("Deduplicate collected shaders", &deduplicateCollection);
+        instance.SetDeduplicateCollection(deduplicateCollection);
+        ImGui::SameLine();
+        ShowHelpMarker("Each command list only reports a shader once per frame while collecting, which makes collecting cheaper in games with many draw calls. Bind and draw counts then count command lists rather than calls.");
+        ImGui::AlignTextToFramePadding();
+        bool extendCollection = instance.GetExtendCollection();
+        ImGui::Checkbox("Extend collection while new shaders appear", &extendCollection);
+        instance.SetExtendCollection(extendCollection);
+        ImGui::SameLine();
+        ShowHelpMarker("Keeps collecting for a while longer whenever a frame still turned up shaders that weren't collected before, up to 3000 frames in total.");
         ImGui::PopItemWidth();
     }
     ImGui::Separator();
@@ -1192,6 +1234,8 @@ static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::eff
             ImGui::EndCombo();
         }
         instance.SetConstHookCopyType(varSelectedCopyMethod);
+        ImGui::SameLine();
+        ShowHelpMarker("The memcpy methods only capture constant buffer writes done by the thread that mapped the buffer. Writes from other worker threads into the mapped memory are missed.");
 
         ImGui::AlignTextToFramePadding();
         bool trackDescriptors = instance.GetTrackDescriptors();
@@ -1201,6 +1245,143 @@ static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::eff
         bool runtimeReload = instance.GetPreventRuntimeReload();
         ImGui::Checkbox("Prevent runtime reload", &runtimeReload);
         instance.SetPreventRuntimeReload(runtimeReload);
+
+        bool interestSet = instance.GetConstBufferInterestSet();
+        ImGui::Checkbox("Only shadow watched constant buffers", &interestSet);
+        instance.SetConstBufferInterestSet(interestSet);
+        ImGui::SameLine();
+        ShowHelpMarker("Only keep host copies of constant buffers that were bound at a slot a toggle group extracts constants from. Copies are dropped after the given number of frames without use. Requires a restart.");
+        if (interestSet)
+        {
+            ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.5f);
+            ImGui::SliderInt("Frames before dropping a shadow copy", instance.ConstBufferInterestFrames(), 1, 1000);
+            ImGui::PopItemWidth();
+        }
+
+        bool skipUnchangedCopies = instance.GetSkipUnchangedBindingCopies();
+        ImGui::Checkbox("Skip unchanged texture binding copies", &skipUnchangedCopies);
+        instance.SetSkipUnchangedBindingCopies(skipUnchangedCopies);
+        ImGui::SameLine();
+        ShowHelpMarker("Tracks which resources the game renders, copies or clears to and skips copying a texture binding's source if it wasn't written to since its last copy. Sources that can be written through unordered access views are always copied.");
+        if (skipUnchangedCopies)
+        {
+            const uint64_t copies = bindingManager.GetFrameBindingCopies();
+            const uint64_t elided = bindingManager.GetFrameElidedBindingCopies();
+            const double rate = copies + elided > 0 ? 100.0 * static_cast<double>(elided) / static_cast<double>(copies + elided) : 0.0;
+            ImGui::Text("Binding copies skipped: %llu of %llu (%.1f%%)", elided, copies + elided, rate);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Frame budget governor", ImGuiTreeNodeFlags_None))
+    {
+        ImGui::AlignTextToFramePadding();
+        bool governorEnabled = instance.GetGovernorEnabled();
+        ImGui::Checkbox("Shed optional work when over budget", &governorEnabled);
+        instance.SetGovernorEnabled(governorEnabled);
+        ImGui::SameLine();
+        ShowHelpMarker("When the average frame time exceeds the budget, optional work is shed in the given order: the preview is paused, texture binding copies and constant updates only happen every Nth frame.");
+
+        ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.5f);
+        ImGui::SliderFloat("Frame budget (ms)", instance.GovernorBudgetMs(), 4.0f, 50.0f, "%.1f");
+        ImGui::SliderInt("Update every Nth frame when shed", instance.GovernorShedInterval(), 2, 30);
+
+        static char priorityBuffer[128] = "";
+        strncpy_s(priorityBuffer, sizeof(priorityBuffer), instance.GetGovernorPriority().c_str(), _TRUNCATE);
+        if (ImGui::InputText("Shed order", priorityBuffer, sizeof(priorityBuffer)))
+        {
+            instance.SetGovernorPriority(std::string(priorityBuffer));
+        }
+        ImGui::PopItemWidth();
+
+        ImGui::Text("Average frame time: %.2f ms, shed level: %u", governor.GetAverageFrameTime(), governor.GetShedLevel());
+        for (uint32_t i = 0; i < Rendering::FEATURE_COUNT; i++)
+        {
+            ImGui::Text("%s: %s", Rendering::GovernedFeatureNames[i].c_str(), governor.IsShed(static_cast<Rendering::GovernedFeature>(i)) ? "shed" : "active");
+        }
+
+        if (ImGui::TreeNode("Decisions"))
+        {
+            for (const auto& decision : governor.GetDecisionLog())
+            {
+                ImGui::TextUnformatted(decision.c_str());
+            }
+            ImGui::TreePop();
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Group cost", ImGuiTreeNodeFlags_None))
+    {
+        ImGui::AlignTextToFramePadding();
+        bool costTiming = instance.GetGroupCostTiming();
+        ImGui::Checkbox("Measure the cost of each group's effects", &costTiming);
+        instance.SetGroupCostTiming(costTiming);
+        ImGui::SameLine();
+        ShowHelpMarker("Wraps the effects rendered for each group in timestamp queries. Results are read back a few frames later. On APIs without timestamp queries the time spent recording the effects on the CPU is shown instead.");
+
+        ImGui::Text("Alpha preservation traffic saved: %.2f MB per frame", static_cast<double>(costTracker.GetFrameBandwidthSaved()) / (1024.0 * 1024.0));
+
+        if (costTracker.IsActive())
+        {
+            ImGui::Text("Timing: %s, dropped frames: %llu", costTracker.IsGPUTiming() ? "GPU timestamps" : "CPU fallback", costTracker.GetDroppedFrames());
+
+            std::unordered_map<int, ShaderToggler::ToggleGroup>& groups = instance.GetToggleGroups();
+            char techniqueName[256];
+
+            for (const auto& cost : costTracker.GetCosts())
+            {
+                const auto& group = groups.find(cost.groupId);
+                const std::string groupName = group != groups.end() ? group->second.getName() : std::format("Group {}", cost.groupId);
+
+                if (ImGui::TreeNode(reinterpret_cast<void*>(static_cast<intptr_t>(cost.groupId)), "%s: %.3f ms", groupName.c_str(), cost.totalMs))
+                {
+                    if (cost.alphaMs > 0.0f)
+                    {
+                        ImGui::Text("Alpha preserve: %.3f ms", cost.alphaMs);
+                    }
+
+                    for (const auto& [technique, ms] : cost.techniqueMs)
+                    {
+                        size_t techniqueNameSize = sizeof(techniqueName);
+                        techniqueName[0] = '\0';
+                        runtime->get_technique_name(reshade::api::effect_technique{ technique }, techniqueName, &techniqueNameSize);
+                        ImGui::Text("%s: %.3f ms", techniqueName, ms);
+                    }
+
+                    ImGui::TreePop();
+                }
+            }
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Trace capture", ImGuiTreeNodeFlags_None))
+    {
+        static int traceFrames = 10;
+
+        ImGui::AlignTextToFramePadding();
+        ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.5f);
+        ImGui::SliderInt("Frames to capture", &traceFrames, 1, 300);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        ShowHelpMarker("Writes the addon events received during the given number of frames (pipelines, render target binds, descriptor updates, draws, presents) to ShaderToggler_trace.txt next to the config file.");
+
+        if (Profiling::TraceCapture::IsCapturing())
+        {
+            if (ImGui::Button("Stop capture"))
+            {
+                Profiling::TraceCapture::Stop();
+            }
+            ImGui::SameLine();
+            ImGui::Text("%u frames left, %zu events", Profiling::TraceCapture::GetRemainingFrames(), Profiling::TraceCapture::GetEventCount());
+        }
+        else if (ImGui::Button("Start capture"))
+        {
+            Profiling::TraceCapture::Start(instance.GetBasePath() / "ShaderToggler_trace.txt", static_cast<uint32_t>(traceFrames));
+        }
+
+        if (Profiling::TraceCapture::GetLastStatus().size() > 0)
+        {
+            ImGui::TextUnformatted(Profiling::TraceCapture::GetLastStatus().c_str());
+        }
     }
 
     if (ImGui::CollapsingHeader("Keybindings", ImGuiTreeNodeFlags_None))
@@ -1343,10 +1524,7 @@ static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::eff
         for (const auto& group : toRemove)
         {
             instance.SignalToggleGroupRemoved(runtime, group);
-
-            std::erase_if(instance.GetToggleGroups(), [&group](const auto& item) {
-                return item.first == group->getId();
-                });
+            instance.RemoveToggleGroup(group);
         }
 
         if (toRemove.size() > 0)
@@ -1364,3 +1542,69 @@ static void DisplaySettings(AddonImGui::AddonUIData& instance, reshade::api::eff
         }
     }
 }
+
+#if SHADERTOGGLER_PROFILING
+static void DisplayProfiling(AddonImGui::AddonUIData& instance, reshade::api::effect_runtime* runtime)
+{
+    static bool showTotals = false;
+    static std::string dumpStatus;
+
+    ImGui::Text("Frames aggregated: %llu", Profiling::Profiler::GetFrameCount());
+    ImGui::SameLine();
+    ImGui::Checkbox("Show totals", &showTotals);
+    ImGui::SameLine();
+    if (ImGui::Button("Dump to CSV"))
+    {
+        const std::filesystem::path file = instance.GetBasePath() / "ShaderToggler_profile.csv";
+        dumpStatus = Profiling::Profiler::DumpCSV(file) ? std::format("Written to {}", file.string()) : std::format("Could not write {}", file.string());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Dump to JSON"))
+    {
+        const std::filesystem::path file = instance.GetBasePath() / "ShaderToggler_profile.json";
+        dumpStatus = Profiling::Profiler::DumpJSON(file) ? std::format("Written to {}", file.string()) : std::format("Could not write {}", file.string());
+    }
+
+    if (dumpStatus.size() > 0)
+    {
+        ImGui::TextUnformatted(dumpStatus.c_str());
+    }
+
+    const auto& statistics = showTotals ? Profiling::Profiler::GetTotalStatistics() : Profiling::Profiler::GetFrameStatistics();
+
+    if (ImGui::BeginTable("ProfilingTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Event");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Total (us)");
+        ImGui::TableSetupColumn("p50 (ns)");
+        ImGui::TableSetupColumn("p90 (ns)");
+        ImGui::TableSetupColumn("p99 (ns)");
+        ImGui::TableSetupColumn("Max (ns)");
+        ImGui::TableHeadersRow();
+
+        for (uint32_t ev = 0; ev < Profiling::EVENT_COUNT; ev++)
+        {
+            const Profiling::EventStatistics& stats = statistics[ev];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Profiling::ProfileEventNames[ev]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", static_cast<double>(stats.totalNs) / 1000.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.p50Ns);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.p90Ns);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.p99Ns);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.maxNs);
+        }
+
+        ImGui::EndTable();
+    }
+}
+#endif
@@ -45,6 +45,7 @@
 #include <stdarg.h>
 #include <fstream>
 #include <float.h>
+#include <algorithm>
 
 #ifdef WIN32
 #include <windows.h>
@@ -69,7 +70,8 @@ CDataFile::CDataFile(t_Str szFileName)
     m_bDirty = false;
     m_szFileName = szFileName;
     m_Flags = (AUTOCREATE_SECTIONS | AUTOCREATE_KEYS);
-    m_Sections.push_back(*(new t_Section));
+    m_Sections.emplace_back();
+    IndexSections();
 
     Load(m_szFileName);
 }
@@ -78,7 +80,8 @@ CDataFile::CDataFile()
 {
     Clear();
     m_Flags = (AUTOCREATE_SECTIONS | AUTOCREATE_KEYS);
-    m_Sections.push_back(*(new t_Section));
+    m_Sections.emplace_back();
+    IndexSections();
 }
 
 // ~CDataFile
@@ -96,6 +99,7 @@ void CDataFile::Clear()
     m_bDirty = false;
     m_szFileName = t_Str("");
     m_Sections.clear();
+    m_SectionIndex.clear();
 }
 
 // SetFileName
@@ -217,14 +221,8 @@ bool CDataFile::Save()
 
     if (File.is_open())
     {
-        SectionItor s_pos;
-        KeyItor k_pos;
-        t_Section Section;
-        t_Key Key;
-
-        for (s_pos = m_Sections.begin(); s_pos != m_Sections.end(); s_pos++)
+        for (const t_Section& Section : m_Sections)
         {
-            Section = (*s_pos);
             bool bWroteComment = false;
 
             t_Str szBuffer;
@@ -239,10 +237,8 @@ bool CDataFile::Save()
                 WriteLn(File, "{}[{}]", bWroteComment ? "" : "\n", Section.szName);
             }
 
-            for (k_pos = Section.Keys.begin(); k_pos != Section.Keys.end(); k_pos++)
+            for (const t_Key& Key : Section.Keys)
             {
-                Key = (*k_pos);
-
                 if (Key.szKey.size() > 0 && Key.szValue.size() > 0)
                 {
                     WriteLn(File, "{0}{1}{2}{3}{4}{5}",
@@ -274,46 +270,33 @@ bool CDataFile::Save()
 
 // SetKeyComment
 // Set the comment of a given key. Returns true if the key is not found.
-bool CDataFile::SetKeyComment(t_Str szKey, t_Str szComment, t_Str szSection)
+bool CDataFile::SetKeyComment(std::string_view szKey, std::string_view szComment, std::string_view szSection)
 {
-    KeyItor k_pos;
-    t_Section* pSection;
+    t_Key* pKey = GetKey(szKey, szSection);
 
-    if ((pSection = GetSection(szSection)) == NULL)
+    if (pKey == NULL)
         return false;
 
-    for (k_pos = pSection->Keys.begin(); k_pos != pSection->Keys.end(); k_pos++)
-    {
-        if (CompareNoCase((*k_pos).szKey, szKey) == 0)
-        {
-            (*k_pos).szComment = szComment;
-            m_bDirty = true;
-            return true;
-        }
-    }
-
-    return false;
+    pKey->szComment = szComment;
+    m_bDirty = true;
 
+    return true;
 }
 
 // SetSectionComment
 // Set the comment for a given section. Returns false if the section
 // was not found.
-bool CDataFile::SetSectionComment(t_Str szSection, t_Str szComment)
+bool CDataFile::SetSectionComment(std::string_view szSection, std::string_view szComment)
 {
-    SectionItor s_pos;
+    t_Section* pSection = GetSection(szSection);
 
-    for (s_pos = m_Sections.begin(); s_pos != m_Sections.end(); s_pos++)
-    {
-        if (CompareNoCase((*s_pos).szName, szSection) == 0)
-        {
-            (*s_pos).szComment = szComment;
-            m_bDirty = true;
-            return true;
-        }
-    }
+    if (pSection == NULL)
+        return false;
 
-    return false;
+    pSection->szComment = szComment;
+    m_bDirty = true;
+
+    return true;
 }
 
 
@@ -322,9 +305,8 @@ bool CDataFile::SetSectionComment(t_Str szSection, t_Str szComment)
 // Key within the given section, and if it finds it, change the keys value to
 // the new value. If it does not locate the key, it will create a new key with
 // the proper value and place it in the section requested.
-bool CDataFile::SetValue(t_Str szKey, t_Str szValue, t_Str szComment, t_Str szSection)
+bool CDataFile::SetValue(std::string_view szKey, std::string_view szValue, std::string_view szComment, std::string_view szSection)
 {
-    t_Key* pKey = GetKey(szKey, szSection);
     t_Section* pSection = GetSection(szSection);
 
     if (pSection == NULL)
@@ -339,19 +321,22 @@ bool CDataFile::SetValue(t_Str szKey, t_Str szValue, t_Str szComment, t_Str szSe
     if (pSection == NULL)
         return false;
 
+    t_Key* pKey = GetKey(szKey, *pSection);
+
     // if the key does not exist in that section, and the value passed 
     // is not t_Str("") then add the new key.
     if (pKey == NULL && szValue.size() > 0 && (m_Flags & AUTOCREATE_KEYS))
     {
-        pKey = new t_Key;
+        t_Key Key;
 
-        pKey->szKey = szKey;
-        pKey->szValue = szValue;
-        pKey->szComment = szComment;
+        Key.szKey = szKey;
+        Key.szValue = szValue;
+        Key.szComment = szComment;
 
         m_bDirty = true;
 
-        pSection->Keys.push_back(*pKey);
+        pSection->KeyIndex.emplace(Key.szKey, pSection->Keys.size());
+        pSection->Keys.push_back(std::move(Key));
 
         return true;
     }
@@ -371,7 +356,7 @@ bool CDataFile::SetValue(t_Str szKey, t_Str szValue, t_Str szComment, t_Str szSe
 
 // SetFloat
 // Passes the given float to SetValue as a string
-bool CDataFile::SetFloat(t_Str szKey, float fValue, t_Str szComment, t_Str szSection)
+bool CDataFile::SetFloat(std::string_view szKey, float fValue, std::string_view szComment, std::string_view szSection)
 {
     char szStr[64];
 
@@ -382,7 +367,7 @@ bool CDataFile::SetFloat(t_Str szKey, float fValue, t_Str szComment, t_Str szSec
 
 // SetInt
 // Passes the given int to SetValue as a string
-bool CDataFile::SetInt(t_Str szKey, int nValue, t_Str szComment, t_Str szSection)
+bool CDataFile::SetInt(std::string_view szKey, int nValue, std::string_view szComment, std::string_view szSection)
 {
     char szStr[64];
 
@@ -395,7 +380,7 @@ bool CDataFile::SetInt(t_Str szKey, int nValue, t_Str szComment, t_Str szSection
 
 // SetUInt
 // Passes the given int to SetValue as a string
-bool CDataFile::SetUInt(t_Str szKey, uint32_t nValue, t_Str szComment, t_Str szSection)
+bool CDataFile::SetUInt(std::string_view szKey, uint32_t nValue, std::string_view szComment, std::string_view szSection)
 {
     char szStr[64];
 
@@ -408,7 +393,7 @@ bool CDataFile::SetUInt(t_Str szKey, uint32_t nValue, t_Str szComment, t_Str szS
 
 // SetBool
 // Passes the given bool to SetValue as a string
-bool CDataFile::SetBool(t_Str szKey, bool bValue, t_Str szComment, t_Str szSection)
+bool CDataFile::SetBool(std::string_view szKey, bool bValue, std::string_view szComment, std::string_view szSection)
 {
     t_Str szValue = bValue ? "True" : "False";
 
@@ -418,7 +403,7 @@ bool CDataFile::SetBool(t_Str szKey, bool bValue, t_Str szComment, t_Str szSecti
 // GetValue
 // Returns the key value as a t_Str object. A return value of
 // t_Str("") indicates that the key could not be found.
-t_Str CDataFile::GetValue(t_Str szKey, t_Str szSection)
+t_Str CDataFile::GetValue(std::string_view szKey, std::string_view szSection)
 {
     t_Key* pKey = GetKey(szKey, szSection);
 
@@ -428,7 +413,7 @@ t_Str CDataFile::GetValue(t_Str szKey, t_Str szSection)
 // GetString
 // Returns the key value as a t_Str object. A return value of
 // t_Str("") indicates that the key could not be found.
-t_Str CDataFile::GetString(t_Str szKey, t_Str szSection)
+t_Str CDataFile::GetString(std::string_view szKey, std::string_view szSection)
 {
     return GetValue(szKey, szSection);
 }
@@ -436,7 +421,7 @@ t_Str CDataFile::GetString(t_Str szKey, t_Str szSection)
 // GetFloat
 // Returns the key value as a float type. Returns FLT_MIN if the key is
 // not found.
-float CDataFile::GetFloat(t_Str szKey, t_Str szSection)
+float CDataFile::GetFloat(std::string_view szKey, std::string_view szSection)
 {
     t_Str szValue = GetValue(szKey, szSection);
 
@@ -449,7 +434,7 @@ float CDataFile::GetFloat(t_Str szKey, t_Str szSection)
 // GetInt
 // Returns the key value as an integer type. Returns INT_MIN if the key is
 // not found.
-int	CDataFile::GetInt(t_Str szKey, t_Str szSection)
+int	CDataFile::GetInt(std::string_view szKey, std::string_view szSection)
 {
     t_Str szValue = GetValue(szKey, szSection);
 
@@ -462,7 +447,7 @@ int	CDataFile::GetInt(t_Str szKey, t_Str szSection)
 // GetUInt
 // Returns the key value as an integer type. Returns UINT_MAX if the key is
 // not found.
-uint32_t CDataFile::GetUInt(t_Str szKey, t_Str szSection)
+uint32_t CDataFile::GetUInt(std::string_view szKey, std::string_view szSection)
 {
     t_Str szValue = GetValue(szKey, szSection);
 
@@ -475,7 +460,7 @@ uint32_t CDataFile::GetUInt(t_Str szKey, t_Str szSection)
 // GetBool
 // Returns the key value as a bool type. Returns false if the key is
 // not found.
-bool CDataFile::GetBool(t_Str szKey, t_Str szSection)
+bool CDataFile::GetBool(std::string_view szKey, std::string_view szSection)
 {
     bool bValue = false;
     t_Str szValue = GetValue(szKey, szSection);
@@ -493,7 +478,7 @@ bool CDataFile::GetBool(t_Str szKey, t_Str szSection)
 // GetBool
 // Returns the key value as a bool type. Returns false if the key is
 // not found.
-bool CDataFile::GetBoolOrDefault(t_Str szKey, t_Str szSection, bool defaultValue)
+bool CDataFile::GetBoolOrDefault(std::string_view szKey, std::string_view szSection, bool defaultValue)
 {
     bool bValue = defaultValue;
     t_Str szValue = GetValue(szKey, szSection);
@@ -517,43 +502,38 @@ bool CDataFile::GetBoolOrDefault(t_Str szKey, t_Str szSection, bool defaultValue
 // DeleteSection
 // Delete a specific section. Returns false if the section cannot be 
 // found or true when sucessfully deleted.
-bool CDataFile::DeleteSection(t_Str szSection)
+bool CDataFile::DeleteSection(std::string_view szSection)
 {
-    SectionItor s_pos;
+    const auto s_pos = m_SectionIndex.find(szSection);
 
-    for (s_pos = m_Sections.begin(); s_pos != m_Sections.end(); s_pos++)
-    {
-        if (CompareNoCase((*s_pos).szName, szSection) == 0)
-        {
-            m_Sections.erase(s_pos);
-            return true;
-        }
-    }
+    if (s_pos == m_SectionIndex.end())
+        return false;
 
-    return false;
+    m_Sections.erase(m_Sections.begin() + s_pos->second);
+    IndexSections();
+
+    return true;
 }
 
 // DeleteKey
 // Delete a specific key in a specific section. Returns false if the key
 // cannot be found or true when sucessfully deleted.
-bool CDataFile::DeleteKey(t_Str szKey, t_Str szFromSection)
+bool CDataFile::DeleteKey(std::string_view szKey, std::string_view szFromSection)
 {
-    KeyItor k_pos;
     t_Section* pSection;
 
     if ((pSection = GetSection(szFromSection)) == NULL)
         return false;
 
-    for (k_pos = pSection->Keys.begin(); k_pos != pSection->Keys.end(); k_pos++)
-    {
-        if (CompareNoCase((*k_pos).szKey, szKey) == 0)
-        {
-            pSection->Keys.erase(k_pos);
-            return true;
-        }
-    }
+    const auto k_pos = pSection->KeyIndex.find(szKey);
 
-    return false;
+    if (k_pos == pSection->KeyIndex.end())
+        return false;
+
+    pSection->Keys.erase(pSection->Keys.begin() + k_pos->second);
+    IndexKeys(*pSection);
+
+    return true;
 }
 
 // CreateKey
@@ -561,7 +541,7 @@ bool CDataFile::DeleteKey(t_Str szKey, t_Str szFromSection)
 // Key within the given section, and if it finds it, change the keys value to
 // the new value. If it does not locate the key, it will create a new key with
 // the proper value and place it in the section requested.
-bool CDataFile::CreateKey(t_Str szKey, t_Str szValue, t_Str szComment, t_Str szSection)
+bool CDataFile::CreateKey(std::string_view szKey, std::string_view szValue, std::string_view szComment, std::string_view szSection)
 {
     bool bAutoKey = (m_Flags & AUTOCREATE_KEYS) == AUTOCREATE_KEYS;
     bool bReturn = false;
@@ -582,21 +562,22 @@ bool CDataFile::CreateKey(t_Str szKey, t_Str szValue, t_Str szComment, t_Str szS
 // allready exists in the list or not, if not, it creates the new section and
 // assigns it the comment given in szComment.  The function returns true if
 // sucessfully created, or false otherwise. 
-bool CDataFile::CreateSection(t_Str szSection, t_Str szComment)
+bool CDataFile::CreateSection(std::string_view szSection, std::string_view szComment)
 {
     t_Section* pSection = GetSection(szSection);
 
     if (pSection)
     {
-        Report(E_INFO, "[CDataFile::CreateSection] Section <%s> allready exists. Aborting.", szSection.c_str());
+        Report(E_INFO, "[CDataFile::CreateSection] Section <%s> allready exists. Aborting.", t_Str(szSection).c_str());
         return false;
     }
 
-    pSection = new t_Section;
+    t_Section Section;
 
-    pSection->szName = szSection;
-    pSection->szComment = szComment;
-    m_Sections.push_back(*pSection);
+    Section.szName = szSection;
+    Section.szComment = szComment;
+    m_SectionIndex.emplace(Section.szName, m_Sections.size());
+    m_Sections.push_back(std::move(Section));
     m_bDirty = true;
 
     return true;
@@ -608,30 +589,57 @@ bool CDataFile::CreateSection(t_Str szSection, t_Str szComment)
 // assigns it the comment given in szComment.  The function returns true if
 // sucessfully created, or false otherwise. This version accpets a KeyList 
 // and sets up the newly created Section with the keys in the list.
-bool CDataFile::CreateSection(t_Str szSection, t_Str szComment, KeyList Keys)
+bool CDataFile::CreateSection(std::string_view szSection, std::string_view szComment, const KeyList& Keys)
 {
     if (!CreateSection(szSection, szComment))
         return false;
 
+    return AppendKeys(szSection, KeyList(Keys));
+}
+
+// AppendKeys
+// Moves the given keys into a section, looking the section up only once. Keys
+// that allready exist in the section get their value and comment replaced,
+// keys without a name or value are skipped just like Save() would skip them.
+// Returns false if the section does not exist and could not be created.
+bool CDataFile::AppendKeys(std::string_view szSection, KeyList&& Keys)
+{
     t_Section* pSection = GetSection(szSection);
 
-    if (!pSection)
+    if (pSection == NULL)
+    {
+        if (!(m_Flags & AUTOCREATE_SECTIONS) || !CreateSection(szSection, ""))
+            return false;
+
+        pSection = GetSection(szSection);
+    }
+
+    if (pSection == NULL)
         return false;
 
-    KeyItor k_pos;
+    pSection->Keys.reserve(pSection->Keys.size() + Keys.size());
+    pSection->KeyIndex.reserve(pSection->Keys.size() + Keys.size());
 
-    pSection->szName = szSection;
-    for (k_pos = Keys.begin(); k_pos != Keys.end(); k_pos++)
+    for (t_Key& Key : Keys)
     {
-        t_Key* pKey = new t_Key;
-        pKey->szComment = (*k_pos).szComment;
-        pKey->szKey = (*k_pos).szKey;
-        pKey->szValue = (*k_pos).szValue;
+        if (Key.szKey.size() == 0 || Key.szValue.size() == 0)
+            continue;
+
+        const auto k_pos = pSection->KeyIndex.find(Key.szKey);
 
-        pSection->Keys.push_back(*pKey);
+        if (k_pos != pSection->KeyIndex.end())
+        {
+            pSection->Keys[k_pos->second].szValue = std::move(Key.szValue);
+            pSection->Keys[k_pos->second].szComment = std::move(Key.szComment);
+        }
+        else if (m_Flags & AUTOCREATE_KEYS)
+        {
+            pSection->KeyIndex.emplace(Key.szKey, pSection->Keys.size());
+            pSection->Keys.push_back(std::move(Key));
+        }
     }
 
-    m_Sections.push_back(*pSection);
+    Keys.clear();
     m_bDirty = true;
 
     return true;
@@ -649,10 +657,9 @@ int CDataFile::SectionCount()
 int CDataFile::KeyCount()
 {
     int nCounter = 0;
-    SectionItor s_pos;
 
-    for (s_pos = m_Sections.begin(); s_pos != m_Sections.end(); s_pos++)
-        nCounter += static_cast<int>((*s_pos).Keys.size());
+    for (const t_Section& Section : m_Sections)
+        nCounter += static_cast<int>(Section.Keys.size());
 
     return nCounter;
 }
@@ -664,9 +671,8 @@ int CDataFile::KeyCount()
 // GetKey
 // Given a key and section name, looks up the key and if found, returns a
 // pointer to that key, otherwise returns NULL.
-t_Key* CDataFile::GetKey(t_Str szKey, t_Str szSection)
+t_Key* CDataFile::GetKey(std::string_view szKey, std::string_view szSection)
 {
-    KeyItor k_pos;
     t_Section* pSection;
 
     // Since our default section has a name value of t_Str("") this should
@@ -675,48 +681,68 @@ t_Key* CDataFile::GetKey(t_Str szKey, t_Str szSection)
     if ((pSection = GetSection(szSection)) == NULL)
         return NULL;
 
-    for (k_pos = pSection->Keys.begin(); k_pos != pSection->Keys.end(); k_pos++)
-    {
-        if (CompareNoCase((*k_pos).szKey, szKey) == 0)
-            return (t_Key*)&(*k_pos);
-    }
+    return GetKey(szKey, *pSection);
+}
 
-    return NULL;
+// GetKey
+// Looks up a key within an allready located section.
+t_Key* CDataFile::GetKey(std::string_view szKey, t_Section& Section)
+{
+    const auto k_pos = Section.KeyIndex.find(szKey);
+
+    return k_pos == Section.KeyIndex.end() ? NULL : &Section.Keys[k_pos->second];
 }
 
 // GetSection
 // Given a section name, locates that section in the list and returns a pointer
 // to it. If the section was not found, returns NULL
-t_Section* CDataFile::GetSection(t_Str szSection)
+t_Section* CDataFile::GetSection(std::string_view szSection)
 {
-    SectionItor s_pos;
+    const auto s_pos = m_SectionIndex.find(szSection);
 
-    for (s_pos = m_Sections.begin(); s_pos != m_Sections.end(); s_pos++)
-    {
-        if (CompareNoCase((*s_pos).szName, szSection) == 0)
-            return (t_Section*)&(*s_pos);
-    }
+    return s_pos == m_SectionIndex.end() ? NULL : &m_Sections[s_pos->second];
+}
+
+// IndexSections
+// Rebuilds the section index from the section list.
+void CDataFile::IndexSections()
+{
+    m_SectionIndex.clear();
+    m_SectionIndex.reserve(m_Sections.size());
 
-    return NULL;
+    for (size_t i = 0; i < m_Sections.size(); i++)
+        m_SectionIndex.emplace(m_Sections[i].szName, i);
 }
 
+// IndexKeys
+// Rebuilds the key index of a section from its key list.
+void CDataFile::IndexKeys(t_Section& Section)
+{
+    Section.KeyIndex.clear();
+    Section.KeyIndex.reserve(Section.Keys.size());
+
+    for (size_t i = 0; i < Section.Keys.size(); i++)
+        Section.KeyIndex.emplace(Section.Keys[i].szKey, i);
+}
 
-t_Str CDataFile::CommentStr(t_Str szComment)
+
+t_Str CDataFile::CommentStr(std::string_view szComment)
 {
     t_Str szNewStr = t_Str("");
+    t_Str szTrimmed = t_Str(szComment);
 
-    Trim(szComment);
+    Trim(szTrimmed);
 
-    if (szComment.size() == 0)
-        return szComment;
+    if (szTrimmed.size() == 0)
+        return szTrimmed;
 
-    if (szComment.find_first_of(CommentIndicators) != 0)
+    if (szTrimmed.find_first_of(CommentIndicators) != 0)
     {
         szNewStr = CommentIndicators[0];
         szNewStr += " ";
     }
 
-    szNewStr += szComment;
+    szNewStr += szTrimmed;
 
     return szNewStr;
 }
@@ -755,13 +781,41 @@ t_Str GetNextWord(t_Str& CommandLine)
 // it's amazing what features std::string lacks.  This function simply
 // does a lowercase compare against the two strings, returning 0 if they
 // match.
-int CompareNoCase(t_Str str1, t_Str str2)
+int CompareNoCase(std::string_view str1, std::string_view str2)
 {
+    const size_t nLength = std::min(str1.size(), str2.size());
+
 #ifdef WIN32
-    return _stricmp(str1.c_str(), str2.c_str());
+    const int nResult = nLength > 0 ? _strnicmp(str1.data(), str2.data(), nLength) : 0;
 #else
-    return strcasecmp(str1.c_str(), str2.c_str());
+    const int nResult = nLength > 0 ? strncasecmp(str1.data(), str2.data(), nLength) : 0;
 #endif
+
+    if (nResult != 0 || str1.size() == str2.size())
+        return nResult;
+
+    return str1.size() < str2.size() ? -1 : 1;
+}
+
+// t_NoCaseHash
+// FNV-1a over the lowercased characters, so names differing only in case
+// end up in the same bucket.
+size_t t_NoCaseHash::operator()(std::string_view szStr) const noexcept
+{
+    size_t nHash = 14695981039346656037ull;
+
+    for (const char c : szStr)
+    {
+        nHash ^= static_cast<size_t>(tolower(static_cast<unsigned char>(c)));
+        nHash *= 1099511628211ull;
+    }
+
+    return nHash;
+}
+
+bool t_NoCaseEqual::operator()(std::string_view str1, std::string_view str2) const noexcept
+{
+    return str1.size() == str2.size() && CompareNoCase(str1, str2) == 0;
 }
 
 // Trim
@@ -17,6 +17,8 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <format>
 
 // Globally defined structures, defines, & types
@@ -90,6 +92,27 @@ const t_Str EqualIndicators = t_Str("=:");
 // the head and tail of strings.
 const t_Str WhiteSpace = t_Str(" \t\n\r");
 
+// t_NoCaseHash, t_NoCaseEqual
+// Case insensitive hashing and comparison for the key and section indices.
+// Both are transparent so lookups can be done without building a t_Str.
+struct t_NoCaseHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view szStr) const noexcept;
+};
+
+struct t_NoCaseEqual
+{
+    using is_transparent = void;
+
+    bool operator()(std::string_view str1, std::string_view str2) const noexcept;
+};
+
+// t_Index
+// Maps a key or section name to its position in the owning list.
+typedef std::unordered_map<t_Str, size_t, t_NoCaseHash, t_NoCaseEqual> t_Index;
+
 // st_key
 // This structure stores the definition of a key. A key is a named identifier
 // that is associated with a value. It may or may not have a comment.  All comments
@@ -121,6 +144,7 @@ typedef struct st_section
     t_Str		szName;
     t_Str		szComment;
     KeyList		Keys;
+    t_Index		KeyIndex;
 
     st_section()
     {
@@ -140,7 +164,7 @@ typedef SectionList::iterator SectionItor;
 /////////////////////////////////////////////////////////////////////////////////
 void	Report(e_DebugLevel DebugLevel, const char* fmt, ...);
 t_Str	GetNextWord(t_Str& CommandLine);
-int		CompareNoCase(t_Str str1, t_Str str2);
+int		CompareNoCase(std::string_view str1, std::string_view str2);
 void	Trim(t_Str& szStr);
 template <typename... Args>
 size_t  WriteLn(std::fstream& stream, std::format_string<Args...> fmt, Args &&... args);
@@ -171,57 +195,57 @@ public:
 
     // GetValue: Our default access method. Returns the raw t_Str value
     // Note that this returns keys specific to the given section only.
-    t_Str		GetValue(t_Str szKey, t_Str szSection = t_Str(""));
+    t_Str		GetValue(std::string_view szKey, std::string_view szSection = "");
     // GetString: Returns the value as a t_Str
-    t_Str		GetString(t_Str szKey, t_Str szSection = t_Str(""));
+    t_Str		GetString(std::string_view szKey, std::string_view szSection = "");
     // GetFloat: Return the value as a float
-    float		GetFloat(t_Str szKey, t_Str szSection = t_Str(""));
+    float		GetFloat(std::string_view szKey, std::string_view szSection = "");
     // GetInt: Return the value as an int
-    int			GetInt(t_Str szKey, t_Str szSection = t_Str(""));
+    int			GetInt(std::string_view szKey, std::string_view szSection = "");
     // GetUInt: Return the value as an int
-    uint32_t	GetUInt(t_Str szKey, t_Str szSection = t_Str(""));
+    uint32_t	GetUInt(std::string_view szKey, std::string_view szSection = "");
     // GetBool: Return the value as a bool
-    bool		GetBool(t_Str szKey, t_Str szSection = t_Str(""));
+    bool		GetBool(std::string_view szKey, std::string_view szSection = "");
 
     // GetBoolOrDefault: Return the value as a bool or a default value if it's not found
-    bool		GetBoolOrDefault(t_Str szKey, t_Str szSection, bool defaultValue);
+    bool		GetBoolOrDefault(std::string_view szKey, std::string_view szSection, bool defaultValue);
 
     // SetValue: Sets the value of a given key. Will create the
     // key if it is not found and AUTOCREATE_KEYS is active.
-    bool		SetValue(t_Str szKey, t_Str szValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		SetValue(std::string_view szKey, std::string_view szValue,
+        std::string_view szComment = "", std::string_view szSection = "");
 
     // SetFloat: Sets the value of a given key. Will create the
     // key if it is not found and AUTOCREATE_KEYS is active.
-    bool		SetFloat(t_Str szKey, float fValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		SetFloat(std::string_view szKey, float fValue,
+        std::string_view szComment = "", std::string_view szSection = "");
 
     // SetInt: Sets the value of a given key. Will create the
     // key if it is not found and AUTOCREATE_KEYS is active.
-    bool		SetInt(t_Str szKey, int nValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		SetInt(std::string_view szKey, int nValue,
+        std::string_view szComment = "", std::string_view szSection = "");
 
     // SetUInt: Sets the value of a given key. Will create the
     // key if it is not found and AUTOCREATE_KEYS is active.
-    bool		SetUInt(t_Str szKey, uint32_t nValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		SetUInt(std::string_view szKey, uint32_t nValue,
+        std::string_view szComment = "", std::string_view szSection = "");
 
     // SetBool: Sets the value of a given key. Will create the
     // key if it is not found and AUTOCREATE_KEYS is active.
-    bool		SetBool(t_Str szKey, bool bValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		SetBool(std::string_view szKey, bool bValue,
+        std::string_view szComment = "", std::string_view szSection = "");
 
     // Sets the comment for a given key.
-    bool		SetKeyComment(t_Str szKey, t_Str szComment, t_Str szSection = t_Str(""));
+    bool		SetKeyComment(std::string_view szKey, std::string_view szComment, std::string_view szSection = "");
 
     // Sets the comment for a given section
-    bool		SetSectionComment(t_Str szSection, t_Str szComment);
+    bool		SetSectionComment(std::string_view szSection, std::string_view szComment);
 
     // DeleteKey: Deletes a given key from a specific section
-    bool		DeleteKey(t_Str szKey, t_Str szFromSection = t_Str(""));
+    bool		DeleteKey(std::string_view szKey, std::string_view szFromSection = "");
 
     // DeleteSection: Deletes a given section.
-    bool		DeleteSection(t_Str szSection);
+    bool		DeleteSection(std::string_view szSection);
 
     // Key/Section handling methods
     /////////////////////////////////////////////////////////////////
@@ -229,14 +253,19 @@ public:
     // CreateKey: Creates a new key in the requested section. The
     // Section will be created if it does not exist and the 
     // AUTOCREATE_SECTIONS bit is set.
-    bool		CreateKey(t_Str szKey, t_Str szValue,
-        t_Str szComment = t_Str(""), t_Str szSection = t_Str(""));
+    bool		CreateKey(std::string_view szKey, std::string_view szValue,
+        std::string_view szComment = "", std::string_view szSection = "");
     // CreateSection: Creates the new section if it does not allready
     // exist. Section is created with no keys.
-    bool		CreateSection(t_Str szSection, t_Str szComment = t_Str(""));
+    bool		CreateSection(std::string_view szSection, std::string_view szComment = "");
     // CreateSection: Creates the new section if it does not allready
     // exist, and copies the keys passed into it into the new section.
-    bool		CreateSection(t_Str szSection, t_Str szComment, KeyList Keys);
+    bool		CreateSection(std::string_view szSection, std::string_view szComment, const KeyList& Keys);
+    // AppendKeys: Moves all keys into the requested section with a single
+    // section lookup. Keys that allready exist have their value replaced.
+    // The section will be created if it does not exist and the
+    // AUTOCREATE_SECTIONS bit is set.
+    bool		AppendKeys(std::string_view szSection, KeyList&& Keys);
 
     // Utility Methods
     /////////////////////////////////////////////////////////////////
@@ -251,7 +280,7 @@ public:
     void		SetFileName(t_Str szFileName);
     // CommentStr
     // Parses a string into a proper comment token/comment.
-    t_Str		CommentStr(t_Str szComment);
+    t_Str		CommentStr(std::string_view szComment);
 
 
 protected:
@@ -266,9 +295,14 @@ protected:
 
     // GetKey: Returns the requested key (if found) from the requested
     // Section. Returns NULL otherwise.
-    t_Key* GetKey(t_Str szKey, t_Str szSection);
+    t_Key* GetKey(std::string_view szKey, std::string_view szSection);
+    t_Key* GetKey(std::string_view szKey, t_Section& Section);
     // GetSection: Returns the requested section (if found), NULL otherwise.
-    t_Section* GetSection(t_Str szSection);
+    t_Section* GetSection(std::string_view szSection);
+    // IndexSections, IndexKeys: Rebuild the lookup indices after entries
+    // were removed from a list.
+    void		IndexSections();
+    static void	IndexKeys(t_Section& Section);
 
 
     // Data
@@ -277,6 +311,7 @@ public:
 
 protected:
     SectionList	m_Sections;		// Our list of sections
+    t_Index		m_SectionIndex;	// Section positions by name
     t_Str		m_szFileName;	// The filename to write to
     bool		m_bDirty;		// Tracks whether or not data has changed.
 };
@@ -1,11 +1,16 @@
+#include <algorithm>
 #include "ConstantCopyBase.h"
 
 using namespace Shim::Constants;
 using namespace reshade::api;
 using namespace std;
 
-unordered_map<uint64_t, vector<uint8_t>> ConstantCopyBase::deviceToHostConstantBuffer;
-shared_mutex ConstantCopyBase::deviceHostMutex;
+HostConstantBufferStore ConstantCopyBase::hostConstantBuffers;
+bool ConstantCopyBase::interestSetEnabled = false;
+uint32_t ConstantCopyBase::interestExpiryFrames = 120;
+atomic_uint64_t ConstantCopyBase::interestFrame = 0;
+unordered_map<uint64_t, atomic_uint64_t> ConstantCopyBase::interestSet;
+shared_mutex ConstantCopyBase::interestMutex;
 
 ConstantCopyBase::ConstantCopyBase()
 {
@@ -19,40 +24,111 @@ ConstantCopyBase::~ConstantCopyBase()
 
 void ConstantCopyBase::GetHostConstantBuffer(reshade::api::command_list* cmd_list, ShaderToggler::ToggleGroup* group, vector<uint8_t>& dest, size_t size, uint64_t resourceHandle)
 {
-    shared_lock<shared_mutex> lock(deviceHostMutex);
-    const auto& it = deviceToHostConstantBuffer.find(resourceHandle);
-    if (it != deviceToHostConstantBuffer.end())
-    {
-        auto& [_, buffer] = *it;
-        std::memcpy(dest.data(), buffer.data(), size);
-    }
+    hostConstantBuffers.Read(resourceHandle, dest.data(), size);
+}
+
+void ConstantCopyBase::GetHostConstantBufferRange(command_list* cmd_list, ShaderToggler::ToggleGroup* group, vector<uint8_t>& dest, size_t size, buffer_range range)
+{
+    // Host copies mirror whole buffers, so by default the range offset is ignored
+    GetHostConstantBuffer(cmd_list, group, dest, size, range.buffer.handle);
+}
+
+size_t ConstantCopyBase::GetConstantBufferRangeSize(device* dev, buffer_range range)
+{
+    return static_cast<size_t>(dev->get_resource_desc(range.buffer).buffer.size);
 }
 
 void ConstantCopyBase::CreateHostConstantBuffer(device* dev, resource resource, size_t size)
 {
-    unique_lock<shared_mutex> lock(deviceHostMutex);
-    deviceToHostConstantBuffer.emplace(resource.handle, vector<uint8_t>(size, 0));
+    hostConstantBuffers.Create(resource.handle, size);
 }
 
 void ConstantCopyBase::DeleteHostConstantBuffer(resource resource)
 {
-    unique_lock<shared_mutex> lock(deviceHostMutex);
-    deviceToHostConstantBuffer.erase(resource.handle);
+    hostConstantBuffers.Delete(resource.handle);
+}
+
+void ConstantCopyBase::SetHostConstantBuffer(const uint64_t handle, const void* buffer, size_t size, uintptr_t offset, uint64_t bufferSize)
+{
+    hostConstantBuffers.Write(handle, buffer, size, offset);
+}
+
+void ConstantCopyBase::SeedHostConstantBuffer(uint64_t handle, map_access access, const void* mapped, uint64_t offset, uint64_t size)
+{
+    if (!interestSetEnabled || mapped == nullptr || access == map_access::write_discard)
+    {
+        return;
+    }
+
+    hostConstantBuffers.Seed(handle, mapped, static_cast<size_t>(size), static_cast<uintptr_t>(offset));
+}
+
+void ConstantCopyBase::SetInterestSet(bool enabled, uint32_t expiryFrames)
+{
+    interestSetEnabled = enabled;
+    interestExpiryFrames = std::max(expiryFrames, 1u);
+}
+
+void ConstantCopyBase::OnBufferInterest(device* device, resource resource, size_t size)
+{
+    if (!interestSetEnabled)
+    {
+        return;
+    }
+
+    const uint64_t frame = interestFrame.load(std::memory_order_relaxed);
+
+    {
+        shared_lock<shared_mutex> lock(interestMutex);
+        const auto& it = interestSet.find(resource.handle);
+        if (it != interestSet.end())
+        {
+            it->second.store(frame, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    unique_lock<shared_mutex> lock(interestMutex);
+    const auto& [_, inserted] = interestSet.try_emplace(resource.handle, frame);
+    if (inserted)
+    {
+        // Start shadowing, contents become valid with the next map (see SeedHostConstantBuffer) or write to the buffer
+        CreateHostConstantBuffer(device, resource, size);
+    }
 }
 
-inline void ConstantCopyBase::SetHostConstantBuffer(const uint64_t handle, const void* buffer, size_t size, uintptr_t offset, uint64_t bufferSize)
+void ConstantCopyBase::OnPresent()
 {
-    unique_lock<shared_mutex> lock(deviceHostMutex);
-    const auto& it = deviceToHostConstantBuffer.find(handle);
-    if (it != deviceToHostConstantBuffer.end())
+    const uint64_t frame = interestFrame.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    if (!interestSetEnabled)
+    {
+        return;
+    }
+
+    unique_lock<shared_mutex> lock(interestMutex);
+    for (auto it = interestSet.begin(); it != interestSet.end();)
     {
-        auto& [_, cBuffer] = *it;
-        memcpy(&cBuffer[offset], buffer, size);
+        if (frame - it->second.load(std::memory_order_relaxed) > interestExpiryFrames && !IsBufferMapped(it->first))
+        {
+            DeleteHostConstantBuffer(resource{ it->first });
+            it = interestSet.erase(it);
+        }
+        else
+        {
+            it++;
+        }
     }
 }
 
 void ConstantCopyBase::OnInitResource(device* device, const resource_desc& desc, const subresource_data* initData, resource_usage usage, reshade::api::resource handle)
 {
+    if (interestSetEnabled)
+    {
+        // Shadow copies are created on demand once a group shows interest in the buffer
+        return;
+    }
+
     if (desc.heap == memory_heap::cpu_to_gpu && static_cast<uint32_t>(desc.usage & resource_usage::constant_buffer))
     {
         CreateHostConstantBuffer(device, handle, static_cast<size_t>(desc.buffer.size));
@@ -69,5 +145,11 @@ void ConstantCopyBase::OnDestroyResource(device* device, resource res)
     if (desc.heap == memory_heap::cpu_to_gpu && static_cast<uint32_t>(desc.usage & resource_usage::constant_buffer))
     {
         DeleteHostConstantBuffer(res);
+
+        if (interestSetEnabled)
+        {
+            unique_lock<shared_mutex> lock(interestMutex);
+            interestSet.erase(res.handle);
+        }
     }
 }
\ No newline at end of file
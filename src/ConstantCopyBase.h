@@ -4,8 +4,10 @@
 #include <reshade_api_device.hpp>
 #include <reshade_api_pipeline.hpp>
 #include <unordered_map>
+#include <atomic>
 #include <shared_mutex>
 #include "ToggleGroup.h"
+#include "ConstantCopyHostStore.h"
 
 namespace Shim
 {
@@ -20,9 +22,11 @@ namespace Shim
             virtual bool UnInit() = 0;
 
             virtual void GetHostConstantBuffer(reshade::api::command_list* cmd_list, ShaderToggler::ToggleGroup* group, std::vector<uint8_t>& dest, size_t size, uint64_t resourceHandle);
+            virtual void GetHostConstantBufferRange(reshade::api::command_list* cmd_list, ShaderToggler::ToggleGroup* group, std::vector<uint8_t>& dest, size_t size, reshade::api::buffer_range range);
+            virtual size_t GetConstantBufferRangeSize(reshade::api::device* dev, reshade::api::buffer_range range);
             virtual void CreateHostConstantBuffer(reshade::api::device* dev, reshade::api::resource resource, size_t size);
             virtual void DeleteHostConstantBuffer(reshade::api::resource resource);
-            virtual inline void SetHostConstantBuffer(const uint64_t handle, const void* buffer, size_t size, uintptr_t offset, uint64_t bufferSize);
+            virtual void SetHostConstantBuffer(const uint64_t handle, const void* buffer, size_t size, uintptr_t offset, uint64_t bufferSize);
 
             virtual void OnInitResource(reshade::api::device* device, const reshade::api::resource_desc& desc, const reshade::api::subresource_data* initData, reshade::api::resource_usage usage, reshade::api::resource handle);
             virtual void OnDestroyResource(reshade::api::device* device, reshade::api::resource res);
@@ -30,9 +34,27 @@ namespace Shim
             virtual void OnUpdateBufferRegion(reshade::api::device* device, const void* data, reshade::api::resource resource, uint64_t offset, uint64_t size) = 0;
             virtual void OnMapBufferRegion(reshade::api::device* device, reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** data) = 0;
             virtual void OnUnmapBufferRegion(reshade::api::device* device, reshade::api::resource resource) = 0;
+
+            // Interest set: only shadow buffers that were seen bound at a slot a group extracts constants from
+            virtual void OnBufferInterest(reshade::api::device* device, reshade::api::resource resource, size_t size);
+            virtual void OnPresent();
+
+            static void SetInterestSet(bool enabled, uint32_t expiryFrames);
         protected:
-            static std::unordered_map<uint64_t, std::vector<uint8_t>> deviceToHostConstantBuffer;
-            static std::shared_mutex deviceHostMutex;
+            // Whether the strategy currently holds a mapping of the buffer, mapped buffers are never expired from the interest set
+            virtual bool IsBufferMapped(uint64_t handle) { return false; }
+
+            // Fills a host copy that hasn't seen a write yet from the mapped memory, so a buffer that just joined the interest
+            // set doesn't extract zeros. Discarded mappings have undefined contents, those stay zero until the game writes them.
+            void SeedHostConstantBuffer(uint64_t handle, reshade::api::map_access access, const void* mapped, uint64_t offset, uint64_t size);
+
+            static HostConstantBufferStore hostConstantBuffers;
+
+            static bool interestSetEnabled;
+            static uint32_t interestExpiryFrames;
+            static std::atomic_uint64_t interestFrame;
+            static std::unordered_map<uint64_t, std::atomic_uint64_t> interestSet;
+            static std::shared_mutex interestMutex;
         };
     }
 }
@@ -31,6 +31,7 @@ namespace Shim
             virtual void OnUpdateBufferRegion(reshade::api::device* device, const void* data, reshade::api::resource resource, uint64_t offset, uint64_t size) override final {};
             virtual void OnMapBufferRegion(reshade::api::device* device, reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** data) override final {};
             virtual void OnUnmapBufferRegion(reshade::api::device* device, reshade::api::resource resource) override final {};
+            virtual void OnBufferInterest(reshade::api::device* device, reshade::api::resource resource, size_t size) override final {};
 
         private:
             std::unordered_map<uint64_t, reshade::api::resource> resToCopyBuffer;
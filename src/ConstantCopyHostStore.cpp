@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "ConstantCopyHostStore.h"
+
+using namespace Shim::Constants;
+using namespace std;
+
+size_t HostBufferSlabAllocator::GetSizeClass(size_t size)
+{
+    const size_t shift = std::max(MinBlockShift, static_cast<size_t>(std::bit_width(std::max<size_t>(size, 1) - 1)));
+    return shift - MinBlockShift;
+}
+
+uint8_t* HostBufferSlabAllocator::Allocate(size_t size, size_t& capacity)
+{
+    if (size > (static_cast<size_t>(1) << MaxBlockShift))
+    {
+        // Oversized buffers bypass the slabs
+        capacity = size;
+        return new uint8_t[size];
+    }
+
+    const size_t sizeClass = GetSizeClass(size);
+    const size_t blockSize = static_cast<size_t>(1) << (sizeClass + MinBlockShift);
+    capacity = blockSize;
+
+    unique_lock<mutex> lock(_allocMutex);
+    auto& freeList = _freeLists[sizeClass];
+
+    if (freeList.empty())
+    {
+        _slabs.push_back(make_unique<uint8_t[]>(SlabSize));
+        uint8_t* slab = _slabs.back().get();
+
+        for (size_t offset = 0; offset + blockSize <= SlabSize; offset += blockSize)
+        {
+            freeList.push_back(slab + offset);
+        }
+    }
+
+    uint8_t* block = freeList.back();
+    freeList.pop_back();
+
+    return block;
+}
+
+void HostBufferSlabAllocator::Free(uint8_t* block, size_t capacity)
+{
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    if (capacity > (static_cast<size_t>(1) << MaxBlockShift))
+    {
+        delete[] block;
+        return;
+    }
+
+    unique_lock<mutex> lock(_allocMutex);
+    _freeLists[GetSizeClass(capacity)].push_back(block);
+}
+
+HostConstantBufferStore::~HostConstantBufferStore()
+{
+    for (auto& shard : _shards)
+    {
+        unique_lock<shared_mutex> lock(shard.mutex);
+        for (auto& [_, buffer] : shard.buffers)
+        {
+            _allocator.Free(buffer.data, buffer.capacity);
+        }
+        shard.buffers.clear();
+    }
+}
+
+void HostConstantBufferStore::Create(uint64_t handle, size_t size)
+{
+    size_t capacity = 0;
+    uint8_t* data = _allocator.Allocate(size, capacity);
+    memset(data, 0, size);
+
+    Shard& shard = _shards[GetShardIndex(handle)];
+    unique_lock<shared_mutex> lock(shard.mutex);
+
+    const auto& [it, inserted] = shard.buffers.try_emplace(handle, HostBuffer{ data, size, capacity });
+    if (!inserted)
+    {
+        // Handle got recycled without a destroy event, keep the existing buffer
+        lock.unlock();
+        _allocator.Free(data, capacity);
+    }
+}
+
+void HostConstantBufferStore::Delete(uint64_t handle)
+{
+    HostBuffer buffer;
+
+    {
+        Shard& shard = _shards[GetShardIndex(handle)];
+        unique_lock<shared_mutex> lock(shard.mutex);
+
+        const auto& it = shard.buffers.find(handle);
+        if (it == shard.buffers.end())
+        {
+            return;
+        }
+
+        buffer = it->second;
+        shard.buffers.erase(it);
+    }
+
+    _allocator.Free(buffer.data, buffer.capacity);
+}
+
+bool HostConstantBufferStore::Write(uint64_t handle, const void* src, size_t size, uintptr_t offset)
+{
+    Shard& shard = _shards[GetShardIndex(handle)];
+    unique_lock<shared_mutex> lock(shard.mutex);
+
+    const auto& it = shard.buffers.find(handle);
+    if (it == shard.buffers.end() || offset >= it->second.size)
+    {
+        return false;
+    }
+
+    HostBuffer& buffer = it->second;
+    memcpy(buffer.data + offset, src, std::min(size, buffer.size - offset));
+    buffer.written = true;
+
+    return true;
+}
+
+bool HostConstantBufferStore::Seed(uint64_t handle, const void* src, size_t size, uintptr_t offset)
+{
+    Shard& shard = _shards[GetShardIndex(handle)];
+    unique_lock<shared_mutex> lock(shard.mutex);
+
+    const auto& it = shard.buffers.find(handle);
+    if (it == shard.buffers.end() || it->second.written || offset >= it->second.size)
+    {
+        return false;
+    }
+
+    HostBuffer& buffer = it->second;
+    memcpy(buffer.data + offset, src, std::min(size, buffer.size - offset));
+    buffer.written = true;
+
+    return true;
+}
+
+bool HostConstantBufferStore::Read(uint64_t handle, void* dest, size_t size)
+{
+    Shard& shard = _shards[GetShardIndex(handle)];
+    shared_lock<shared_mutex> lock(shard.mutex);
+
+    const auto& it = shard.buffers.find(handle);
+    if (it == shard.buffers.end())
+    {
+        return false;
+    }
+
+    const HostBuffer& buffer = it->second;
+    memcpy(dest, buffer.data, std::min(size, buffer.size));
+
+    return true;
+}
+
+bool HostConstantBufferStore::Contains(uint64_t handle)
+{
+    Shard& shard = _shards[GetShardIndex(handle)];
+    shared_lock<shared_mutex> lock(shard.mutex);
+
+    return shard.buffers.contains(handle);
+}
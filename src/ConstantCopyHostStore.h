@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Shim
+{
+    namespace Constants
+    {
+        // Hands out host constant buffer storage from fixed size slabs, one free list per power-of-two size class.
+        // Blocks are recycled, slabs are only released when the allocator is destroyed.
+        class HostBufferSlabAllocator final {
+        public:
+            HostBufferSlabAllocator() = default;
+            ~HostBufferSlabAllocator() = default;
+
+            uint8_t* Allocate(size_t size, size_t& capacity);
+            void Free(uint8_t* block, size_t capacity);
+
+        private:
+            static constexpr size_t MinBlockShift = 8;   // 256 bytes
+            static constexpr size_t MaxBlockShift = 16;  // 64 KiB, the D3D constant buffer limit
+            static constexpr size_t SizeClassCount = MaxBlockShift - MinBlockShift + 1;
+            static constexpr size_t SlabSize = 256 * 1024;
+
+            static size_t GetSizeClass(size_t size);
+
+            std::mutex _allocMutex;
+            std::array<std::vector<uint8_t*>, SizeClassCount> _freeLists;
+            std::vector<std::unique_ptr<uint8_t[]>> _slabs;
+        };
+
+        struct HostBuffer
+        {
+            uint8_t* data = nullptr;
+            size_t size = 0;
+            size_t capacity = 0;
+            bool written = false;   // false until the first write, the contents are zero until then
+        };
+
+        // Host side copies of mapped constant buffers, sharded by resource handle so writers to different buffers
+        // don't contend on a single lock.
+        class HostConstantBufferStore final {
+        public:
+            HostConstantBufferStore() = default;
+            ~HostConstantBufferStore();
+
+            void Create(uint64_t handle, size_t size);
+            void Delete(uint64_t handle);
+            bool Write(uint64_t handle, const void* src, size_t size, uintptr_t offset);
+            // Like Write, but only if the buffer hasn't been written to since it was created
+            bool Seed(uint64_t handle, const void* src, size_t size, uintptr_t offset);
+            bool Read(uint64_t handle, void* dest, size_t size);
+            bool Contains(uint64_t handle);
+
+        private:
+            static constexpr size_t ShardCount = 64;
+
+            struct Shard
+            {
+                std::shared_mutex mutex;
+                std::unordered_map<uint64_t, HostBuffer> buffers;
+            };
+
+            static inline size_t GetShardIndex(uint64_t handle)
+            {
+                // Handles are mostly pointers, mix the bits so aligned addresses spread over all shards
+                return static_cast<size_t>((handle * 0x9E3779B97F4A7C15ull) >> 58) & (ShardCount - 1);
+            }
+
+            std::array<Shard, ShardCount> _shards;
+            HostBufferSlabAllocator _allocator;
+        };
+    }
+}
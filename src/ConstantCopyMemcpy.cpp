@@ -8,6 +8,9 @@ using namespace std;
 
 sig_memcpy* ConstantCopyMemcpy::org_memcpy = nullptr;
 ConstantCopyMemcpy* ConstantCopyMemcpy::_instance = nullptr;
+thread_local ThreadMapCounter* ConstantCopyMemcpy::_threadMapCounter = nullptr;
+mutex ConstantCopyMemcpy::_threadMapCounterMutex;
+vector<unique_ptr<ThreadMapCounter>> ConstantCopyMemcpy::_threadMapCounters;
 
 ConstantCopyMemcpy::ConstantCopyMemcpy()
 {
@@ -29,6 +32,29 @@ bool ConstantCopyMemcpy::UnInit()
 }
 
 
+ThreadMapCounter* ConstantCopyMemcpy::TrackThreadMap()
+{
+    if (_threadMapCounter == nullptr)
+    {
+        unique_lock<mutex> lock(_threadMapCounterMutex);
+        _threadMapCounters.push_back(make_unique<ThreadMapCounter>());
+        _threadMapCounter = _threadMapCounters.back().get();
+    }
+
+    _threadMapCounter->count.fetch_add(1, std::memory_order_relaxed);
+
+    return _threadMapCounter;
+}
+
+void ConstantCopyMemcpy::UntrackThreadMap(ThreadMapCounter* counter)
+{
+    if (counter != nullptr)
+    {
+        counter->count.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+
 bool ConstantCopyMemcpy::HookStatic(sig_memcpy** original, sig_memcpy* detour)
 {
     string exe = GameHookT<sig_memcpy>::GetExecutableName();
@@ -94,7 +120,12 @@ bool ConstantCopyMemcpy::Unhook()
 
 void* __fastcall ConstantCopyMemcpy::detour_memcpy(void* dest, void* src, size_t size)
 {
-    _instance->OnMemcpy(dest, src, size);
+    const ThreadMapCounter* counter = _threadMapCounter;
+
+    if (counter != nullptr && counter->count.load(std::memory_order_relaxed) > 0 && size >= MinTrackedCopySize)
+    {
+        _instance->OnMemcpy(dest, src, size);
+    }
 
     return org_memcpy(dest, src, size);
 }
\ No newline at end of file
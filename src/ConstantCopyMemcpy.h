@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <vector>
 #include <shared_mutex>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "ConstantCopyBase.h"
 #include "GameHookT.h"
 
@@ -53,14 +56,21 @@ namespace Shim
 {
     namespace Constants
     {
+        // Number of constant buffers a thread has mapped and not yet unmapped. Counters are never freed, so a mapping
+        // can still be untracked after its thread exited.
+        struct ThreadMapCounter
+        {
+            std::atomic_int32_t count = 0;
+        };
+
         struct BufferCopy
         {
             uint64_t resource = 0;
             void* destination = nullptr;
-            uint8_t* hostDestination = nullptr;
             uint64_t offset = 0;
             uint64_t size = 0;
             uint64_t bufferSize = 0;
+            ThreadMapCounter* mapThread = nullptr;  // counter of the thread that mapped the buffer
         };
 
 
@@ -82,10 +92,26 @@ namespace Shim
         protected:
             static ConstantCopyMemcpy* _instance;
 
+            // Counter of the current thread. Threads that never mapped a constant buffer bypass OnMemcpy with a single TLS read.
+            // Only writes done by the thread that mapped a buffer are captured, writes from other worker threads into the
+            // mapped memory are missed.
+            static thread_local ThreadMapCounter* _threadMapCounter;
+
+            // Counts a mapping against the current thread, the returned counter is passed to UntrackThreadMap when the
+            // mapping ends, whichever thread unmaps it.
+            static ThreadMapCounter* TrackThreadMap();
+            static void UntrackThreadMap(ThreadMapCounter* counter);
+
+            // Copies smaller than a single 32-bit constant can't carry shader constant data
+            static constexpr size_t MinTrackedCopySize = sizeof(uint32_t);
+
         private:
             bool HookStatic(sig_memcpy** original, sig_memcpy* detour);
             bool HookDynamic(sig_memcpy** original, sig_memcpy* detour);
 
+            static std::mutex _threadMapCounterMutex;
+            static std::vector<std::unique_ptr<ThreadMapCounter>> _threadMapCounters;
+
             static sig_memcpy* org_memcpy;
             static void* __fastcall detour_memcpy(void* dest, void* src, size_t size);
         };
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "ConstantCopyMemcpyNested.h"
 
 using namespace Shim::Constants;
@@ -11,18 +12,40 @@ ConstantCopyMemcpyNested::ConstantCopyMemcpyNested()
 
 ConstantCopyMemcpyNested::~ConstantCopyMemcpyNested()
 {
-
+    delete _intervalIndex.exchange(nullptr);
 }
 
 void ConstantCopyMemcpyNested::OnMapBufferRegion(device* device, resource resource, uint64_t offset, uint64_t size, map_access access, void** data)
 {
+    if (interestSetEnabled && !hostConstantBuffers.Contains(resource.handle))
+    {
+        return;
+    }
+
     if (access == map_access::write_discard || access == map_access::write_only)
     {
         resource_desc desc = device->get_resource_desc(resource);
         if (desc.heap == memory_heap::cpu_to_gpu && static_cast<uint32_t>(desc.usage & resource_usage::constant_buffer))
         {
-            unique_lock<shared_mutex> lock(_map_mutex);
-            _resourceMemoryMapping[resource.handle] = BufferCopy{ resource.handle, *data, nullptr, offset, size, desc.buffer.size };
+            SeedHostConstantBuffer(resource.handle, access, *data, offset, size);
+
+            BufferCopy buffer{ resource.handle, *data, offset, size, desc.buffer.size };
+            const uintptr_t start = reinterpret_cast<uintptr_t>(buffer.destination);
+
+            unique_lock<mutex> lock(_map_mutex);
+            const auto& [it, inserted] = _resourceMemoryMapping.try_emplace(resource.handle, buffer);
+            if (!inserted)
+            {
+                // Mapped again without an unmap, possibly by another thread. Drop the previous mapping.
+                EraseInterval(reinterpret_cast<uintptr_t>(it->second.destination), resource.handle);
+                UntrackThreadMap(it->second.mapThread);
+            }
+
+            it->second = buffer;
+            it->second.mapThread = TrackThreadMap();
+
+            InsertInterval(MappedInterval{ start, start + buffer.bufferSize - buffer.offset, buffer.resource, buffer.bufferSize });
+            PublishIntervalIndex();
         }
     }
 }
@@ -33,23 +56,113 @@ void ConstantCopyMemcpyNested::OnUnmapBufferRegion(device* device, resource reso
     resource_desc desc = device->get_resource_desc(resource);
     if (desc.heap == memory_heap::cpu_to_gpu && static_cast<uint32_t>(desc.usage & resource_usage::constant_buffer))
     {
-        unique_lock<shared_mutex> lock(_map_mutex);
-        _resourceMemoryMapping.erase(resource.handle);
+        unique_lock<mutex> lock(_map_mutex);
+        const auto& it = _resourceMemoryMapping.find(resource.handle);
+        if (it != _resourceMemoryMapping.end())
+        {
+            EraseInterval(reinterpret_cast<uintptr_t>(it->second.destination), resource.handle);
+            UntrackThreadMap(it->second.mapThread);
+            _resourceMemoryMapping.erase(it);
+
+            PublishIntervalIndex();
+        }
     }
 }
 
-void ConstantCopyMemcpyNested::OnMemcpy(void* volatile dest, void* src, size_t size)
+void ConstantCopyMemcpyNested::OnPresent()
+{
+    ConstantCopyBase::OnPresent();
+
+    unique_lock<mutex> lock(_map_mutex);
+
+    _frame++;
+
+    // Any memcpy that loaded a retired index has long returned by now
+    std::erase_if(_retiredIndices, [&](const auto& retired) { return retired.first + IndexRetireFrames <= _frame; });
+}
+
+bool ConstantCopyMemcpyNested::IsBufferMapped(uint64_t handle)
+{
+    unique_lock<mutex> lock(_map_mutex);
+    return _resourceMemoryMapping.contains(handle);
+}
+
+void ConstantCopyMemcpyNested::InsertInterval(const MappedInterval& interval)
 {
-    shared_lock<shared_mutex> lock(_map_mutex);
-    if (_resourceMemoryMapping.size() > 0)
+    // Called with _map_mutex held
+    auto it = std::upper_bound(_intervals.begin(), _intervals.end(), interval.start, [](uintptr_t start, const MappedInterval& other) { return start < other.start; });
+    _intervals.insert(it, interval);
+}
+
+void ConstantCopyMemcpyNested::EraseInterval(uintptr_t start, uint64_t resource)
+{
+    // Called with _map_mutex held
+    auto it = std::lower_bound(_intervals.begin(), _intervals.end(), start, [](const MappedInterval& other, uintptr_t start) { return other.start < start; });
+
+    for (; it != _intervals.end() && it->start == start; it++)
     {
-        for (auto& [_,buffer] : _resourceMemoryMapping)
+        if (it->resource == resource)
         {
-            if (dest >= buffer.destination && static_cast<uintptr_t>(reinterpret_cast<intptr_t>(dest)) <= reinterpret_cast<intptr_t>(buffer.destination) + buffer.bufferSize - buffer.offset)
-            {
-                SetHostConstantBuffer(buffer.resource, src, size, reinterpret_cast<intptr_t>(dest) - reinterpret_cast<intptr_t>(buffer.destination), buffer.bufferSize);
-                break;
-            }
+            _intervals.erase(it);
+            return;
+        }
+    }
+}
+
+void ConstantCopyMemcpyNested::PublishIntervalIndex()
+{
+    // Called with _map_mutex held
+    uintptr_t minAddress = UINTPTR_MAX;
+    uintptr_t maxAddress = 0;
+
+    if (!_intervals.empty())
+    {
+        minAddress = _intervals.front().start;
+
+        for (const auto& interval : _intervals)
+        {
+            maxAddress = std::max(maxAddress, interval.end);
         }
     }
-}
\ No newline at end of file
+
+    const IntervalIndex* previous = _intervalIndex.exchange(new IntervalIndex(_intervals), std::memory_order_acq_rel);
+    if (previous != nullptr)
+    {
+        _retiredIndices.emplace_back(_frame, previous);
+    }
+
+    // The index is published before the bounds are widened so a memcpy passing the range check always finds its region
+    _intervalMin.store(minAddress, std::memory_order_release);
+    _intervalMax.store(maxAddress, std::memory_order_release);
+}
+
+void ConstantCopyMemcpyNested::OnMemcpy(void* volatile dest, void* src, size_t size)
+{
+    const uintptr_t address = reinterpret_cast<uintptr_t>(dest);
+
+    // Reject the vast majority of memcpy calls with a single range check
+    if (address < _intervalMin.load(std::memory_order_acquire) || address >= _intervalMax.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    const IntervalIndex* index = _intervalIndex.load(std::memory_order_acquire);
+    if (index == nullptr || index->empty())
+    {
+        return;
+    }
+
+    // First interval starting after dest, the candidate is the one before it
+    auto it = std::upper_bound(index->begin(), index->end(), address, [](uintptr_t addr, const MappedInterval& interval) { return addr < interval.start; });
+
+    if (it == index->begin())
+    {
+        return;
+    }
+
+    const MappedInterval& interval = *std::prev(it);
+    if (address < interval.end)
+    {
+        SetHostConstantBuffer(interval.resource, src, size, address - interval.start, interval.bufferSize);
+    }
+}
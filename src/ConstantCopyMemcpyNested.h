@@ -1,10 +1,21 @@
 #pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "ConstantCopyMemcpy.h"
 
 namespace Shim
 {
     namespace Constants
     {
+        struct MappedInterval
+        {
+            uintptr_t start = 0;
+            uintptr_t end = 0;      // exclusive
+            uint64_t resource = 0;
+            uint64_t bufferSize = 0;
+        };
+
         class ConstantCopyMemcpyNested final : public virtual ConstantCopyMemcpy {
         public:
             ConstantCopyMemcpyNested();
@@ -13,9 +24,30 @@ namespace Shim
             void OnMemcpy(void* dest, void* src, size_t size) override final;
             void OnMapBufferRegion(reshade::api::device * device, reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** data) override final;
             void OnUnmapBufferRegion(reshade::api::device* device, reshade::api::resource resource) override final;
+            void OnPresent() override final;
+        protected:
+            bool IsBufferMapped(uint64_t handle) override final;
         private:
+            // Immutable snapshot of all mapped regions, sorted by start address. A new snapshot is published on every map/unmap
+            // so the memcpy detour never has to take _map_mutex, replaced snapshots are freed a few presents later.
+            using IntervalIndex = std::vector<MappedInterval>;
+
+            static constexpr uint64_t IndexRetireFrames = 3;
+
+            void InsertInterval(const MappedInterval& interval);
+            void EraseInterval(uintptr_t start, uint64_t resource);
+            void PublishIntervalIndex();
+
             std::unordered_map<uint64_t, BufferCopy> _resourceMemoryMapping;
-            std::shared_mutex _map_mutex;
+            // Sorted master copy of the published index
+            std::vector<MappedInterval> _intervals;
+            std::vector<std::pair<uint64_t, std::unique_ptr<const IntervalIndex>>> _retiredIndices;
+            uint64_t _frame = 0;
+            std::mutex _map_mutex;
+
+            std::atomic<const IntervalIndex*> _intervalIndex = nullptr;
+            std::atomic<uintptr_t> _intervalMin = UINTPTR_MAX;
+            std::atomic<uintptr_t> _intervalMax = 0;
         };
     }
-}
\ No newline at end of file
+}
@@ -18,27 +18,50 @@ void ConstantCopyMemcpySingular::OnMapBufferRegion(device* device, resource reso
     if (access == map_access::write_discard || access == map_access::write_only)
     {
         resource_desc desc = device->get_resource_desc(resource);
-        const auto& it = deviceToHostConstantBuffer.find(resource.handle);
-
-        if (it != deviceToHostConstantBuffer.end())
+        // Only the handle is kept, writes go through the store so they're clamped to the host buffer under its shard lock
+        if (hostConstantBuffers.Contains(resource.handle))
         {
-            auto& [_, buf] = *it;
+            // A mapping still active, possibly on another thread, is replaced by this one
+            SeedHostConstantBuffer(resource.handle, access, *data, offset, size);
+
+            UntrackThreadMap(_bufferCopy.mapThread);
+            _bufferCopy.mapThread = TrackThreadMap();
+
             _bufferCopy.resource = resource.handle;
             _bufferCopy.destination = *data;
             _bufferCopy.size = size;
             _bufferCopy.offset = offset;
             _bufferCopy.bufferSize = desc.buffer.size;
-            _bufferCopy.hostDestination = buf.data();
         }
     }
 }
 
 void ConstantCopyMemcpySingular::OnUnmapBufferRegion(device* device, resource resource)
 {
+    UntrackThreadMap(_bufferCopy.mapThread);
+    _bufferCopy.mapThread = nullptr;
+
     _bufferCopy.resource = 0;
     _bufferCopy.destination = nullptr;
 }
 
+void ConstantCopyMemcpySingular::DeleteHostConstantBuffer(resource resource)
+{
+    ConstantCopyBase::DeleteHostConstantBuffer(resource);
+
+    // Stop capturing into the deleted buffer, the thread counter stays tracked until the game unmaps
+    if (_bufferCopy.resource == resource.handle)
+    {
+        _bufferCopy.resource = 0;
+        _bufferCopy.destination = nullptr;
+    }
+}
+
+bool ConstantCopyMemcpySingular::IsBufferMapped(uint64_t handle)
+{
+    return _bufferCopy.resource == handle;
+}
+
 void ConstantCopyMemcpySingular::OnMemcpy(void* dest, void* src, size_t size)
 {
     uintptr_t destPtr = reinterpret_cast<uintptr_t>(dest);
@@ -46,8 +69,8 @@ void ConstantCopyMemcpySingular::OnMemcpy(void* dest, void* src, size_t size)
 
     if (_bufferCopy.resource != 0 &&
         destPtr >= destinationPtr &&
-        destPtr <= destinationPtr + _bufferCopy.bufferSize - _bufferCopy.offset)
+        destPtr < destinationPtr + _bufferCopy.bufferSize - _bufferCopy.offset)
     {
-        memcpy(_bufferCopy.hostDestination, src, size);
+        SetHostConstantBuffer(_bufferCopy.resource, src, size, destPtr - destinationPtr, _bufferCopy.bufferSize);
     }
 }
\ No newline at end of file
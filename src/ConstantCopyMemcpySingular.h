@@ -13,6 +13,9 @@ namespace Shim
             void OnMemcpy(void* dest, void* src, size_t size) override final;
             void OnMapBufferRegion(reshade::api::device* device, reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** data) override final;
             void OnUnmapBufferRegion(reshade::api::device* device, reshade::api::resource resource) override final;
+            void DeleteHostConstantBuffer(reshade::api::resource resource) override final;
+        protected:
+            bool IsBufferMapped(uint64_t handle) override final;
         private:
             static BufferCopy _bufferCopy;
         };
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cstring>
+#include "ConstantCopyPersistentMap.h"
+
+using namespace Shim::Constants;
+using namespace reshade::api;
+using namespace std;
+
+ConstantCopyPersistentMap::ConstantCopyPersistentMap()
+{
+}
+
+ConstantCopyPersistentMap::~ConstantCopyPersistentMap()
+{
+}
+
+void ConstantCopyPersistentMap::OnMapBufferRegion(device* device, resource resource, uint64_t offset, uint64_t size, map_access access, void** data)
+{
+    if (data == nullptr || *data == nullptr || access == map_access::read_only)
+    {
+        return;
+    }
+
+    resource_desc desc = device->get_resource_desc(resource);
+    if (desc.type != resource_type::buffer || desc.heap != memory_heap::cpu_to_gpu || offset >= desc.buffer.size)
+    {
+        return;
+    }
+
+    unique_lock<shared_mutex> lock(_mappedMutex);
+    PersistentMapping& mapping = _mappedBuffers[resource.handle];
+    mapping.size = desc.buffer.size;
+    mapping.windows.clear();
+
+    if (device->get_api() == device_api::d3d12)
+    {
+        // Upload heaps stay mapped at a fixed address, so the mapping is tracked relative to the start of the buffer
+        mapping.base = static_cast<const uint8_t*>(*data) - offset;
+    }
+    else
+    {
+        mapping.mapped = static_cast<const uint8_t*>(*data);
+        mapping.mapOffset = offset;
+        mapping.mapSize = size == UINT64_MAX ? desc.buffer.size - offset : std::min(size, desc.buffer.size - offset);
+    }
+}
+
+void ConstantCopyPersistentMap::OnUnmapBufferRegion(device* device, resource resource)
+{
+    unique_lock<shared_mutex> lock(_mappedMutex);
+
+    const auto& it = _mappedBuffers.find(resource.handle);
+    if (it == _mappedBuffers.end())
+    {
+        return;
+    }
+
+    PersistentMapping& mapping = it->second;
+
+    if (mapping.mapped != nullptr)
+    {
+        // The game is done writing, take a single copy of the range it mapped
+        mapping.snapshot.resize(static_cast<size_t>(mapping.size), 0);
+        memcpy(mapping.snapshot.data() + mapping.mapOffset, mapping.mapped, static_cast<size_t>(mapping.mapSize));
+        mapping.mapped = nullptr;
+        mapping.windows.clear();
+    }
+    else
+    {
+        _mappedBuffers.erase(it);
+    }
+}
+
+void ConstantCopyPersistentMap::OnDestroyResource(device* device, resource res)
+{
+    unique_lock<shared_mutex> lock(_mappedMutex);
+    _mappedBuffers.erase(res.handle);
+}
+
+void ConstantCopyPersistentMap::OnPresent()
+{
+    ConstantCopyBase::OnPresent();
+
+    const uint64_t frame = interestFrame.load(std::memory_order_relaxed);
+
+    unique_lock<shared_mutex> lock(_mappedMutex);
+    for (auto& [_, mapping] : _mappedBuffers)
+    {
+        std::erase_if(mapping.windows, [&](const auto& window) { return frame - window.second.frame > WindowRetireFrames; });
+    }
+}
+
+size_t ConstantCopyPersistentMap::GetConstantBufferRangeSize(device* dev, buffer_range range)
+{
+    const uint64_t bufferSize = dev->get_resource_desc(range.buffer).buffer.size;
+
+    if (range.offset >= bufferSize)
+    {
+        return 0;
+    }
+
+    uint64_t size = range.size == UINT64_MAX ? bufferSize - range.offset : range.size;
+    size = (size + ConstantWindowAlignment - 1) & ~(ConstantWindowAlignment - 1);
+
+    return static_cast<size_t>(std::min(size, bufferSize - range.offset));
+}
+
+void ConstantCopyPersistentMap::GetHostConstantBuffer(command_list* cmd_list, ShaderToggler::ToggleGroup* group, vector<uint8_t>& dest, size_t size, uint64_t resourceHandle)
+{
+    GetHostConstantBufferRange(cmd_list, group, dest, size, buffer_range{ resource{ resourceHandle }, 0, UINT64_MAX });
+}
+
+void ConstantCopyPersistentMap::CopyWindow(const PersistentMapping& mapping, uint64_t offset, vector<uint8_t>& dest, size_t size)
+{
+    const size_t windowSize = static_cast<size_t>(std::min<uint64_t>(size, mapping.size - offset));
+    dest.resize(windowSize, 0);
+
+    if (mapping.base != nullptr)
+    {
+        memcpy(dest.data(), mapping.base + offset, windowSize);
+    }
+    else if (!mapping.snapshot.empty())
+    {
+        memcpy(dest.data(), mapping.snapshot.data() + offset, windowSize);
+    }
+}
+
+void ConstantCopyPersistentMap::GetHostConstantBufferRange(command_list* cmd_list, ShaderToggler::ToggleGroup* group, vector<uint8_t>& dest, size_t size, buffer_range range)
+{
+    const uint64_t frame = interestFrame.load(std::memory_order_relaxed);
+
+    {
+        shared_lock<shared_mutex> lock(_mappedMutex);
+
+        const auto& it = _mappedBuffers.find(range.buffer.handle);
+        if (it == _mappedBuffers.end() || range.offset >= it->second.size)
+        {
+            return;
+        }
+
+        const PersistentMapping& mapping = it->second;
+        const auto& window = mapping.windows.find(range.offset);
+        const size_t windowSize = static_cast<size_t>(std::min<uint64_t>(size, mapping.size - range.offset));
+        if (mapping.base == nullptr || (window != mapping.windows.end() && window->second.frame == frame && window->second.data.size() >= windowSize))
+        {
+            // Unmapped buffers are read from their snapshot, which is host memory
+            const vector<uint8_t>& source = mapping.base == nullptr ? mapping.snapshot : window->second.data;
+            const size_t sourceOffset = mapping.base == nullptr ? static_cast<size_t>(range.offset) : 0;
+
+            if (source.size() > sourceOffset)
+            {
+                memcpy(dest.data(), source.data() + sourceOffset, std::min({ size, dest.size(), source.size() - sourceOffset }));
+            }
+
+            return;
+        }
+    }
+
+    // First read of this window in the current frame, copy it out of upload memory once
+    unique_lock<shared_mutex> lock(_mappedMutex);
+
+    const auto& it = _mappedBuffers.find(range.buffer.handle);
+    if (it == _mappedBuffers.end() || range.offset >= it->second.size)
+    {
+        return;
+    }
+
+    PersistentWindow& window = it->second.windows[range.offset];
+    if (window.frame != frame || window.data.size() < std::min<uint64_t>(size, it->second.size - range.offset))
+    {
+        CopyWindow(it->second, range.offset, window.data, size);
+        window.frame = frame;
+    }
+
+    memcpy(dest.data(), window.data.data(), std::min({ size, dest.size(), window.data.size() }));
+}
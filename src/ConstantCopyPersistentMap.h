@@ -0,0 +1,73 @@
+#pragma once
+
+#include <reshade_api.hpp>
+#include <reshade_api_device.hpp>
+#include <reshade_api_pipeline.hpp>
+#include <unordered_map>
+#include <vector>
+#include <shared_mutex>
+#include "ConstantCopyBase.h"
+
+namespace Shim
+{
+    namespace Constants
+    {
+        // Copy of a constant window read from upload memory, reused by every draw of the same frame
+        struct PersistentWindow
+        {
+            std::vector<uint8_t> data;
+            uint64_t frame = 0;
+        };
+
+        struct PersistentMapping
+        {
+            const uint8_t* base = nullptr;          // start of the buffer while persistently mapped (D3D12 only)
+            const uint8_t* mapped = nullptr;        // start of the mapped range while a non-persistent map is open
+            uint64_t mapOffset = 0;
+            uint64_t mapSize = 0;
+            uint64_t size = 0;
+            std::vector<uint8_t> snapshot;          // buffer contents as of the last unmap
+            std::unordered_map<uint64_t, PersistentWindow> windows;
+        };
+
+        // Reads constants straight from persistently mapped upload buffers (common in D3D12 titles which sub-allocate
+        // constant data from one large upload heap). Only the window referenced by the bound buffer_range is read, and
+        // only once per frame since upload memory is write-combined. Other APIs don't guarantee the mapped pointer can be
+        // rebased to the start of the buffer, there the mapped range is copied once when the game unmaps it.
+        class ConstantCopyPersistentMap final : public virtual ConstantCopyBase {
+        public:
+            ConstantCopyPersistentMap();
+            ~ConstantCopyPersistentMap();
+
+            bool Init() override final { return true; };
+            bool UnInit() override final { return true; };
+
+            void GetHostConstantBuffer(reshade::api::command_list* cmd_list, ShaderToggler::ToggleGroup* group, std::vector<uint8_t>& dest, size_t size, uint64_t resourceHandle) override final;
+            void GetHostConstantBufferRange(reshade::api::command_list* cmd_list, ShaderToggler::ToggleGroup* group, std::vector<uint8_t>& dest, size_t size, reshade::api::buffer_range range) override final;
+            size_t GetConstantBufferRangeSize(reshade::api::device* dev, reshade::api::buffer_range range) override final;
+            void CreateHostConstantBuffer(reshade::api::device* dev, reshade::api::resource resource, size_t size) override final {};
+            void DeleteHostConstantBuffer(reshade::api::resource resource) override final {};
+            void SetHostConstantBuffer(const uint64_t handle, const void* buffer, size_t size, uintptr_t offset, uint64_t bufferSize) override final {};
+
+            void OnInitResource(reshade::api::device* device, const reshade::api::resource_desc& desc, const reshade::api::subresource_data* initData, reshade::api::resource_usage usage, reshade::api::resource handle) override final {};
+            void OnDestroyResource(reshade::api::device* device, reshade::api::resource res) override final;
+
+            void OnUpdateBufferRegion(reshade::api::device* device, const void* data, reshade::api::resource resource, uint64_t offset, uint64_t size) override final {};
+            void OnMapBufferRegion(reshade::api::device* device, reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** data) override final;
+            void OnUnmapBufferRegion(reshade::api::device* device, reshade::api::resource resource) override final;
+            void OnBufferInterest(reshade::api::device* device, reshade::api::resource resource, size_t size) override final {};
+            void OnPresent() override final;
+
+        private:
+            // D3D12 requires constant buffer views to be 256 byte aligned
+            static constexpr uint64_t ConstantWindowAlignment = 256;
+            // Windows not read for this many presents are released
+            static constexpr uint64_t WindowRetireFrames = 60;
+
+            static void CopyWindow(const PersistentMapping& mapping, uint64_t offset, std::vector<uint8_t>& dest, size_t size);
+
+            std::unordered_map<uint64_t, PersistentMapping> _mappedBuffers;
+            std::shared_mutex _mappedMutex;
+        };
+    }
+}
@@ -2,6 +2,7 @@
 #include "ConstantHandlerBase.h"
 #include "PipelinePrivateData.h"
 #include "StateTracking.h"
+#include "Profiling.h"
 
 using namespace Shim::Constants;
 using namespace reshade::api;
@@ -313,6 +314,8 @@ void ConstantHandlerBase::UpdateConstants(command_list* cmd_list)
 void ConstantHandlerBase::ApplyConstantValues(effect_runtime* runtime, const ToggleGroup* group,
     const unordered_map<string, tuple<constant_type, vector<effect_uniform_variable>>>& constants)
 {
+    PROFILE_EVENT(EVENT_APPLY_CONSTANTS);
+
     unique_lock<shared_mutex> lock(varMutex);
 
     if (!groupBufferContent.contains(group) || runtime == nullptr)
@@ -370,13 +373,15 @@ void ConstantHandlerBase::SetConstants(const ToggleGroup* group, const vector<ui
         return;
     }
 
-    InitBuffers(group, buf.size());
+    const size_t size = buf.size() * sizeof(uint32_t);
+
+    InitBuffers(group, size);
 
     vector<uint8_t>& bufferContent = groupBufferContent.at(group);
     vector<uint8_t>& prevBufferContent = groupPrevBufferContent.at(group);
 
-    std::memcpy(prevBufferContent.data(), bufferContent.data(), buf.size());
-    std::memcpy(bufferContent.data(), reinterpret_cast<const uint8_t*>(buf.data()), buf.size() * 4);
+    std::memcpy(prevBufferContent.data(), bufferContent.data(), size);
+    std::memcpy(bufferContent.data(), reinterpret_cast<const uint8_t*>(buf.data()), size);
 }
 
 void ConstantHandlerBase::SetBufferRange(ToggleGroup* group, buffer_range range, device* dev, command_list* cmd_list)
@@ -386,8 +391,14 @@ void ConstantHandlerBase::SetBufferRange(ToggleGroup* group, buffer_range range,
         return;
     }
 
-    resource_desc targetBufferDesc = dev->get_resource_desc(range.buffer);
-    size_t size = static_cast<size_t>(targetBufferDesc.buffer.size);
+    size_t size = _constCopy->GetConstantBufferRangeSize(dev, range);
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    _constCopy->OnBufferInterest(dev, range.buffer, size);
 
     InitBuffers(group, size);
 
@@ -395,7 +406,7 @@ void ConstantHandlerBase::SetBufferRange(ToggleGroup* group, buffer_range range,
     vector<uint8_t>& prevBufferContent = groupPrevBufferContent.at(group);
 
     std::memcpy(prevBufferContent.data(), bufferContent.data(), size);
-    _constCopy->GetHostConstantBuffer(cmd_list, group, bufferContent, size, range.buffer.handle);
+    _constCopy->GetHostConstantBufferRange(cmd_list, group, bufferContent, size, range);
 }
 
 void ConstantHandlerBase::InitBuffers(const ToggleGroup* group, size_t size)
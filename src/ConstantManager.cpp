@@ -5,6 +5,7 @@
 #include "ConstantCopyFFXIV.h"
 #include "ConstantCopyNierReplicant.h"
 #include "ConstantCopyGPUReadback.h"
+#include "ConstantCopyPersistentMap.h"
 
 using namespace Shim::Constants;
 using namespace std;
@@ -23,6 +24,8 @@ ConstantCopyType ConstantManager::ResolveConstantCopyType(const string& ctype)
         return ConstantCopyType::Copy_NierReplicant;
     else if (ctype == "gpu_readback")
         return ConstantCopyType::Copy_GPUReadback;
+    else if (ctype == "persistent_map")
+        return ConstantCopyType::Copy_PersistentMap;
     
     return ConstantCopyType::Copy_None;
 }
@@ -77,10 +80,18 @@ bool ConstantManager::Init(AddonImGui::AddonUIData& data, Rendering::ToggleGroup
         *constantCopy = &constantTypeGPUReadback;
     }
         break;
+    case ConstantCopyType::Copy_PersistentMap:
+    {
+        static ConstantCopyPersistentMap constantTypePersistentMap;
+        *constantCopy = &constantTypePersistentMap;
+    }
+        break;
     default:
         *constantCopy = nullptr;
     }
 
+    ConstantCopyBase::SetInterestSet(data.GetConstBufferInterestSet(), static_cast<uint32_t>(*data.ConstBufferInterestFrames()));
+
     if (*constantCopy != nullptr && (*constantCopy)->Init())
     {
         // No need for separate ones for now
@@ -17,6 +17,7 @@ namespace Shim
             Copy_FFXIV,
             Copy_NierReplicant,
             Copy_GPUReadback,
+            Copy_PersistentMap,
         };
 
         static const std::vector<std::string> ConstantCopyTypeNames = {
@@ -25,7 +26,8 @@ namespace Shim
             "ffxiv",
             "nier_replicant",
             "memcpy_singular",
-            "memcpy_nested"
+            "memcpy_nested",
+            "persistent_map"
         };
 
         enum ConstantHandlerType
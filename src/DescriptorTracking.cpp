@@ -6,6 +6,8 @@
 #include <algorithm>
 #include "reshade.hpp"
 #include "DescriptorTracking.h"
+#include "Profiling.h"
+#include "TraceCapture.h"
 
 using namespace reshade::api;
 
@@ -119,12 +121,16 @@ void descriptor_tracking::on_destroy_pipeline_layout(device* device, pipeline_la
 
 bool descriptor_tracking::on_copy_descriptor_tables(device* device, uint32_t count, const descriptor_table_copy* copies)
 {
+    PROFILE_EVENT(EVENT_COPY_DESCRIPTOR_TABLES);
+
     descriptor_tracking& ctx = device->get_private_data<descriptor_tracking>();
 
     for (uint32_t i = 0; i < count; ++i)
     {
         const descriptor_table_copy& copy = copies[i];
 
+        Profiling::TraceCapture::Record("copy_descriptor_tables", "src={:x} src_binding={} dst={:x} dst_binding={} count={}", copy.source_table.handle, copy.source_binding, copy.dest_table.handle, copy.dest_binding, copy.count);
+
         uint32_t src_offset;
         descriptor_heap src_heap;
         device->get_descriptor_heap_offset(copy.source_table, copy.source_binding, copy.source_array_offset, &src_heap, &src_offset);
@@ -150,12 +156,16 @@ bool descriptor_tracking::on_copy_descriptor_tables(device* device, uint32_t cou
 
 bool descriptor_tracking::on_update_descriptor_tables(device* device, uint32_t count, const descriptor_table_update* updates)
 {
+    PROFILE_EVENT(EVENT_UPDATE_DESCRIPTOR_TABLES);
+
     descriptor_tracking& ctx = device->get_private_data<descriptor_tracking>();
 
     for (uint32_t i = 0; i < count; ++i)
     {
         const descriptor_table_update& update = updates[i];
 
+        Profiling::TraceCapture::Record("update_descriptor_tables", "table={:x} binding={} offset={} count={} type={}", update.table.handle, update.binding, update.array_offset, update.count, static_cast<uint32_t>(update.type));
+
         uint32_t offset;
         descriptor_heap heap;
         device->get_descriptor_heap_offset(update.table, update.binding, update.array_offset, &heap, &offset);
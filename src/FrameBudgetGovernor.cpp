@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <format>
+#include <sstream>
+#include "FrameBudgetGovernor.h"
+
+using namespace Rendering;
+using namespace std;
+
+FrameBudgetGovernor::FrameBudgetGovernor(AddonImGui::AddonUIData& data) : uiData(data)
+{
+    // Constructed during static initialization, before GovernedFeatureNames and the config are guaranteed to be
+    // there, so start in the default order. The configured order is parsed on the first present.
+    for (uint32_t i = 0; i < FEATURE_COUNT; i++)
+    {
+        _priority.push_back(static_cast<GovernedFeature>(i));
+    }
+}
+
+FrameBudgetGovernor::~FrameBudgetGovernor()
+{
+
+}
+
+void FrameBudgetGovernor::ParsePriority(const string& priority)
+{
+    _priority.clear();
+
+    stringstream stream(priority);
+    string name;
+    while (getline(stream, name, ','))
+    {
+        for (uint32_t i = 0; i < FEATURE_COUNT; i++)
+        {
+            const GovernedFeature feature = static_cast<GovernedFeature>(i);
+            if (name == GovernedFeatureNames[i] && std::find(_priority.begin(), _priority.end(), feature) == _priority.end())
+            {
+                _priority.push_back(feature);
+            }
+        }
+    }
+
+    // Features missing in the configured order are shed last, in their default order
+    for (uint32_t i = 0; i < FEATURE_COUNT; i++)
+    {
+        const GovernedFeature feature = static_cast<GovernedFeature>(i);
+        if (std::find(_priority.begin(), _priority.end(), feature) == _priority.end())
+        {
+            _priority.push_back(feature);
+        }
+    }
+
+    _parsedPriority = priority;
+}
+
+void FrameBudgetGovernor::LogDecision(const string& decision)
+{
+    reshade::log_message(reshade::log_level::info, decision.c_str());
+
+    unique_lock<mutex> lock(_logMutex);
+    _decisionLog.push_front(decision);
+    if (_decisionLog.size() > DecisionLogSize)
+    {
+        _decisionLog.pop_back();
+    }
+}
+
+vector<string> FrameBudgetGovernor::GetDecisionLog()
+{
+    unique_lock<mutex> lock(_logMutex);
+    return vector<string>(_decisionLog.begin(), _decisionLog.end());
+}
+
+void FrameBudgetGovernor::ApplyShedLevel(uint32_t level, const string& reason)
+{
+    level = std::min(level, static_cast<uint32_t>(FEATURE_COUNT));
+
+    if (level == _shedLevel)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < FEATURE_COUNT; i++)
+    {
+        _shed[_priority[i]].store(i < level, std::memory_order_relaxed);
+    }
+
+    if (level > _shedLevel)
+    {
+        LogDecision(std::format("Frame budget governor: shedding '{}' ({})", GovernedFeatureNames[_priority[level - 1]], reason));
+    }
+    else
+    {
+        LogDecision(std::format("Frame budget governor: restoring '{}' ({})", GovernedFeatureNames[_priority[level]], reason));
+    }
+
+    _shedLevel = level;
+}
+
+void FrameBudgetGovernor::OnReshadePresent()
+{
+    const auto now = chrono::steady_clock::now();
+    const float frameTimeMs = _lastPresent.time_since_epoch().count() > 0 ? chrono::duration<float, milli>(now - _lastPresent).count() : 0.0f;
+    _lastPresent = now;
+    _frame++;
+
+    if (_parsedPriority != uiData.GetGovernorPriority())
+    {
+        ParsePriority(uiData.GetGovernorPriority());
+
+        // Re-apply current level in the new order
+        const uint32_t level = _shedLevel;
+        _shedLevel = 0;
+        for (auto& shed : _shed)
+            shed.store(false, std::memory_order_relaxed);
+        ApplyShedLevel(level, "priority order changed");
+    }
+
+    if (!uiData.GetGovernorEnabled())
+    {
+        ApplyShedLevel(0, "governor disabled");
+        _overBudgetFrames = 0;
+        _underBudgetFrames = 0;
+        return;
+    }
+
+    // Ignore hitches like loading screens or the first frame
+    if (frameTimeMs <= 0.0f || frameTimeMs > 250.0f)
+    {
+        return;
+    }
+
+    _averageFrameTimeMs = _averageFrameTimeMs <= 0.0f ? frameTimeMs : _averageFrameTimeMs * 0.95f + frameTimeMs * 0.05f;
+
+    const float budget = *uiData.GovernorBudgetMs();
+
+    if (_averageFrameTimeMs > budget * 1.05f)
+    {
+        _underBudgetFrames = 0;
+        if (++_overBudgetFrames >= EscalateFrames && _shedLevel < FEATURE_COUNT)
+        {
+            ApplyShedLevel(_shedLevel + 1, std::format("average frame time {:.2f} ms over budget {:.2f} ms", _averageFrameTimeMs, budget));
+            _overBudgetFrames = 0;
+        }
+    }
+    else if (_averageFrameTimeMs < budget * 0.9f)
+    {
+        _overBudgetFrames = 0;
+        if (++_underBudgetFrames >= RelaxFrames && _shedLevel > 0)
+        {
+            ApplyShedLevel(_shedLevel - 1, std::format("average frame time {:.2f} ms within budget {:.2f} ms", _averageFrameTimeMs, budget));
+            _underBudgetFrames = 0;
+        }
+    }
+    else
+    {
+        _overBudgetFrames = 0;
+        _underBudgetFrames = 0;
+    }
+}
+
+bool FrameBudgetGovernor::IsAllowed(GovernedFeature feature) const
+{
+    if (!_shed[feature].load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    // Preview is paused entirely, copies are thinned out to every Nth frame
+    if (feature == FEATURE_PREVIEW)
+    {
+        return false;
+    }
+
+    const uint64_t interval = static_cast<uint64_t>(std::max(*uiData.GovernorShedInterval(), 1));
+    return _frame.load(std::memory_order_relaxed) % interval == 0;
+}
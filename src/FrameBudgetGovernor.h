@@ -0,0 +1,67 @@
+#pragma once
+
+#include <reshade.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AddonUIData.h"
+
+namespace Rendering
+{
+    enum GovernedFeature : uint32_t
+    {
+        FEATURE_PREVIEW = 0,
+        FEATURE_BINDINGS,
+        FEATURE_CONSTANTS,
+        FEATURE_COUNT
+    };
+
+    static const std::vector<std::string> GovernedFeatureNames = {
+        "preview",
+        "bindings",
+        "constants"
+    };
+
+    // Sheds optional addon work in a configurable order when the measured frame time exceeds the configured budget.
+    class __declspec(novtable) FrameBudgetGovernor final
+    {
+    public:
+        FrameBudgetGovernor(AddonImGui::AddonUIData& data);
+        ~FrameBudgetGovernor();
+
+        void OnReshadePresent();
+        bool IsAllowed(GovernedFeature feature) const;
+
+        uint32_t GetShedLevel() const { return _shedLevel; }
+        float GetAverageFrameTime() const { return _averageFrameTimeMs; }
+        bool IsShed(GovernedFeature feature) const { return _shed[feature].load(std::memory_order_relaxed); }
+        std::vector<std::string> GetDecisionLog();
+
+    private:
+        static constexpr uint32_t EscalateFrames = 30;
+        static constexpr uint32_t RelaxFrames = 120;
+        static constexpr size_t DecisionLogSize = 16;
+
+        void ParsePriority(const std::string& priority);
+        void ApplyShedLevel(uint32_t level, const std::string& reason);
+        void LogDecision(const std::string& decision);
+
+        AddonImGui::AddonUIData& uiData;
+        std::chrono::steady_clock::time_point _lastPresent;
+        std::vector<GovernedFeature> _priority;
+        std::string _parsedPriority;
+        std::array<std::atomic_bool, FEATURE_COUNT> _shed = {};
+        std::atomic_uint64_t _frame = 0;
+        uint32_t _shedLevel = 0;
+        uint32_t _overBudgetFrames = 0;
+        uint32_t _underBudgetFrames = 0;
+        float _averageFrameTimeMs = 0.0f;
+
+        std::mutex _logMutex;
+        std::deque<std::string> _decisionLog;
+    };
+}
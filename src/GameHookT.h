@@ -22,8 +22,8 @@ using sig_ffxiv_cbload1 = uint64_t(__fastcall)(uintptr_t param_1, ID3D11DeviceCo
 using sig_ffxiv_memcpy = void(__fastcall)(void* param_1, void* param_2, size_t param_3);
 using sig_nier_replicant_cbload = void(__fastcall)(intptr_t p1, intptr_t* p2, uintptr_t p3);
 using sig_ffxiv_texture_create = void(__fastcall)(uintptr_t*, uintptr_t*);
-using sig_ffxiv_textures_recreate = uintptr_t(__fastcall)(uintptr_t);
-using sig_ffxiv_textures_create = uintptr_t(__fastcall)(uintptr_t);
+using sig_ffxiv_textures_recreate = uintptr_t __fastcall(uintptr_t);
+using sig_ffxiv_textures_create = uintptr_t __fastcall(uintptr_t);
 
 namespace Shim
 {
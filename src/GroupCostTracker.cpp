@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <chrono>
+#include "GroupCostTracker.h"
+#include "PipelinePrivateData.h"
+
+using namespace Rendering;
+using namespace ShaderToggler;
+using namespace reshade::api;
+using namespace std;
+
+bool QueryHeapTimestampBackend::Init(device* device, command_queue* queue, uint32_t count)
+{
+    if (device == nullptr || queue == nullptr)
+    {
+        return false;
+    }
+
+    _frequency = queue->get_timestamp_frequency();
+    if (_frequency == 0)
+    {
+        return false;
+    }
+
+    return device->create_query_heap(query_type::timestamp, count, &_heap);
+}
+
+void QueryHeapTimestampBackend::Destroy(device* device)
+{
+    if (device != nullptr && _heap != 0)
+    {
+        device->destroy_query_heap(_heap);
+    }
+
+    _heap = {};
+}
+
+void QueryHeapTimestampBackend::Write(command_list* cmd_list, uint32_t index)
+{
+    cmd_list->end_query(_heap, query_type::timestamp, index);
+}
+
+bool QueryHeapTimestampBackend::Resolve(device* device, uint32_t first, uint32_t count, uint64_t* results)
+{
+    return device->get_query_heap_results(_heap, first, count, results, sizeof(uint64_t));
+}
+
+bool CPUTimestampBackend::Init(device* device, command_queue* queue, uint32_t count)
+{
+    _ticks.assign(count, 0);
+    return true;
+}
+
+void CPUTimestampBackend::Destroy(device* device)
+{
+    _ticks.clear();
+}
+
+void CPUTimestampBackend::Write(command_list* cmd_list, uint32_t index)
+{
+    _ticks[index] = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool CPUTimestampBackend::Resolve(device* device, uint32_t first, uint32_t count, uint64_t* results)
+{
+    if (first + count > _ticks.size())
+    {
+        return false;
+    }
+
+    std::copy_n(_ticks.begin() + first, count, results);
+    return true;
+}
+
+uint64_t CPUTimestampBackend::GetFrequency() const
+{
+    return 1000000000;
+}
+
+GroupCostTracker::GroupCostTracker(AddonImGui::AddonUIData& data) : uiData(data)
+{
+}
+
+GroupCostTracker::~GroupCostTracker()
+{
+
+}
+
+uint32_t GroupCostTracker::Begin(command_list* cmd_list, const ToggleGroup* group, GroupCostScope scope, uint64_t technique)
+{
+    if (!uiData.GetGroupCostTiming() || group == nullptr)
+    {
+        return UINT32_MAX;
+    }
+
+    TimestampBackend* backend = _activeBackend.load(std::memory_order_acquire);
+    if (backend == nullptr || cmd_list->get_device() != _device.load(std::memory_order_relaxed))
+    {
+        return UINT32_MAX;
+    }
+
+    CostTimingChunk& claim = cmd_list->get_private_data<CommandListDataContainer>().costTiming;
+    const uint64_t frame = _frame.load(std::memory_order_acquire);
+
+    if (claim.frame != frame)
+    {
+        const uint32_t chunk = _slots[frame % FramesInFlight].claimed.fetch_add(1, std::memory_order_relaxed);
+
+        claim.frame = frame;
+        claim.chunk = chunk < ChunksPerFrame ? chunk : UINT32_MAX;
+    }
+
+    if (claim.chunk == UINT32_MAX)
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t slotIndex = static_cast<uint32_t>(claim.frame % FramesInFlight);
+    TimestampChunk& chunk = _slots[slotIndex].chunks[claim.chunk];
+    if (chunk.used + 2 > TimestampsPerChunk)
+    {
+        return UINT32_MAX;
+    }
+
+    // Both timestamps are reserved up front so a chunk's used range is always fully written
+    const uint32_t base = slotIndex * TimestampsPerFrame + claim.chunk * TimestampsPerChunk;
+    chunk.scopes.push_back(ScopeRecord{ group->getId(), scope, technique, base + chunk.used, base + chunk.used + 1 });
+    chunk.used += 2;
+
+    backend->Write(cmd_list, chunk.scopes.back().begin);
+
+    // Scopes carry their slot and chunk in case a present on another thread advances the frame in between
+    return (slotIndex << 24) | (claim.chunk << 16) | static_cast<uint32_t>(chunk.scopes.size() - 1);
+}
+
+void GroupCostTracker::End(command_list* cmd_list, uint32_t scope)
+{
+    if (scope == UINT32_MAX)
+    {
+        return;
+    }
+
+    TimestampBackend* backend = _activeBackend.load(std::memory_order_acquire);
+
+    const uint32_t slotIndex = scope >> 24;
+    const uint32_t chunkIndex = (scope >> 16) & 0xFF;
+    const uint32_t scopeIndex = scope & 0xFFFF;
+
+    if (backend == nullptr || slotIndex >= FramesInFlight || chunkIndex >= ChunksPerFrame || scopeIndex >= _slots[slotIndex].chunks[chunkIndex].scopes.size())
+    {
+        return;
+    }
+
+    backend->Write(cmd_list, _slots[slotIndex].chunks[chunkIndex].scopes[scopeIndex].end);
+}
+
+void GroupCostTracker::ResolveSlot(FrameSlot& slot, uint32_t slotIndex)
+{
+    const uint32_t claimed = std::min(slot.claimed.load(std::memory_order_relaxed), ChunksPerFrame);
+
+    if (_backend != nullptr && claimed > 0)
+    {
+        const double tickToMs = 1000.0 / static_cast<double>(_backend->GetFrequency());
+        unordered_map<int, GroupCost> frameCosts;
+        bool resolved = true;
+
+        for (uint32_t c = 0; c < claimed && resolved; c++)
+        {
+            const TimestampChunk& chunk = slot.chunks[c];
+            if (chunk.used == 0)
+            {
+                continue;
+            }
+
+            const uint32_t base = slotIndex * TimestampsPerFrame + c * TimestampsPerChunk;
+            _results.resize(chunk.used);
+
+            if (!_backend->Resolve(_device.load(std::memory_order_relaxed), base, chunk.used, _results.data()))
+            {
+                resolved = false;
+                break;
+            }
+
+            for (const auto& record : chunk.scopes)
+            {
+                const uint64_t begin = _results[record.begin - base];
+                const uint64_t end = _results[record.end - base];
+
+                if (end < begin)
+                {
+                    continue;
+                }
+
+                const float ms = static_cast<float>(static_cast<double>(end - begin) * tickToMs);
+                GroupCost& cost = frameCosts[record.groupId];
+                cost.groupId = record.groupId;
+
+                switch (record.scope)
+                {
+                case SCOPE_GROUP:
+                    cost.totalMs += ms;
+                    break;
+                case SCOPE_TECHNIQUE:
+                    cost.techniqueMs[record.technique] += ms;
+                    break;
+                case SCOPE_ALPHA:
+                    cost.alphaMs += ms;
+                    break;
+                }
+            }
+        }
+
+        if (!resolved)
+        {
+            _droppedFrames++;
+        }
+        else if (_discardFrames == 0)
+        {
+            for (const auto& [groupId, frameCost] : frameCosts)
+            {
+                auto [it, inserted] = _costs.try_emplace(groupId);
+                GroupCostEntry& entry = it->second;
+                const float weight = inserted ? 1.0f : Smoothing;
+
+                entry.cost.groupId = groupId;
+                entry.cost.totalMs += (frameCost.totalMs - entry.cost.totalMs) * weight;
+                entry.cost.alphaMs += (frameCost.alphaMs - entry.cost.alphaMs) * weight;
+
+                for (const auto& [technique, ms] : frameCost.techniqueMs)
+                {
+                    auto [tit, techInserted] = entry.cost.techniqueMs.try_emplace(technique, ms);
+                    if (!techInserted)
+                    {
+                        tit->second += (ms - tit->second) * Smoothing;
+                    }
+                }
+
+                entry.lastFrame = _frame.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (auto& chunk : slot.chunks)
+    {
+        chunk.scopes.clear();
+        chunk.used = 0;
+    }
+
+    slot.claimed.store(0, std::memory_order_relaxed);
+}
+
+void GroupCostTracker::ClearSlots()
+{
+    for (auto& slot : _slots)
+    {
+        for (auto& chunk : slot.chunks)
+        {
+            chunk.scopes.clear();
+            chunk.used = 0;
+        }
+
+        slot.claimed.store(0, std::memory_order_relaxed);
+    }
+
+    // Invalidates the chunks command lists still hold from before
+    _frame.fetch_add(1, std::memory_order_release);
+}
+
+void GroupCostTracker::Reset(device* device)
+{
+    _activeBackend.store(nullptr, std::memory_order_release);
+
+    if (_backend != nullptr)
+    {
+        _backend->Destroy(device);
+        _backend.reset();
+    }
+
+    _device = nullptr;
+    _costs.clear();
+    _discardFrames = 0;
+
+    ClearSlots();
+}
+
+void GroupCostTracker::OnReshadePresent(effect_runtime* runtime)
+{
+    unique_lock<mutex> lock(_mutex);
+
+    _frameBandwidthSaved = _bandwidthSaved.exchange(0, std::memory_order_relaxed);
+
+    if (!uiData.GetGroupCostTiming())
+    {
+        // Only deactivated, command lists on other threads may still be writing timestamps through the backend
+        if (_activeBackend.exchange(nullptr, std::memory_order_acq_rel) != nullptr)
+        {
+            _costs.clear();
+        }
+
+        return;
+    }
+
+    if (_backend == nullptr)
+    {
+        device* device = runtime->get_device();
+        unique_ptr<TimestampBackend> backend = make_unique<QueryHeapTimestampBackend>();
+
+        if (!backend->Init(device, runtime->get_command_queue(), FramesInFlight * TimestampsPerFrame))
+        {
+            reshade::log_message(reshade::log_level::info, "Timestamp queries are not available, timing group effects on the CPU instead");
+
+            backend = make_unique<CPUTimestampBackend>();
+            backend->Init(device, runtime->get_command_queue(), FramesInFlight * TimestampsPerFrame);
+        }
+
+        _backend = std::move(backend);
+        _device = device;
+    }
+
+    if (_activeBackend.load(std::memory_order_relaxed) == nullptr)
+    {
+        // Scopes recorded before timing was turned off are incomplete
+        _discardFrames = FramesInFlight;
+        _activeBackend.store(_backend.get(), std::memory_order_release);
+        return;
+    }
+
+    // The slot about to be reused was recorded FramesInFlight - 1 frames ago. It's resolved before the new frame is
+    // published, so no command list claims chunks in it while it's read.
+    const uint64_t frame = _frame.load(std::memory_order_relaxed) + 1;
+    const uint32_t slotIndex = static_cast<uint32_t>(frame % FramesInFlight);
+
+    ResolveSlot(_slots[slotIndex], slotIndex);
+    _frame.store(frame, std::memory_order_release);
+
+    if (_discardFrames > 0)
+    {
+        _discardFrames--;
+    }
+
+    std::erase_if(_costs, [&](const auto& entry) { return entry.second.lastFrame + ExpiryFrames < frame; });
+}
+
+void GroupCostTracker::OnDestroyDevice(device* device)
+{
+    unique_lock<mutex> lock(_mutex);
+
+    if (device == _device)
+    {
+        Reset(device);
+    }
+}
+
+void GroupCostTracker::OnReshadeReloadedEffects()
+{
+    unique_lock<mutex> lock(_mutex);
+
+    // Technique handles of pending scopes are invalidated by the reload, skip the frames still in flight
+    _costs.clear();
+    _discardFrames = FramesInFlight;
+}
+
+void GroupCostTracker::SetBackend(unique_ptr<TimestampBackend> backend, device* device)
+{
+    unique_lock<mutex> lock(_mutex);
+
+    Reset(_device);
+
+    _backend = std::move(backend);
+    _device = device;
+    _activeBackend.store(_backend.get(), std::memory_order_release);
+}
+
+vector<GroupCost> GroupCostTracker::GetCosts()
+{
+    unique_lock<mutex> lock(_mutex);
+
+    vector<GroupCost> costs;
+    costs.reserve(_costs.size());
+
+    for (const auto& [groupId, entry] : _costs)
+    {
+        costs.push_back(entry.cost);
+    }
+
+    std::sort(costs.begin(), costs.end(), [](const GroupCost& a, const GroupCost& b) { return a.totalMs > b.totalMs; });
+
+    return costs;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <reshade.hpp>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "AddonUIData.h"
+
+namespace Rendering
+{
+    // Source of timestamps for the group cost tracker. Kept abstract so APIs without timestamp queries can fall back to CPU timing.
+    class TimestampBackend {
+    public:
+        virtual ~TimestampBackend() = default;
+
+        virtual bool Init(reshade::api::device* device, reshade::api::command_queue* queue, uint32_t count) = 0;
+        virtual void Destroy(reshade::api::device* device) = 0;
+        virtual void Write(reshade::api::command_list* cmd_list, uint32_t index) = 0;
+        // Copies the ticks of [first, first + count) to results, returns false if they're not available yet
+        virtual bool Resolve(reshade::api::device* device, uint32_t first, uint32_t count, uint64_t* results) = 0;
+        virtual uint64_t GetFrequency() const = 0;
+        virtual bool IsGPU() const = 0;
+    };
+
+    class QueryHeapTimestampBackend final : public virtual TimestampBackend {
+    public:
+        bool Init(reshade::api::device* device, reshade::api::command_queue* queue, uint32_t count) override;
+        void Destroy(reshade::api::device* device) override;
+        void Write(reshade::api::command_list* cmd_list, uint32_t index) override;
+        bool Resolve(reshade::api::device* device, uint32_t first, uint32_t count, uint64_t* results) override;
+        uint64_t GetFrequency() const override { return _frequency; }
+        bool IsGPU() const override { return true; }
+
+    private:
+        reshade::api::query_heap _heap = {};
+        uint64_t _frequency = 0;
+    };
+
+    // Measures when the commands were recorded rather than executed, which still ranks groups by their submission cost
+    class CPUTimestampBackend final : public virtual TimestampBackend {
+    public:
+        bool Init(reshade::api::device* device, reshade::api::command_queue* queue, uint32_t count) override;
+        void Destroy(reshade::api::device* device) override;
+        void Write(reshade::api::command_list* cmd_list, uint32_t index) override;
+        bool Resolve(reshade::api::device* device, uint32_t first, uint32_t count, uint64_t* results) override;
+        uint64_t GetFrequency() const override;
+        bool IsGPU() const override { return false; }
+
+    private:
+        std::vector<uint64_t> _ticks;
+    };
+
+    enum GroupCostScope : uint32_t
+    {
+        SCOPE_GROUP = 0,
+        SCOPE_TECHNIQUE,
+        SCOPE_ALPHA
+    };
+
+    struct GroupCost
+    {
+        int groupId = 0;
+        float totalMs = 0.0f;
+        float alphaMs = 0.0f;
+        std::unordered_map<uint64_t, float> techniqueMs;
+    };
+
+    // Attributes the cost of each group's effect injection to the group and its techniques. Timestamps are resolved
+    // a few frames after they were recorded so reading them never stalls on the GPU.
+    //
+    // Every command list claims its own chunk of the frame's timestamps on its first scope, so Begin/End only touch
+    // data owned by that command list. A command list still recording FramesInFlight presents later loses its scopes.
+    class __declspec(novtable) GroupCostTracker final
+    {
+    public:
+        GroupCostTracker(AddonImGui::AddonUIData& data);
+        ~GroupCostTracker();
+
+        // Returns the scope to pass to End, UINT32_MAX if nothing is being measured
+        uint32_t Begin(reshade::api::command_list* cmd_list, const ShaderToggler::ToggleGroup* group, GroupCostScope scope, uint64_t technique = 0);
+        void End(reshade::api::command_list* cmd_list, uint32_t scope);
+
+        void OnReshadePresent(reshade::api::effect_runtime* runtime);
+        void OnDestroyDevice(reshade::api::device* device);
+        void OnReshadeReloadedEffects();
+
+        // Replaces the backend with an already initialized one, e.g. a fake backend when testing. Not safe while command lists record scopes.
+        void SetBackend(std::unique_ptr<TimestampBackend> backend, reshade::api::device* device);
+
+        bool IsActive() const { return _activeBackend.load(std::memory_order_relaxed) != nullptr; }
+        bool IsGPUTiming() const { const TimestampBackend* backend = _activeBackend.load(std::memory_order_relaxed); return backend != nullptr && backend->IsGPU(); }
+        uint64_t GetDroppedFrames() const { return _droppedFrames; }
+
+        // Estimated memory traffic avoided by the cheaper alpha preservation paths
+        void RecordBandwidthSaved(uint64_t bytes) { _bandwidthSaved.fetch_add(bytes, std::memory_order_relaxed); }
+        uint64_t GetFrameBandwidthSaved() const { return _frameBandwidthSaved; }
+        std::vector<GroupCost> GetCosts();
+
+        static constexpr uint32_t FramesInFlight = 4;
+        static constexpr uint32_t TimestampsPerFrame = 512;
+        static constexpr uint32_t TimestampsPerChunk = 32;
+        static constexpr uint32_t ChunksPerFrame = TimestampsPerFrame / TimestampsPerChunk;
+
+    private:
+        static constexpr float Smoothing = 0.1f;
+        static constexpr uint64_t ExpiryFrames = 300;
+
+        struct ScopeRecord
+        {
+            int groupId;
+            GroupCostScope scope;
+            uint64_t technique;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        // Written only by the command list that claimed it, read at present once its frame is no longer recorded
+        struct TimestampChunk
+        {
+            std::vector<ScopeRecord> scopes;
+            uint32_t used = 0;
+        };
+
+        struct FrameSlot
+        {
+            std::array<TimestampChunk, ChunksPerFrame> chunks;
+            std::atomic_uint32_t claimed = 0;
+        };
+
+        struct GroupCostEntry
+        {
+            GroupCost cost;
+            uint64_t lastFrame = 0;
+        };
+
+        void ResolveSlot(FrameSlot& slot, uint32_t slotIndex);
+        void ClearSlots();
+        void Reset(reshade::api::device* device);
+
+        AddonImGui::AddonUIData& uiData;
+        std::mutex _mutex;
+        std::unique_ptr<TimestampBackend> _backend;
+        std::atomic<TimestampBackend*> _activeBackend = nullptr;
+        std::atomic<reshade::api::device*> _device = nullptr;
+        std::array<FrameSlot, FramesInFlight> _slots;
+        std::atomic_uint64_t _frame = 0;
+        uint32_t _discardFrames = 0;
+        uint64_t _droppedFrames = 0;
+        std::atomic_uint64_t _bandwidthSaved = 0;
+        uint64_t _frameBandwidthSaved = 0;
+        std::vector<uint64_t> _results;
+        std::unordered_map<int, GroupCostEntry> _costs;
+    };
+
+    class __declspec(novtable) GroupCostTimer final
+    {
+    public:
+        GroupCostTimer(GroupCostTracker& tracker, reshade::api::command_list* cmd_list, const ShaderToggler::ToggleGroup* group, GroupCostScope scope, uint64_t technique = 0) :
+            _tracker(tracker), _cmd_list(cmd_list), _scope(tracker.Begin(cmd_list, group, scope, technique))
+        {
+        }
+
+        ~GroupCostTimer()
+        {
+            _tracker.End(_cmd_list, _scope);
+        }
+
+    private:
+        GroupCostTracker& _tracker;
+        reshade::api::command_list* _cmd_list;
+        uint32_t _scope;
+    };
+}
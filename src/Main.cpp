@@ -58,6 +58,10 @@
 #include "TechniqueManager.h"
 #include "StateTracking.h"
 #include "KeyMonitor.h"
+#include "FrameBudgetGovernor.h"
+#include "GroupCostTracker.h"
+#include "TraceCapture.h"
+#include "Profiling.h"
 
 using namespace reshade::api;
 using namespace ShaderToggler;
@@ -84,16 +88,23 @@ static ConstantCopyBase* constantCopy = nullptr;
 static bool constantHandlerHooked = false;
 
 static atomic_uint32_t g_activeCollectorFrameCounter = 0;
+static atomic_uint64_t g_collectionFrame = 0;
+static uint32_t g_collectionFramesElapsed = 0;
+// While new shaders keep showing up, the collection phase is extended to at least this many frames, up to a maximum
+static constexpr uint32_t COLLECTION_EXTEND_FRAMES = 30;
+static constexpr uint32_t COLLECTION_MAX_FRAMES = 3000;
 static AddonUIData g_addonUIData(&g_pixelShaderManager, &g_vertexShaderManager, &g_computeShaderManager, constantHandler, &g_activeCollectorFrameCounter);
 
 static KeyMonitor keyMonitor;
 static Rendering::ResourceManager resourceManager;
 static Rendering::ToggleGroupResourceManager groupResourceManager;
 static Rendering::RenderingShaderManager renderingShaderManager(g_addonUIData, resourceManager);
-static Rendering::RenderingEffectManager renderingEffectManager(g_addonUIData, resourceManager, renderingShaderManager, groupResourceManager);
+static Rendering::GroupCostTracker groupCostTracker(g_addonUIData);
+static Rendering::RenderingEffectManager renderingEffectManager(g_addonUIData, resourceManager, renderingShaderManager, groupResourceManager, groupCostTracker);
 static Rendering::RenderingBindingManager renderingBindingManager(g_addonUIData, resourceManager, groupResourceManager);
 static Rendering::RenderingPreviewManager renderingPreviewManager(g_addonUIData, resourceManager, renderingShaderManager);
-static Rendering::RenderingQueueManager renderingQueueManager(g_addonUIData, resourceManager);
+static Rendering::FrameBudgetGovernor frameBudgetGovernor(g_addonUIData);
+static Rendering::RenderingQueueManager renderingQueueManager(g_addonUIData, resourceManager, frameBudgetGovernor);
 static ShaderToggler::TechniqueManager techniqueManager(keyMonitor);
 
 // TODO: actually implement ability to turn off srgb-view generation
@@ -111,6 +122,8 @@ static uint32_t calculateShaderHash(void* shaderData)
         return 0;
     }
 
+    PROFILE_EVENT(EVENT_SHADER_HASH);
+
     const auto shaderDesc = *static_cast<shader_desc*>(shaderData);
     return compute_crc32(static_cast<const uint8_t*>(shaderDesc.code), shaderDesc.code_size);
 }
@@ -129,6 +142,9 @@ static void onDestroyDevice(device* device)
     renderingBindingManager.DisposeTextureBindings(device);
     resourceManager.OnDestroyDevice(device);
     renderingShaderManager.DestroyShaders(device);
+    groupCostTracker.OnDestroyDevice(device);
+    Profiling::TraceCapture::WaitForFlush();
+    g_addonUIData.StopBackgroundSave();
 
     device->destroy_private_data<DeviceDataContainer>();
 }
@@ -176,6 +192,14 @@ static bool onCreateResource(device* device, resource_desc& desc, subresource_da
 
 static void onInitResource(device* device, const resource_desc& desc, const subresource_data* initData, resource_usage usage, reshade::api::resource handle)
 {
+    if (Profiling::TraceCapture::IsCapturing())
+    {
+        if (desc.type == resource_type::buffer)
+            Profiling::TraceCapture::Record("init_resource", "{:x} type={} size={} heap={} usage={:x}", handle.handle, static_cast<uint32_t>(desc.type), desc.buffer.size, static_cast<uint32_t>(desc.heap), static_cast<uint32_t>(desc.usage));
+        else
+            Profiling::TraceCapture::Record("init_resource", "{:x} type={} width={} height={} format={} heap={} usage={:x}", handle.handle, static_cast<uint32_t>(desc.type), desc.texture.width, desc.texture.height, static_cast<uint32_t>(desc.texture.format), static_cast<uint32_t>(desc.heap), static_cast<uint32_t>(desc.usage));
+    }
+
     resourceManager.OnInitResource(device, desc, initData, usage, handle);
     
     if (constantCopy != nullptr)
@@ -186,6 +210,7 @@ static void onInitResource(device* device, const resource_desc& desc, const subr
 static void onDestroyResource(device* device, resource res)
 {
     resourceManager.OnDestroyResource(device, res);
+    renderingBindingManager.OnResourceDestroyed(device, res);
     
     if (constantCopy != nullptr)
         constantCopy->OnDestroyResource(device, res);
@@ -200,13 +225,18 @@ static bool onCreateResourceView(device* device, resource resource, resource_usa
 
 static void onInitResourceView(device* device, resource resource, resource_usage usage_type, const resource_view_desc& desc, resource_view view)
 {
+    Profiling::TraceCapture::Record("init_resource_view", "{:x} resource={:x} usage={:x} format={}", view.handle, resource.handle, static_cast<uint32_t>(usage_type), static_cast<uint32_t>(desc.format));
+
     resourceManager.OnInitResourceView(device, resource, usage_type, desc, view);
+    renderingBindingManager.OnInitResourceView(device, resource, usage_type, view);
 }
 
 
 static void onDestroyResourceView(device* device, resource_view view)
 {
     resourceManager.OnDestroyResourceView(device, view);
+    renderingBindingManager.OnDestroyResourceView(device, view);
+    renderingShaderManager.OnDestroyResourceView(view);
 }
 
 
@@ -216,6 +246,7 @@ static void onReshadeReloadedEffects(effect_runtime* runtime)
     DeviceDataContainer& deviceData = runtime->get_device()->get_private_data<DeviceDataContainer>();
     
     techniqueManager.OnReshadeReloadedEffects(runtime);
+    groupCostTracker.OnReshadeReloadedEffects();
 
     if (deviceData.current_runtime == runtime)
     {
@@ -316,8 +347,60 @@ static void onDestroyEffectRuntime(effect_runtime* runtime)
 }
 
 
-static void onInitPipeline(device* device, pipeline_layout, uint32_t subobjectCount, const pipeline_subobject* subobjects, pipeline pipelineHandle)
+static size_t getShaderCodeSize(const pipeline_subobject& subobject)
 {
+    return subobject.data != nullptr ? static_cast<const shader_desc*>(subobject.data)->code_size : 0;
+}
+
+// Records enough of the pipeline description for a replay to rebuild it: stage hashes with code sizes, output formats
+// and topology
+static void RecordPipelineDesc(pipeline_layout layout, uint32_t subobjectCount, const pipeline_subobject* subobjects, pipeline pipelineHandle, uint32_t vsHash, uint32_t psHash, uint32_t csHash)
+{
+    size_t vsSize = 0;
+    size_t psSize = 0;
+    size_t csSize = 0;
+    uint32_t depthFormat = 0;
+    uint32_t topology = 0;
+    std::string renderTargetFormats;
+
+    for (uint32_t i = 0; i < subobjectCount; ++i)
+    {
+        switch (subobjects[i].type)
+        {
+        case pipeline_subobject_type::vertex_shader:
+            vsSize = getShaderCodeSize(subobjects[i]);
+            break;
+        case pipeline_subobject_type::pixel_shader:
+            psSize = getShaderCodeSize(subobjects[i]);
+            break;
+        case pipeline_subobject_type::compute_shader:
+            csSize = getShaderCodeSize(subobjects[i]);
+            break;
+        case pipeline_subobject_type::depth_stencil_format:
+            depthFormat = subobjects[i].count > 0 ? static_cast<uint32_t>(*static_cast<const reshade::api::format*>(subobjects[i].data)) : 0;
+            break;
+        case pipeline_subobject_type::primitive_topology:
+            topology = subobjects[i].count > 0 ? static_cast<uint32_t>(*static_cast<const primitive_topology*>(subobjects[i].data)) : 0;
+            break;
+        case pipeline_subobject_type::render_target_formats:
+            for (uint32_t f = 0; f < subobjects[i].count; f++)
+            {
+                renderTargetFormats += std::format("{}{}", f > 0 ? "," : "", static_cast<uint32_t>(static_cast<const reshade::api::format*>(subobjects[i].data)[f]));
+            }
+            break;
+        }
+    }
+
+    Profiling::TraceCapture::Record("init_pipeline", "{:x} layout={:x} vs={:08x}:{} ps={:08x}:{} cs={:08x}:{} rt_formats={} ds_format={} topology={}",
+        pipelineHandle.handle, layout.handle, vsHash, vsSize, psHash, psSize, csHash, csSize, renderTargetFormats.empty() ? "-" : renderTargetFormats, depthFormat, topology);
+}
+
+static void onInitPipeline(device* device, pipeline_layout layout, uint32_t subobjectCount, const pipeline_subobject* subobjects, pipeline pipelineHandle)
+{
+    uint32_t vsHash = 0;
+    uint32_t psHash = 0;
+    uint32_t csHash = 0;
+
     // shader has been created, we will now create a hash and store it with the handle we got.
     for (uint32_t i = 0; i < subobjectCount; ++i)
     {
@@ -325,21 +408,29 @@ static void onInitPipeline(device* device, pipeline_layout, uint32_t subobjectCo
         {
         case pipeline_subobject_type::vertex_shader:
         {
-            g_vertexShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
+            vsHash = calculateShaderHash(subobjects[i].data);
+            g_vertexShaderManager.addHashHandlePair(vsHash, pipelineHandle.handle);
         }
         break;
         case pipeline_subobject_type::pixel_shader:
         {
-            g_pixelShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
+            psHash = calculateShaderHash(subobjects[i].data);
+            g_pixelShaderManager.addHashHandlePair(psHash, pipelineHandle.handle);
         }
         break;
         case pipeline_subobject_type::compute_shader:
         {
-            g_computeShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
+            csHash = calculateShaderHash(subobjects[i].data);
+            g_computeShaderManager.addHashHandlePair(csHash, pipelineHandle.handle);
         }
         break;
         }
     }
+
+    if (Profiling::TraceCapture::IsCapturing())
+    {
+        RecordPipelineDesc(layout, subobjectCount, subobjects, pipelineHandle, vsHash, psHash, csHash);
+    }
 }
 
 
@@ -351,8 +442,50 @@ static void onDestroyPipeline(device* device, pipeline pipelineHandle)
 }
 
 
+static auto CollectionRepeatReporter(ShaderManager& shaderManager)
+{
+    return [&shaderManager](bool draw, uint32_t hash, uint32_t repeats) { shaderManager.collectShaderRepeats(draw, hash, repeats); };
+}
+
+static void CollectShaderBind(ShaderManager& shaderManager, ShaderData& shaderData, uint32_t shaderHash)
+{
+    // When deduplicating, a command list reports every shader at most once per frame, barring filter collisions. Repeats are only counted
+    // and reported in bulk once they drop out of the filter.
+    if (g_addonUIData.GetDeduplicateCollection() && shaderData.collectionFilter.SeenBefore(false, shaderHash, g_collectionFrame.load(std::memory_order_relaxed), CollectionRepeatReporter(shaderManager)))
+    {
+        return;
+    }
+
+    shaderManager.collectShaderBind(shaderHash);
+}
+
+static void ExtendCollectionPhase(size_t newShaders)
+{
+    if (g_activeCollectorFrameCounter == 0)
+    {
+        g_collectionFramesElapsed = 0;
+        return;
+    }
+
+    g_collectionFramesElapsed++;
+
+    if (newShaders == 0 || !g_addonUIData.GetExtendCollection() || g_collectionFramesElapsed >= COLLECTION_MAX_FRAMES)
+    {
+        return;
+    }
+
+    // The counter is also counted down by the overlay, so only ever raise it
+    uint32_t remaining = g_activeCollectorFrameCounter.load();
+    while (remaining > 0 && remaining < COLLECTION_EXTEND_FRAMES && !g_activeCollectorFrameCounter.compare_exchange_weak(remaining, COLLECTION_EXTEND_FRAMES))
+    {
+    }
+}
+
 static void onBindPipeline(command_list* commandList, pipeline_stage stages, pipeline pipelineHandle)
 {
+    PROFILE_EVENT(EVENT_BIND_PIPELINE);
+    Profiling::TraceCapture::Record("bind_pipeline", "{:x} stages={:x} pipeline={:x}", reinterpret_cast<uintptr_t>(commandList), static_cast<uint32_t>(stages), pipelineHandle.handle);
+
     if (nullptr == commandList || pipelineHandle.handle == 0 || !((uint32_t)(stages & pipeline_stage::pixel_shader) || (uint32_t)(stages & pipeline_stage::vertex_shader) || (uint32_t)(stages & pipeline_stage::compute_shader)))
     {
         return;
@@ -382,7 +515,7 @@ static void onBindPipeline(command_list* commandList, pipeline_stage stages, pip
         if (g_activeCollectorFrameCounter > 0)
         {
             // in collection mode
-            g_pixelShaderManager.addActivePipelineHandle(pipelineHandle.handle);
+            CollectShaderBind(g_pixelShaderManager, commandListData.ps, handleHasPixelShaderAttached);
         }
         if (commandListData.ps.activeShaderHash != handleHasPixelShaderAttached)
         {
@@ -399,7 +532,7 @@ static void onBindPipeline(command_list* commandList, pipeline_stage stages, pip
         if (g_activeCollectorFrameCounter > 0)
         {
             // in collection mode
-            g_vertexShaderManager.addActivePipelineHandle(pipelineHandle.handle);
+            CollectShaderBind(g_vertexShaderManager, commandListData.vs, handleHasVertexShaderAttached);
         }
         if (commandListData.vs.activeShaderHash != handleHasVertexShaderAttached)
         {
@@ -416,7 +549,7 @@ static void onBindPipeline(command_list* commandList, pipeline_stage stages, pip
         if (g_activeCollectorFrameCounter > 0)
         {
             // in collection mode
-            g_computeShaderManager.addActivePipelineHandle(pipelineHandle.handle);
+            CollectShaderBind(g_computeShaderManager, commandListData.cs, handleHasComputeShaderAttached);
         }
         if (commandListData.cs.activeShaderHash != handleHasComputeShaderAttached)
         {
@@ -454,6 +587,17 @@ static void onBindPipeline(command_list* commandList, pipeline_stage stages, pip
 
 static void onBindRenderTargetsAndDepthStencil(command_list* cmd_list, uint32_t count, const resource_view* rtvs, resource_view dsv)
 {
+    PROFILE_EVENT(EVENT_BIND_RENDER_TARGETS);
+
+    if (Profiling::TraceCapture::IsCapturing())
+    {
+        string views;
+        for (uint32_t i = 0; i < count; i++)
+            views += std::format(" {:x}", rtvs[i].handle);
+
+        Profiling::TraceCapture::Record("bind_render_targets", "{:x} dsv={:x} count={}{}", reinterpret_cast<uintptr_t>(cmd_list), dsv.handle, count, views);
+    }
+
     if (cmd_list == nullptr || cmd_list->get_device() == nullptr)
     {
         return;
@@ -463,6 +607,8 @@ static void onBindRenderTargetsAndDepthStencil(command_list* cmd_list, uint32_t
     CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
     DeviceDataContainer& deviceData = device->get_private_data<DeviceDataContainer>();
 
+    renderingBindingManager.OnRenderTargetsBound(cmd_list, count, rtvs, dsv);
+
     //if (count > 0)
     //{
         if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_RENDERTARGET_PREVIEW && !(commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_PREVIEW))
@@ -487,6 +633,17 @@ static void onBindRenderTargetsAndDepthStencil(command_list* cmd_list, uint32_t
 
 static void onBeginRenderPass(command_list* cmd_list, uint32_t count, const render_pass_render_target_desc* rts, const render_pass_depth_stencil_desc* ds)
 {
+    PROFILE_EVENT(EVENT_BEGIN_RENDER_PASS);
+
+    if (Profiling::TraceCapture::IsCapturing())
+    {
+        string views;
+        for (uint32_t i = 0; i < count; i++)
+            views += std::format(" {:x}", rts[i].view.handle);
+
+        Profiling::TraceCapture::Record("begin_render_pass", "{:x} dsv={:x} count={}{}", reinterpret_cast<uintptr_t>(cmd_list), ds != nullptr ? ds->view.handle : 0, count, views);
+    }
+
     if (cmd_list == nullptr || cmd_list->get_device() == nullptr)
     {
         return;
@@ -495,6 +652,16 @@ static void onBeginRenderPass(command_list* cmd_list, uint32_t count, const rend
     device* device = cmd_list->get_device();
     CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
     DeviceDataContainer& deviceData = device->get_private_data<DeviceDataContainer>();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        renderingBindingManager.OnResourceViewWritten(device, rts[i].view);
+    }
+
+    if (ds != nullptr)
+    {
+        renderingBindingManager.OnResourceViewWritten(device, ds->view);
+    }
     
     if (!deviceData.current_runtime->get_effects_state())
     {
@@ -513,6 +680,65 @@ static void onBeginRenderPass(command_list* cmd_list, uint32_t count, const rend
 }
 
 
+static bool onCopyResource(command_list* cmd_list, resource source, resource dest)
+{
+    renderingBindingManager.OnResourceWritten(cmd_list->get_device(), dest);
+    return false;
+}
+
+
+static bool onCopyBufferToTexture(command_list* cmd_list, resource source, uint64_t source_offset, uint32_t row_length, uint32_t slice_height, resource dest, uint32_t dest_subresource, const subresource_box* dest_box)
+{
+    renderingBindingManager.OnResourceWritten(cmd_list->get_device(), dest);
+    return false;
+}
+
+
+static bool onCopyTextureRegion(command_list* cmd_list, resource source, uint32_t source_subresource, const subresource_box* source_box, resource dest, uint32_t dest_subresource, const subresource_box* dest_box, filter_mode filter)
+{
+    renderingBindingManager.OnResourceWritten(cmd_list->get_device(), dest);
+    return false;
+}
+
+
+static bool onResolveTextureRegion(command_list* cmd_list, resource source, uint32_t source_subresource, const subresource_box* source_box, resource dest, uint32_t dest_subresource, int32_t dest_x, int32_t dest_y, int32_t dest_z, format format)
+{
+    renderingBindingManager.OnResourceWritten(cmd_list->get_device(), dest);
+    return false;
+}
+
+
+static bool onClearRenderTargetView(command_list* cmd_list, resource_view rtv, const float color[4], uint32_t rect_count, const rect* rects)
+{
+    renderingBindingManager.OnResourceViewWritten(cmd_list->get_device(), rtv);
+    return false;
+}
+
+
+static bool onClearDepthStencilView(command_list* cmd_list, resource_view dsv, const float* depth, const uint8_t* stencil, uint32_t rect_count, const rect* rects)
+{
+    renderingBindingManager.OnResourceViewWritten(cmd_list->get_device(), dsv);
+    return false;
+}
+
+
+static bool onUpdateTextureRegion(device* device, const subresource_data& data, resource dest, uint32_t dest_subresource, const subresource_box* dest_box)
+{
+    renderingBindingManager.OnResourceWritten(device, dest);
+    return false;
+}
+
+
+// D3D11 dynamic textures are written through a map rather than an update
+static void onMapTextureRegion(device* device, resource resource, uint32_t subresource, const subresource_box* box, map_access access, subresource_data* data)
+{
+    if (access != map_access::read_only)
+    {
+        renderingBindingManager.OnResourceWritten(device, resource);
+    }
+}
+
+
 static void onReshadeOverlay(effect_runtime* runtime)
 {
     DisplayOverlay(g_addonUIData, resourceManager, runtime);
@@ -551,6 +777,13 @@ static void onReshadePresent(effect_runtime* runtime)
     deviceData.rendered_effects = false;
 
     keyMonitor.PollKeyStates(runtime);
+    g_addonUIData.OnReshadePresent();
+    g_collectionFrame.fetch_add(1, std::memory_order_relaxed);
+    const size_t newShaders = g_pixelShaderManager.mergeCollectedShaders() + g_vertexShaderManager.mergeCollectedShaders() + g_computeShaderManager.mergeCollectedShaders();
+    ExtendCollectionPhase(newShaders);
+    frameBudgetGovernor.OnReshadePresent();
+    groupCostTracker.OnReshadePresent(runtime);
+    renderingBindingManager.OnReshadePresent(dev);
 
     if (g_addonUIData.GetPreventRuntimeReload())
     {
@@ -567,16 +800,27 @@ static void onReshadePresent(effect_runtime* runtime)
 
     techniqueManager.OnReshadePresent(runtime);
 
+    if (constantCopy != nullptr)
+        constantCopy->OnPresent();
+
     deviceData.bindingsUpdated.clear();
     deviceData.constantsUpdated.clear();
     deviceData.huntPreview.Reset();
 
+#if SHADERTOGGLER_PROFILING
+    Profiling::Profiler::OnPresent();
+#endif
+    Profiling::TraceCapture::OnPresent();
+
     CheckHotkeys(g_addonUIData, runtime);
 }
 
 
 static void onMapBufferRegion(device* device, resource resource, uint64_t offset, uint64_t size, map_access access, void** data)
 {
+    PROFILE_EVENT(EVENT_MAP_BUFFER_REGION);
+    Profiling::TraceCapture::Record("map_buffer_region", "{:x} offset={} size={} access={}", resource.handle, offset, size, static_cast<uint32_t>(access));
+
     if (constantCopy != nullptr)
         constantCopy->OnMapBufferRegion(device, resource, offset, size, access, data);
 }
@@ -584,6 +828,8 @@ static void onMapBufferRegion(device* device, resource resource, uint64_t offset
 
 static void onUnmapBufferRegion(device* device, resource resource)
 {
+    PROFILE_EVENT(EVENT_UNMAP_BUFFER_REGION);
+
     if (constantCopy != nullptr)
         constantCopy->OnUnmapBufferRegion(device, resource);
 }
@@ -591,6 +837,8 @@ static void onUnmapBufferRegion(device* device, resource resource)
 
 static bool onUpdateBufferRegion(device* device, const void* data, resource resource, uint64_t offset, uint64_t size)
 {
+    PROFILE_EVENT(EVENT_UPDATE_BUFFER_REGION);
+
     if (constantCopy != nullptr)
         constantCopy->OnUpdateBufferRegion(device, data, resource, offset, size);
 
@@ -600,8 +848,15 @@ static bool onUpdateBufferRegion(device* device, const void* data, resource reso
 
 static void displaySettings(effect_runtime* runtime)
 {
-    DisplaySettings(g_addonUIData, runtime);
+    DisplaySettings(g_addonUIData, runtime, frameBudgetGovernor, groupCostTracker, renderingBindingManager);
+}
+
+#if SHADERTOGGLER_PROFILING
+static void displayProfiling(effect_runtime* runtime)
+{
+    DisplayProfiling(g_addonUIData, runtime);
 }
+#endif
 
 
 static void Init()
@@ -623,10 +878,49 @@ static void UnInit()
     constantManager.UnInit();
 }
 
+static void CollectShaderDraw(command_list* cmd_list, ShaderManager& shaderManager, ShaderData& shaderData)
+{
+    if (g_addonUIData.GetDeduplicateCollection() && shaderData.collectionFilter.SeenBefore(true, shaderData.activeShaderHash, g_collectionFrame.load(std::memory_order_relaxed), CollectionRepeatReporter(shaderManager)))
+    {
+        // the draw still takes its place in the frame, so the draw order of the others holds
+        shaderManager.skipShaderDraw();
+        return;
+    }
+
+    const state_tracking& state = cmd_list->get_private_data<state_tracking>();
+    const uint32_t width = state.viewports.size() > 0 ? static_cast<uint32_t>(state.viewports[0].width) : 0;
+    const uint32_t height = state.viewports.size() > 0 ? static_cast<uint32_t>(state.viewports[0].height) : 0;
+
+    shaderManager.collectShaderDraw(shaderData.activeShaderHash, width, height);
+}
+
+static void CollectDrawCall(command_list* cmd_list, CommandListDataContainer& commandListData, const uint64_t match_modifier)
+{
+    if (match_modifier & Rendering::MATCH_PS)
+    {
+        CollectShaderDraw(cmd_list, g_pixelShaderManager, commandListData.ps);
+    }
+
+    if (match_modifier & Rendering::MATCH_VS)
+    {
+        CollectShaderDraw(cmd_list, g_vertexShaderManager, commandListData.vs);
+    }
+
+    if (match_modifier & Rendering::MATCH_CS)
+    {
+        CollectShaderDraw(cmd_list, g_computeShaderManager, commandListData.cs);
+    }
+}
+
 static void CheckDrawCall(command_list* cmd_list, const uint64_t match_modifier = Rendering::MATCH_ALL)
 {
     CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
 
+    if (g_activeCollectorFrameCounter > 0)
+    {
+        CollectDrawCall(cmd_list, commandListData, match_modifier);
+    }
+
     if (commandListData.commandQueue & Rendering::MATCH_ALL & match_modifier)
     {
         if (constantHandler != nullptr && (commandListData.commandQueue & Rendering::MATCH_CONST & match_modifier))
@@ -654,6 +948,9 @@ static void CheckDrawCall(command_list* cmd_list, const uint64_t match_modifier
 
 static bool onDraw(command_list* cmd_list, uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
 {
+    PROFILE_EVENT(EVENT_DRAW);
+    Profiling::TraceCapture::Record("draw", "{:x} vertices={} instances={}", reinterpret_cast<uintptr_t>(cmd_list), vertex_count, instance_count);
+
     CheckDrawCall(cmd_list, Rendering::MATCH_PS | Rendering::MATCH_VS);
 
     return false;
@@ -661,6 +958,9 @@ static bool onDraw(command_list* cmd_list, uint32_t vertex_count, uint32_t insta
 
 static bool onDispatch(command_list* cmd_list, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
+    PROFILE_EVENT(EVENT_DISPATCH);
+    Profiling::TraceCapture::Record("dispatch", "{:x} groups={}x{}x{}", reinterpret_cast<uintptr_t>(cmd_list), group_count_x, group_count_y, group_count_z);
+
     CheckDrawCall(cmd_list, Rendering::MATCH_CS);
 
     return false;
@@ -668,6 +968,9 @@ static bool onDispatch(command_list* cmd_list, uint32_t group_count_x, uint32_t
 
 static bool onDrawIndexed(command_list* cmd_list, uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
+    PROFILE_EVENT(EVENT_DRAW_INDEXED);
+    Profiling::TraceCapture::Record("draw_indexed", "{:x} indices={} instances={}", reinterpret_cast<uintptr_t>(cmd_list), index_count, instance_count);
+
     CheckDrawCall(cmd_list, Rendering::MATCH_PS | Rendering::MATCH_VS);
 
     return false;
@@ -675,6 +978,9 @@ static bool onDrawIndexed(command_list* cmd_list, uint32_t index_count, uint32_t
 
 static bool onDrawOrDispatchIndirect(command_list* cmd_list, indirect_command type, resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
 {
+    PROFILE_EVENT(EVENT_DRAW_OR_DISPATCH_INDIRECT);
+    Profiling::TraceCapture::Record("draw_or_dispatch_indirect", "{:x} type={} count={}", reinterpret_cast<uintptr_t>(cmd_list), static_cast<uint32_t>(type), draw_count);
+
     switch (type)
     {
     case indirect_command::unknown:
@@ -702,7 +1008,7 @@ filesystem::path getModulePath(HMODULE module)
     return GetModuleFileNameW(module, buf, ARRAYSIZE(buf)) ? buf : filesystem::path();
 }
 
-BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
+BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 {
     switch (fdwReason)
     {
@@ -747,6 +1053,14 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
         reshade::register_event<reshade::addon_event::destroy_device>(onDestroyDevice);
         reshade::register_event<reshade::addon_event::bind_render_targets_and_depth_stencil>(onBindRenderTargetsAndDepthStencil);
         reshade::register_event<reshade::addon_event::begin_render_pass>(onBeginRenderPass);
+        reshade::register_event<reshade::addon_event::copy_resource>(onCopyResource);
+        reshade::register_event<reshade::addon_event::copy_buffer_to_texture>(onCopyBufferToTexture);
+        reshade::register_event<reshade::addon_event::copy_texture_region>(onCopyTextureRegion);
+        reshade::register_event<reshade::addon_event::resolve_texture_region>(onResolveTextureRegion);
+        reshade::register_event<reshade::addon_event::clear_render_target_view>(onClearRenderTargetView);
+        reshade::register_event<reshade::addon_event::clear_depth_stencil_view>(onClearDepthStencilView);
+        reshade::register_event<reshade::addon_event::update_texture_region>(onUpdateTextureRegion);
+        reshade::register_event<reshade::addon_event::map_texture_region>(onMapTextureRegion);
         reshade::register_event<reshade::addon_event::init_effect_runtime>(onInitEffectRuntime);
         reshade::register_event<reshade::addon_event::destroy_effect_runtime>(onDestroyEffectRuntime);
         reshade::register_event<reshade::addon_event::present>(onPresent);
@@ -757,8 +1071,13 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
         reshade::register_event<reshade::addon_event::draw_or_dispatch_indirect>(onDrawOrDispatchIndirect);
 
         reshade::register_overlay(nullptr, &displaySettings);
+#if SHADERTOGGLER_PROFILING
+        reshade::register_overlay("Shader Toggler Profiling", &displayProfiling);
+#endif
         break;
     case DLL_PROCESS_DETACH:
+        // On process exit the other threads are already gone and may have left the CRT locked, only an unload may still write
+        g_addonUIData.DetachBackgroundSave(lpReserved == nullptr);
         UnInit();
         reshade::unregister_event<reshade::addon_event::create_swapchain>(onCreateSwapchain);
         reshade::unregister_event<reshade::addon_event::init_swapchain>(onInitSwapchain);
@@ -781,6 +1100,14 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
         reshade::unregister_event<reshade::addon_event::destroy_device>(onDestroyDevice);
         reshade::unregister_event<reshade::addon_event::bind_render_targets_and_depth_stencil>(onBindRenderTargetsAndDepthStencil);
         reshade::unregister_event<reshade::addon_event::begin_render_pass>(onBeginRenderPass);
+        reshade::unregister_event<reshade::addon_event::copy_resource>(onCopyResource);
+        reshade::unregister_event<reshade::addon_event::copy_buffer_to_texture>(onCopyBufferToTexture);
+        reshade::unregister_event<reshade::addon_event::copy_texture_region>(onCopyTextureRegion);
+        reshade::unregister_event<reshade::addon_event::resolve_texture_region>(onResolveTextureRegion);
+        reshade::unregister_event<reshade::addon_event::clear_render_target_view>(onClearRenderTargetView);
+        reshade::unregister_event<reshade::addon_event::clear_depth_stencil_view>(onClearDepthStencilView);
+        reshade::unregister_event<reshade::addon_event::update_texture_region>(onUpdateTextureRegion);
+        reshade::unregister_event<reshade::addon_event::map_texture_region>(onMapTextureRegion);
         reshade::unregister_event<reshade::addon_event::init_effect_runtime>(onInitEffectRuntime);
         reshade::unregister_event<reshade::addon_event::destroy_effect_runtime>(onDestroyEffectRuntime);
         reshade::unregister_event<reshade::addon_event::create_resource>(onCreateResource);
@@ -797,6 +1124,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
         reshade::unregister_event<reshade::addon_event::draw_or_dispatch_indirect>(onDrawOrDispatchIndirect);
 
         reshade::unregister_overlay(nullptr, &displaySettings);
+#if SHADERTOGGLER_PROFILING
+        reshade::unregister_overlay("Shader Toggler Profiling", &displayProfiling);
+#endif
 
         state_tracking::unregister_events();
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <tuple>
+#include <mutex>
 #include <shared_mutex>
 #include <chrono>
 #include "reshade.hpp"
@@ -23,6 +26,64 @@ struct __declspec(novtable) ResourceRenderData final {
 using effect_queue = std::unordered_map<EffectData*, ResourceRenderData>;
 using binding_queue = std::unordered_map<ShaderToggler::ToggleGroup*, ResourceRenderData>;
 
+// Direct mapped cache of the shader hashes a command list already reported to the collection in the current frame
+struct __declspec(novtable) CollectionFilter final {
+    static constexpr uint32_t Size = 64;
+
+    struct Entry {
+        uint32_t hash = 0;
+        uint32_t repeats = 0;
+    };
+
+    std::array<Entry, Size> binds = {};
+    std::array<Entry, Size> draws = {};
+    uint64_t frame = UINT64_MAX;
+
+    // Returns true if the hash was reported before this frame and counts the repeat, remembers it otherwise. Collisions only cause a hash to be reported again.
+    // The repeats of hashes dropped from the cache are handed to report(draw, hash, repeats), so the collected counts stay exact.
+    template<typename F>
+    bool SeenBefore(bool draw, uint32_t hash, uint64_t currentFrame, F&& report)
+    {
+        if (frame != currentFrame)
+        {
+            Flush(report);
+            frame = currentFrame;
+        }
+
+        Entry& entry = (draw ? draws : binds)[hash % Size];
+        if (entry.hash == hash)
+        {
+            entry.repeats++;
+            return true;
+        }
+
+        if (entry.repeats > 0)
+        {
+            report(draw, entry.hash, entry.repeats);
+        }
+
+        entry = Entry{ hash, 0 };
+        return false;
+    }
+
+    template<typename F>
+    void Flush(F&& report)
+    {
+        for (bool draw : { false, true })
+        {
+            for (Entry& entry : draw ? draws : binds)
+            {
+                if (entry.repeats > 0)
+                {
+                    report(draw, entry.hash, entry.repeats);
+                }
+
+                entry = Entry{};
+            }
+        }
+    }
+};
+
 struct __declspec(novtable) ShaderData final {
     uint32_t activeShaderHash = -1;
     binding_queue bindingsToUpdate;
@@ -30,6 +91,7 @@ struct __declspec(novtable) ShaderData final {
     effect_queue techniquesToRender;
     std::unordered_set<ShaderToggler::ToggleGroup*> srvToUpdate;
     const std::vector<ShaderToggler::ToggleGroup*>* blockedShaderGroups = nullptr;
+    CollectionFilter collectionFilter;
     uint32_t id = 0;
 
     ShaderData(uint32_t _id) : id(_id) { }
@@ -45,11 +107,18 @@ struct __declspec(novtable) ShaderData final {
     }
 };
 
+// Range of group cost timestamps a command list claimed for a frame, see Rendering::GroupCostTracker
+struct __declspec(novtable) CostTimingChunk final {
+    uint64_t frame = UINT64_MAX;
+    uint32_t chunk = UINT32_MAX;
+};
+
 struct __declspec(uuid("222F7169-3C09-40DB-9BC9-EC53842CE537")) CommandListDataContainer {
     uint64_t commandQueue = 0;
     ShaderData ps{ 0 };
     ShaderData vs{ 1 };
     ShaderData cs{ 2 };
+    CostTimingChunk costTiming;
 
     void Reset()
     {
@@ -75,6 +144,18 @@ struct __declspec(novtable) TextureBindingData final
     bool reset = false;
 };
 
+struct __declspec(novtable) SharedBindingCopy final
+{
+    int owner;
+    reshade::api::resource_view srv;
+};
+
+struct __declspec(novtable) BindingCopySource final
+{
+    reshade::api::resource source;
+    uint64_t generation;
+};
+
 struct __declspec(novtable) HuntPreview final
 {
     reshade::api::resource target = reshade::api::resource{ 0 };
@@ -122,6 +203,14 @@ struct __declspec(uuid("C63E95B1-4E2F-46D6-A276-E8B4612C069A")) DeviceDataContai
     std::unordered_set<const ShaderToggler::ToggleGroup*> bindingsUpdated;
     std::unordered_set<const ShaderToggler::ToggleGroup*> constantsUpdated;
     std::unordered_set<const ShaderToggler::ToggleGroup*> srvUpdated;
+    std::unordered_map<int, SharedBindingCopy> bindingShares;
+    std::unordered_map<int, BindingCopySource> bindingCopySources;
+    std::shared_mutex write_mutex;
+    std::atomic_uint64_t writeGeneration = 0;
+    // Generation of the last write to each resource a binding was copied from, other resources aren't stamped
+    std::unordered_map<uint64_t, std::atomic_uint64_t> resourceWrites;
+    // Resources of the render target and depth stencil views, so binding them doesn't have to query the view
+    std::unordered_map<uint64_t, uint64_t> writeViewResources;
     HuntPreview huntPreview;
 };
 
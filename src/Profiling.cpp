@@ -0,0 +1,201 @@
+#include "Profiling.h"
+
+#if SHADERTOGGLER_PROFILING
+
+#include <algorithm>
+#include <fstream>
+#include <format>
+
+using namespace Profiling;
+using namespace std;
+
+mutex Profiler::_threadMutex;
+vector<unique_ptr<ThreadProfile>> Profiler::_threads;
+array<EventHistogram, EVENT_COUNT> Profiler::_previousTotals;
+array<EventStatistics, EVENT_COUNT> Profiler::_frameStatistics;
+array<EventStatistics, EVENT_COUNT> Profiler::_totalStatistics;
+uint64_t Profiler::_frameCount = 0;
+
+ThreadProfile& Profiler::GetThreadProfile()
+{
+    // Profiles are owned by the registry so their data outlives the thread that recorded it
+    thread_local ThreadProfile* profile = nullptr;
+
+    if (profile == nullptr)
+    {
+        auto newProfile = make_unique<ThreadProfile>();
+        profile = newProfile.get();
+
+        unique_lock<mutex> lock(_threadMutex);
+        _threads.push_back(std::move(newProfile));
+    }
+
+    return *profile;
+}
+
+uint64_t Profiler::GetBucketValue(uint32_t bucket)
+{
+    if (bucket < SubBucketCount)
+        return bucket;
+
+    const uint32_t exponent = bucket / SubBucketCount - 1;
+    const uint64_t subBucket = bucket % SubBucketCount;
+
+    // Upper bound of the bucket
+    return ((SubBucketCount | subBucket) << exponent) + ((static_cast<uint64_t>(1) << exponent) - 1);
+}
+
+uint64_t EventHistogram::Percentile(double p) const
+{
+    if (calls == 0)
+        return 0;
+
+    const uint64_t target = static_cast<uint64_t>(static_cast<double>(calls) * p);
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < BucketCount; i++)
+    {
+        seen += buckets[i];
+        if (seen > target)
+        {
+            return std::min(Profiler::GetBucketValue(i), maxNs);
+        }
+    }
+
+    return maxNs;
+}
+
+EventStatistics Profiler::ToStatistics(const EventHistogram& histogram)
+{
+    return EventStatistics{
+        histogram.calls,
+        histogram.totalNs,
+        histogram.maxNs,
+        histogram.Percentile(0.5),
+        histogram.Percentile(0.9),
+        histogram.Percentile(0.99)
+    };
+}
+
+void Profiler::OnPresent()
+{
+    array<EventHistogram, EVENT_COUNT> totals;
+
+    {
+        unique_lock<mutex> lock(_threadMutex);
+        for (const auto& thread : _threads)
+        {
+            for (uint32_t ev = 0; ev < EVENT_COUNT; ev++)
+            {
+                const ThreadEventData& data = thread->events[ev];
+                EventHistogram& total = totals[ev];
+
+                for (uint32_t b = 0; b < BucketCount; b++)
+                {
+                    total.buckets[b] += data.buckets[b].load(std::memory_order_relaxed);
+                }
+
+                total.calls += data.calls.load(std::memory_order_relaxed);
+                total.totalNs += data.totalNs.load(std::memory_order_relaxed);
+                total.maxNs = std::max(total.maxNs, data.maxNs.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    for (uint32_t ev = 0; ev < EVENT_COUNT; ev++)
+    {
+        // Histograms are cumulative, the difference to the previous present is the last frame
+        EventHistogram frame;
+        const EventHistogram& previous = _previousTotals[ev];
+
+        for (uint32_t b = 0; b < BucketCount; b++)
+        {
+            frame.buckets[b] = totals[ev].buckets[b] - previous.buckets[b];
+            if (frame.buckets[b] > 0)
+                frame.maxNs = GetBucketValue(b);
+        }
+
+        frame.calls = totals[ev].calls - previous.calls;
+        frame.totalNs = totals[ev].totalNs - previous.totalNs;
+        frame.maxNs = std::min(frame.maxNs, totals[ev].maxNs);
+
+        _frameStatistics[ev] = ToStatistics(frame);
+        _totalStatistics[ev] = ToStatistics(totals[ev]);
+    }
+
+    _previousTotals = totals;
+    _frameCount++;
+}
+
+bool Profiler::DumpCSV(const filesystem::path& file)
+{
+    ofstream out(file, ios::out | ios::trunc);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out << "event,frame_calls,frame_total_us,total_calls,total_us,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n";
+
+    for (uint32_t ev = 0; ev < EVENT_COUNT; ev++)
+    {
+        const EventStatistics& frame = _frameStatistics[ev];
+        const EventStatistics& total = _totalStatistics[ev];
+
+        out << std::format("{},{},{:.3f},{},{:.3f},{},{},{},{},{}\n",
+            ProfileEventNames[ev],
+            frame.calls,
+            static_cast<double>(frame.totalNs) / 1000.0,
+            total.calls,
+            static_cast<double>(total.totalNs) / 1000.0,
+            total.calls > 0 ? total.totalNs / total.calls : 0,
+            total.p50Ns,
+            total.p90Ns,
+            total.p99Ns,
+            total.maxNs);
+    }
+
+    return true;
+}
+
+bool Profiler::DumpJSON(const filesystem::path& file)
+{
+    ofstream out(file, ios::out | ios::trunc);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    // Follows the layout of google benchmark's JSON reporter so results can be compared with its tooling
+    out << "{\n  \"context\": {\n";
+    out << std::format("    \"date\": \"{:%Y-%m-%dT%H:%M:%S}\",\n", chrono::floor<chrono::seconds>(chrono::system_clock::now()));
+    out << std::format("    \"frames\": {},\n", _frameCount);
+#if defined(_DEBUG)
+    out << "    \"library_build_type\": \"debug\"\n";
+#else
+    out << "    \"library_build_type\": \"release\"\n";
+#endif
+    out << "  },\n  \"benchmarks\": [\n";
+
+    for (uint32_t ev = 0; ev < EVENT_COUNT; ev++)
+    {
+        const EventStatistics& total = _totalStatistics[ev];
+
+        out << std::format("    {{\"name\": \"{}\", \"iterations\": {}, \"real_time\": {}, \"cpu_time\": {}, \"time_unit\": \"ns\", \"p50\": {}, \"p90\": {}, \"p99\": {}, \"max\": {}}}{}\n",
+            ProfileEventNames[ev],
+            total.calls,
+            total.calls > 0 ? total.totalNs / total.calls : 0,
+            total.calls > 0 ? total.totalNs / total.calls : 0,
+            total.p50Ns,
+            total.p90Ns,
+            total.p99Ns,
+            total.maxNs,
+            ev + 1 < EVENT_COUNT ? "," : "");
+    }
+
+    out << "  ]\n}\n";
+
+    return true;
+}
+
+#endif
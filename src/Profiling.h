@@ -0,0 +1,204 @@
+#pragma once
+
+// Per event timing instrumentation. Enabled in debug builds, release builds need SHADERTOGGLER_PROFILING defined.
+#if defined(_DEBUG) && !defined(SHADERTOGGLER_PROFILING)
+#define SHADERTOGGLER_PROFILING 1
+#endif
+
+#if SHADERTOGGLER_PROFILING
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Profiling
+{
+    enum ProfileEvent : uint32_t
+    {
+        EVENT_BIND_PIPELINE = 0,
+        EVENT_DRAW,
+        EVENT_DRAW_INDEXED,
+        EVENT_DISPATCH,
+        EVENT_DRAW_OR_DISPATCH_INDIRECT,
+        EVENT_BIND_RENDER_TARGETS,
+        EVENT_BEGIN_RENDER_PASS,
+        EVENT_MAP_BUFFER_REGION,
+        EVENT_UNMAP_BUFFER_REGION,
+        EVENT_UPDATE_BUFFER_REGION,
+        EVENT_COPY_DESCRIPTOR_TABLES,
+        EVENT_UPDATE_DESCRIPTOR_TABLES,
+        EVENT_BIND_DESCRIPTOR_TABLES,
+        EVENT_PUSH_DESCRIPTORS,
+        EVENT_PUSH_CONSTANTS,
+        EVENT_SHADER_HASH,
+        EVENT_SHADER_HANDLE_LOOKUP,
+        EVENT_TOGGLE_GROUP_LOOKUP,
+        EVENT_STATE_CAPTURE,
+        EVENT_STATE_APPLY,
+        EVENT_CHECK_CALL,
+        EVENT_APPLY_CONSTANTS,
+        EVENT_COUNT
+    };
+
+    static constexpr const char* ProfileEventNames[] = {
+        "bind_pipeline",
+        "draw",
+        "draw_indexed",
+        "dispatch",
+        "draw_or_dispatch_indirect",
+        "bind_render_targets_and_depth_stencil",
+        "begin_render_pass",
+        "map_buffer_region",
+        "unmap_buffer_region",
+        "update_buffer_region",
+        "copy_descriptor_tables",
+        "update_descriptor_tables",
+        "bind_descriptor_tables",
+        "push_descriptors",
+        "push_constants",
+        "compute_crc32",
+        "shader_handle_lookup",
+        "toggle_group_lookup",
+        "state_block_capture",
+        "state_block_apply",
+        "check_call_for_command_list",
+        "apply_constant_values",
+    };
+
+    static_assert(sizeof(ProfileEventNames) / sizeof(ProfileEventNames[0]) == EVENT_COUNT);
+
+    // Log-linear histogram: one bucket group per power of two nanoseconds, split in 2^SubBucketBits sub buckets
+    static constexpr uint32_t SubBucketBits = 3;
+    static constexpr uint32_t SubBucketCount = 1 << SubBucketBits;
+    static constexpr uint32_t BucketCount = 32 * SubBucketCount;
+
+    struct EventHistogram
+    {
+        std::array<uint64_t, BucketCount> buckets = {};
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        uint64_t Percentile(double p) const;
+    };
+
+    struct EventStatistics
+    {
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p90Ns = 0;
+        uint64_t p99Ns = 0;
+    };
+
+    // Written by the owning thread only, read relaxed by the aggregation at present
+    struct ThreadEventData
+    {
+        std::array<std::atomic_uint32_t, BucketCount> buckets = {};
+        std::atomic_uint64_t calls = 0;
+        std::atomic_uint64_t totalNs = 0;
+        std::atomic_uint64_t maxNs = 0;
+    };
+
+    struct ThreadProfile
+    {
+        std::array<ThreadEventData, EVENT_COUNT> events;
+    };
+
+    class __declspec(novtable) Profiler final
+    {
+    public:
+        static inline void Record(ProfileEvent ev, uint64_t ns)
+        {
+            ThreadEventData& data = GetThreadProfile().events[ev];
+            const uint32_t bucket = GetBucket(ns);
+
+            // Single writer, plain load/store pairs avoid locked RMW instructions on the hot path
+            data.buckets[bucket].store(data.buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            data.calls.store(data.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            data.totalNs.store(data.totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > data.maxNs.load(std::memory_order_relaxed))
+                data.maxNs.store(ns, std::memory_order_relaxed);
+        }
+
+        static void OnPresent();
+        static const std::array<EventStatistics, EVENT_COUNT>& GetFrameStatistics() { return _frameStatistics; }
+        static const std::array<EventStatistics, EVENT_COUNT>& GetTotalStatistics() { return _totalStatistics; }
+        static uint64_t GetFrameCount() { return _frameCount; }
+        static bool DumpCSV(const std::filesystem::path& file);
+        static bool DumpJSON(const std::filesystem::path& file);
+
+    private:
+        static inline uint32_t GetBucket(uint64_t ns)
+        {
+            if (ns < SubBucketCount)
+                return static_cast<uint32_t>(ns);
+
+            const uint32_t exponent = static_cast<uint32_t>(63 - std::countl_zero(ns)) - SubBucketBits;
+            const uint32_t index = (exponent + 1) * SubBucketCount + static_cast<uint32_t>((ns >> exponent) & (SubBucketCount - 1));
+            return index < BucketCount ? index : BucketCount - 1;
+        }
+
+        static uint64_t GetBucketValue(uint32_t bucket);
+        static ThreadProfile& GetThreadProfile();
+        static EventStatistics ToStatistics(const EventHistogram& histogram);
+
+        friend struct EventHistogram;
+
+        static std::mutex _threadMutex;
+        static std::vector<std::unique_ptr<ThreadProfile>> _threads;
+        static std::array<EventHistogram, EVENT_COUNT> _previousTotals;
+        static std::array<EventStatistics, EVENT_COUNT> _frameStatistics;
+        static std::array<EventStatistics, EVENT_COUNT> _totalStatistics;
+        static uint64_t _frameCount;
+    };
+
+    // Records exclusive time: a timer nested in another one on the same thread is only counted for its own event, so
+    // e.g. a toggle group lookup inside bind_pipeline doesn't also inflate the bind_pipeline figures
+    class ScopedEventTimer final
+    {
+    public:
+        ScopedEventTimer(ProfileEvent ev) : _event(ev), _parent(_current), _start(std::chrono::steady_clock::now())
+        {
+            _current = this;
+        }
+
+        ~ScopedEventTimer()
+        {
+            const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+
+            _current = _parent;
+            if (_parent != nullptr)
+            {
+                _parent->_childNs += elapsed;
+            }
+
+            Profiler::Record(_event, elapsed > _childNs ? elapsed - _childNs : 0);
+        }
+
+        ScopedEventTimer(const ScopedEventTimer&) = delete;
+        ScopedEventTimer& operator=(const ScopedEventTimer&) = delete;
+
+    private:
+        static inline thread_local ScopedEventTimer* _current = nullptr;
+
+        ProfileEvent _event;
+        ScopedEventTimer* _parent;
+        uint64_t _childNs = 0;
+        std::chrono::steady_clock::time_point _start;
+    };
+}
+
+#define PROFILE_EVENT(ev) Profiling::ScopedEventTimer _profileEventTimer(Profiling::ev)
+
+#else
+
+#define PROFILE_EVENT(ev)
+
+#endif
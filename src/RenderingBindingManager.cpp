@@ -32,6 +32,9 @@ void RenderingBindingManager::DisposeTextureBindings(device* device)
 
     unique_lock<shared_mutex> lock(data.binding_mutex);
 
+    data.bindingShares.clear();
+    data.bindingCopySources.clear();
+
     if (empty_res != 0)
     {
         device->destroy_resource(empty_res);
@@ -114,26 +117,94 @@ uint32_t RenderingBindingManager::UpdateTextureBinding(effect_runtime* runtime,
         groupResource.owning = true;
     }
 
-    // Copy format changed, recreate internal buffer
-    if (!toggleGroupResources.IsCompatibleWithGroupFormat(runtime->get_device(), ShaderToggler::GroupResourceType::RESOURCE_BINDING, res, group))
+    // Copy format changed, switch to a cached buffer or recreate the internal one
+    if (!toggleGroupResources.AcquireGroupBuffer(runtime->get_device(), ShaderToggler::GroupResourceType::RESOURCE_BINDING, res, group, desc, viewformat))
     {
-        groupResource.target_description = desc;
-        groupResource.view_format = viewformat;
-        groupResource.state = ShaderToggler::GroupResourceState::RESOURCE_INVALID;
         runtime->update_texture_bindings(group->getTextureBindingName().c_str(), empty_srv, empty_srv);
 
         return 0;
     }
 
-    if (groupResource.state == ShaderToggler::GroupResourceState::RESOURCE_RECREATED || groupResource.state == ShaderToggler::GroupResourceState::RESOURCE_CLEARED)
+    if (groupResource.state == ShaderToggler::GroupResourceState::RESOURCE_RECREATED || groupResource.state == ShaderToggler::GroupResourceState::RESOURCE_CLEARED ||
+        groupResource.state == ShaderToggler::GroupResourceState::RESOURCE_SHARED)
     {
         runtime->update_texture_bindings(group->getTextureBindingName().c_str(), groupResource.srv, groupResource.srv);
         groupResource.state = ShaderToggler::GroupResourceState::RESOURCE_VALID;
+
+        // The buffer's contents can't be relied on anymore
+        data.bindingCopySources.erase(group->getId());
     }
 
     return 1;
 }
 
+bool RenderingBindingManager::_IsBindingSourceUnchanged(command_list* cmd_list, DeviceDataContainer& deviceData, const ToggleGroup* group, resource source)
+{
+    const auto copied = deviceData.bindingCopySources.find(group->getId());
+
+    if (copied == deviceData.bindingCopySources.end() || copied->second.source != source)
+    {
+        return false;
+    }
+
+    device* device = cmd_list->get_device();
+
+    // Writes through unordered access views can't be attributed to a resource, always copy those
+    if ((device->get_resource_desc(source).usage & resource_usage::unordered_access) != 0)
+    {
+        return false;
+    }
+
+    // Draws following the copy may still write to a source that is bound for output
+    const state_tracking& state = cmd_list->get_private_data<state_tracking>();
+
+    shared_lock<shared_mutex> lock(deviceData.write_mutex);
+
+    for (const auto& rtv : state.render_targets)
+    {
+        if (rtv != 0 && _GetViewResource(device, deviceData, rtv) == source.handle)
+        {
+            return false;
+        }
+    }
+
+    if (state.depth_stencil != 0 && _GetViewResource(device, deviceData, state.depth_stencil) == source.handle)
+    {
+        return false;
+    }
+
+    // A source without a stamp, e.g. a new resource reusing a destroyed one's handle, counts as changed
+    const auto written = deviceData.resourceWrites.find(source.handle);
+
+    return written != deviceData.resourceWrites.end() && written->second.load(std::memory_order_relaxed) <= copied->second.generation;
+}
+
+bool RenderingBindingManager::_ShareTextureBinding(effect_runtime* runtime, DeviceDataContainer& deviceData, ToggleGroup* group, const SharedBindingCopy& copy)
+{
+    if (copy.srv == 0 || copy.owner == group->getId())
+    {
+        return false;
+    }
+
+    GroupResource& groupResource = group->GetGroupResource(ShaderToggler::GroupResourceType::RESOURCE_BINDING);
+    const auto share = deviceData.bindingShares.find(group->getId());
+
+    if (groupResource.state != ShaderToggler::GroupResourceState::RESOURCE_SHARED || share == deviceData.bindingShares.end() ||
+        share->second.owner != copy.owner || share->second.srv != copy.srv)
+    {
+        runtime->update_texture_bindings(group->getTextureBindingName().c_str(), copy.srv, copy.srv);
+        deviceData.bindingShares[group->getId()] = copy;
+        groupResource.state = ShaderToggler::GroupResourceState::RESOURCE_SHARED;
+
+        if (!groupResource.owning)
+        {
+            groupResource.g_res = { 0 };
+        }
+    }
+
+    return true;
+}
+
 void RenderingBindingManager::_QueueOrDequeue(
     command_list* cmd_list,
     DeviceDataContainer& deviceData,
@@ -184,7 +255,8 @@ void RenderingBindingManager::_UpdateTextureBindings(command_list* cmd_list,
     DeviceDataContainer& deviceData,
     const binding_queue& bindingsToUpdate,
     vector<ToggleGroup*>& removalList,
-    const unordered_set<ToggleGroup*>& toUpdateBindings)
+    const unordered_set<ToggleGroup*>& toUpdateBindings,
+    binding_copies& copies)
 {
     effect_runtime* runtime = deviceData.current_runtime;
 
@@ -230,19 +302,54 @@ void RenderingBindingManager::_UpdateTextureBindings(command_list* cmd_list,
             }
             else
             {
-                resource_desc resDesc = runtime->get_device()->get_resource_desc(bindingData.resource);
+                const bool flip = group->getFlipBufferBinding() && runtimeData.specialEffects[REST_FLIP].technique != 0;
+                const binding_copy_key key = { bindingData.resource.handle, bindingData.invocationLocation, bindingData.format, flip };
+                const auto copy = copies.find(key);
 
-                uint32_t retUpdate = UpdateTextureBinding(runtime, group, bindingData.resource, resDesc, bindingData.format);
+                // Another group already copied the same source at this point, bind its copy instead of making another one
+                if (copy == copies.end() || !_ShareTextureBinding(runtime, deviceData, group, copy->second))
+                {
+                    resource_desc resDesc = runtime->get_device()->get_resource_desc(bindingData.resource);
 
-                resource target_res = bindingResource.res;
+                    uint32_t retUpdate = UpdateTextureBinding(runtime, group, bindingData.resource, resDesc, bindingData.format);
 
-                if (retUpdate && target_res != 0)
-                {
-                    cmd_list->copy_resource(bindingData.resource, target_res);
+                    resource target_res = bindingResource.res;
 
-                    if (group->getFlipBufferBinding() && bindingResource.rtv != 0 && runtimeData.specialEffects[REST_FLIP].technique != 0)
+                    if (retUpdate && target_res != 0)
                     {
-                        deviceData.current_runtime->render_technique(runtimeData.specialEffects[REST_FLIP].technique, cmd_list, bindingResource.rtv, bindingResource.rtv_srgb);
+                        const bool skipUnchanged = uiData.GetSkipUnchangedBindingCopies();
+
+                        if (skipUnchanged && _IsBindingSourceUnchanged(cmd_list, deviceData, group, bindingData.resource))
+                        {
+                            _elidedBindingCopies.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else
+                        {
+                            cmd_list->copy_resource(bindingData.resource, target_res);
+
+                            if (flip && bindingResource.rtv != 0)
+                            {
+                                deviceData.current_runtime->render_technique(runtimeData.specialEffects[REST_FLIP].technique, cmd_list, bindingResource.rtv, bindingResource.rtv_srgb);
+                            }
+
+                            _bindingCopies.fetch_add(1, std::memory_order_relaxed);
+
+                            if (skipUnchanged)
+                            {
+                                unique_lock<shared_mutex> lock(deviceData.write_mutex);
+                                const uint64_t generation = deviceData.writeGeneration.load(std::memory_order_relaxed);
+
+                                // Start stamping the source, an existing stamp may still be needed by another group's older copy
+                                deviceData.resourceWrites.try_emplace(bindingData.resource.handle, generation);
+                                deviceData.bindingCopySources[group->getId()] = BindingCopySource{ bindingData.resource, generation };
+                            }
+                            else
+                            {
+                                deviceData.bindingCopySources.erase(group->getId());
+                            }
+                        }
+
+                        copies.emplace(key, SharedBindingCopy{ group->getId(), bindingResource.srv });
                     }
                 }
             }
@@ -301,17 +408,20 @@ void RenderingBindingManager::UpdateTextureBindings(command_list* cmd_list, uint
     vector<ToggleGroup*> vsRemovalList;
     vector<ToggleGroup*> csRemovalList;
 
+    // Copies are only shared within one update since the source can be rewritten between draws
+    binding_copies copies;
+
     if (psToUpdateBindings.size() > 0)
     {
-        _UpdateTextureBindings(cmd_list, deviceData, commandListData.ps.bindingsToUpdate, psRemovalList, psToUpdateBindings);
+        _UpdateTextureBindings(cmd_list, deviceData, commandListData.ps.bindingsToUpdate, psRemovalList, psToUpdateBindings, copies);
     }
     if (vsToUpdateBindings.size() > 0)
     {
-        _UpdateTextureBindings(cmd_list, deviceData, commandListData.vs.bindingsToUpdate, vsRemovalList, vsToUpdateBindings);
+        _UpdateTextureBindings(cmd_list, deviceData, commandListData.vs.bindingsToUpdate, vsRemovalList, vsToUpdateBindings, copies);
     }
     if (csToUpdateBindings.size() > 0)
     {
-        _UpdateTextureBindings(cmd_list, deviceData, commandListData.cs.bindingsToUpdate, csRemovalList, csToUpdateBindings);
+        _UpdateTextureBindings(cmd_list, deviceData, commandListData.cs.bindingsToUpdate, csRemovalList, csToUpdateBindings, copies);
     }
     mtx.unlock();
 
@@ -332,6 +442,115 @@ void RenderingBindingManager::UpdateTextureBindings(command_list* cmd_list, uint
 
 }
 
+void RenderingBindingManager::OnRenderTargetsBound(command_list* cmd_list, uint32_t count, const resource_view* rtvs, resource_view dsv)
+{
+    if (!uiData.GetSkipUnchangedBindingCopies())
+    {
+        return;
+    }
+
+    device* device = cmd_list->get_device();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        OnResourceViewWritten(device, rtvs[i]);
+    }
+
+    OnResourceViewWritten(device, dsv);
+}
+
+void RenderingBindingManager::OnResourceViewWritten(device* device, resource_view view)
+{
+    if (view == 0 || !uiData.GetSkipUnchangedBindingCopies())
+    {
+        return;
+    }
+
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    shared_lock<shared_mutex> lock(data.write_mutex);
+
+    if (!data.resourceWrites.empty())
+    {
+        _StampWrite(data, _GetViewResource(device, data, view));
+    }
+}
+
+void RenderingBindingManager::OnResourceWritten(device* device, resource res)
+{
+    if (res == 0 || !uiData.GetSkipUnchangedBindingCopies())
+    {
+        return;
+    }
+
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    shared_lock<shared_mutex> lock(data.write_mutex);
+    _StampWrite(data, res.handle);
+}
+
+void RenderingBindingManager::_StampWrite(DeviceDataContainer& deviceData, uint64_t res)
+{
+    const auto written = deviceData.resourceWrites.find(res);
+
+    if (written != deviceData.resourceWrites.end())
+    {
+        written->second.store(deviceData.writeGeneration.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t RenderingBindingManager::_GetViewResource(device* device, DeviceDataContainer& deviceData, resource_view view)
+{
+    const auto viewResource = deviceData.writeViewResources.find(view.handle);
+
+    // Views created before the addon was loaded aren't known
+    return viewResource != deviceData.writeViewResources.end() ? viewResource->second : device->get_resource_from_view(view).handle;
+}
+
+void RenderingBindingManager::OnInitResourceView(device* device, resource res, resource_usage usage_type, resource_view view)
+{
+    if ((usage_type & (resource_usage::render_target | resource_usage::depth_stencil)) == 0 || view == 0)
+    {
+        return;
+    }
+
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    unique_lock<shared_mutex> lock(data.write_mutex);
+    data.writeViewResources[view.handle] = res.handle;
+}
+
+void RenderingBindingManager::OnDestroyResourceView(device* device, resource_view view)
+{
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    unique_lock<shared_mutex> lock(data.write_mutex);
+    data.writeViewResources.erase(view.handle);
+}
+
+void RenderingBindingManager::OnResourceDestroyed(device* device, resource res)
+{
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    // Handles can be reused, a resource created later starts out unstamped
+    unique_lock<shared_mutex> lock(data.write_mutex);
+    data.resourceWrites.erase(res.handle);
+}
+
+void RenderingBindingManager::OnReshadePresent(device* device)
+{
+    _frameBindingCopies = _bindingCopies.exchange(0, std::memory_order_relaxed);
+    _frameElidedBindingCopies = _elidedBindingCopies.exchange(0, std::memory_order_relaxed);
+
+    DeviceDataContainer& data = device->get_private_data<DeviceDataContainer>();
+
+    if (!uiData.GetSkipUnchangedBindingCopies())
+    {
+        unique_lock<shared_mutex> lock(data.write_mutex);
+        data.resourceWrites.clear();
+    }
+}
+
 void RenderingBindingManager::ClearUnmatchedTextureBindings(reshade::api::command_list* cmd_list)
 {
     DeviceDataContainer& data = cmd_list->get_device()->get_private_data<DeviceDataContainer>();
@@ -345,6 +564,22 @@ void RenderingBindingManager::ClearUnmatchedTextureBindings(reshade::api::comman
         ToggleGroup& group = groupData.second;
         GroupResource& resources = group.GetGroupResource(ShaderToggler::GroupResourceType::RESOURCE_BINDING);
 
+        // Unbind copies shared from a group whose buffer was recreated, disposed or removed
+        if (resources.state == ShaderToggler::GroupResourceState::RESOURCE_SHARED && empty_srv != 0)
+        {
+            const auto share = data.bindingShares.find(group.getId());
+            const auto owner = share == data.bindingShares.end() ? uiData.GetToggleGroups().end() : uiData.GetToggleGroups().find(share->second.owner);
+
+            if (owner == uiData.GetToggleGroups().end() ||
+                owner->second.GetGroupResource(ShaderToggler::GroupResourceType::RESOURCE_BINDING).srv != share->second.srv ||
+                owner->second.GetGroupResource(ShaderToggler::GroupResourceType::RESOURCE_BINDING).state == ShaderToggler::GroupResourceState::RESOURCE_RECREATED)
+            {
+                data.current_runtime->update_texture_bindings(group.getTextureBindingName().c_str(), empty_srv, empty_srv);
+                resources.state = ShaderToggler::GroupResourceState::RESOURCE_CLEARED;
+                continue;
+            }
+        }
+
         if (!data.bindingsUpdated.contains(&group) && (resources.clear_on_miss() && empty_srv != 0 && resources.state != ShaderToggler::GroupResourceState::RESOURCE_CLEARED))
         {
             data.current_runtime->update_texture_bindings(group.getTextureBindingName().c_str(), empty_srv, empty_srv);
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <tuple>
 #include "RenderingManager.h"
 #include "ToggleGroupResourceManager.h"
 
 namespace Rendering
 {
+    // Source resource, invocation location, view format and flip of a binding copy
+    using binding_copy_key = std::tuple<uint64_t, uint64_t, reshade::api::format, bool>;
+    using binding_copies = std::map<binding_copy_key, SharedBindingCopy>;
+
     class __declspec(novtable) RenderingBindingManager final
     {
     public:
@@ -18,6 +25,17 @@ namespace Rendering
         void DisposeTextureBindings(reshade::api::device* device);
         void UpdateTextureBindings(reshade::api::command_list* cmd_list, uint64_t callLocation = CALL_DRAW, uint64_t invocation = MATCH_NONE);
         void ClearUnmatchedTextureBindings(reshade::api::command_list* cmd_list);
+
+        // Write tracking used to skip copies of binding sources that haven't changed since they were last copied
+        void OnRenderTargetsBound(reshade::api::command_list* cmd_list, uint32_t count, const reshade::api::resource_view* rtvs, reshade::api::resource_view dsv);
+        void OnResourceWritten(reshade::api::device* device, reshade::api::resource res);
+        void OnResourceViewWritten(reshade::api::device* device, reshade::api::resource_view view);
+        void OnResourceDestroyed(reshade::api::device* device, reshade::api::resource res);
+        void OnInitResourceView(reshade::api::device* device, reshade::api::resource res, reshade::api::resource_usage usage_type, reshade::api::resource_view view);
+        void OnDestroyResourceView(reshade::api::device* device, reshade::api::resource_view view);
+        void OnReshadePresent(reshade::api::device* device);
+        uint64_t GetFrameBindingCopies() const { return _frameBindingCopies; }
+        uint64_t GetFrameElidedBindingCopies() const { return _frameElidedBindingCopies; }
     private:
         AddonImGui::AddonUIData& uiData;
         ResourceManager& resourceManager;
@@ -27,11 +45,22 @@ namespace Rendering
         reshade::api::resource_view empty_srv = { 0 };
         reshade::api::resource_view empty_rtv = { 0 };
 
+        std::atomic_uint64_t _bindingCopies = 0;
+        std::atomic_uint64_t _elidedBindingCopies = 0;
+        uint64_t _frameBindingCopies = 0;
+        uint64_t _frameElidedBindingCopies = 0;
+
         void _UpdateTextureBindings(reshade::api::command_list* cmd_list,
             DeviceDataContainer& deviceData,
             const binding_queue& bindingsToUpdate,
             std::vector<ShaderToggler::ToggleGroup*>& removalList,
-            const std::unordered_set<ShaderToggler::ToggleGroup*>& toUpdateBindings);
+            const std::unordered_set<ShaderToggler::ToggleGroup*>& toUpdateBindings,
+            binding_copies& copies);
+        bool _IsBindingSourceUnchanged(reshade::api::command_list* cmd_list, DeviceDataContainer& deviceData, const ShaderToggler::ToggleGroup* group, reshade::api::resource source);
+        // Expects write_mutex to be held
+        static uint64_t _GetViewResource(reshade::api::device* device, DeviceDataContainer& deviceData, reshade::api::resource_view view);
+        static void _StampWrite(DeviceDataContainer& deviceData, uint64_t res);
+        bool _ShareTextureBinding(reshade::api::effect_runtime* runtime, DeviceDataContainer& deviceData, ShaderToggler::ToggleGroup* group, const SharedBindingCopy& copy);
         bool _CreateTextureBinding(reshade::api::effect_runtime* runtime,
             reshade::api::resource* res,
             reshade::api::resource_view* srv,
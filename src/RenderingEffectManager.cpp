@@ -7,8 +7,20 @@ using namespace ShaderToggler;
 using namespace reshade::api;
 using namespace std;
 
-RenderingEffectManager::RenderingEffectManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, RenderingShaderManager& shManager, ToggleGroupResourceManager& tgrManager) : 
-    uiData(data), resourceManager(rManager), shaderManager(shManager), groupResourceManager(tgrManager)
+// Estimated bytes no longer moved compared to preserving alpha with a full copy. The full copy reads and writes the
+// target and restoring reads the copy again, the mask path reads the target once and writes and reads the mask.
+static uint64_t getAlphaTrafficSaved(const resource_desc& desc, reshade::api::format targetFormat, reshade::api::format maskFormat)
+{
+    const uint64_t targetSize = static_cast<uint64_t>(format_row_pitch(targetFormat, desc.texture.width)) * desc.texture.height;
+    const uint64_t maskSize = maskFormat != format::unknown ? static_cast<uint64_t>(format_row_pitch(maskFormat, desc.texture.width)) * desc.texture.height : 0;
+    const uint64_t fullCopy = 3 * targetSize;
+    const uint64_t maskCopy = maskFormat != format::unknown ? targetSize + 2 * maskSize : 0;
+
+    return fullCopy > maskCopy ? fullCopy - maskCopy : 0;
+}
+
+RenderingEffectManager::RenderingEffectManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, RenderingShaderManager& shManager, ToggleGroupResourceManager& tgrManager, GroupCostTracker& gcTracker) : 
+    uiData(data), resourceManager(rManager), shaderManager(shManager), groupResourceManager(tgrManager), costTracker(gcTracker)
 {
 }
 
@@ -103,19 +115,64 @@ bool RenderingEffectManager::_RenderEffects(
         resource_view view_srgb = {};
         resource_view group_view = {};
         resource_desc desc = cmd_list->get_device()->get_resource_desc(active_resource.resource);
-        GroupResource& groupResource = group->GetGroupResource(GroupResourceType::RESOURCE_ALPHA);
         const shared_ptr<GlobalResourceView>& view = resourceManager.GetResourceView(runtime->get_device(), active_resource);
         bool copyPreserveAlpha = false;
+        bool maskPreserveAlpha = false;
+        resource_view alpha_mask_rtv = {};
+        resource_view alpha_mask_srv = {};
 
         if (view == nullptr)
         {
             continue;
         }
 
+        GroupCostTimer groupTimer(costTracker, cmd_list, group, SCOPE_GROUP);
+
         if (group->getPreserveAlpha())
         {
-            if (groupResourceManager.IsCompatibleWithGroupFormat(runtime->get_device(), GroupResourceType::RESOURCE_ALPHA, active_resource.resource, group))
+            reshade::api::format maskFormat = format::unknown;
+            AlphaPreserveMode alphaMode = ToggleGroupResourceManager::GetAlphaPreserveMode(runtime->get_device()->get_api(), active_resource.format, &maskFormat);
+
+            if (alphaMode == AlphaPreserveMode::ALPHA_MASK && view->srv != 0)
+            {
+                resource_desc maskDesc = desc;
+                maskDesc.texture.format = maskFormat;
+
+                if (groupResourceManager.AcquireGroupBuffer(runtime->get_device(), GroupResourceType::RESOURCE_ALPHA_MASK, active_resource.resource, group, maskDesc, maskFormat))
+                {
+                    groupResourceManager.SetGroupBufferHandles(group, GroupResourceType::RESOURCE_ALPHA_MASK, nullptr, &alpha_mask_rtv, nullptr, &alpha_mask_srv);
+                }
+            }
+
+            // The full copy protects alpha whenever the mask buffer isn't there yet or the mask shaders don't work with these formats
+            if (alphaMode == AlphaPreserveMode::ALPHA_MASK && (alpha_mask_srv == 0 || !shaderManager.IsAlphaMaskAvailable(runtime->get_device(), view->rtv, alpha_mask_rtv)))
+            {
+                alphaMode = AlphaPreserveMode::ALPHA_COPY;
+            }
+
+            if (alphaMode == AlphaPreserveMode::ALPHA_NONE)
+            {
+                view_non_srgb = view->rtv;
+                view_srgb = view->rtv_srgb;
+
+                costTracker.RecordBandwidthSaved(getAlphaTrafficSaved(desc, active_resource.format, format::unknown));
+            }
+            else if (alphaMode == AlphaPreserveMode::ALPHA_MASK)
             {
+                GroupCostTimer alphaTimer(costTracker, cmd_list, group, SCOPE_ALPHA);
+
+                view_non_srgb = view->rtv;
+                view_srgb = view->rtv_srgb;
+
+                shaderManager.ExtractAlpha(cmd_list, view->srv, alpha_mask_rtv, desc.texture.width, desc.texture.height);
+                maskPreserveAlpha = true;
+
+                costTracker.RecordBandwidthSaved(getAlphaTrafficSaved(desc, active_resource.format, maskFormat));
+            }
+            else if (groupResourceManager.AcquireGroupBuffer(runtime->get_device(), GroupResourceType::RESOURCE_ALPHA, active_resource.resource, group, desc, active_resource.format))
+            {
+                GroupCostTimer alphaTimer(costTracker, cmd_list, group, SCOPE_ALPHA);
+
                 resource group_res = {};
                 groupResourceManager.SetGroupBufferHandles(group, GroupResourceType::RESOURCE_ALPHA, &group_res, &view_non_srgb, &view_srgb, &group_view);
                 cmd_list->copy_resource(active_resource.resource, group_res);
@@ -125,10 +182,6 @@ bool RenderingEffectManager::_RenderEffects(
             {
                 view_non_srgb = view->rtv;
                 view_srgb = view->rtv_srgb;
-
-                groupResource.state = GroupResourceState::RESOURCE_INVALID;
-                groupResource.target_description = desc;
-                groupResource.view_format = active_resource.format;
             }
         }
         else
@@ -144,17 +197,22 @@ bool RenderingEffectManager::_RenderEffects(
 
         if (group->getFlipBuffer() && runtimeData.specialEffects[REST_FLIP].technique != 0)
         {
+            GroupCostTimer techniqueTimer(costTracker, cmd_list, group, SCOPE_TECHNIQUE, runtimeData.specialEffects[REST_FLIP].technique.handle);
             runtime->render_technique(runtimeData.specialEffects[REST_FLIP].technique, cmd_list, view_non_srgb, view_srgb);
         }
 
         if (group->getToneMap() && runtimeData.specialEffects[REST_TONEMAP_TO_SDR].technique != 0)
         {
+            GroupCostTimer techniqueTimer(costTracker, cmd_list, group, SCOPE_TECHNIQUE, runtimeData.specialEffects[REST_TONEMAP_TO_SDR].technique.handle);
             runtime->render_technique(runtimeData.specialEffects[REST_TONEMAP_TO_SDR].technique, cmd_list, view_non_srgb, view_srgb);
         }
 
         for (const auto& effectTech : effectList)
         {
-            runtime->render_technique(effectTech->technique, cmd_list, view_non_srgb, view_srgb);
+            {
+                GroupCostTimer techniqueTimer(costTracker, cmd_list, group, SCOPE_TECHNIQUE, effectTech->technique.handle);
+                runtime->render_technique(effectTech->technique, cmd_list, view_non_srgb, view_srgb);
+            }
 
             effectTech->rendered = true;
 
@@ -165,21 +223,32 @@ bool RenderingEffectManager::_RenderEffects(
 
         if (group->getToneMap() && runtimeData.specialEffects[REST_TONEMAP_TO_HDR].technique != 0)
         {
+            GroupCostTimer techniqueTimer(costTracker, cmd_list, group, SCOPE_TECHNIQUE, runtimeData.specialEffects[REST_TONEMAP_TO_HDR].technique.handle);
             runtime->render_technique(runtimeData.specialEffects[REST_TONEMAP_TO_HDR].technique, cmd_list, view_non_srgb, view_srgb);
         }
 
         if (group->getFlipBuffer() && runtimeData.specialEffects[REST_FLIP].technique != 0)
         {
+            GroupCostTimer techniqueTimer(costTracker, cmd_list, group, SCOPE_TECHNIQUE, runtimeData.specialEffects[REST_FLIP].technique.handle);
             runtime->render_technique(runtimeData.specialEffects[REST_FLIP].technique, cmd_list, view_non_srgb, view_srgb);
         }
 
+        if (maskPreserveAlpha)
+        {
+            GroupCostTimer alphaTimer(costTracker, cmd_list, group, SCOPE_ALPHA);
+            shaderManager.RestoreAlpha(cmd_list, alpha_mask_srv, view->rtv, desc.texture.width, desc.texture.height);
+        }
+
         if (copyPreserveAlpha)
         {
             resource_view target_view_non_srgb = view->rtv;
             resource_view target_view_srgb = view->rtv_srgb;
 
             if (target_view_non_srgb != 0)
+            {
+                GroupCostTimer alphaTimer(costTracker, cmd_list, group, SCOPE_ALPHA);
                 shaderManager.CopyResourceMaskAlpha(cmd_list, group_view, target_view_non_srgb, desc.texture.width, desc.texture.height);
+            }
         }
     }
 
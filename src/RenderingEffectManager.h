@@ -3,13 +3,14 @@
 #include "RenderingManager.h"
 #include "RenderingShaderManager.h"
 #include "ToggleGroupResourceManager.h"
+#include "GroupCostTracker.h"
 
 namespace Rendering
 {
     class __declspec(novtable) RenderingEffectManager final
     {
     public:
-        RenderingEffectManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, RenderingShaderManager& shManager, ToggleGroupResourceManager& tgrManager);
+        RenderingEffectManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, RenderingShaderManager& shManager, ToggleGroupResourceManager& tgrManager, GroupCostTracker& gcTracker);
         ~RenderingEffectManager();
 
         void RenderEffects(reshade::api::command_list* cmd_list, uint64_t callLocation = CALL_DRAW, uint64_t invocation = MATCH_NONE);
@@ -20,6 +21,7 @@ namespace Rendering
         ResourceManager& resourceManager;
         RenderingShaderManager& shaderManager;
         ToggleGroupResourceManager& groupResourceManager;
+        GroupCostTracker& costTracker;
 
         bool _RenderEffects(
             reshade::api::command_list* cmd_list,
@@ -1,11 +1,12 @@
 #include "RenderingQueueManager.h"
+#include "Profiling.h"
 
 using namespace Rendering;
 using namespace ShaderToggler;
 using namespace reshade::api;
 using namespace std;
 
-RenderingQueueManager::RenderingQueueManager(AddonImGui::AddonUIData& data, ResourceManager& rManager) : uiData(data), resourceManager(rManager)
+RenderingQueueManager::RenderingQueueManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, FrameBudgetGovernor& fGovernor) : uiData(data), resourceManager(rManager), governor(fGovernor)
 {
 }
 
@@ -16,115 +17,101 @@ RenderingQueueManager::~RenderingQueueManager()
 
 void RenderingQueueManager::_CheckCallForCommandList(ShaderData& sData, CommandListDataContainer& commandListData, DeviceDataContainer& deviceData, RuntimeDataContainer& runtimeData) const
 {
+    PROFILE_EVENT(EVENT_CHECK_CALL);
+
     // Masks which checks to perform. Note that we will always schedule a draw call check for binding and effect updates,
     // this serves the purpose of assigning the resource_view to perform the update later on if needed.
     uint64_t queue_mask = MATCH_NONE;
 
-    // Shift in case of VS using data id
-    const uint64_t match_effect = MATCH_EFFECT_PS << sData.id;
-    const uint64_t match_binding = MATCH_BINDING_PS << sData.id;
-    const uint64_t match_const = MATCH_CONST_PS << sData.id;
-    const uint64_t match_preview = MATCH_PREVIEW_PS << sData.id;
+    // Optional work the frame budget governor may shed for this frame
+    const bool allowConstants = governor.IsAllowed(FEATURE_CONSTANTS);
+    const bool allowBindings = governor.IsAllowed(FEATURE_BINDINGS);
+    const bool allowPreview = governor.IsAllowed(FEATURE_PREVIEW);
 
     if (sData.blockedShaderGroups != nullptr)
     {
         for (auto group : *sData.blockedShaderGroups)
         {
-            if (group->isActive())
+            if (!group->isActive())
+            {
+                continue;
+            }
+
+            // Plan masks are for the pixel shader stage, shift in case of VS/CS using data id
+            const InvocationPlan& plan = group->getInvocationPlan();
+
+            if (allowConstants && plan.constantsMask != MATCH_NONE && !deviceData.constantsUpdated.contains(group))
             {
-                if (group->getExtractConstants() && !deviceData.constantsUpdated.contains(group))
+                if (!sData.constantBuffersToUpdate.contains(group))
                 {
-                    if (!sData.constantBuffersToUpdate.contains(group))
-                    {
-                        sData.constantBuffersToUpdate.emplace(group);
-                        queue_mask |= match_const;
-                    }
+                    sData.constantBuffersToUpdate.emplace(group);
+                    queue_mask |= plan.constantsMask << sData.id;
                 }
+            }
 
-                if (group->getId() == uiData.GetToggleGroupIdShaderEditing() && !deviceData.huntPreview.matched)
+            if (allowPreview && group->getId() == uiData.GetToggleGroupIdShaderEditing() && !deviceData.huntPreview.matched)
+            {
+                if (uiData.GetCurrentTabType() == AddonImGui::TAB_RENDER_TARGET)
                 {
-                    if (uiData.GetCurrentTabType() == AddonImGui::TAB_RENDER_TARGET)
-                    {
-                        if (group->getRenderToResourceViews())
-                        {
-                            queue_mask |= match_preview << (CALL_DRAW * MATCH_DELIMITER);
-                            deviceData.huntPreview.target_invocation_location = CALL_DRAW;
-                        }
-                        else
-                        {
-                            queue_mask |= (match_preview << (group->getInvocationLocation() * MATCH_DELIMITER)) | (match_preview << (CALL_DRAW * MATCH_DELIMITER));
-                            deviceData.huntPreview.target_invocation_location = group->getInvocationLocation();
-                        }
-                    }
+                    queue_mask |= plan.previewMask << sData.id;
+                    deviceData.huntPreview.target_invocation_location = plan.effectLocation;
                 }
+            }
 
-                if (group->isProvidingTextureBinding() && !deviceData.bindingsUpdated.contains(group))
+            if (plan.bindingMask != MATCH_NONE && !deviceData.bindingsUpdated.contains(group))
+            {
+                if (!allowBindings)
                 {
-                    if (!sData.bindingsToUpdate.contains(group))
-                    {
-                        if (!group->getCopyTextureBinding() || group->getExtractResourceViews())
-                        {
-                            sData.bindingsToUpdate.emplace(group, ResourceRenderData{ group, CALL_DRAW, resource{ 0 }, format::unknown });
-                            queue_mask |= (match_binding << CALL_DRAW * MATCH_DELIMITER);
-                        }
-                        else
-                        {
-                            sData.bindingsToUpdate.emplace(group, ResourceRenderData{ group, group->getBindingInvocationLocation(), resource{ 0 }, format::unknown });
-                            queue_mask |= (match_binding << (group->getBindingInvocationLocation() * MATCH_DELIMITER)) | (match_binding << (CALL_DRAW * MATCH_DELIMITER));
-                        }
-                    }
+                    // The group matched but its copy is shed this frame. Count it as updated so clear on miss keeps the last copy bound.
+                    deviceData.bindingsUpdated.emplace(group);
                 }
-
-                if (group->getAllowAllTechniques())
+                else if (!sData.bindingsToUpdate.contains(group))
                 {
-                    auto& preferred = group->GetPreferredTechniqueData();
+                    sData.bindingsToUpdate.emplace(group, ResourceRenderData{ group, plan.bindingLocation, resource{ 0 }, format::unknown });
+                    queue_mask |= plan.bindingMask << sData.id;
+                }
+            }
 
-                    for (const auto& techData : runtimeData.allEnabledTechniques)
-                    {
-                        if (group->getHasTechniqueExceptions() && preferred.contains(techData))
-                        {
-                            continue;
-                        }
-
-                        if (!techData->rendered)
-                        {
-                            if (!sData.techniquesToRender.contains(techData))
-                            {
-                                if (group->getRenderToResourceViews())
-                                {
-                                    sData.techniquesToRender.emplace(techData, ResourceRenderData{ group, CALL_DRAW, resource{ 0 }, format::unknown });
-                                    queue_mask |= (match_effect << CALL_DRAW * MATCH_DELIMITER);
-                                }
-                                else
-                                {
-                                    sData.techniquesToRender.emplace(techData, ResourceRenderData{ group, group->getInvocationLocation(), resource{ 0 }, format::unknown });
-                                    queue_mask |= (match_effect << (group->getInvocationLocation() * MATCH_DELIMITER)) | (match_effect << (CALL_DRAW * MATCH_DELIMITER));
-                                }
-                            }
-                        }
-                    }
+            if (plan.techniques == TechniqueSelection::NONE)
+            {
+                continue;
+            }
+
+            const uint64_t effectMask = plan.effectMask << sData.id;
+            const auto& preferred = group->GetPreferredTechniqueData();
+            bool queued = false;
+
+            auto queueTechnique = [&](EffectData* techData) {
+                if (!techData->rendered && sData.techniquesToRender.try_emplace(techData, ResourceRenderData{ group, plan.effectLocation, resource{ 0 }, format::unknown }).second)
+                {
+                    queued = true;
                 }
-                else if (group->preferredTechniques().size() > 0) {
-                    auto& preferred = group->GetPreferredTechniqueData();
+            };
 
-                    for (auto& eff : preferred)
+            if (plan.techniques == TechniqueSelection::PREFERRED)
+            {
+                for (const auto& techData : preferred)
+                {
+                    queueTechnique(techData);
+                }
+            }
+            else
+            {
+                for (const auto& techData : runtimeData.allEnabledTechniques)
+                {
+                    if (plan.techniques == TechniqueSelection::ALL_EXCEPT_PREFERRED && preferred.contains(techData))
                     {
-                        if (!eff->rendered && !sData.techniquesToRender.contains(eff))
-                        {
-                            if (group->getRenderToResourceViews())
-                            {
-                                sData.techniquesToRender.emplace(eff, ResourceRenderData{ group, CALL_DRAW, resource{ 0 }, format::unknown });
-                                queue_mask |= (match_effect << CALL_DRAW * MATCH_DELIMITER);
-                            }
-                            else
-                            {
-                                sData.techniquesToRender.emplace(eff, ResourceRenderData{ group, group->getInvocationLocation(), resource{ 0 }, format::unknown });
-                                queue_mask |= (match_effect << (group->getInvocationLocation() * MATCH_DELIMITER)) | (match_effect << (CALL_DRAW * MATCH_DELIMITER));
-                            }
-                        }
+                        continue;
                     }
+
+                    queueTechnique(techData);
                 }
             }
+
+            if (queued)
+            {
+                queue_mask |= effectMask;
+            }
         }
     }
 
@@ -1,13 +1,14 @@
 #pragma once
 
 #include "RenderingManager.h"
+#include "FrameBudgetGovernor.h"
 
 namespace Rendering
 {
     class __declspec(novtable) RenderingQueueManager final
     {
     public:
-        RenderingQueueManager(AddonImGui::AddonUIData& data, ResourceManager& rManager);
+        RenderingQueueManager(AddonImGui::AddonUIData& data, ResourceManager& rManager, FrameBudgetGovernor& fGovernor);
         ~RenderingQueueManager();
 
         void RescheduleGroups(CommandListDataContainer& commandListData, DeviceDataContainer& deviceData);
@@ -17,6 +18,7 @@ namespace Rendering
     private:
         AddonImGui::AddonUIData& uiData;
         ResourceManager& resourceManager;
+        FrameBudgetGovernor& governor;
 
         void _RescheduleGroups(ShaderData& sData, CommandListDataContainer& commandListData, DeviceDataContainer& deviceData);
         void _CheckCallForCommandList(ShaderData& sData, CommandListDataContainer& commandListData, DeviceDataContainer& deviceData, RuntimeDataContainer& runtimeData) const;
@@ -16,9 +16,14 @@ RenderingShaderManager::~RenderingShaderManager()
 {
 }
 
-bool RenderingShaderManager::CreatePipeline(reshade::api::device* device, reshade::api::pipeline_layout layout, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, uint8_t write_mask)
+bool RenderingShaderManager::IsSupportedAPI(device_api api)
 {
-    if (sh_pipeline == 0 && (device->get_api() == device_api::d3d9 || device->get_api() == device_api::d3d10 || device->get_api() == device_api::d3d11 || device->get_api() == device_api::d3d12))
+    return api == device_api::d3d9 || api == device_api::d3d10 || api == device_api::d3d11 || api == device_api::d3d12 || api == device_api::vulkan;
+}
+
+bool RenderingShaderManager::CreatePipeline(reshade::api::device* device, reshade::api::pipeline_layout layout, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, uint8_t write_mask, bool blend, reshade::api::format rt_format)
+{
+    if (sh_pipeline == 0 && IsSupportedAPI(device->get_api()))
     {
         const EmbeddedResourceData vs = resourceManager.GetResourceData(vs_resource_id);
         const EmbeddedResourceData ps = resourceManager.GetResourceData(ps_resource_id);
@@ -40,7 +45,7 @@ bool RenderingShaderManager::CreatePipeline(reshade::api::device* device, reshad
         }
 
         blend_desc blend_state;
-        blend_state.blend_enable[0] = true;
+        blend_state.blend_enable[0] = blend;
         blend_state.source_color_blend_factor[0] = blend_factor::source_alpha;
         blend_state.dest_color_blend_factor[0] = blend_factor::one_minus_source_alpha;
         blend_state.color_blend_op[0] = blend_op::add;
@@ -57,6 +62,11 @@ bool RenderingShaderManager::CreatePipeline(reshade::api::device* device, reshad
 
         subobjects.push_back({ pipeline_subobject_type::rasterizer_state, 1, &rasterizer_state });
 
+        if (rt_format != format::unknown)
+        {
+            subobjects.push_back({ pipeline_subobject_type::render_target_formats, 1, &rt_format });
+        }
+
         if (!device->create_pipeline(layout, static_cast<uint32_t>(subobjects.size()), subobjects.data(), &sh_pipeline))
         {
             sh_pipeline = {};
@@ -71,9 +81,9 @@ bool RenderingShaderManager::CreatePipeline(reshade::api::device* device, reshad
     return false;
 }
 
-void RenderingShaderManager::InitShader(reshade::api::device* device, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, reshade::api::pipeline_layout& sh_layout, reshade::api::sampler& sh_sampler)
+void RenderingShaderManager::InitShader(reshade::api::device* device, reshade::api::pipeline_layout& sh_layout, reshade::api::sampler& sh_sampler)
 {
-    if (sh_pipeline == 0 && (device->get_api() == device_api::d3d9 || device->get_api() == device_api::d3d10 || device->get_api() == device_api::d3d11 || device->get_api() == device_api::d3d12))
+    if (sh_layout == 0 && IsSupportedAPI(device->get_api()))
     {
         sampler_desc sampler_desc = {};
         sampler_desc.filter = filter_mode::min_mag_mip_point;
@@ -86,13 +96,11 @@ void RenderingShaderManager::InitShader(reshade::api::device* device, uint16_t p
         layout_params[1] = descriptor_range{ 0, 0, 0, 1, shader_stage::all, 1, descriptor_type::shader_resource_view };
 
         if (!device->create_pipeline_layout(2, layout_params, &sh_layout) ||
-            !CreatePipeline(device, sh_layout, ps_resource_id, vs_resource_id, sh_pipeline) ||
             !device->create_sampler(sampler_desc, &sh_sampler))
         {
-            sh_pipeline = {};
             sh_layout = {};
             sh_sampler = {};
-            reshade::log_message(reshade::log_level::warning, "Unable to create preview copy pipeline");
+            reshade::log_message(reshade::log_level::warning, "Unable to create preview copy pipeline layout");
         }
 
         if (fullscreenQuadVertexBuffer == 0 && device->get_api() == device_api::d3d9)
@@ -124,68 +132,177 @@ void RenderingShaderManager::InitShader(reshade::api::device* device, uint16_t p
     }
 }
 
-void RenderingShaderManager::InitShaders(reshade::api::device* device)
+void RenderingShaderManager::CreatePipelines(reshade::api::device* device, ShaderPipelines& sh_pipelines, reshade::api::format rt_format)
 {
+    uint16_t vs = SHADER_FULLSCREEN_VS_4_0;
+    uint16_t copy_ps = SHADER_PREVIEW_COPY_PS_4_0;
+    uint16_t extract_ps = SHADER_ALPHA_EXTRACT_PS_4_0;
+    uint16_t restore_ps = SHADER_ALPHA_RESTORE_PS_4_0;
+
     if (device->get_api() == device_api::d3d9)
     {
-        InitShader(device, SHADER_PREVIEW_COPY_PS_3_0, SHADER_FULLSCREEN_VS_3_0, copyPipeline, copyPipelineLayout, copyPipelineSampler);
-        CreatePipeline(device, copyPipelineLayout, SHADER_PREVIEW_COPY_PS_3_0, SHADER_FULLSCREEN_VS_3_0, copyPipelineAlpha, 0x7);
+        vs = SHADER_FULLSCREEN_VS_3_0;
+        copy_ps = SHADER_PREVIEW_COPY_PS_3_0;
+        extract_ps = SHADER_ALPHA_EXTRACT_PS_3_0;
+        restore_ps = SHADER_ALPHA_RESTORE_PS_3_0;
     }
-    else
+    else if (device->get_api() == device_api::vulkan)
+    {
+        vs = SHADER_FULLSCREEN_VS_SPIRV;
+        copy_ps = SHADER_PREVIEW_COPY_PS_SPIRV;
+        extract_ps = SHADER_ALPHA_EXTRACT_PS_SPIRV;
+        restore_ps = SHADER_ALPHA_RESTORE_PS_SPIRV;
+    }
+
+    CreatePipeline(device, copyPipelineLayout, copy_ps, vs, sh_pipelines[PIPELINE_COPY], 0xF, true, rt_format);
+    CreatePipeline(device, copyPipelineLayout, copy_ps, vs, sh_pipelines[PIPELINE_COPY_ALPHA], 0x7, true, rt_format);
+    CreatePipeline(device, copyPipelineLayout, extract_ps, vs, sh_pipelines[PIPELINE_ALPHA_EXTRACT], 0xF, true, rt_format);
+    CreatePipeline(device, copyPipelineLayout, restore_ps, vs, sh_pipelines[PIPELINE_ALPHA_RESTORE], 0x8, false, rt_format);
+}
+
+pipeline RenderingShaderManager::GetPipeline(reshade::api::device* device, ShaderPipeline sh_pipeline, resource_view rtv_dst)
+{
+    if (!perFormatPipelines)
+    {
+        return pipelines[sh_pipeline];
+    }
+
+    {
+        shared_lock<shared_mutex> lock(formatPipelineMutex);
+
+        const auto view = viewPipelines.find(rtv_dst.handle);
+        if (view != viewPipelines.end())
+        {
+            return (*view->second)[sh_pipeline];
+        }
+    }
+
+    const reshade::api::format rt_format = device->get_resource_view_desc(rtv_dst).format;
+
+    unique_lock<shared_mutex> lock(formatPipelineMutex);
+
+    auto [it, inserted] = formatPipelines.try_emplace(rt_format, ShaderPipelines{});
+    if (inserted)
+    {
+        // Failed pipelines stay empty so they're not attempted again on every copy
+        CreatePipelines(device, it->second, rt_format);
+    }
+
+    viewPipelines[rtv_dst.handle] = &it->second;
+
+    return it->second[sh_pipeline];
+}
+
+void RenderingShaderManager::OnDestroyResourceView(resource_view view)
+{
+    if (!perFormatPipelines)
+    {
+        return;
+    }
+
+    {
+        shared_lock<shared_mutex> lock(formatPipelineMutex);
+
+        if (!viewPipelines.contains(view.handle))
+        {
+            return;
+        }
+    }
+
+    // The handle may be reused for a view of a different format
+    unique_lock<shared_mutex> lock(formatPipelineMutex);
+    viewPipelines.erase(view.handle);
+}
+
+bool RenderingShaderManager::IsAlphaMaskAvailable(reshade::api::device* device, resource_view rtv_target, resource_view rtv_mask)
+{
+    if (copyPipelineLayout == 0 || rtv_target == 0 || rtv_mask == 0)
+    {
+        return false;
+    }
+
+    return GetPipeline(device, PIPELINE_ALPHA_EXTRACT, rtv_mask) != 0 && GetPipeline(device, PIPELINE_ALPHA_RESTORE, rtv_target) != 0;
+}
+
+void RenderingShaderManager::InitShaders(reshade::api::device* device)
+{
+    perFormatPipelines = device->get_api() == device_api::vulkan;
+
+    InitShader(device, copyPipelineLayout, copyPipelineSampler);
+
+    if (copyPipelineLayout != 0 && !perFormatPipelines)
     {
-        InitShader(device, SHADER_PREVIEW_COPY_PS_4_0, SHADER_FULLSCREEN_VS_4_0, copyPipeline, copyPipelineLayout, copyPipelineSampler);
-        CreatePipeline(device, copyPipelineLayout, SHADER_PREVIEW_COPY_PS_4_0, SHADER_FULLSCREEN_VS_4_0, copyPipelineAlpha, 0x7);
+        CreatePipelines(device, pipelines);
     }
 }
 
 void RenderingShaderManager::DestroyShaders(reshade::api::device* device)
 {
-    if (copyPipeline != 0)
+    for (auto& sh_pipeline : pipelines)
     {
-        //device->destroy_pipeline(copyPipeline);
-        copyPipeline = {};
+        if (sh_pipeline != 0)
+        {
+            device->destroy_pipeline(sh_pipeline);
+            sh_pipeline = {};
+        }
     }
 
-    if (copyPipelineAlpha != 0)
     {
-        //device->destroy_pipeline(copyPipelineAlpha);
-        copyPipelineAlpha = {};
+        unique_lock<shared_mutex> lock(formatPipelineMutex);
+
+        for (auto& [rt_format, sh_pipelines] : formatPipelines)
+        {
+            for (auto& sh_pipeline : sh_pipelines)
+            {
+                if (sh_pipeline != 0)
+                {
+                    device->destroy_pipeline(sh_pipeline);
+                }
+            }
+        }
+
+        viewPipelines.clear();
+        formatPipelines.clear();
     }
 
     if (copyPipelineLayout != 0)
     {
-        //device->destroy_pipeline_layout(copyPipelineLayout);
+        device->destroy_pipeline_layout(copyPipelineLayout);
         copyPipelineLayout = {};
     }
 
     if (copyPipelineSampler != 0)
     {
-        //device->destroy_sampler(copyPipelineSampler);
+        device->destroy_sampler(copyPipelineSampler);
         copyPipelineSampler = {};
     }
+
+    if (fullscreenQuadVertexBuffer != 0)
+    {
+        device->destroy_resource(fullscreenQuadVertexBuffer);
+        fullscreenQuadVertexBuffer = {};
+    }
 }
 
-void RenderingShaderManager::ApplyShader(command_list* cmd_list, resource_view srv_src, resource_view rtv_dst, pipeline& sh_pipeline,
-    pipeline_layout& sh_layout, sampler& sh_sampler, uint32_t width, uint32_t height)
+void RenderingShaderManager::ApplyShader(command_list* cmd_list, resource_view srv_src, resource_view rtv_dst, ShaderPipeline sh_pipeline,
+    pipeline_layout sh_layout, sampler sh_sampler, uint32_t width, uint32_t height)
 {
     device* device = cmd_list->get_device();
 
-    //if (device->get_api() == device_api::d3d12)
-    //{
-    //    DestroyShaders(device);
-    //    InitShaders(device);
-    //}
-
-    if (sh_pipeline == 0 || !(device->get_api() == device_api::d3d9 || device->get_api() == device_api::d3d10 || device->get_api() == device_api::d3d11 || device->get_api() == device_api::d3d12))
+    if (sh_layout == 0 || !IsSupportedAPI(device->get_api()))
     {
         return;
     }
 
-    cmd_list->get_private_data<state_tracking>().capture(cmd_list, true);
+    const pipeline active_pipeline = GetPipeline(device, sh_pipeline, rtv_dst);
+    if (active_pipeline == 0)
+    {
+        return;
+    }
 
     cmd_list->bind_render_targets_and_depth_stencil(1, &rtv_dst);
 
-    cmd_list->bind_pipeline(pipeline_stage::all_graphics, sh_pipeline);
+    cmd_list->bind_pipeline(pipeline_stage::all_graphics, active_pipeline);
 
     cmd_list->push_descriptors(shader_stage::pixel, sh_layout, 0, descriptor_table_update{ {}, 0, 0, 1, descriptor_type::sampler, &sh_sampler });
     cmd_list->push_descriptors(shader_stage::pixel, sh_layout, 1, descriptor_table_update{ {}, 0, 0, 1, descriptor_type::shader_resource_view, &srv_src });
@@ -210,12 +327,28 @@ void RenderingShaderManager::ApplyShader(command_list* cmd_list, resource_view s
 
 void RenderingShaderManager::CopyResource(command_list* cmd_list, resource_view srv_src, resource_view rtv_dst, uint32_t width, uint32_t height)
 {
-    ApplyShader(cmd_list, srv_src, rtv_dst, copyPipeline, copyPipelineLayout, copyPipelineSampler, width, height);
+    cmd_list->get_private_data<state_tracking>().capture(cmd_list, true);
+    ApplyShader(cmd_list, srv_src, rtv_dst, PIPELINE_COPY, copyPipelineLayout, copyPipelineSampler, width, height);
     cmd_list->get_private_data<state_tracking>().apply(cmd_list, true);
 }
 
 void RenderingShaderManager::CopyResourceMaskAlpha(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, uint32_t width, uint32_t height)
 {
-    ApplyShader(cmd_list, srv_src, rtv_dst, copyPipelineAlpha, copyPipelineLayout, copyPipelineSampler, width, height);
+    cmd_list->get_private_data<state_tracking>().capture(cmd_list, true);
+    ApplyShader(cmd_list, srv_src, rtv_dst, PIPELINE_COPY_ALPHA, copyPipelineLayout, copyPipelineSampler, width, height);
+    cmd_list->get_private_data<state_tracking>().apply(cmd_list, true);
+}
+
+void RenderingShaderManager::ExtractAlpha(command_list* cmd_list, resource_view srv_src, resource_view rtv_dst, uint32_t width, uint32_t height)
+{
+    cmd_list->get_private_data<state_tracking>().capture(cmd_list, true);
+    ApplyShader(cmd_list, srv_src, rtv_dst, PIPELINE_ALPHA_EXTRACT, copyPipelineLayout, copyPipelineSampler, width, height);
     cmd_list->get_private_data<state_tracking>().apply(cmd_list, true);
-}
\ No newline at end of file
+}
+
+void RenderingShaderManager::RestoreAlpha(command_list* cmd_list, resource_view srv_src, resource_view rtv_dst, uint32_t width, uint32_t height)
+{
+    cmd_list->get_private_data<state_tracking>().capture(cmd_list, true);
+    ApplyShader(cmd_list, srv_src, rtv_dst, PIPELINE_ALPHA_RESTORE, copyPipelineLayout, copyPipelineSampler, width, height);
+    cmd_list->get_private_data<state_tracking>().apply(cmd_list, true);
+}
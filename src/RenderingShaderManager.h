@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <mutex>
+#include <shared_mutex>
 #include "RenderingManager.h"
 
 namespace Rendering
@@ -12,10 +15,27 @@ namespace Rendering
 
         void InitShaders(reshade::api::device* device);
         void DestroyShaders(reshade::api::device* device);
+        void OnDestroyResourceView(reshade::api::resource_view view);
 
         void CopyResource(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, uint32_t width, uint32_t height);
         void CopyResourceMaskAlpha(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, uint32_t width, uint32_t height);
+        bool IsCopyAvailable() const { return perFormatPipelines ? copyPipelineLayout != 0 : pipelines[PIPELINE_COPY] != 0 && pipelines[PIPELINE_COPY_ALPHA] != 0; }
+        void ExtractAlpha(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, uint32_t width, uint32_t height);
+        void RestoreAlpha(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, uint32_t width, uint32_t height);
+        // Whether the mask can be extracted into rtv_mask and restored into rtv_target. On Vulkan this creates the pipelines for both formats.
+        bool IsAlphaMaskAvailable(reshade::api::device* device, reshade::api::resource_view rtv_target, reshade::api::resource_view rtv_mask);
     private:
+        enum ShaderPipeline : uint32_t
+        {
+            PIPELINE_COPY = 0,
+            PIPELINE_COPY_ALPHA,
+            PIPELINE_ALPHA_EXTRACT,
+            PIPELINE_ALPHA_RESTORE,
+            PIPELINE_COUNT
+        };
+
+        using ShaderPipelines = std::array<reshade::api::pipeline, PIPELINE_COUNT>;
+
         struct vert_uv
         {
             float x, y;
@@ -26,16 +46,25 @@ namespace Rendering
             vert_uv uv;
         };
 
-        void InitShader(reshade::api::device* device, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, reshade::api::pipeline_layout& sh_layout, reshade::api::sampler& sh_sampler);
-        void ApplyShader(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, reshade::api::pipeline& sh_pipeline,
-            reshade::api::pipeline_layout& sh_layout, reshade::api::sampler& sh_sampler, uint32_t width, uint32_t height);
-        bool CreatePipeline(reshade::api::device* device, reshade::api::pipeline_layout layout, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, uint8_t write_mask = 0xF);
+        static bool IsSupportedAPI(reshade::api::device_api api);
+        void InitShader(reshade::api::device* device, reshade::api::pipeline_layout& sh_layout, reshade::api::sampler& sh_sampler);
+        // Callers capture and restore the command list state around one or more draws
+        void ApplyShader(reshade::api::command_list* cmd_list, reshade::api::resource_view srv_src, reshade::api::resource_view rtv_dst, ShaderPipeline sh_pipeline,
+            reshade::api::pipeline_layout sh_layout, reshade::api::sampler sh_sampler, uint32_t width, uint32_t height);
+        bool CreatePipeline(reshade::api::device* device, reshade::api::pipeline_layout layout, uint16_t ps_resource_id, uint16_t vs_resource_id, reshade::api::pipeline& sh_pipeline, uint8_t write_mask = 0xF, bool blend = true, reshade::api::format rt_format = reshade::api::format::unknown);
+        void CreatePipelines(reshade::api::device* device, ShaderPipelines& sh_pipelines, reshade::api::format rt_format = reshade::api::format::unknown);
+        reshade::api::pipeline GetPipeline(reshade::api::device* device, ShaderPipeline sh_pipeline, reshade::api::resource_view rtv_dst);
 
         AddonImGui::AddonUIData& uiData;
         ResourceManager& resourceManager;
 
-        reshade::api::pipeline copyPipeline;
-        reshade::api::pipeline copyPipelineAlpha;
+        ShaderPipelines pipelines = {};
+        // Vulkan pipelines are tied to the format of the render target they write to, so they're created on first use per format
+        bool perFormatPipelines = false;
+        std::shared_mutex formatPipelineMutex;
+        std::unordered_map<reshade::api::format, ShaderPipelines> formatPipelines;
+        // Pipelines per render target view, so copies don't have to query the view's format every time
+        std::unordered_map<uint64_t, const ShaderPipelines*> viewPipelines;
         reshade::api::pipeline_layout copyPipelineLayout;
         reshade::api::sampler copyPipelineSampler;
 
@@ -4,6 +4,7 @@
 #include <reshade_api_device.hpp>
 #include <reshade_api_pipeline.hpp>
 #include <unordered_map>
+#include <mutex>
 #include <shared_mutex>
 
 #include "ResourceShim.h"
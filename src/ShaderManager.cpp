@@ -30,6 +30,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include "ShaderManager.h"
 
 using namespace reshade::api;
@@ -37,7 +38,42 @@ using namespace std;
 
 namespace ShaderToggler
 {
-    ShaderManager::ShaderManager() : _activeHuntedShaderHash(0)
+    static atomic_uint32_t s_shaderManagerCount = 0;
+
+    CollectionBuffer::CollectionBuffer() : _head(new Chunk()), _tail(_head)
+    {
+    }
+
+
+    CollectionBuffer::~CollectionBuffer()
+    {
+        while (_head != nullptr)
+        {
+            Chunk* next = _head->next.load(std::memory_order_relaxed);
+            delete _head;
+            _head = next;
+        }
+    }
+
+
+    void CollectionBuffer::append(const CollectionEvent& event)
+    {
+        uint32_t count = _tail->count.load(std::memory_order_relaxed);
+
+        if (count == ChunkSize)
+        {
+            Chunk* chunk = new Chunk();
+            _tail->next.store(chunk, std::memory_order_release);
+            _tail = chunk;
+            count = 0;
+        }
+
+        _tail->events[count] = event;
+        _tail->count.store(count + 1, std::memory_order_release);
+    }
+
+
+    ShaderManager::ShaderManager() : _activeHuntedShaderHash(0), _id(s_shaderManagerCount++)
     {
     }
 
@@ -61,13 +97,34 @@ namespace ShaderToggler
             const auto& it = _handleToShaderHash.find(handle);
             const auto& shaderHash = it->second;
             _handleToShaderHash.erase(handle);
-            _collectedActiveShaderHashes.erase(shaderHash);
+
+            {
+                unique_lock lock(_collectedActiveHandlesMutex);
+                const auto& collected = _collectedActiveShaderIndices.find(shaderHash);
+                if (collected != _collectedActiveShaderIndices.end())
+                {
+                    const uint32_t index = collected->second;
+                    _collectedActiveShaderIndices.erase(collected);
+                    _collectedActiveShaderHashes.erase(_collectedActiveShaderHashes.begin() + index);
+
+                    // keep the order stable, shift the indices of everything after the removed hash
+                    for (uint32_t i = index; i < _collectedActiveShaderHashes.size(); i++)
+                    {
+                        _collectedActiveShaderIndices[_collectedActiveShaderHashes[i]] = i;
+                    }
+
+                    _markedLinksDirty = true;
+                }
+
+                _collectedShaderStats.erase(shaderHash);
+            }
+
             _shaderHashes.erase(shaderHash);
         }
     }
 
 
-    void ShaderManager::startHuntingMode(const unordered_set<uint32_t> currentMarkedHashes)
+    void ShaderManager::startHuntingMode(span<const uint32_t> currentMarkedHashes)
     {
         // copy the currently marked hashes (from the active group) to the set of marked hashes.
         {
@@ -84,9 +141,20 @@ namespace ShaderToggler
         _activeHuntedShaderIndex = -1;
         _activeHuntedShaderHash = 0;
         {
+            unique_lock bufferLock(_collectionBuffersMutex);
             unique_lock lock(_collectedActiveHandlesMutex);
             _collectedActiveShaderHashes.clear();			// clear it so we start with a clean slate
+            _collectedActiveShaderIndices.clear();
+            _collectedShaderStats.clear();
+            _collectedSequence = 0;
+
+            // drop whatever was recorded before hunting started
+            for (auto& buffer : _collectionBuffers)
+            {
+                buffer->consume([](const CollectionEvent&) {});
+            }
         }
+        _markedLinksDirty = true;
     }
 
 
@@ -107,6 +175,7 @@ namespace ShaderToggler
             unique_lock lock(_markedShaderHashMutex);
             _markedShaderHashes.clear();
         }
+        _markedLinksDirty = true;
     }
 
 
@@ -119,9 +188,70 @@ namespace ShaderToggler
         }
 
         // no lock needed, collecting phase is over
-        auto it = _collectedActiveShaderHashes.begin();
-        std::advance(it, _activeHuntedShaderIndex);
-        _activeHuntedShaderHash = *it;
+        _activeHuntedShaderHash = _collectedActiveShaderHashes[_activeHuntedShaderIndex];
+    }
+
+
+    void ShaderManager::updateMarkedLinks()
+    {
+        if (!_markedLinksDirty.exchange(false))
+        {
+            return;
+        }
+
+        shared_lock lock(_markedShaderHashMutex);
+
+        const int32_t count = static_cast<int32_t>(_collectedActiveShaderHashes.size());
+        _nextMarkedIndex.assign(count, -1);
+        _previousMarkedIndex.assign(count, -1);
+
+        // Walking the list twice lets the links wrap around its end. A shader that's the only marked one links to itself.
+        int32_t nextMarked = -1;
+        for (int32_t i = count * 2 - 1; i >= 0; i--)
+        {
+            const int32_t index = i % count;
+            _nextMarkedIndex[index] = nextMarked;
+
+            if (_markedShaderHashes.contains(_collectedActiveShaderHashes[index]))
+            {
+                nextMarked = index;
+            }
+        }
+
+        int32_t previousMarked = -1;
+        for (int32_t i = 0; i < count * 2; i++)
+        {
+            const int32_t index = i % count;
+            _previousMarkedIndex[index] = previousMarked;
+
+            if (_markedShaderHashes.contains(_collectedActiveShaderHashes[index]))
+            {
+                previousMarked = index;
+            }
+        }
+    }
+
+
+    int32_t ShaderManager::findMarkedShaderIndex(bool forward)
+    {
+        updateMarkedLinks();
+
+        const int32_t count = static_cast<int32_t>(_collectedActiveShaderHashes.size());
+        if (count == 0 || static_cast<int32_t>(_nextMarkedIndex.size()) != count)
+        {
+            return -1;
+        }
+
+        if (_activeHuntedShaderIndex < 0 || _activeHuntedShaderIndex >= count)
+        {
+            // nothing hunted yet, start at the first or last marked shader
+            const int32_t edge = forward ? 0 : count - 1;
+            return isHuntedShaderMarked(_collectedActiveShaderHashes[edge]) ? edge : (forward ? _nextMarkedIndex[edge] : _previousMarkedIndex[edge]);
+        }
+
+        const int32_t index = forward ? _nextMarkedIndex[_activeHuntedShaderIndex] : _previousMarkedIndex[_activeHuntedShaderIndex];
+
+        return index == _activeHuntedShaderIndex ? -1 : index;
     }
 
 
@@ -145,33 +275,12 @@ namespace ShaderToggler
                 return;
             }
 
-            // we have marked shaders, find the next one in collected active shader hashes that's part of this set.
-            auto it = _collectedActiveShaderHashes.begin();
-            int index = _activeHuntedShaderIndex + 1;
-            std::advance(it, index);
-            bool foundHash = false;
-            uint32_t hash = 0;
-            while (index != _activeHuntedShaderIndex)
-            {
-                if (it == _collectedActiveShaderHashes.end())
-                {
-                    it = _collectedActiveShaderHashes.begin();
-                    index = 0;
-                }
-                hash = *it;
-                if (_markedShaderHashes.contains(hash))
-                {
-                    // found one
-                    foundHash = true;
-                    break;
-                }
-                ++it;
-                index++;
-            }
-            if (foundHash)
+            // we have marked shaders, jump to the next one in collected active shader hashes that's part of this set.
+            const int32_t index = findMarkedShaderIndex(true);
+            if (index >= 0)
             {
                 _activeHuntedShaderIndex = index;
-                _activeHuntedShaderHash = hash;
+                _activeHuntedShaderHash = _collectedActiveShaderHashes[index];
             }
             // always done
             return;
@@ -207,34 +316,12 @@ namespace ShaderToggler
                 // also if there are no marked shaders, we won't find a next, so return now too.
                 return;
             }
-            // we have marked shaders, find the next one in collected active shader hashes that's part of this set.
-            auto it = _collectedActiveShaderHashes.begin();
-            int32_t index = _activeHuntedShaderIndex - 1;
-            std::advance(it, index);
-            bool foundHash = false;
-            uint32_t hash = 0;
-            while (index != _activeHuntedShaderIndex)
-            {
-                if (it == _collectedActiveShaderHashes.begin())
-                {
-                    it = _collectedActiveShaderHashes.end();
-                    --it;
-                    index = static_cast<int32_t>(_collectedActiveShaderHashes.size()) - 1;
-                }
-                hash = *it;
-                if (_markedShaderHashes.contains(hash))
-                {
-                    // found one
-                    foundHash = true;
-                    break;
-                }
-                --it;
-                index--;
-            }
-            if (foundHash)
+            // we have marked shaders, jump to the previous one in collected active shader hashes that's part of this set.
+            const int32_t index = findMarkedShaderIndex(false);
+            if (index >= 0)
             {
                 _activeHuntedShaderIndex = index;
-                _activeHuntedShaderHash = hash;
+                _activeHuntedShaderHash = _collectedActiveShaderHashes[index];
             }
             // always done
             return;
@@ -297,12 +384,224 @@ namespace ShaderToggler
     void ShaderManager::addActivePipelineHandle(uint64_t handle)
     {
         // get the shader hash bound to this pipeline handle
-        const auto shaderHash = getShaderHash(handle);
+        collectShaderBind(getShaderHash(handle));
+    }
+
+
+    CollectionBuffer& ShaderManager::getCollectionBuffer()
+    {
+        thread_local vector<CollectionBuffer*> buffers;
+
+        if (_id >= buffers.size())
+        {
+            buffers.resize(_id + 1, nullptr);
+        }
+
+        CollectionBuffer*& buffer = buffers[_id];
+        if (buffer == nullptr)
+        {
+            // only locked the first time a thread collects for this manager
+            unique_ptr<CollectionBuffer> created = make_unique<CollectionBuffer>();
+            buffer = created.get();
+
+            unique_lock lock(_collectionBuffersMutex);
+            _collectionBuffers.push_back(std::move(created));
+        }
+
+        return *buffer;
+    }
+
+
+    void ShaderManager::collectShaderBind(uint32_t shaderHash)
+    {
         if (shaderHash > 0)
         {
-            unique_lock lock(_collectedActiveHandlesMutex);
-            _collectedActiveShaderHashes.emplace(shaderHash);
+            getCollectionBuffer().append(CollectionEvent{ shaderHash, 0, 0, 0, false });
+        }
+    }
+
+
+    void ShaderManager::collectShaderDraw(uint32_t shaderHash, uint32_t width, uint32_t height)
+    {
+        if (shaderHash == 0 || shaderHash == UINT32_MAX)
+        {
+            return;
+        }
+
+        CollectionBuffer& buffer = getCollectionBuffer();
+        buffer.append(CollectionEvent{ shaderHash, nextDrawIndex(buffer), width, height, true });
+    }
+
+
+    void ShaderManager::collectShaderRepeats(bool isDraw, uint32_t shaderHash, uint32_t count)
+    {
+        if (shaderHash == 0 || shaderHash == UINT32_MAX || count == 0)
+        {
+            return;
+        }
+
+        getCollectionBuffer().append(CollectionEvent{ shaderHash, UINT32_MAX, 0, 0, isDraw, count });
+    }
+
+
+    void ShaderManager::skipShaderDraw()
+    {
+        nextDrawIndex(getCollectionBuffer());
+    }
+
+
+    uint32_t ShaderManager::nextDrawIndex(CollectionBuffer& buffer)
+    {
+        // draw indices restart every frame, so they're the position of the draw within the frame on this thread
+        const uint64_t frame = _frame.load(std::memory_order_relaxed);
+        if (buffer.frame != frame)
+        {
+            buffer.frame = frame;
+            buffer.drawIndex = 0;
+        }
+
+        return buffer.drawIndex++;
+    }
+
+
+    bool ShaderManager::addCollectedShaderHash(uint32_t shaderHash)
+    {
+        if (_collectedActiveShaderIndices.try_emplace(shaderHash, static_cast<uint32_t>(_collectedActiveShaderHashes.size())).second)
+        {
+            _collectedActiveShaderHashes.push_back(shaderHash);
+            _collectedShaderStats[shaderHash].firstSeen = _collectedSequence++;
+            _markedLinksDirty = true;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    size_t ShaderManager::mergeCollectedShaders()
+    {
+        _frame.fetch_add(1, std::memory_order_relaxed);
+
+        unique_lock bufferLock(_collectionBuffersMutex);
+        unique_lock lock(_collectedActiveHandlesMutex);
+
+        bool changed = false;
+        size_t newShaders = 0;
+
+        for (auto& buffer : _collectionBuffers)
+        {
+            buffer->consume([&](const CollectionEvent& event) {
+                if (addCollectedShaderHash(event.shaderHash))
+                {
+                    newShaders++;
+                }
+
+                CollectedShaderStats& stats = _collectedShaderStats[event.shaderHash];
+                if (event.isDraw)
+                {
+                    stats.drawCount += event.count;
+
+                    // repeats carry no draw index nor viewport
+                    if (event.drawIndex != UINT32_MAX)
+                    {
+                        stats.firstDrawIndex = std::min(stats.firstDrawIndex, event.drawIndex);
+                        stats.width = event.width;
+                        stats.height = event.height;
+                    }
+                }
+                else
+                {
+                    stats.bindCount += event.count;
+                }
+
+                changed = true;
+                });
+        }
+
+        if (changed && _collectedShaderOrder != CollectedShaderOrder::FIRST_SEEN)
+        {
+            sortCollectedShaders();
+        }
+
+        return newShaders;
+    }
+
+
+    void ShaderManager::setCollectedShaderOrder(CollectedShaderOrder order)
+    {
+        if (order == _collectedShaderOrder)
+        {
+            return;
+        }
+
+        unique_lock lock(_collectedActiveHandlesMutex);
+
+        _collectedShaderOrder = order;
+        sortCollectedShaders();
+    }
+
+
+    void ShaderManager::sortCollectedShaders()
+    {
+        static const CollectedShaderStats noStats;
+
+        const auto statsOf = [&](uint32_t hash) -> const CollectedShaderStats& {
+            const auto& it = _collectedShaderStats.find(hash);
+            return it == _collectedShaderStats.end() ? noStats : it->second;
+        };
+
+        // ties keep the order in which the shaders were first seen, so the result doesn't shuffle between frames
+        std::sort(_collectedActiveShaderHashes.begin(), _collectedActiveShaderHashes.end(), [&](uint32_t a, uint32_t b) {
+            const CollectedShaderStats& sa = statsOf(a);
+            const CollectedShaderStats& sb = statsOf(b);
+
+            switch (_collectedShaderOrder)
+            {
+            case CollectedShaderOrder::DRAW_ORDER:
+                if (sa.firstDrawIndex != sb.firstDrawIndex)
+                {
+                    return sa.firstDrawIndex < sb.firstDrawIndex;
+                }
+                break;
+            case CollectedShaderOrder::DRAW_COUNT:
+                if (sa.drawCount != sb.drawCount)
+                {
+                    return sa.drawCount > sb.drawCount;
+                }
+                break;
+            case CollectedShaderOrder::TARGET_SIZE:
+            {
+                const uint64_t areaA = static_cast<uint64_t>(sa.width) * sa.height;
+                const uint64_t areaB = static_cast<uint64_t>(sb.width) * sb.height;
+                if (areaA != areaB)
+                {
+                    return areaA > areaB;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+
+            return sa.firstSeen < sb.firstSeen;
+            });
+
+        for (uint32_t i = 0; i < _collectedActiveShaderHashes.size(); i++)
+        {
+            _collectedActiveShaderIndices[_collectedActiveShaderHashes[i]] = i;
         }
+
+        // the hunted shader stays selected, wherever it ended up
+        if (_activeHuntedShaderIndex >= 0)
+        {
+            const auto& it = _collectedActiveShaderIndices.find(_activeHuntedShaderHash);
+            if (it != _collectedActiveShaderIndices.end())
+            {
+                _activeHuntedShaderIndex = static_cast<int32_t>(it->second);
+            }
+        }
+
+        _markedLinksDirty = true;
     }
 
 
@@ -323,6 +622,7 @@ namespace ShaderToggler
             // add it
             _markedShaderHashes.emplace(_activeHuntedShaderHash);
         }
+        _markedLinksDirty = true;
     }
 
 
@@ -35,15 +35,112 @@
 #include <map>
 #include <reshade_api_device.hpp>
 #include <reshade_api_pipeline.hpp>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <span>
 #include <unordered_set>
 #include <tsl/robin_map.h>
 #include "CDataFile.h"
 #include "ToggleGroup.h"
+#include "Profiling.h"
 
 
 namespace ShaderToggler
 {
+    enum class CollectedShaderOrder : uint32_t
+    {
+        FIRST_SEEN = 0,
+        DRAW_ORDER,
+        DRAW_COUNT,
+        TARGET_SIZE
+    };
+
+    /// <summary>
+    /// What was seen of a shader during the collection phase. The dimensions are those of the viewport of its last recorded draw.
+    /// </summary>
+    struct CollectedShaderStats
+    {
+        uint64_t firstSeen = 0;
+        uint32_t firstDrawIndex = UINT32_MAX;
+        uint32_t bindCount = 0;
+        uint32_t drawCount = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct CollectionEvent
+    {
+        uint32_t shaderHash;
+        uint32_t drawIndex;
+        uint32_t width;
+        uint32_t height;
+        bool isDraw;
+        uint32_t count = 1;
+    };
+
+    /// <summary>
+    /// Unbounded single producer, single consumer queue of collection events. The thread owning the buffer appends to it without
+    /// locking, the present thread consumes it.
+    /// </summary>
+    class __declspec(novtable) CollectionBuffer final
+    {
+    public:
+        CollectionBuffer();
+        ~CollectionBuffer();
+
+        void append(const CollectionEvent& event);
+
+        template<typename F>
+        void consume(F&& func)
+        {
+            while (true)
+            {
+                const uint32_t count = _head->count.load(std::memory_order_acquire);
+                for (; _consumed < count; _consumed++)
+                {
+                    func(_head->events[_consumed]);
+                }
+
+                if (count < ChunkSize)
+                {
+                    return;
+                }
+
+                // The producer has moved on to a next chunk once it's linked, so the full one can go
+                Chunk* next = _head->next.load(std::memory_order_acquire);
+                if (next == nullptr)
+                {
+                    return;
+                }
+
+                delete _head;
+                _head = next;
+                _consumed = 0;
+            }
+        }
+
+        // Only touched by the owning thread
+        uint64_t frame = 0;
+        uint32_t drawIndex = 0;
+
+    private:
+        static constexpr uint32_t ChunkSize = 1024;
+
+        struct Chunk
+        {
+            std::array<CollectionEvent, ChunkSize> events;
+            std::atomic_uint32_t count = 0;
+            std::atomic<Chunk*> next = nullptr;
+        };
+
+        Chunk* _head;
+        Chunk* _tail;
+        uint32_t _consumed = 0;
+    };
+
     /// <summary>
     /// Class which manages a set of shaders for a given type (pixel, vertex...)
     /// </summary>
@@ -59,7 +156,7 @@ namespace ShaderToggler
         ///	where the user can step through collected active shaders to mark them for assignment to the current edited group.
         /// </summary>
         /// <param name="currentMarkedHashes"></param>
-        void startHuntingMode(const std::unordered_set<uint32_t> currentMarkedHashes);
+        void startHuntingMode(std::span<const uint32_t> currentMarkedHashes);
         void stopHuntingMode();
         /// <summary>
         /// Moves to the next shader. If control is pressed as well, it'll step to the next marked shader (if any). If there aren't any shaders in that
@@ -88,12 +185,36 @@ namespace ShaderToggler
         /// <returns></returns>
         uint32_t getShaderHash(uint64_t handle);
         void addActivePipelineHandle(uint64_t handle);
+        /// <summary>
+        /// Records a bind or a draw of the given shader during the collection phase. Only appends to a buffer owned by the calling thread,
+        /// the buffers are merged into the collected shaders by mergeCollectedShaders.
+        /// </summary>
+        void collectShaderBind(uint32_t shaderHash);
+        void collectShaderDraw(uint32_t shaderHash, uint32_t width, uint32_t height);
+        /// <summary>
+        /// Records binds or draws of a shader that were already reported this frame. They only add to the counts, skipShaderDraw keeps
+        /// the draw indices of the draws that follow in place.
+        /// </summary>
+        void collectShaderRepeats(bool isDraw, uint32_t shaderHash, uint32_t count);
+        void skipShaderDraw();
+        /// <summary>
+        /// Merges what the render threads collected since the last call. Called once per frame on the present thread.
+        /// </summary>
+        /// <returns>the number of shaders that weren't collected before</returns>
+        size_t mergeCollectedShaders();
+        void setCollectedShaderOrder(CollectedShaderOrder order);
+        CollectedShaderOrder getCollectedShaderOrder() const { return _collectedShaderOrder; }
+        const CollectedShaderStats* getCollectedShaderStats(uint32_t shaderHash) const
+        {
+            const auto& it = _collectedShaderStats.find(shaderHash);
+            return it == _collectedShaderStats.end() ? nullptr : &it->second;
+        }
         void toggleMarkOnHuntedShader();
         void resetActiveHuntedShader();
 
         size_t getPipelineCount() { return _handleToShaderHash.size(); }
         size_t getShaderCount() { return _shaderHashes.size(); }
-        const std::unordered_set<uint32_t>& getCollectedShaderHashes() const { return _collectedActiveShaderHashes; }
+        const std::vector<uint32_t>& getCollectedShaderHashes() const { return _collectedActiveShaderHashes; }
         void setActivedHuntedShaderIndex(uint32_t index);
         size_t getAmountShaderHashesCollected() { return _collectedActiveShaderHashes.size(); }
         bool isInHuntingMode() const { return _isInHuntingMode; }
@@ -121,15 +242,8 @@ namespace ShaderToggler
 
         uint32_t getCollectedShaderHash(uint32_t index)
         {
-            if (index < 0 || _collectedActiveShaderHashes.size() <= 0 || index >= _collectedActiveShaderHashes.size())
-            {
-                return 0;
-            }
-
             // no lock needed, collecting phase is over
-            auto it = _collectedActiveShaderHashes.begin();
-            std::advance(it, index);
-            return *it;
+            return index < _collectedActiveShaderHashes.size() ? _collectedActiveShaderHashes[index] : 0;
         }
 
         size_t getMarkedShaderCount()
@@ -146,6 +260,8 @@ namespace ShaderToggler
 
         inline uint32_t safeGetShaderHash(uint64_t pipelineHandle)
         {
+            PROFILE_EVENT(EVENT_SHADER_HANDLE_LOOKUP);
+
             std::shared_lock lock(_hashHandlesMutex);
             const auto& it = _handleToShaderHash.find(pipelineHandle);
 
@@ -154,11 +270,30 @@ namespace ShaderToggler
 
     private:
         void setActiveHuntedShaderHandle();
+        CollectionBuffer& getCollectionBuffer();
+        uint32_t nextDrawIndex(CollectionBuffer& buffer);
+        bool addCollectedShaderHash(uint32_t shaderHash);
+        void sortCollectedShaders();
+        void updateMarkedLinks();
+        int32_t findMarkedShaderIndex(bool forward);
 
         std::unordered_set<uint32_t> _shaderHashes;				// all shader hashes added through init pipeline
         //std::unordered_map<uint64_t, uint32_t> _handleToShaderHash;		// pipeline handle per shader hash. Handle is removed when a pipeline is destroyed.
         tsl::robin_map<uint64_t, uint32_t> _handleToShaderHash;
-        std::unordered_set<uint32_t> _collectedActiveShaderHashes;	// shader hashes bound to pipeline handles which were collected during the collection phase after hunting was enabled, which are the pipeline handles active during the last X frames
+        std::vector<uint32_t> _collectedActiveShaderHashes;	// shader hashes bound to pipeline handles which were collected during the collection phase after hunting was enabled, which are the pipeline handles active during the last X frames. In the order they were first seen.
+        tsl::robin_map<uint32_t, uint32_t> _collectedActiveShaderIndices;	// index of each collected shader hash in _collectedActiveShaderHashes
+        std::vector<int32_t> _nextMarkedIndex;		// per collected shader, the index of the next marked one, wrapping around. -1 if none are marked.
+        std::vector<int32_t> _previousMarkedIndex;	// per collected shader, the index of the previous marked one, wrapping around. -1 if none are marked.
+        std::atomic_bool _markedLinksDirty = true;
+        tsl::robin_map<uint32_t, CollectedShaderStats> _collectedShaderStats;
+        CollectedShaderOrder _collectedShaderOrder = CollectedShaderOrder::FIRST_SEEN;
+        uint64_t _collectedSequence = 0;
+
+        // Collection buffers of all threads that recorded something for this manager
+        const uint32_t _id;
+        std::atomic_uint64_t _frame = 0;
+        std::mutex _collectionBuffersMutex;
+        std::vector<std::unique_ptr<CollectionBuffer>> _collectionBuffers;
         std::unordered_set<uint32_t> _markedShaderHashes;		// the hashes for shaders which are currently marked.
 
         bool _isInHuntingMode = false;
@@ -6,6 +6,7 @@
 #include <limits>
 #include "reshade.hpp"
 #include "StateTracking.h"
+#include "Profiling.h"
 
 using namespace reshade::api;
 using namespace StateTracking;
@@ -90,6 +91,8 @@ void state_block::apply_descriptors(command_list* cmd_list) const
 
 void state_block::capture(command_list* cmd_list, bool force_restore)
 {
+    PROFILE_EVENT(EVENT_STATE_CAPTURE);
+
     if (force_restore && cmd_list->get_device()->get_api() == device_api::d3d9 && dx_state == nullptr)
     {
         IDirect3DDevice9* device = reinterpret_cast<IDirect3DDevice9*>(cmd_list->get_device()->get_native());
@@ -103,6 +106,8 @@ void state_block::capture(command_list* cmd_list, bool force_restore)
 
 void state_block::apply(command_list* cmd_list, bool force_restore)
 {
+    PROFILE_EVENT(EVENT_STATE_APPLY);
+
     switch (cmd_list->get_device()->get_api())
     {
     case device_api::d3d9:
@@ -359,6 +364,8 @@ static void on_bind_scissor_rects(command_list* cmd_list, uint32_t first, uint32
 
 static void on_bind_descriptor_tables(command_list* cmd_list, shader_stage stages, pipeline_layout layout, uint32_t first, uint32_t count, const descriptor_table* tables)
 {
+    PROFILE_EVENT(EVENT_BIND_DESCRIPTOR_TABLES);
+
     int32_t idx = get_shader_stage_index(stages);
 
     if (idx < 0)
@@ -422,6 +429,8 @@ static void on_bind_descriptor_tables(command_list* cmd_list, shader_stage stage
 
 static void on_bind_descriptor_tables_no_track(command_list* cmd_list, shader_stage stages, pipeline_layout layout, uint32_t first, uint32_t count, const descriptor_table* tables)
 {
+    PROFILE_EVENT(EVENT_BIND_DESCRIPTOR_TABLES);
+
     int32_t idx = get_shader_stage_index(stages);
 
     if (idx < 0)
@@ -483,6 +492,8 @@ static inline void fill_descriptors(std::vector<descriptor_tracking::descriptor_
 
 static void on_push_descriptors(command_list* cmd_list, shader_stage stages, pipeline_layout layout, uint32_t layout_param, const descriptor_table_update& update)
 {
+    PROFILE_EVENT(EVENT_PUSH_DESCRIPTORS);
+
     int32_t idx = get_shader_stage_index(stages);
 
     if (idx < 0)
@@ -528,6 +539,8 @@ static void on_push_descriptors(command_list* cmd_list, shader_stage stages, pip
 
 static void on_push_constants(command_list* cmd_list, shader_stage stages, pipeline_layout layout, uint32_t layout_param, uint32_t first, uint32_t count, const void* values)
 {
+    PROFILE_EVENT(EVENT_PUSH_CONSTANTS);
+
     int32_t idx = get_shader_stage_index(stages);
 
     if (idx < 0)
@@ -8,6 +8,7 @@
 #include <vector>
 #include <array>
 #include <unordered_map>
+#include <mutex>
 #include <shared_mutex>
 #include <unordered_set>
 #include <d3d9.h>
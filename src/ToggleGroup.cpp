@@ -30,12 +30,176 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <format>
 #include <sstream>
 #include "stdafx.h"
 #include "ToggleGroup.h"
+#include "RenderingManager.h"
 
 using namespace std;
 
+namespace
+{
+    // Shader hash lists are stored as a single base64 string of the sorted hashes, each hash written as the
+    // LEB128 varint of its distance to the previous one. This keeps large lists to a few bytes per hash.
+    constexpr char Base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    constexpr array<uint8_t, 256> MakeBase64Table()
+    {
+        array<uint8_t, 256> table = {};
+        table.fill(0xFF);
+
+        for (uint8_t i = 0; i < 64; i++)
+        {
+            table[static_cast<uint8_t>(Base64Chars[i])] = i;
+        }
+
+        return table;
+    }
+
+    constexpr array<uint8_t, 256> Base64Table = MakeBase64Table();
+
+    // Expects the hashes to be sorted
+    string PackHashes(const vector<uint32_t>& hashes)
+    {
+        vector<uint8_t> bytes;
+        bytes.reserve(hashes.size() * 5);
+
+        uint32_t previous = 0;
+        for (const auto hash : hashes)
+        {
+            uint32_t delta = hash - previous;
+            previous = hash;
+
+            while (delta >= 0x80)
+            {
+                bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+                delta >>= 7;
+            }
+            bytes.push_back(static_cast<uint8_t>(delta));
+        }
+
+        string packed;
+        packed.reserve((bytes.size() + 2) / 3 * 4);
+
+        size_t i = 0;
+        for (; i + 2 < bytes.size(); i += 3)
+        {
+            const uint32_t triple = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+            packed.push_back(Base64Chars[(triple >> 18) & 0x3F]);
+            packed.push_back(Base64Chars[(triple >> 12) & 0x3F]);
+            packed.push_back(Base64Chars[(triple >> 6) & 0x3F]);
+            packed.push_back(Base64Chars[triple & 0x3F]);
+        }
+
+        if (i < bytes.size())
+        {
+            const bool hasSecond = i + 1 < bytes.size();
+            const uint32_t triple = (bytes[i] << 16) | (hasSecond ? bytes[i + 1] << 8 : 0);
+            packed.push_back(Base64Chars[(triple >> 18) & 0x3F]);
+            packed.push_back(Base64Chars[(triple >> 12) & 0x3F]);
+            packed.push_back(hasSecond ? Base64Chars[(triple >> 6) & 0x3F] : '=');
+            packed.push_back('=');
+        }
+
+        return packed;
+    }
+
+    // Decodes into the hash list, which comes out sorted as the deltas are unsigned. Returns false if the string is malformed
+    bool UnpackHashes(string_view packed, vector<uint32_t>& hashes, size_t expected)
+    {
+        while (!packed.empty() && packed.back() == '=')
+        {
+            packed.remove_suffix(1);
+        }
+
+        if (packed.size() % 4 == 1)
+        {
+            return false;
+        }
+
+        vector<uint8_t> bytes;
+        bytes.reserve(packed.size() / 4 * 3 + 2);
+
+        size_t i = 0;
+        for (; i + 3 < packed.size(); i += 4)
+        {
+            const uint8_t a = Base64Table[static_cast<uint8_t>(packed[i])];
+            const uint8_t b = Base64Table[static_cast<uint8_t>(packed[i + 1])];
+            const uint8_t c = Base64Table[static_cast<uint8_t>(packed[i + 2])];
+            const uint8_t d = Base64Table[static_cast<uint8_t>(packed[i + 3])];
+
+            // Invalid characters have the high bit set, so one test covers all four
+            if ((a | b | c | d) & 0x80)
+            {
+                return false;
+            }
+
+            const uint32_t triple = (a << 18) | (b << 12) | (c << 6) | d;
+            bytes.push_back(static_cast<uint8_t>(triple >> 16));
+            bytes.push_back(static_cast<uint8_t>(triple >> 8));
+            bytes.push_back(static_cast<uint8_t>(triple));
+        }
+
+        if (i < packed.size())
+        {
+            uint32_t triple = 0;
+            const size_t remaining = packed.size() - i;
+
+            for (size_t j = 0; j < remaining; j++)
+            {
+                const uint8_t v = Base64Table[static_cast<uint8_t>(packed[i + j])];
+                if (v & 0x80)
+                {
+                    return false;
+                }
+                triple |= static_cast<uint32_t>(v) << (18 - j * 6);
+            }
+
+            bytes.push_back(static_cast<uint8_t>(triple >> 16));
+            if (remaining == 3)
+            {
+                bytes.push_back(static_cast<uint8_t>(triple >> 8));
+            }
+        }
+
+        hashes.reserve(expected);
+
+        uint32_t previous = 0;
+        uint32_t delta = 0;
+        uint32_t shift = 0;
+        for (const auto byte : bytes)
+        {
+            if (shift > 28)
+            {
+                return false;
+            }
+
+            delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+            if (byte & 0x80)
+            {
+                shift += 7;
+                continue;
+            }
+
+            // A zero delta after the first hash would be a duplicate, which the packer never writes
+            if (delta == 0 && !hashes.empty())
+            {
+                return false;
+            }
+
+            previous += delta;
+            hashes.push_back(previous);
+            delta = 0;
+            shift = 0;
+        }
+
+        return shift == 0;
+    }
+}
+
 namespace ShaderToggler
 {
     ToggleGroup::ToggleGroup(string name, int id)
@@ -60,9 +224,12 @@ namespace ShaderToggler
         _srvCycle = CYCLE_NONE;
         _rtCycle = CYCLE_NONE;
 
+        updateInvocationPlan();
+
         _group_buffers[static_cast<uint32_t>(GroupResourceType::RESOURCE_ALPHA)] = { {}, {}, {}, {}, {}, {}, {}, [&]() { return _preserveAlpha; }, [&]() { return false; }, GroupResourceState::RESOURCE_INVALID, true };
         _group_buffers[static_cast<uint32_t>(GroupResourceType::RESOURCE_BINDING)] = { {}, {}, {}, {}, {}, {}, {}, [&]() { return _copyTextureBinding && _isProvidingTextureBinding; }, [&]() { return _clearBindings; }, GroupResourceState::RESOURCE_INVALID, true };
         _group_buffers[static_cast<uint32_t>(GroupResourceType::RESOURCE_CONSTANTS_COPY)] = { {}, {}, {}, {}, {}, {}, {}, [&]() { return _extractConstants; }, [&]() { return false; }, GroupResourceState::RESOURCE_INVALID, true };
+        _group_buffers[static_cast<uint32_t>(GroupResourceType::RESOURCE_ALPHA_MASK)] = { {}, {}, {}, {}, {}, {}, {}, [&]() { return _preserveAlpha; }, [&]() { return false; }, GroupResourceState::RESOURCE_INVALID, true };
     }
 
 
@@ -119,6 +286,7 @@ namespace ShaderToggler
         _renderSrvDescIndex = other._renderSrvDescIndex;
         _renderSrvShaderStage = other._renderSrvShaderStage;
         _renderSrvSlotIndex = other._renderSrvSlotIndex;
+        updateInvocationPlan();
     }
 
 
@@ -143,6 +311,45 @@ namespace ShaderToggler
     }
 
 
+    void ToggleGroup::updateInvocationPlan()
+    {
+        using namespace Rendering;
+
+        InvocationPlan plan;
+
+        plan.constantsMask = _extractConstants ? MATCH_CONST_PS : MATCH_NONE;
+
+        // Effects and the preview always get a draw call check to pick up the resource_view, plus a check at the invocation location unless rendering to the bound SRVs
+        plan.effectLocation = _renderToResourceViews ? static_cast<uint32_t>(CALL_DRAW) : _invocationLocation;
+        plan.effectMask = (MATCH_EFFECT_PS << (plan.effectLocation * MATCH_DELIMITER)) | (MATCH_EFFECT_PS << (CALL_DRAW * MATCH_DELIMITER));
+        plan.previewMask = (MATCH_PREVIEW_PS << (plan.effectLocation * MATCH_DELIMITER)) | (MATCH_PREVIEW_PS << (CALL_DRAW * MATCH_DELIMITER));
+
+        if (_isProvidingTextureBinding)
+        {
+            plan.bindingLocation = !_copyTextureBinding || _extractResourceViews ? static_cast<uint32_t>(CALL_DRAW) : _bindingInvocationLocation;
+            plan.bindingMask = (MATCH_BINDING_PS << (plan.bindingLocation * MATCH_DELIMITER)) | (MATCH_BINDING_PS << (CALL_DRAW * MATCH_DELIMITER));
+        }
+
+        if (_allowAllTechniques)
+        {
+            plan.techniques = _hasTechniqueExceptions ? TechniqueSelection::ALL_EXCEPT_PREFERRED : TechniqueSelection::ALL;
+        }
+        else if (_preferredTechniques.size() > 0)
+        {
+            plan.techniques = TechniqueSelection::PREFERRED;
+        }
+
+        auto published = std::find_if(_invocationPlans.begin(), _invocationPlans.end(), [&](const auto& existing) { return *existing == plan; });
+
+        if (published == _invocationPlans.end())
+        {
+            published = _invocationPlans.insert(_invocationPlans.end(), std::make_unique<const InvocationPlan>(plan));
+        }
+
+        _invocationPlan.store(published->get(), std::memory_order_release);
+    }
+
+
     int ToggleGroup::getNewGroupId()
     {
         static atomic_int s_groupId = 0;
@@ -158,42 +365,58 @@ namespace ShaderToggler
     }
 
 
-    void ToggleGroup::storeCollectedHashes(const unordered_set<uint32_t> pixelShaderHashes, const unordered_set<uint32_t> vertexShaderHashes, const unordered_set<uint32_t> computeShaderHashes)
+    void ToggleGroup::assignHashes(vector<uint32_t>& hashes, const unordered_set<uint32_t>& source)
     {
-        _vertexShaderHashes.clear();
-        _pixelShaderHashes.clear();
-        _computeShaderHashes.clear();
+        hashes.assign(source.begin(), source.end());
+        std::sort(hashes.begin(), hashes.end());
+    }
 
-        for (const auto hash : vertexShaderHashes)
-        {
-            _vertexShaderHashes.emplace(hash);
-        }
-        for (const auto hash : pixelShaderHashes)
+
+    bool ToggleGroup::containsHash(const vector<uint32_t>& hashes, uint32_t hash)
+    {
+        // Branch free lower bound, the loop only depends on the size so it doesn't suffer from mispredictions
+        const uint32_t* base = hashes.data();
+        size_t length = hashes.size();
+
+        if (length == 0)
         {
-            _pixelShaderHashes.emplace(hash);
+            return false;
         }
-        for (const auto hash : computeShaderHashes)
+
+        while (length > 1)
         {
-            _computeShaderHashes.emplace(hash);
+            const size_t half = length / 2;
+            base = base[half - 1] < hash ? base + half : base;
+            length -= half;
         }
+
+        return *base == hash;
+    }
+
+
+    void ToggleGroup::storeCollectedHashes(const unordered_set<uint32_t>& pixelShaderHashes, const unordered_set<uint32_t>& vertexShaderHashes, const unordered_set<uint32_t>& computeShaderHashes)
+    {
+        assignHashes(_vertexShaderHashes, vertexShaderHashes);
+        assignHashes(_pixelShaderHashes, pixelShaderHashes);
+        assignHashes(_computeShaderHashes, computeShaderHashes);
     }
 
 
     bool ToggleGroup::isBlockedVertexShader(uint32_t shaderHash) const
     {
-        return _isActive && (_vertexShaderHashes.contains(shaderHash));
+        return _isActive && containsHash(_vertexShaderHashes, shaderHash);
     }
 
 
     bool ToggleGroup::isBlockedPixelShader(uint32_t shaderHash) const
     {
-        return _isActive && (_pixelShaderHashes.contains(shaderHash));
+        return _isActive && containsHash(_pixelShaderHashes, shaderHash);
     }
 
 
     bool ToggleGroup::isBlockedComputeShader(uint32_t shaderHash) const
     {
-        return _isActive && (_computeShaderHashes.contains(shaderHash));
+        return _isActive && containsHash(_computeShaderHashes, shaderHash);
     }
 
 
@@ -231,39 +454,66 @@ namespace ShaderToggler
     }
 
 
-    void ToggleGroup::saveState(CDataFile& iniFile, int groupCounter) const
+    void ToggleGroup::saveHashes(CDataFile& iniFile, const vector<uint32_t>& hashes, const string& category)
     {
-        const string sectionRoot = "Group" + std::to_string(groupCounter);
-        const string vertexHashesCategory = sectionRoot + "_VertexShaders";
-        const string pixelHashesCategory = sectionRoot + "_PixelShaders";
-        const string computeHashesCategory = sectionRoot + "_ComputeShaders";
-        const string constantsCategory = sectionRoot + "_Constants";
+        // Always written in the packed format, which migrates configs still using one key per hash
+        iniFile.SetUInt("AmountHashes", static_cast<uint32_t>(hashes.size()), "", category);
+        iniFile.SetValue("PackedHashes", PackHashes(hashes), "", category);
+    }
 
-        int counter = 0;
-        for (const auto hash : _vertexShaderHashes)
+
+    void ToggleGroup::loadHashes(CDataFile& iniFile, vector<uint32_t>& hashes, const string& category)
+    {
+        const int amount = iniFile.GetInt("AmountHashes", category);
+        if (amount <= 0)
         {
-            iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", vertexHashesCategory);
-            counter++;
+            return;
         }
-        iniFile.SetUInt("AmountHashes", counter, "", vertexHashesCategory);
 
-        counter = 0;
-        for (const auto hash : _pixelShaderHashes)
+        const string packed = iniFile.GetValue("PackedHashes", category);
+        if (packed.size() > 0)
         {
-            iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", pixelHashesCategory);
-            counter++;
+            vector<uint32_t> unpacked;
+            if (UnpackHashes(packed, unpacked, amount) && unpacked.size() == static_cast<size_t>(amount))
+            {
+                hashes = std::move(unpacked);
+                return;
+            }
+
+            reshade::log_message(reshade::log_level::warning, std::format("Packed shader hashes in section \"{}\" are malformed, falling back to individual hash keys", category).c_str());
         }
-        iniFile.SetUInt("AmountHashes", counter, "", pixelHashesCategory);
 
-        counter = 0;
-        for (const auto hash : _computeShaderHashes)
+        hashes.clear();
+        hashes.reserve(amount);
+
+        for (int i = 0; i < amount; i++)
         {
-            iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", computeHashesCategory);
-            counter++;
+            uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), category);
+            if (hash != UINT_MAX)
+            {
+                hashes.push_back(hash);
+            }
         }
-        iniFile.SetUInt("AmountHashes", counter, "", computeHashesCategory);
 
-        counter = 0;
+        // Legacy lists are in set iteration order and could contain the same hash twice
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    }
+
+
+    void ToggleGroup::saveState(CDataFile& iniFile, int groupCounter) const
+    {
+        const string sectionRoot = "Group" + std::to_string(groupCounter);
+        const string vertexHashesCategory = sectionRoot + "_VertexShaders";
+        const string pixelHashesCategory = sectionRoot + "_PixelShaders";
+        const string computeHashesCategory = sectionRoot + "_ComputeShaders";
+        const string constantsCategory = sectionRoot + "_Constants";
+
+        saveHashes(iniFile, _vertexShaderHashes, vertexHashesCategory);
+        saveHashes(iniFile, _pixelShaderHashes, pixelHashesCategory);
+        saveHashes(iniFile, _computeShaderHashes, computeHashesCategory);
+
+        int counter = 0;
         for (const auto& [varName, varData] : _varOffsetMapping)
         {
             const auto& [varOffset, varUsePref] = varData;
@@ -354,33 +604,9 @@ namespace ShaderToggler
     {
         if (groupCounter < 0)
         {
-            int amount = iniFile.GetInt("AmountHashes", "PixelShaders");
-            for (int i = 0; i < amount; i++)
-            {
-                uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "PixelShaders");
-                if (hash != UINT_MAX)
-                {
-                    _pixelShaderHashes.emplace(hash);
-                }
-            }
-            amount = iniFile.GetInt("AmountHashes", "VertexShaders");
-            for (int i = 0; i < amount; i++)
-            {
-                uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "VertexShaders");
-                if (hash != UINT_MAX)
-                {
-                    _vertexShaderHashes.emplace(hash);
-                }
-            }
-            amount = iniFile.GetInt("AmountHashes", "ComputeShaders");
-            for (int i = 0; i < amount; i++)
-            {
-                uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "ComputeShaders");
-                if (hash != UINT_MAX)
-                {
-                    _computeShaderHashes.emplace(hash);
-                }
-            }
+            loadHashes(iniFile, _pixelShaderHashes, "PixelShaders");
+            loadHashes(iniFile, _vertexShaderHashes, "VertexShaders");
+            loadHashes(iniFile, _computeShaderHashes, "ComputeShaders");
 
             // done
             return;
@@ -392,35 +618,9 @@ namespace ShaderToggler
         const string computeHashesCategory = sectionRoot + "_ComputeShaders";
         const string constantsCategory = sectionRoot + "_Constants";
 
-        int amountShaders = iniFile.GetInt("AmountHashes", vertexHashesCategory);
-        for (int i = 0; i < amountShaders; i++)
-        {
-            uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), vertexHashesCategory);
-            if (hash != UINT_MAX)
-            {
-                _vertexShaderHashes.emplace(hash);
-            }
-        }
-
-        amountShaders = iniFile.GetInt("AmountHashes", pixelHashesCategory);
-        for (int i = 0; i < amountShaders; i++)
-        {
-            uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), pixelHashesCategory);
-            if (hash != UINT_MAX)
-            {
-                _pixelShaderHashes.emplace(hash);
-            }
-        }
-
-        amountShaders = iniFile.GetInt("AmountHashes", computeHashesCategory);
-        for (int i = 0; i < amountShaders; i++)
-        {
-            uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), computeHashesCategory);
-            if (hash != UINT_MAX)
-            {
-                _computeShaderHashes.emplace(hash);
-            }
-        }
+        loadHashes(iniFile, _vertexShaderHashes, vertexHashesCategory);
+        loadHashes(iniFile, _pixelShaderHashes, pixelHashesCategory);
+        loadHashes(iniFile, _computeShaderHashes, computeHashesCategory);
 
         int amountConstants = iniFile.GetInt("AmountConstants", constantsCategory);
         for (int i = 0; i < amountConstants; i++)
@@ -630,5 +830,7 @@ namespace ShaderToggler
         _flipBuffer = iniFile.GetBoolOrDefault("FlipBuffer", sectionRoot, false);
 
         _flipBufferBinding = iniFile.GetBoolOrDefault("FlipBufferBinding", sectionRoot, false);
+
+        updateInvocationPlan();
     }
 }
@@ -32,10 +32,14 @@
 #pragma once
 
 #include <string>
+#include <span>
+#include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
 
 #include "reshade.hpp"
 #include "CDataFile.h"
@@ -63,7 +67,8 @@ namespace ShaderToggler
     {
         RESOURCE_ALPHA = 0,
         RESOURCE_BINDING = 1,
-        RESOURCE_CONSTANTS_COPY = 2
+        RESOURCE_CONSTANTS_COPY = 2,
+        RESOURCE_ALPHA_MASK = 3
     };
 
     enum class GroupResourceState : uint32_t
@@ -73,9 +78,33 @@ namespace ShaderToggler
         //RESOURCE_RECREATING = 2,
         RESOURCE_RECREATED = 4,
         RESOURCE_CLEARED = 8,
+        RESOURCE_SHARED = 16,     // bound to another group's copy of the same source
     };
 
-    constexpr uint32_t GroupResourceTypeCount = 3;
+    constexpr uint32_t GroupResourceTypeCount = 4;
+
+    enum class TechniqueSelection : uint32_t
+    {
+        NONE = 0,
+        ALL,
+        ALL_EXCEPT_PREFERRED,
+        PREFERRED
+    };
+
+    // What a group schedules when one of its shaders gets bound, compiled from the group's options whenever one of them changes.
+    // Masks are expressed for the pixel shader stage and shifted to the bound stage by the caller.
+    struct __declspec(novtable) InvocationPlan final
+    {
+        uint64_t constantsMask = 0;
+        uint64_t bindingMask = 0;
+        uint64_t effectMask = 0;
+        uint64_t previewMask = 0;
+        uint32_t bindingLocation = 0;
+        uint32_t effectLocation = 0;
+        TechniqueSelection techniques = TechniqueSelection::NONE;
+
+        bool operator==(const InvocationPlan&) const = default;
+    };
 
     struct __declspec(novtable) GroupResource final
     {
@@ -115,7 +144,7 @@ namespace ShaderToggler
         /// <param name="iniFile"></param>
         /// <param name="groupCounter">if -1, the ini file is in the pre-1.0 format</param>
         void loadState(CDataFile& iniFile, int groupCounter);
-        void storeCollectedHashes(const std::unordered_set<uint32_t> pixelShaderHashes, const std::unordered_set<uint32_t> vertexShaderHashes, const std::unordered_set<uint32_t> computeShaderHashes);
+        void storeCollectedHashes(const std::unordered_set<uint32_t>& pixelShaderHashes, const std::unordered_set<uint32_t>& vertexShaderHashes, const std::unordered_set<uint32_t>& computeShaderHashes);
         bool isBlockedVertexShader(uint32_t shaderHash) const;
         bool isBlockedPixelShader(uint32_t shaderHash) const;
         bool isBlockedComputeShader(uint32_t shaderHash) const;
@@ -131,13 +160,14 @@ namespace ShaderToggler
         bool isEmpty() const { return _vertexShaderHashes.size() <= 0 && _pixelShaderHashes.size() <= 0; }
         int getId() const { return _id; }
         const std::unordered_set<std::string>& preferredTechniques() const { return _preferredTechniques; }
-        void setPreferredTechniques(std::unordered_set<std::string>& techniques) { _preferredTechniques = techniques; }
-        std::unordered_set<uint32_t> getPixelShaderHashes() const { return _pixelShaderHashes; }
-        std::unordered_set<uint32_t> getVertexShaderHashes() const { return _vertexShaderHashes; }
-        std::unordered_set<uint32_t> getComputeShaderHashes() const { return _computeShaderHashes; }
-        void setInvocationLocation(uint32_t location) { _invocationLocation = location; }
+        void setPreferredTechniques(std::unordered_set<std::string>& techniques) { _preferredTechniques = techniques; updateInvocationPlan(); }
+        // Sorted and free of duplicates
+        std::span<const uint32_t> getPixelShaderHashes() const { return _pixelShaderHashes; }
+        std::span<const uint32_t> getVertexShaderHashes() const { return _vertexShaderHashes; }
+        std::span<const uint32_t> getComputeShaderHashes() const { return _computeShaderHashes; }
+        void setInvocationLocation(uint32_t location) { _invocationLocation = location; updateInvocationPlan(); }
         uint32_t getInvocationLocation() const { return _invocationLocation; }
-        void setBindingInvocationLocation(uint32_t location) { _bindingInvocationLocation = location; }
+        void setBindingInvocationLocation(uint32_t location) { _bindingInvocationLocation = location; updateInvocationPlan(); }
         uint32_t getBindingInvocationLocation() const { return _bindingInvocationLocation; }
         void setCBSlotIndex(uint32_t index) { _cbSlotIndex = index; }
         uint32_t getCBSlotIndex() const { return _cbSlotIndex; }
@@ -148,21 +178,21 @@ namespace ShaderToggler
         void setRenderTargetIndex(uint32_t index) { _rtIndex = index; }
         uint32_t getRenderTargetIndex() const { return _rtIndex; }
         bool isProvidingTextureBinding() const { return _isProvidingTextureBinding; }
-        void setProvidingTextureBinding(bool isProvidingTextureBinding) { _isProvidingTextureBinding = isProvidingTextureBinding; }
+        void setProvidingTextureBinding(bool isProvidingTextureBinding) { _isProvidingTextureBinding = isProvidingTextureBinding; updateInvocationPlan(); }
         const std::string& getTextureBindingName() const { return _textureBindingName; }
         void setTextureBindingName(std::string textureBindingName) { _textureBindingName = textureBindingName; }
         bool getClearBindings() { return _clearBindings; }
         void setClearBindings(bool clear) { _clearBindings = clear; }
         bool getAllowAllTechniques() const { return _allowAllTechniques; }
-        void setAllowAllTechniques(bool allowAllTechniques) { _allowAllTechniques = allowAllTechniques; }
+        void setAllowAllTechniques(bool allowAllTechniques) { _allowAllTechniques = allowAllTechniques; updateInvocationPlan(); }
         bool getExtractConstants() const { return _extractConstants; }
-        void setExtractConstant(bool extract) { _extractConstants = extract; }
+        void setExtractConstant(bool extract) { _extractConstants = extract; updateInvocationPlan(); }
         uint32_t getCBShaderStage() const { return _cbShaderStage; }
         void setCBShaderStage(uint32_t shaderStage) { _cbShaderStage = shaderStage; }
         bool getExtractResourceViews() const { return _extractResourceViews; }
-        void setExtractResourceViews(bool extract) { _extractResourceViews = extract; }
+        void setExtractResourceViews(bool extract) { _extractResourceViews = extract; updateInvocationPlan(); }
         bool getRenderToResourceViews() const { return _renderToResourceViews; }
-        void setRenderToResourceViews(bool render) { _renderToResourceViews = render; }
+        void setRenderToResourceViews(bool render) { _renderToResourceViews = render; updateInvocationPlan(); }
         void setBindingSRVSlotIndex(uint32_t index) { _bindingSrvSlotIndex = index; }
         uint32_t getBindingSRVSlotIndex() const { return _bindingSrvSlotIndex; }
         void setRenderSRVSlotIndex(uint32_t index) { _renderSrvSlotIndex = index; }
@@ -178,7 +208,7 @@ namespace ShaderToggler
         void setBindingRenderTargetIndex(uint32_t index) { _bindingRTIndex = index; }
         uint32_t getBindingRenderTargetIndex() const { return _bindingRTIndex; }
         bool getHasTechniqueExceptions() const { return _hasTechniqueExceptions; }
-        void setHasTechniqueExceptions(bool exceptions) { _hasTechniqueExceptions = exceptions; }
+        void setHasTechniqueExceptions(bool exceptions) { _hasTechniqueExceptions = exceptions; updateInvocationPlan(); }
         uint32_t getMatchSwapchainResolution() const { return _matchSwapchainResolution; }
         void setMatchSwapchainResolution(uint32_t match) { _matchSwapchainResolution = match; }
         uint32_t getBindingMatchSwapchainResolution() const { return _bindingMatchSwapchainResolution; }
@@ -186,7 +216,9 @@ namespace ShaderToggler
         bool getRequeueAfterRTMatchingFailure() const { return _requeueAfterRTMatchingFailure; }
         void setRequeueAfterRTMatchingFailure(bool requeue) { _requeueAfterRTMatchingFailure = requeue; }
         bool getCopyTextureBinding() const { return _copyTextureBinding; }
-        void setCopyTextureBinding(bool copy) { _copyTextureBinding = copy; }
+        void setCopyTextureBinding(bool copy) { _copyTextureBinding = copy; updateInvocationPlan(); }
+        // Plans are immutable once published, a reader keeps seeing the plan it loaded even if an option changes meanwhile
+        const InvocationPlan& getInvocationPlan() const { return *_invocationPlan.load(std::memory_order_acquire); }
         const std::unordered_map<std::string, std::tuple<uintptr_t, bool>>& GetVarOffsetMapping() const { return _varOffsetMapping; }
         bool SetVarMapping(uintptr_t, std::string&, bool);
         bool RemoveVarMapping(std::string&);
@@ -237,12 +269,19 @@ namespace ShaderToggler
         const std::unordered_set<EffectData*>& GetPreferredTechniqueData();
 
     private:
+        static void saveHashes(CDataFile& iniFile, const std::vector<uint32_t>& hashes, const std::string& category);
+        static void loadHashes(CDataFile& iniFile, std::vector<uint32_t>& hashes, const std::string& category);
+        static void assignHashes(std::vector<uint32_t>& hashes, const std::unordered_set<uint32_t>& source);
+        static bool containsHash(const std::vector<uint32_t>& hashes, uint32_t hash);
+        void updateInvocationPlan();
+
         int _id;
         std::string	_name;
         uint32_t _keybind;
-        std::unordered_set<uint32_t> _vertexShaderHashes;
-        std::unordered_set<uint32_t> _pixelShaderHashes;
-        std::unordered_set<uint32_t> _computeShaderHashes;
+        // Kept sorted so lookups are a binary search over contiguous memory
+        std::vector<uint32_t> _vertexShaderHashes;
+        std::vector<uint32_t> _pixelShaderHashes;
+        std::vector<uint32_t> _computeShaderHashes;
         uint32_t _invocationLocation = 0;
         uint32_t _rtIndex = 0;
         uint32_t _cbSlotIndex = 2;
@@ -282,7 +321,11 @@ namespace ShaderToggler
         DescriptorCycle _cbCycle;
         DescriptorCycle _srvCycle;
         DescriptorCycle _rtCycle;
+        // Every plan published so far, since a render thread may still be reading an older one. Identical plans are
+        // reused, so this only grows with the number of distinct option combinations the group went through.
+        std::vector<std::unique_ptr<const InvocationPlan>> _invocationPlans;
+        std::atomic<const InvocationPlan*> _invocationPlan = nullptr;
 
-        std::array<GroupResource, 3> _group_buffers;
+        std::array<GroupResource, GroupResourceTypeCount> _group_buffers;
     };
 }
@@ -95,6 +95,66 @@ static bool isValidRenderTarget(reshade::api::format format)
     return false;
 }
 
+AlphaPreserveMode ToggleGroupResourceManager::GetAlphaPreserveMode(reshade::api::device_api api, reshade::api::format format, reshade::api::format* maskFormat)
+{
+    *maskFormat = reshade::api::format::unknown;
+
+    switch (format)
+    {
+    case reshade::api::format::r8g8b8a8_typeless:
+    case reshade::api::format::r8g8b8a8_unorm:
+    case reshade::api::format::r8g8b8a8_unorm_srgb:
+    case reshade::api::format::b8g8r8a8_typeless:
+    case reshade::api::format::b8g8r8a8_unorm:
+    case reshade::api::format::b8g8r8a8_unorm_srgb:
+    case reshade::api::format::r10g10b10a2_typeless:
+    case reshade::api::format::r10g10b10a2_unorm:
+    case reshade::api::format::b10g10r10a2_typeless:
+    case reshade::api::format::b10g10r10a2_unorm:
+        *maskFormat = reshade::api::format::r8_unorm;
+        break;
+    case reshade::api::format::r16g16b16a16_unorm:
+        *maskFormat = reshade::api::format::r16_unorm;
+        break;
+    case reshade::api::format::r16g16b16a16_float:
+        *maskFormat = reshade::api::format::r16_float;
+        break;
+    case reshade::api::format::r32g32b32a32_float:
+        *maskFormat = reshade::api::format::r32_float;
+        break;
+    case reshade::api::format::r8g8b8x8_unorm:
+    case reshade::api::format::r8g8b8x8_unorm_srgb:
+    case reshade::api::format::b8g8r8x8_typeless:
+    case reshade::api::format::b8g8r8x8_unorm:
+    case reshade::api::format::b8g8r8x8_unorm_srgb:
+    case reshade::api::format::r11g11b10_float:
+    case reshade::api::format::r9g9b9e5:
+    case reshade::api::format::b5g6r5_unorm:
+    case reshade::api::format::r32g32b32_float:
+    case reshade::api::format::r16g16_unorm:
+    case reshade::api::format::r16g16_float:
+    case reshade::api::format::r32g32_float:
+    case reshade::api::format::r8g8_unorm:
+    case reshade::api::format::r8_unorm:
+    case reshade::api::format::r16_unorm:
+    case reshade::api::format::r16_float:
+    case reshade::api::format::r32_float:
+        return AlphaPreserveMode::ALPHA_NONE;
+    default:
+        // Integer and ambiguous typeless formats keep using a full copy
+        return AlphaPreserveMode::ALPHA_COPY;
+    }
+
+    // Single channel formats map to luminance formats on D3D9, which can't be rendered to
+    if (api == reshade::api::device_api::d3d9)
+    {
+        *maskFormat = reshade::api::format::unknown;
+        return AlphaPreserveMode::ALPHA_COPY;
+    }
+
+    return AlphaPreserveMode::ALPHA_MASK;
+}
+
 void ToggleGroupResourceManager::ToggleGroupRemoved(reshade::api::effect_runtime* runtime, ShaderToggler::ToggleGroup* group)
 {
     runtime->get_command_queue()->wait_idle();
@@ -108,6 +168,19 @@ void ToggleGroupResourceManager::ToggleGroupRemoved(reshade::api::effect_runtime
             DisposeGroupResources(runtime->get_device(), resources.res, resources.rtv, resources.rtv_srgb, resources.srv);
         }
     }
+
+    unique_lock<mutex> lock(_cacheMutex);
+
+    const auto cache = _bufferCache.find(group->getId());
+    if (cache != _bufferCache.end())
+    {
+        for (auto& buffers : cache->second)
+        {
+            DisposeCachedBuffers(runtime->get_device(), buffers);
+        }
+
+        _bufferCache.erase(cache);
+    }
 }
 
 void ToggleGroupResourceManager::DisposeGroupResources(device* device, resource& res, resource_view& rtv, resource_view& rtv_srgb, resource_view& srv)
@@ -138,6 +211,16 @@ void ToggleGroupResourceManager::DisposeGroupResources(device* device, resource&
     rtv_srgb = resource_view{ 0 };
 }
 
+void ToggleGroupResourceManager::DisposeCachedBuffers(device* device, vector<CachedGroupBuffer>& buffers)
+{
+    for (auto& buffer : buffers)
+    {
+        DisposeGroupResources(device, buffer.res, buffer.rtv, buffer.rtv_srgb, buffer.srv);
+    }
+
+    buffers.clear();
+}
+
 void ToggleGroupResourceManager::DisposeGroupBuffers(reshade::api::device* device, std::unordered_map<int, ShaderToggler::ToggleGroup>& groups)
 {
     if (device == nullptr)
@@ -157,6 +240,53 @@ void ToggleGroupResourceManager::DisposeGroupBuffers(reshade::api::device* devic
             DisposeGroupResources(device, resources.res, resources.rtv, resources.rtv_srgb, resources.srv);
         }
     }
+
+    unique_lock<mutex> lock(_cacheMutex);
+
+    for (auto& [groupId, cache] : _bufferCache)
+    {
+        for (auto& buffers : cache)
+        {
+            DisposeCachedBuffers(device, buffers);
+        }
+    }
+
+    _bufferCache.clear();
+    DisposeCachedBuffers(device, _evictedBuffers);
+}
+
+void ToggleGroupResourceManager::CreateGroupResources(device* device, const resource_desc& targetDesc, reshade::api::format viewFormat,
+    resource& res, resource_view& rtv, resource_view& rtv_srgb, resource_view& srv)
+{
+    reshade::api::resource_usage res_usage = resource_usage::copy_dest | resource_usage::copy_source | resource_usage::shader_resource;
+
+    bool validRT = isValidRenderTarget(targetDesc.texture.format);
+    if (validRT)
+    {
+        res_usage |= resource_usage::render_target;
+    }
+
+    resource_desc group_desc = resource_desc(targetDesc.texture.width, targetDesc.texture.height, 1, 1, format_to_typeless(targetDesc.texture.format), 1, memory_heap::gpu_only, res_usage);
+
+    if (!device->create_resource(group_desc, nullptr, resource_usage::copy_dest, &res))
+    {
+        reshade::log_message(reshade::log_level::error, "Failed to create group render target!");
+    }
+
+    if (validRT && res != 0 && !device->create_resource_view(res, resource_usage::shader_resource, resource_view_desc(format_to_default_typed(viewFormat, 0)), &srv))
+    {
+        reshade::log_message(reshade::log_level::error, "Failed to create group shader resource view!");
+    }
+
+    if (validRT && res != 0 && !device->create_resource_view(res, resource_usage::render_target, resource_view_desc(format_to_default_typed(viewFormat, 0)), &rtv))
+    {
+        reshade::log_message(reshade::log_level::error, "Failed to create group render target view!");
+    }
+
+    if (res != 0 && !device->create_resource_view(res, resource_usage::render_target, resource_view_desc(format_to_default_typed(viewFormat, 1)), &rtv_srgb))
+    {
+        reshade::log_message(reshade::log_level::error, "Failed to create group SRGB render target view!");
+    }
 }
 
 void ToggleGroupResourceManager::CheckGroupBuffers(reshade::api::effect_runtime* runtime, std::unordered_map<int, ShaderToggler::ToggleGroup>& groups)
@@ -164,14 +294,39 @@ void ToggleGroupResourceManager::CheckGroupBuffers(reshade::api::effect_runtime*
     if (runtime == nullptr || runtime->get_device() == nullptr)
         return;
 
+    unique_lock<mutex> lock(_cacheMutex);
+
+    DisposeCachedBuffers(runtime->get_device(), _evictedBuffers);
+
     for (auto& groupEntry : groups)
     {
         ShaderToggler::ToggleGroup& group = groupEntry.second;
+        const auto cache = _bufferCache.find(group.getId());
 
         for (uint32_t i = 0; i < GroupResourceTypeCount; i++)
         {
             GroupResource& resources = group.GetGroupResource(static_cast<GroupResourceType>(i));
 
+            if (cache != _bufferCache.end())
+            {
+                if (!resources.enabled())
+                {
+                    // Cached buffers are of no use anymore once the group stops using the type
+                    DisposeCachedBuffers(runtime->get_device(), cache->second[i]);
+                }
+                else
+                {
+                    // Configurations that were requested but superseded by a cached buffer in the same frame
+                    for (auto& buffer : cache->second[i])
+                    {
+                        if (buffer.res == 0)
+                        {
+                            CreateGroupResources(runtime->get_device(), buffer.target_description, buffer.view_format, buffer.res, buffer.rtv, buffer.rtv_srgb, buffer.srv);
+                        }
+                    }
+                }
+            }
+
             if (!resources.owning)
                 continue;
 
@@ -188,38 +343,10 @@ void ToggleGroupResourceManager::CheckGroupBuffers(reshade::api::effect_runtime*
 
             DisposeGroupResources(runtime->get_device(), resources.res, resources.rtv, resources.rtv_srgb, resources.srv);
 
-            if (static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_ALPHA || static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_BINDING)
+            if (static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_ALPHA || static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_BINDING ||
+                static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_ALPHA_MASK)
             {
-                reshade::api::resource_usage res_usage = resource_usage::copy_dest | resource_usage::copy_source | resource_usage::shader_resource;
-
-                bool validRT = isValidRenderTarget(resources.target_description.texture.format);
-                if (validRT)
-                {
-                    res_usage |= resource_usage::render_target;
-                }
-
-                resource_desc desc = resources.target_description;
-                resource_desc group_desc = resource_desc(desc.texture.width, desc.texture.height, 1, 1, format_to_typeless(desc.texture.format), 1, memory_heap::gpu_only, res_usage);
-
-                if (!runtime->get_device()->create_resource(group_desc, nullptr, resource_usage::copy_dest, &resources.res))
-                {
-                    reshade::log_message(reshade::log_level::error, "Failed to create group render target!");
-                }
-
-                if (validRT && resources.res != 0 && !runtime->get_device()->create_resource_view(resources.res, resource_usage::shader_resource, resource_view_desc(format_to_default_typed(resources.view_format, 0)), &resources.srv))
-                {
-                    reshade::log_message(reshade::log_level::error, "Failed to create group shader resource view!");
-                }
-
-                if (validRT && resources.res != 0 && !runtime->get_device()->create_resource_view(resources.res, resource_usage::render_target, resource_view_desc(format_to_default_typed(resources.view_format, 0)), &resources.rtv))
-                {
-                    reshade::log_message(reshade::log_level::error, "Failed to create group render target view!");
-                }
-
-                if (resources.res != 0 && !runtime->get_device()->create_resource_view(resources.res, resource_usage::render_target, resource_view_desc(format_to_default_typed(resources.view_format, 1)), &resources.rtv_srgb))
-                {
-                    reshade::log_message(reshade::log_level::error, "Failed to create group SRGB render target view!");
-                }
+                CreateGroupResources(runtime->get_device(), resources.target_description, resources.view_format, resources.res, resources.rtv, resources.rtv_srgb, resources.srv);
             }
             else if (static_cast<GroupResourceType>(i) == GroupResourceType::RESOURCE_CONSTANTS_COPY)
             {
@@ -248,16 +375,8 @@ void ToggleGroupResourceManager::SetGroupBufferHandles(ShaderToggler::ToggleGrou
         *srv = resources.srv;
 }
 
-bool ToggleGroupResourceManager::IsCompatibleWithGroupFormat(reshade::api::device* device, const GroupResourceType type, reshade::api::resource res, ShaderToggler::ToggleGroup* group)
+bool ToggleGroupResourceManager::IsCompatible(const GroupResourceType type, const resource_desc& tdesc, const resource_desc& preview_desc, reshade::api::format groupViewFormat)
 {
-    const GroupResource& resources = group->GetGroupResource(type);
-    
-    if (res == 0 || resources.res == 0)
-        return false;
-    
-    resource_desc tdesc = device->get_resource_desc(res);
-    resource_desc preview_desc = device->get_resource_desc(resources.res);
-    
     if (type == GroupResourceType::RESOURCE_ALPHA || type == GroupResourceType::RESOURCE_BINDING)
     {
         if (format_to_typeless(tdesc.texture.format) == format_to_typeless(preview_desc.texture.format) &&
@@ -268,6 +387,16 @@ bool ToggleGroupResourceManager::IsCompatibleWithGroupFormat(reshade::api::devic
             return true;
         }
     }
+    else if (type == GroupResourceType::RESOURCE_ALPHA_MASK)
+    {
+        // The mask's format follows from the target format, callers check it against view_format
+        if (format_to_typeless(groupViewFormat) == format_to_typeless(preview_desc.texture.format) &&
+            tdesc.texture.width == preview_desc.texture.width &&
+            tdesc.texture.height == preview_desc.texture.height)
+        {
+            return true;
+        }
+    }
     else if (type == GroupResourceType::RESOURCE_CONSTANTS_COPY)
     {
         if (tdesc.buffer.size == preview_desc.buffer.size)
@@ -276,5 +405,121 @@ bool ToggleGroupResourceManager::IsCompatibleWithGroupFormat(reshade::api::devic
         }
     }
 
+    return false;
+}
+
+bool ToggleGroupResourceManager::IsCompatibleWithGroupFormat(reshade::api::device* device, const GroupResourceType type, reshade::api::resource res, ShaderToggler::ToggleGroup* group)
+{
+    const GroupResource& resources = group->GetGroupResource(type);
+    
+    if (res == 0 || resources.res == 0)
+        return false;
+    
+    resource_desc tdesc = device->get_resource_desc(res);
+    resource_desc preview_desc = device->get_resource_desc(resources.res);
+    
+    return IsCompatible(type, tdesc, preview_desc, resources.view_format);
+}
+
+void ToggleGroupResourceManager::CacheGroupBuffer(vector<CachedGroupBuffer>& cache, const CachedGroupBuffer& buffer)
+{
+    cache.insert(cache.begin(), buffer);
+
+    if (cache.size() > CachedBuffersPerType)
+    {
+        // Evicted buffers may still be in use by commands recorded this frame, they're destroyed at the next present
+        _evictedBuffers.push_back(cache.back());
+        cache.pop_back();
+    }
+}
+
+bool ToggleGroupResourceManager::AcquireGroupBuffer(device* device, const GroupResourceType type, resource res, ToggleGroup* group, const resource_desc& desc, reshade::api::format viewFormat)
+{
+    GroupResource& resources = group->GetGroupResource(type);
+
+    if (IsCompatibleWithGroupFormat(device, type, res, group) && (type != GroupResourceType::RESOURCE_ALPHA_MASK || resources.view_format == viewFormat))
+    {
+        return true;
+    }
+
+    // Buffers not created by the group and constant copies are never cached
+    if (res == 0 || !resources.owning || type == GroupResourceType::RESOURCE_CONSTANTS_COPY)
+    {
+        resources.target_description = desc;
+        resources.view_format = viewFormat;
+        resources.state = GroupResourceState::RESOURCE_INVALID;
+
+        return false;
+    }
+
+    const resource_desc tdesc = device->get_resource_desc(res);
+
+    unique_lock<mutex> lock(_cacheMutex);
+
+    vector<CachedGroupBuffer>& cache = _bufferCache[group->getId()][static_cast<uint32_t>(type)];
+
+    const auto cached = std::find_if(cache.begin(), cache.end(), [&](const CachedGroupBuffer& buffer) {
+        return buffer.res != 0 && buffer.view_format == viewFormat && IsCompatible(type, tdesc, device->get_resource_desc(buffer.res), buffer.view_format);
+        });
+
+    CachedGroupBuffer hit = {};
+    const bool found = cached != cache.end();
+
+    if (found)
+    {
+        hit = *cached;
+        cache.erase(cached);
+    }
+
+    // Park the current buffer so switching back to its configuration later doesn't allocate either
+    if (resources.res != 0 && resources.state != GroupResourceState::RESOURCE_INVALID)
+    {
+        CacheGroupBuffer(cache, CachedGroupBuffer{ resources.res, resources.rtv, resources.rtv_srgb, resources.srv, resources.target_description, resources.view_format });
+
+        resources.res = resource{ 0 };
+        resources.rtv = resource_view{ 0 };
+        resources.rtv_srgb = resource_view{ 0 };
+        resources.srv = resource_view{ 0 };
+    }
+    else if (resources.res != 0 && found)
+    {
+        // Already marked for recreation, its description no longer matches the buffer
+        _evictedBuffers.push_back(CachedGroupBuffer{ resources.res, resources.rtv, resources.rtv_srgb, resources.srv, resources.target_description, resources.view_format });
+
+        resources.res = resource{ 0 };
+        resources.rtv = resource_view{ 0 };
+        resources.rtv_srgb = resource_view{ 0 };
+        resources.srv = resource_view{ 0 };
+    }
+
+    if (found)
+    {
+        // A configuration still waiting for its buffer gets one created in the cache instead
+        if (resources.state == GroupResourceState::RESOURCE_INVALID && resources.res == 0 &&
+            std::none_of(cache.begin(), cache.end(), [&](const CachedGroupBuffer& buffer) {
+                return buffer.res == 0 && buffer.view_format == resources.view_format &&
+                    buffer.target_description.texture.width == resources.target_description.texture.width &&
+                    buffer.target_description.texture.height == resources.target_description.texture.height &&
+                    buffer.target_description.texture.format == resources.target_description.texture.format;
+                }))
+        {
+            CacheGroupBuffer(cache, CachedGroupBuffer{ resource{ 0 }, resource_view{ 0 }, resource_view{ 0 }, resource_view{ 0 }, resources.target_description, resources.view_format });
+        }
+
+        resources.res = hit.res;
+        resources.rtv = hit.rtv;
+        resources.rtv_srgb = hit.rtv_srgb;
+        resources.srv = hit.srv;
+        resources.target_description = hit.target_description;
+        resources.view_format = hit.view_format;
+        resources.state = GroupResourceState::RESOURCE_RECREATED;
+
+        return true;
+    }
+
+    resources.target_description = desc;
+    resources.view_format = viewFormat;
+    resources.state = GroupResourceState::RESOURCE_INVALID;
+
     return false;
 }
\ No newline at end of file
@@ -5,11 +5,29 @@
 #include <unordered_map>
 #include <array>
 #include <shared_mutex>
+#include <mutex>
 #include <functional>
 #include "PipelinePrivateData.h"
 
 namespace Rendering
 {
+    enum class AlphaPreserveMode : uint32_t
+    {
+        ALPHA_NONE = 0,     // target has no alpha channel to protect
+        ALPHA_MASK = 1,     // alpha is saved to and restored from a single channel group buffer
+        ALPHA_COPY = 2      // the target is copied to a full group buffer the techniques render into
+    };
+
+    struct __declspec(novtable) CachedGroupBuffer final
+    {
+        reshade::api::resource res;
+        reshade::api::resource_view rtv;
+        reshade::api::resource_view rtv_srgb;
+        reshade::api::resource_view srv;
+        reshade::api::resource_desc target_description;
+        reshade::api::format view_format;
+    };
+
     class __declspec(novtable) ToggleGroupResourceManager final
     {
     public:
@@ -17,9 +35,26 @@ namespace Rendering
         void CheckGroupBuffers(reshade::api::effect_runtime* runtime, std::unordered_map<int, ShaderToggler::ToggleGroup>& groups);
         void SetGroupBufferHandles(ShaderToggler::ToggleGroup* group, const ShaderToggler::GroupResourceType type, reshade::api::resource* res, reshade::api::resource_view* rtv, reshade::api::resource_view* rtv_srgb, reshade::api::resource_view* srv);
         bool IsCompatibleWithGroupFormat(reshade::api::device* device, const ShaderToggler::GroupResourceType type, reshade::api::resource res, ShaderToggler::ToggleGroup* group);
+        // Makes the group buffer of the given type compatible with res, swapping in a cached buffer if one matches.
+        // Otherwise the buffer is marked for recreation at the next present and false is returned.
+        bool AcquireGroupBuffer(reshade::api::device* device, const ShaderToggler::GroupResourceType type, reshade::api::resource res, ShaderToggler::ToggleGroup* group, const reshade::api::resource_desc& desc, reshade::api::format viewFormat);
 
         void ToggleGroupRemoved(reshade::api::effect_runtime*, ShaderToggler::ToggleGroup*);
+
+        static AlphaPreserveMode GetAlphaPreserveMode(reshade::api::device_api api, reshade::api::format format, reshade::api::format* maskFormat);
     private:
+        static constexpr size_t CachedBuffersPerType = 3;
+
         void DisposeGroupResources(reshade::api::device* device, reshade::api::resource& res, reshade::api::resource_view& rtv, reshade::api::resource_view& rtv_srgb, reshade::api::resource_view& srv);
+        void DisposeCachedBuffers(reshade::api::device* device, std::vector<CachedGroupBuffer>& buffers);
+        void CacheGroupBuffer(std::vector<CachedGroupBuffer>& cache, const CachedGroupBuffer& buffer);
+        void CreateGroupResources(reshade::api::device* device, const reshade::api::resource_desc& targetDesc, reshade::api::format viewFormat,
+            reshade::api::resource& res, reshade::api::resource_view& rtv, reshade::api::resource_view& rtv_srgb, reshade::api::resource_view& srv);
+        static bool IsCompatible(const ShaderToggler::GroupResourceType type, const reshade::api::resource_desc& targetDesc, const reshade::api::resource_desc& groupDesc, reshade::api::format groupViewFormat);
+
+        // Buffers of previously used target configurations per group and type, most recently used first
+        std::mutex _cacheMutex;
+        std::unordered_map<int, std::array<std::vector<CachedGroupBuffer>, ShaderToggler::GroupResourceTypeCount>> _bufferCache;
+        std::vector<CachedGroupBuffer> _evictedBuffers;
     };
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <fstream>
+#include <reshade.hpp>
+#include "TraceCapture.h"
+
+using namespace Profiling;
+using namespace std;
+
+atomic_bool TraceCapture::_capturing = false;
+atomic_uint64_t TraceCapture::_frame = 0;
+atomic_uint64_t TraceCapture::_sequence = 0;
+atomic_size_t TraceCapture::_eventCount = 0;
+uint32_t TraceCapture::_remainingFrames = 0;
+filesystem::path TraceCapture::_file;
+mutex TraceCapture::_statusMutex;
+string TraceCapture::_lastStatus;
+mutex TraceCapture::_bufferMutex;
+vector<shared_ptr<TraceCapture::ThreadBuffer>> TraceCapture::_buffers;
+mutex TraceCapture::_writerMutex;
+thread TraceCapture::_writer;
+
+TraceCapture::ThreadBuffer& TraceCapture::GetThreadBuffer()
+{
+    thread_local shared_ptr<ThreadBuffer> threadBuffer;
+
+    if (threadBuffer == nullptr)
+    {
+        // Registered once per thread and kept alive by the list, so a thread exiting mid capture keeps its events
+        threadBuffer = make_shared<ThreadBuffer>();
+
+        unique_lock<mutex> lock(_bufferMutex);
+        threadBuffer->threadIndex = static_cast<uint32_t>(_buffers.size());
+        _buffers.push_back(threadBuffer);
+    }
+
+    return *threadBuffer;
+}
+
+void TraceCapture::Start(const filesystem::path& file, uint32_t frames)
+{
+    if (IsCapturing() || frames == 0)
+    {
+        return;
+    }
+
+    WaitForFlush();
+
+    {
+        unique_lock<mutex> lock(_bufferMutex);
+        for (auto& buffer : _buffers)
+        {
+            unique_lock<mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+
+    _file = file;
+    _frame = 0;
+    _sequence = 0;
+    _eventCount = 0;
+    _remainingFrames = frames;
+    SetLastStatus(std::format("Capturing {} frames", frames));
+    _capturing = true;
+
+    reshade::log_message(reshade::log_level::info, std::format("Starting trace capture of {} frames to \"{}\"", frames, file.string()).c_str());
+}
+
+void TraceCapture::Stop()
+{
+    if (!IsCapturing())
+    {
+        return;
+    }
+
+    _capturing = false;
+    _remainingFrames = 0;
+    Flush();
+}
+
+void TraceCapture::OnPresent()
+{
+    if (!IsCapturing())
+    {
+        return;
+    }
+
+    Record("present", "");
+    _frame++;
+
+    if (--_remainingFrames == 0)
+    {
+        Stop();
+    }
+}
+
+void TraceCapture::WaitForFlush()
+{
+    unique_lock<mutex> lock(_writerMutex);
+    if (_writer.joinable())
+    {
+        _writer.join();
+    }
+}
+
+string TraceCapture::GetLastStatus()
+{
+    unique_lock<mutex> lock(_statusMutex);
+    return _lastStatus;
+}
+
+void TraceCapture::SetLastStatus(string status)
+{
+    unique_lock<mutex> lock(_statusMutex);
+    _lastStatus = std::move(status);
+}
+
+void TraceCapture::Flush()
+{
+    vector<pair<uint64_t, string>> events;
+
+    {
+        unique_lock<mutex> lock(_bufferMutex);
+        for (auto& buffer : _buffers)
+        {
+            unique_lock<mutex> bufferLock(buffer->mutex);
+            move(buffer->events.begin(), buffer->events.end(), back_inserter(events));
+            buffer->events.clear();
+        }
+    }
+
+    SetLastStatus(std::format("Writing {} events", events.size()));
+
+    // Sorting and writing a few hundred thousand lines takes long enough to hitch the frame that stopped the capture
+    unique_lock<mutex> lock(_writerMutex);
+    if (_writer.joinable())
+    {
+        _writer.join();
+    }
+    _writer = thread(&TraceCapture::Write, _file, std::move(events));
+}
+
+void TraceCapture::Write(filesystem::path file, vector<pair<uint64_t, string>> events)
+{
+    sort(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    ofstream out(file, ios::out | ios::trunc);
+    if (!out.is_open())
+    {
+        const string status = std::format("Could not write trace to \"{}\"", file.string());
+        reshade::log_message(reshade::log_level::error, status.c_str());
+        SetLastStatus(status);
+        return;
+    }
+
+    out << "# ShaderToggler trace v2: <frame> <thread> <event> <arguments>\n";
+    for (const auto& [sequence, line] : events)
+    {
+        out << line << '\n';
+    }
+
+    const string status = std::format("Wrote {} events to \"{}\"", events.size(), file.string());
+    reshade::log_message(reshade::log_level::info, status.c_str());
+    SetLastStatus(status);
+}
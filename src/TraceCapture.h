@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Profiling
+{
+    // Records the addon events received over a number of frames into a line based text trace, one event per line:
+    // <frame> <thread> <event> <arguments...>. Handles are written as hex, descriptions as key=value pairs.
+    // Every thread appends to its own buffer; the buffers are merged back into event order and written out on a
+    // separate thread once the capture stops.
+    class __declspec(novtable) TraceCapture final
+    {
+    public:
+        static void Start(const std::filesystem::path& file, uint32_t frames);
+        static void Stop();
+        static void OnPresent();
+
+        // Waits for a pending write to finish. Call before the device goes away, never from DllMain.
+        static void WaitForFlush();
+
+        static inline bool IsCapturing() { return _capturing.load(std::memory_order_relaxed); }
+        static uint32_t GetRemainingFrames() { return _remainingFrames; }
+        static size_t GetEventCount() { return _eventCount.load(std::memory_order_relaxed); }
+        static std::string GetLastStatus();
+
+        template<class... Args>
+        static void Record(const char* eventName, std::format_string<Args...> fmt, Args&&... args)
+        {
+            if (!IsCapturing())
+            {
+                return;
+            }
+
+            ThreadBuffer& buffer = GetThreadBuffer();
+
+            std::string line = std::format("{} {} {} ", _frame.load(std::memory_order_relaxed), buffer.threadIndex, eventName);
+            std::format_to(std::back_inserter(line), fmt, std::forward<Args>(args)...);
+
+            const uint64_t sequence = _sequence.fetch_add(1, std::memory_order_relaxed);
+
+            // Only contended while the buffers are handed to the writer
+            std::unique_lock<std::mutex> lock(buffer.mutex);
+            buffer.events.emplace_back(sequence, std::move(line));
+            _eventCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    private:
+        struct ThreadBuffer
+        {
+            uint32_t threadIndex = 0;
+            std::mutex mutex;
+            std::vector<std::pair<uint64_t, std::string>> events;
+        };
+
+        static ThreadBuffer& GetThreadBuffer();
+        static void Flush();
+        static void Write(std::filesystem::path file, std::vector<std::pair<uint64_t, std::string>> events);
+        static void SetLastStatus(std::string status);
+
+        static std::atomic_bool _capturing;
+        static std::atomic_uint64_t _frame;
+        static std::atomic_uint64_t _sequence;
+        static std::atomic_size_t _eventCount;
+        static uint32_t _remainingFrames;
+        static std::filesystem::path _file;
+        static std::mutex _statusMutex;
+        static std::string _lastStatus;
+        static std::mutex _bufferMutex;
+        static std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+        static std::mutex _writerMutex;
+        static std::thread _writer;
+    };
+}
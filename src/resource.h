@@ -12,12 +12,20 @@
 #define SHADER_PREVIEW_COPY_PS_4_0      108
 #define SHADER_FULLSCREEN_VS_3_0        109
 #define SHADER_PREVIEW_COPY_PS_3_0      110
+#define SHADER_ALPHA_EXTRACT_PS_4_0     111
+#define SHADER_ALPHA_RESTORE_PS_4_0     112
+#define SHADER_ALPHA_EXTRACT_PS_3_0     113
+#define SHADER_ALPHA_RESTORE_PS_3_0     114
+#define SHADER_FULLSCREEN_VS_SPIRV      115
+#define SHADER_PREVIEW_COPY_PS_SPIRV    116
+#define SHADER_ALPHA_EXTRACT_PS_SPIRV   117
+#define SHADER_ALPHA_RESTORE_PS_SPIRV   118
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        111
+#define _APS_NEXT_RESOURCE_VALUE        119
 #define _APS_NEXT_COMMAND_VALUE         40001
 #define _APS_NEXT_CONTROL_VALUE         1001
 #define _APS_NEXT_SYMED_VALUE           101
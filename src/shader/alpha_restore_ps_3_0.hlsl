@@ -0,0 +1,7 @@
+texture2D t0 : register(t0);
+sampler2D s0 : register(s0);
+
+void main(float4 vpos : VPOS, float2 uv : TEXCOORD, out float4 col : COLOR)
+{
+	col = float4(0.0, 0.0, 0.0, tex2D(s0, uv).r); // Written with an alpha only write mask
+}
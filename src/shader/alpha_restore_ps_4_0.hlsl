@@ -0,0 +1,7 @@
+Texture2D t0 : register(t0);
+SamplerState s0 : register(s0);
+
+void main(float4 vpos : SV_POSITION, float2 uv : TEXCOORD0, out float4 col : SV_TARGET)
+{
+	col = float4(0.0, 0.0, 0.0, t0.Sample(s0, uv).r); // Written with an alpha only write mask
+}
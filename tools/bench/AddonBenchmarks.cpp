@@ -0,0 +1,719 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Micro benchmarks for the addon's per call hot paths, run against the stub ReShade headers and the mock device in
+// tools/mock with synthetic input. Uses google benchmark, so results can be written as JSON and compared between
+// versions:
+//
+//     addon_benchmarks --benchmark_format=json --benchmark_out=results.json
+//
+/////////////////////////////////////////////////////////////////////////
+#include <reshade.hpp>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "mock/MockDevice.h"
+#include "AddonUIData.h"
+#include "CDataFile.h"
+#include "ConstantCopyMemcpyNested.h"
+#include "ConstantHandlerBase.h"
+#include "DescriptorTracking.h"
+#include "FrameBudgetGovernor.h"
+#include "PipelinePrivateData.h"
+#include "RenderingQueueManager.h"
+#include "ResourceManager.h"
+#include "ShaderManager.h"
+#include "StateTracking.h"
+#include "crc32_hash.hpp"
+
+using namespace reshade::api;
+using namespace ShaderToggler;
+using namespace AddonImGui;
+using namespace Shim::Constants;
+using namespace std;
+
+static constexpr uint32_t HashesPerGroup = 64;
+
+// Synthetic shader hashes, the same for every run so results stay comparable
+static vector<uint32_t> MakeHashes(size_t count, uint32_t seed)
+{
+    mt19937 rng(seed);
+    vector<uint32_t> hashes(count);
+    for (auto& hash : hashes)
+    {
+        hash = rng();
+    }
+    return hashes;
+}
+
+// Counts the calls state_block::apply makes instead of logging them, so the bookkeeping doesn't dominate the timing
+class __declspec(novtable) CountingCommandList final : public Mock::MockObject<command_list>
+{
+public:
+    CountingCommandList(device* device) : _device(device) {}
+
+    device* get_device() override { return _device; }
+
+    void barrier(uint32_t, const resource*, const resource_usage*, const resource_usage*) override { calls++; }
+    void bind_render_targets_and_depth_stencil(uint32_t, const resource_view*, resource_view) override { calls++; }
+    void bind_pipeline(pipeline_stage, pipeline) override { calls++; }
+    void bind_pipeline_states(uint32_t, const dynamic_state*, const uint32_t*) override { calls++; }
+    void bind_viewports(uint32_t, uint32_t, const viewport*) override { calls++; }
+    void bind_scissor_rects(uint32_t, uint32_t, const rect*) override { calls++; }
+    void push_constants(shader_stage, pipeline_layout, uint32_t, uint32_t, uint32_t, const void*) override { calls++; }
+    void push_descriptors(shader_stage, pipeline_layout, uint32_t, const descriptor_table_update&) override { calls++; }
+    void bind_descriptor_tables(shader_stage, pipeline_layout, uint32_t, uint32_t, const descriptor_table*) override { calls++; }
+    void bind_vertex_buffers(uint32_t, uint32_t, const resource*, const uint64_t*, const uint32_t*) override { calls++; }
+    void draw(uint32_t, uint32_t, uint32_t, uint32_t) override { calls++; }
+    void copy_resource(resource, resource) override { calls++; }
+    void copy_buffer_region(resource, uint64_t, resource, uint64_t, uint64_t) override { calls++; }
+    void copy_texture_region(resource, uint32_t, const subresource_box*, resource, uint32_t, const subresource_box*, filter_mode) override { calls++; }
+    void clear_render_target_view(resource_view, const float[4], uint32_t, const rect*) override { calls++; }
+    void begin_query(query_heap, query_type, uint32_t) override {}
+    void end_query(query_heap, query_type, uint32_t) override {}
+
+    uint64_t calls = 0;
+
+private:
+    device* _device;
+};
+
+// Toggle groups with disjoint pixel, vertex and compute shader hash sets, indexed the way the addon does at runtime
+class GroupFixture final
+{
+public:
+    GroupFixture(uint32_t groupCount, uint32_t hashesPerGroup = HashesPerGroup) :
+        uiData(&pixelShaderManager, &vertexShaderManager, &computeShaderManager, nullptr, &activeCollectorFrameCounter)
+    {
+        const vector<uint32_t> hashes = MakeHashes(static_cast<size_t>(groupCount) * hashesPerGroup * 3, 0x5EED);
+
+        for (uint32_t g = 0; g < groupCount; g++)
+        {
+            const int id = ToggleGroup::getNewGroupId();
+            ToggleGroup& group = uiData.GetToggleGroups().emplace(id, ToggleGroup("Group" + to_string(id), id)).first->second;
+
+            unordered_set<uint32_t> stageHashes[3];
+            for (uint32_t stage = 0; stage < 3; stage++)
+            {
+                for (uint32_t i = 0; i < hashesPerGroup; i++)
+                {
+                    const uint32_t hash = hashes[(static_cast<size_t>(g) * 3 + stage) * hashesPerGroup + i];
+                    stageHashes[stage].insert(hash);
+                    knownHashes[stage].push_back(hash);
+                }
+            }
+
+            group.storeCollectedHashes(stageHashes[0], stageHashes[1], stageHashes[2]);
+            group.toggleActive();
+        }
+
+        uiData.UpdateToggleGroupsForShaderHashes();
+    }
+
+    ShaderManager pixelShaderManager;
+    ShaderManager vertexShaderManager;
+    ShaderManager computeShaderManager;
+    atomic_uint32_t activeCollectorFrameCounter = 0;
+    AddonUIData uiData;
+    vector<uint32_t> knownHashes[3];
+};
+
+static void BM_ShaderManagerHandleLookup(benchmark::State& state)
+{
+    ShaderManager manager;
+    const vector<uint32_t> hashes = MakeHashes(static_cast<size_t>(state.range(0)), 0xC0DE);
+
+    for (size_t i = 0; i < hashes.size(); i++)
+    {
+        manager.addHashHandlePair(hashes[i], 0x1000 + i);
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(manager.safeGetShaderHash(0x1000 + i));
+        i = (i + 1) % hashes.size();
+    }
+}
+BENCHMARK(BM_ShaderManagerHandleLookup)->Arg(256)->Arg(4096)->Arg(65536);
+
+template <const vector<ToggleGroup*>* (AddonUIData::*Lookup)(uint32_t), uint32_t Stage>
+static void BM_ToggleGroupLookup(benchmark::State& state)
+{
+    GroupFixture fixture(static_cast<uint32_t>(state.range(0)));
+
+    // Every other lookup misses, which is what the bulk of draws in a frame do
+    const vector<uint32_t>& known = fixture.knownHashes[Stage];
+    const vector<uint32_t> unknown = MakeHashes(known.size(), 0xBAD);
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize((fixture.uiData.*Lookup)(known[i]));
+        benchmark::DoNotOptimize((fixture.uiData.*Lookup)(unknown[i]));
+        i = (i + 1) % known.size();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_ToggleGroupLookup, &AddonUIData::GetToggleGroupsForPixelShaderHash, 0)->Name("BM_GetToggleGroupsForPixelShaderHash")->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(BM_ToggleGroupLookup, &AddonUIData::GetToggleGroupsForVertexShaderHash, 1)->Name("BM_GetToggleGroupsForVertexShaderHash")->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(BM_ToggleGroupLookup, &AddonUIData::GetToggleGroupsForComputeShaderHash, 2)->Name("BM_GetToggleGroupsForComputeShaderHash")->Arg(1)->Arg(16)->Arg(128);
+
+template <bool (ToggleGroup::*IsBlocked)(uint32_t) const, uint32_t Stage>
+static void BM_ToggleGroupIsBlocked(benchmark::State& state)
+{
+    GroupFixture fixture(1, static_cast<uint32_t>(state.range(0)));
+    const ToggleGroup& group = fixture.uiData.GetToggleGroups().begin()->second;
+
+    // Alternates hits and misses like BM_ToggleGroupLookup
+    const vector<uint32_t>& known = fixture.knownHashes[Stage];
+    const vector<uint32_t> unknown = MakeHashes(known.size(), 0xBAD);
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize((group.*IsBlocked)(known[i]));
+        benchmark::DoNotOptimize((group.*IsBlocked)(unknown[i]));
+        i = (i + 1) % known.size();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_ToggleGroupIsBlocked, &ToggleGroup::isBlockedPixelShader, 0)->Name("BM_IsBlockedPixelShader")->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_ToggleGroupIsBlocked, &ToggleGroup::isBlockedVertexShader, 1)->Name("BM_IsBlockedVertexShader")->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_ToggleGroupIsBlocked, &ToggleGroup::isBlockedComputeShader, 2)->Name("BM_IsBlockedComputeShader")->Arg(100)->Arg(1000)->Arg(10000);
+
+// Walks all hashes of a group through the span getters, like the UI and StartShaderEditing do
+static void BM_ToggleGroupHashSpans(benchmark::State& state)
+{
+    GroupFixture fixture(1, static_cast<uint32_t>(state.range(0)));
+    const ToggleGroup& group = fixture.uiData.GetToggleGroups().begin()->second;
+
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (const span<const uint32_t> hashes : { group.getPixelShaderHashes(), group.getVertexShaderHashes(), group.getComputeShaderHashes() })
+        {
+            sum = accumulate(hashes.begin(), hashes.end(), sum);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 3);
+}
+BENCHMARK(BM_ToggleGroupHashSpans)->Arg(100)->Arg(1000)->Arg(10000);
+
+// The second argument changes 1% of the first group's pixel shader hashes before every update, otherwise the index is
+// already up to date
+static void BM_UpdateToggleGroupsForShaderHashes(benchmark::State& state)
+{
+    const uint32_t hashesPerGroup = static_cast<uint32_t>(state.range(1));
+    const bool changed = state.range(2) != 0;
+    GroupFixture fixture(static_cast<uint32_t>(state.range(0)), hashesPerGroup);
+    ToggleGroup& group = fixture.uiData.GetToggleGroups().begin()->second;
+
+    const vector<uint32_t> replacements = MakeHashes(hashesPerGroup / 100 + 1, 0xED17);
+    const span<const uint32_t> pixelHashes = group.getPixelShaderHashes();
+    const span<const uint32_t> vertexHashes = group.getVertexShaderHashes();
+    const span<const uint32_t> computeHashes = group.getComputeShaderHashes();
+    const unordered_set<uint32_t> vertexShaderHashes(vertexHashes.begin(), vertexHashes.end());
+    const unordered_set<uint32_t> computeShaderHashes(computeHashes.begin(), computeHashes.end());
+    unordered_set<uint32_t> pixelShaderHashes[2] = { { pixelHashes.begin(), pixelHashes.end() }, { pixelHashes.begin(), pixelHashes.end() } };
+    for (size_t i = 0; i < replacements.size(); i++)
+    {
+        pixelShaderHashes[1].erase(pixelHashes[i * 100]);
+        pixelShaderHashes[1].insert(replacements[i]);
+    }
+
+    size_t edit = 0;
+    for (auto _ : state)
+    {
+        if (changed)
+        {
+            state.PauseTiming();
+            edit ^= 1;
+            group.storeCollectedHashes(pixelShaderHashes[edit], vertexShaderHashes, computeShaderHashes);
+            state.ResumeTiming();
+        }
+
+        fixture.uiData.UpdateToggleGroupsForShaderHashes();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0) * hashesPerGroup * 3);
+}
+BENCHMARK(BM_UpdateToggleGroupsForShaderHashes)->ArgNames({ "groups", "hashes", "changed" })
+    ->Args({ 1, 10000, 0 })->Args({ 16, 10000, 0 })->Args({ 1, 10000, 1 })->Args({ 16, 10000, 1 })->Unit(benchmark::kMicrosecond);
+
+static void BM_ComputeCrc32(benchmark::State& state)
+{
+    vector<uint8_t> code(static_cast<size_t>(state.range(0)));
+    mt19937 rng(0xC4C);
+    for (auto& byte : code)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(compute_crc32(code.data(), code.size()));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComputeCrc32)->Arg(1 << 10)->Arg(16 << 10)->Arg(256 << 10);
+
+static void BM_UpdateDescriptorTables(benchmark::State& state)
+{
+    Mock::CallLog log;
+    Mock::MockDevice device(device_api::d3d12, &log);
+    reshade::stub::invoke<reshade::addon_event::init_device>(static_cast<reshade::api::device*>(&device));
+
+    const uint32_t count = static_cast<uint32_t>(state.range(0));
+    vector<resource_view> views(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        views[i] = resource_view{ 0x2000 + i };
+    }
+
+    descriptor_table_update update = {};
+    update.table = descriptor_table{ 0x3000 };
+    update.count = count;
+    update.type = descriptor_type::shader_resource_view;
+    update.descriptors = views.data();
+
+    for (auto _ : state)
+    {
+        reshade::stub::invoke<reshade::addon_event::update_descriptor_tables>(static_cast<reshade::api::device*>(&device), 1u, static_cast<const descriptor_table_update*>(&update));
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+
+    reshade::stub::invoke<reshade::addon_event::destroy_device>(static_cast<reshade::api::device*>(&device));
+}
+BENCHMARK(BM_UpdateDescriptorTables)->Arg(1)->Arg(16)->Arg(256);
+
+static void BM_StateBlockCaptureApply(benchmark::State& state)
+{
+    Mock::CallLog log;
+    Mock::MockDevice device(static_cast<device_api>(state.range(0)), &log);
+    CountingCommandList cmd_list(&device);
+
+    reshade::stub::invoke<reshade::addon_event::init_device>(static_cast<reshade::api::device*>(&device));
+    reshade::stub::invoke<reshade::addon_event::init_command_list>(static_cast<command_list*>(&cmd_list));
+
+    const resource_view rtvs[2] = { resource_view{ 0x4000 }, resource_view{ 0x4001 } };
+    const viewport viewports[1] = { viewport{ 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f } };
+    const dynamic_state states[1] = { dynamic_state::primitive_topology };
+    const uint32_t values[1] = { static_cast<uint32_t>(primitive_topology::triangle_list) };
+
+    command_list* cmd = &cmd_list;
+    state_tracking& block = cmd->get_private_data<state_tracking>();
+
+    // The events the state is captured from, followed by restoring it after the addon rendered its effects
+    for (auto _ : state)
+    {
+        reshade::stub::invoke<reshade::addon_event::bind_render_targets_and_depth_stencil>(cmd, 2u, static_cast<const resource_view*>(rtvs), resource_view{ 0x4100 });
+        reshade::stub::invoke<reshade::addon_event::bind_pipeline>(cmd, pipeline_stage::vertex_shader, pipeline{ 0x5000 });
+        reshade::stub::invoke<reshade::addon_event::bind_pipeline>(cmd, pipeline_stage::pixel_shader, pipeline{ 0x5001 });
+        reshade::stub::invoke<reshade::addon_event::bind_pipeline_states>(cmd, 1u, static_cast<const dynamic_state*>(states), static_cast<const uint32_t*>(values));
+        reshade::stub::invoke<reshade::addon_event::bind_viewports>(cmd, 0u, 1u, static_cast<const viewport*>(viewports));
+
+        block.capture(cmd, true);
+        block.apply(cmd, true);
+    }
+
+    benchmark::DoNotOptimize(cmd_list.calls);
+    state.counters["binds_per_apply"] = static_cast<double>(cmd_list.calls) / static_cast<double>(state.iterations());
+
+    reshade::stub::invoke<reshade::addon_event::destroy_command_list>(cmd);
+    reshade::stub::invoke<reshade::addon_event::destroy_device>(static_cast<reshade::api::device*>(&device));
+}
+BENCHMARK(BM_StateBlockCaptureApply)->Arg(static_cast<int64_t>(device_api::d3d11))->Arg(static_cast<int64_t>(device_api::d3d12));
+
+static void BM_CheckCallForCommandList(benchmark::State& state)
+{
+    GroupFixture fixture(static_cast<uint32_t>(state.range(0)));
+    Rendering::ResourceManager resourceManager;
+    Rendering::FrameBudgetGovernor governor(fixture.uiData);
+    Rendering::RenderingQueueManager queueManager(fixture.uiData, resourceManager, governor);
+
+    Mock::CallLog log;
+    Mock::MockDevice device(device_api::d3d11, &log);
+    Mock::MockCommandQueue queue(&device, &log);
+    Mock::MockEffectRuntime runtime(&device, &queue, &log, 1920, 1080);
+    command_list* cmd_list = queue.get_immediate_command_list();
+
+    DeviceDataContainer& deviceData = device.create_private_data<DeviceDataContainer>();
+    CommandListDataContainer& commandListData = cmd_list->create_private_data<CommandListDataContainer>();
+    RuntimeDataContainer& runtimeData = runtime.create_private_data<RuntimeDataContainer>();
+    deviceData.current_runtime = &runtime;
+
+    // Every group renders two techniques of its own and takes constants, so all queues get work
+    vector<ToggleGroup*> matchedGroups;
+    for (auto& [id, group] : fixture.uiData.GetToggleGroups())
+    {
+        unordered_set<string> techniques;
+        for (uint32_t t = 0; t < 2; t++)
+        {
+            const string name = std::format("Technique{}_{} [Bench.fx]", id, t);
+            runtimeData.allTechniques.emplace(name, EffectData(effect_technique{ runtimeData.allTechniques.size() + 1 }));
+            techniques.insert(name);
+        }
+
+        group.setPreferredTechniques(techniques);
+        group.setExtractConstant(true);
+        group.AssignPreferredTechniqueData(runtimeData.allTechniques);
+        matchedGroups.push_back(&group);
+    }
+
+    for (auto _ : state)
+    {
+        commandListData.Reset();
+        commandListData.ps.blockedShaderGroups = &matchedGroups;
+        commandListData.vs.blockedShaderGroups = &matchedGroups;
+
+        queueManager.CheckCallForCommandList(cmd_list);
+        benchmark::DoNotOptimize(commandListData.commandQueue);
+    }
+
+    deviceData.current_runtime = nullptr;
+    runtime.destroy_private_data<RuntimeDataContainer>();
+    cmd_list->destroy_private_data<CommandListDataContainer>();
+    device.destroy_private_data<DeviceDataContainer>();
+}
+BENCHMARK(BM_CheckCallForCommandList)->Arg(1)->Arg(8)->Arg(32);
+
+static void BM_ApplyConstantValues(benchmark::State& state)
+{
+    const uint32_t variableCount = static_cast<uint32_t>(state.range(0));
+
+    Mock::CallLog log;
+    Mock::MockDevice device(device_api::d3d11, &log);
+    Mock::MockCommandQueue queue(&device, &log);
+    Mock::MockEffectRuntime runtime(&device, &queue, &log, 1920, 1080);
+    ConstantHandlerBase constantHandler;
+    ToggleGroup group("Constants", ToggleGroup::getNewGroupId());
+
+    // One float4 per variable, every variable read by two effects
+    unordered_map<string, tuple<constant_type, vector<effect_uniform_variable>>> constants;
+    for (uint32_t v = 0; v < variableCount; v++)
+    {
+        string name = std::format("Variable{}", v);
+        runtime.AddUniform(name, reshade::api::format::r32_float, 1, 4);
+        runtime.AddUniform(name, reshade::api::format::r32_float, 1, 4);
+
+        constants.emplace(name, make_tuple(constant_type::type_float4, vector<effect_uniform_variable>{ effect_uniform_variable{ v * 2 + 1 }, effect_uniform_variable{ v * 2 + 2 } }));
+        group.SetVarMapping(v * 16, name, (v & 1) != 0);
+    }
+
+    vector<uint32_t> buffer(variableCount * 4 + 4);
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        buffer[i] = static_cast<uint32_t>(i);
+    }
+    constantHandler.SetConstants(&group, buffer, &device, queue.get_immediate_command_list());
+
+    for (auto _ : state)
+    {
+        constantHandler.ApplyConstantValues(&runtime, &group, constants);
+    }
+
+    state.SetItemsProcessed(state.iterations() * variableCount);
+}
+BENCHMARK(BM_ApplyConstantValues)->Arg(4)->Arg(32)->Arg(256);
+
+enum class MemcpyCase
+{
+    EarlyOutMiss,
+    RangeMiss,
+    Hit
+};
+
+// Constant buffers mapped through the nested memcpy strategy, with memcpy destinations for each kind of lookup
+class MemcpyFixture final
+{
+public:
+    static constexpr uint64_t BufferSize = 256;
+    static constexpr size_t CopySize = 64;
+
+    MemcpyFixture(uint32_t bufferCount) : device(device_api::d3d11, &log)
+    {
+        const resource_desc desc(BufferSize, memory_heap::cpu_to_gpu, resource_usage::constant_buffer);
+
+        vector<uintptr_t> starts;
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            const resource buffer = { 0x6000 + i };
+            device.AddResource(buffer, desc);
+            copy.OnInitResource(&device, desc, nullptr, resource_usage::general, buffer);
+
+            void* data = nullptr;
+            device.map_buffer_region(buffer, 0, UINT64_MAX, map_access::write_discard, &data);
+            copy.OnMapBufferRegion(&device, buffer, 0, UINT64_MAX, map_access::write_discard, &data);
+
+            buffers.push_back(buffer);
+            starts.push_back(reinterpret_cast<uintptr_t>(data));
+        }
+
+        std::sort(starts.begin(), starts.end());
+
+        for (size_t i = 0; i < starts.size(); i++)
+        {
+            // Below the lowest mapped address, rejected by the range check
+            destinations[static_cast<size_t>(MemcpyCase::EarlyOutMiss)].push_back(reinterpret_cast<void*>(starts.front() - (i % 16 + 1) * CopySize));
+
+            // Between two mapped buffers, only rejected after the index lookup
+            if (i + 1 < starts.size() && starts[i] + BufferSize < starts[i + 1])
+            {
+                destinations[static_cast<size_t>(MemcpyCase::RangeMiss)].push_back(reinterpret_cast<void*>(starts[i] + BufferSize));
+            }
+
+            destinations[static_cast<size_t>(MemcpyCase::Hit)].push_back(reinterpret_cast<void*>(starts[i] + (i * CopySize) % BufferSize));
+        }
+    }
+
+    ~MemcpyFixture()
+    {
+        for (const resource buffer : buffers)
+        {
+            copy.OnUnmapBufferRegion(&device, buffer);
+            copy.OnDestroyResource(&device, buffer);
+        }
+    }
+
+    Mock::CallLog log;
+    Mock::MockDevice device;
+    ConstantCopyMemcpyNested copy;
+    vector<resource> buffers;
+    vector<void*> destinations[3];
+};
+
+// The part of detour_memcpy that depends on the mapped buffers, for a thread with a constant buffer mapped
+template <MemcpyCase Case>
+static void BM_MemcpyNestedOnMemcpy(benchmark::State& state)
+{
+    MemcpyFixture fixture(static_cast<uint32_t>(state.range(0)));
+    const vector<void*>& destinations = fixture.destinations[static_cast<size_t>(Case)];
+    if (destinations.empty())
+    {
+        state.SkipWithError("No memcpy destinations for this case");
+        return;
+    }
+
+    uint8_t source[MemcpyFixture::CopySize] = {};
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        fixture.copy.OnMemcpy(destinations[i], source, sizeof(source));
+        i = (i + 1) % destinations.size();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_MemcpyNestedOnMemcpy, MemcpyCase::EarlyOutMiss)->Name("BM_MemcpyNestedEarlyOutMiss")->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_MemcpyNestedOnMemcpy, MemcpyCase::RangeMiss)->Name("BM_MemcpyNestedRangeMiss")->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_MemcpyNestedOnMemcpy, MemcpyCase::Hit)->Name("BM_MemcpyNestedHit")->Arg(16)->Arg(256)->Arg(4096);
+
+static constexpr uint32_t KeysPerSection = 2000;
+
+// Scratch ini file in the temp directory, removed again when the benchmark is done
+class ScratchFile final
+{
+public:
+    ScratchFile(const string& name) : path((filesystem::temp_directory_path() / name).string()) {}
+    ~ScratchFile() { filesystem::remove(path); }
+
+    const string path;
+};
+
+// Hash sections the way configs written before the packed format store them, one ShaderHash<N> key per hash
+static void FillHashSections(CDataFile& iniFile, uint32_t keyCount)
+{
+    const vector<uint32_t> hashes = MakeHashes(keyCount, 0x1F1E);
+
+    for (uint32_t i = 0; i < keyCount; i++)
+    {
+        const string section = "Group" + to_string(i / KeysPerSection) + "_PixelShaders";
+        iniFile.SetUInt("ShaderHash" + to_string(i % KeysPerSection), hashes[i], "", section);
+    }
+}
+
+static void BM_DataFileSetValues(benchmark::State& state)
+{
+    const uint32_t keyCount = static_cast<uint32_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        CDataFile iniFile;
+        FillHashSections(iniFile, keyCount);
+        benchmark::DoNotOptimize(iniFile.KeyCount());
+
+        // Unsaved changes, the destructor would try to write them to a file without a name
+        iniFile.Clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * keyCount);
+}
+BENCHMARK(BM_DataFileSetValues)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_DataFileSave(benchmark::State& state)
+{
+    const uint32_t keyCount = static_cast<uint32_t>(state.range(0));
+    ScratchFile file("addon_benchmarks_save.ini");
+
+    CDataFile iniFile;
+    FillHashSections(iniFile, keyCount);
+    iniFile.SetFileName(file.path);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(iniFile.Save());
+    }
+
+    state.SetItemsProcessed(state.iterations() * keyCount);
+}
+BENCHMARK(BM_DataFileSave)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_DataFileLoad(benchmark::State& state)
+{
+    const uint32_t keyCount = static_cast<uint32_t>(state.range(0));
+    ScratchFile file("addon_benchmarks_load.ini");
+
+    {
+        CDataFile iniFile;
+        FillHashSections(iniFile, keyCount);
+        iniFile.SetFileName(file.path);
+        iniFile.Save();
+    }
+
+    for (auto _ : state)
+    {
+        CDataFile iniFile;
+        benchmark::DoNotOptimize(iniFile.Load(file.path));
+        iniFile.Clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * keyCount);
+}
+BENCHMARK(BM_DataFileLoad)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Groups with the given number of pixel shader hashes each, written and read the way AddonUIData saves the config
+static vector<ToggleGroup> MakeHashGroups(uint32_t groupCount, uint32_t hashesPerGroup)
+{
+    const vector<uint32_t> hashes = MakeHashes(static_cast<size_t>(groupCount) * hashesPerGroup, 0x5A7E);
+
+    vector<ToggleGroup> groups;
+    for (uint32_t g = 0; g < groupCount; g++)
+    {
+        ToggleGroup& group = groups.emplace_back("Group" + to_string(g), static_cast<int>(g));
+        const unordered_set<uint32_t> pixelShaderHashes(hashes.begin() + static_cast<size_t>(g) * hashesPerGroup, hashes.begin() + static_cast<size_t>(g + 1) * hashesPerGroup);
+        group.storeCollectedHashes(pixelShaderHashes, {}, {});
+    }
+
+    return groups;
+}
+
+static void BM_ToggleGroupSaveState(benchmark::State& state)
+{
+    const uint32_t groupCount = static_cast<uint32_t>(state.range(0));
+    const uint32_t hashesPerGroup = static_cast<uint32_t>(state.range(1));
+    const vector<ToggleGroup> groups = MakeHashGroups(groupCount, hashesPerGroup);
+    ScratchFile file("addon_benchmarks_groups_save.ini");
+
+    for (auto _ : state)
+    {
+        CDataFile iniFile;
+        iniFile.SetFileName(file.path);
+        for (uint32_t g = 0; g < groupCount; g++)
+        {
+            groups[g].saveState(iniFile, static_cast<int>(g));
+        }
+        iniFile.SetUInt("AmountGroups", groupCount, "", "General");
+        benchmark::DoNotOptimize(iniFile.Save());
+    }
+
+    state.SetItemsProcessed(state.iterations() * groupCount * hashesPerGroup);
+}
+BENCHMARK(BM_ToggleGroupSaveState)->ArgNames({ "groups", "hashes" })->Args({ 20, 2000 })->Args({ 50, 2000 })->Unit(benchmark::kMillisecond);
+
+// The second argument picks configs still written with one key per hash, which are read through the fallback path
+static void BM_ToggleGroupLoadState(benchmark::State& state)
+{
+    const uint32_t groupCount = static_cast<uint32_t>(state.range(0));
+    const uint32_t hashesPerGroup = KeysPerSection;
+    const bool legacyHashes = state.range(1) != 0;
+    ScratchFile file("addon_benchmarks_groups_load.ini");
+
+    {
+        CDataFile iniFile;
+        iniFile.SetFileName(file.path);
+
+        if (legacyHashes)
+        {
+            FillHashSections(iniFile, groupCount * hashesPerGroup);
+            for (uint32_t g = 0; g < groupCount; g++)
+            {
+                iniFile.SetUInt("AmountHashes", hashesPerGroup, "", "Group" + to_string(g) + "_PixelShaders");
+            }
+        }
+        else
+        {
+            const vector<ToggleGroup> groups = MakeHashGroups(groupCount, hashesPerGroup);
+            for (uint32_t g = 0; g < groupCount; g++)
+            {
+                groups[g].saveState(iniFile, static_cast<int>(g));
+            }
+        }
+
+        iniFile.Save();
+    }
+
+    for (auto _ : state)
+    {
+        CDataFile iniFile;
+        iniFile.Load(file.path);
+
+        vector<ToggleGroup> groups(groupCount);
+        for (uint32_t g = 0; g < groupCount; g++)
+        {
+            groups[g].loadState(iniFile, static_cast<int>(g));
+        }
+        benchmark::DoNotOptimize(groups.data());
+        iniFile.Clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * groupCount * hashesPerGroup);
+}
+BENCHMARK(BM_ToggleGroupLoadState)->ArgNames({ "groups", "legacy" })->Args({ 20, 0 })->Args({ 50, 0 })->Args({ 20, 1 })->Args({ 50, 1 })->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+    // state_tracking registers descriptor tracking with tracking disabled, swap in the tracking variant so
+    // update_descriptor_tables is measured
+    state_tracking::register_events(true);
+    descriptor_tracking::unregister_events(false);
+    descriptor_tracking::register_events(true);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    descriptor_tracking::unregister_events(true);
+    descriptor_tracking::register_events(false);
+    state_tracking::unregister_events();
+
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include "MockDevice.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+using namespace Mock;
+using namespace reshade::api;
+using namespace std;
+
+size_t CallLog::Count(const string& prefix) const
+{
+    return count_if(_calls.begin(), _calls.end(), [&prefix](const string& call) { return call.rfind(prefix, 0) == 0; });
+}
+
+device* MockCommandList::get_device()
+{
+    return _device;
+}
+
+void MockCommandList::bind_render_targets_and_depth_stencil(uint32_t count, const resource_view* rtvs, resource_view dsv)
+{
+    _log->Add(std::format("bind_render_targets count={} rtv={:#x}", count, count > 0 && rtvs != nullptr ? rtvs[0].handle : 0));
+}
+
+void MockCommandList::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t, uint32_t)
+{
+    _log->Add(std::format("draw vertices={} instances={}", vertex_count, instance_count));
+}
+
+void MockCommandList::copy_resource(resource source, resource dest)
+{
+    _log->Add(std::format("copy_resource src={:#x} dst={:#x}", source.handle, dest.handle));
+}
+
+void MockCommandList::copy_buffer_region(resource source, uint64_t source_offset, resource dest, uint64_t dest_offset, uint64_t size)
+{
+    _log->Add(std::format("copy_buffer_region src={:#x}+{} dst={:#x}+{} size={}", source.handle, source_offset, dest.handle, dest_offset, size));
+}
+
+void MockCommandList::copy_texture_region(resource source, uint32_t, const subresource_box*, resource dest, uint32_t, const subresource_box*, filter_mode)
+{
+    _log->Add(std::format("copy_texture_region src={:#x} dst={:#x}", source.handle, dest.handle));
+}
+
+void MockCommandList::clear_render_target_view(resource_view rtv, const float[4], uint32_t, const rect*)
+{
+    _log->Add(std::format("clear_render_target_view rtv={:#x}", rtv.handle));
+}
+
+device* MockCommandQueue::get_device()
+{
+    return _device;
+}
+
+void MockDevice::AddResource(resource handle, const resource_desc& desc)
+{
+    _resources[handle.handle] = desc;
+}
+
+void MockDevice::AddResourceView(resource_view handle, resource resource, const resource_view_desc& desc)
+{
+    _views[handle.handle] = { resource, desc };
+}
+
+void MockDevice::RemoveResource(resource handle)
+{
+    _resources.erase(handle.handle);
+    _bufferMemory.erase(handle.handle);
+}
+
+void MockDevice::RemoveResourceView(resource_view handle)
+{
+    _views.erase(handle.handle);
+}
+
+bool MockDevice::create_sampler(const sampler_desc&, sampler* out_handle)
+{
+    *out_handle = { NextHandle() };
+    return true;
+}
+
+bool MockDevice::create_resource(const resource_desc& desc, const subresource_data*, resource_usage, resource* out_handle, void**)
+{
+    *out_handle = { NextHandle() };
+    _resources[out_handle->handle] = desc;
+    _ownedResources++;
+    return true;
+}
+
+void MockDevice::destroy_resource(resource handle)
+{
+    if (_resources.erase(handle.handle) > 0 && _ownedResources > 0)
+        _ownedResources--;
+    _bufferMemory.erase(handle.handle);
+}
+
+resource_desc MockDevice::get_resource_desc(resource resource) const
+{
+    const auto it = _resources.find(resource.handle);
+    return it != _resources.end() ? it->second : resource_desc{};
+}
+
+bool MockDevice::create_resource_view(resource resource, resource_usage, const resource_view_desc& desc, resource_view* out_handle)
+{
+    *out_handle = { NextHandle() };
+    _views[out_handle->handle] = { resource, desc };
+    _ownedViews++;
+    return true;
+}
+
+void MockDevice::destroy_resource_view(resource_view handle)
+{
+    if (_views.erase(handle.handle) > 0 && _ownedViews > 0)
+        _ownedViews--;
+}
+
+resource MockDevice::get_resource_from_view(resource_view view) const
+{
+    const auto it = _views.find(view.handle);
+    return it != _views.end() ? it->second.resource : resource{ 0 };
+}
+
+resource_view_desc MockDevice::get_resource_view_desc(resource_view view) const
+{
+    const auto it = _views.find(view.handle);
+    return it != _views.end() ? it->second.desc : resource_view_desc{};
+}
+
+bool MockDevice::map_buffer_region(resource resource, uint64_t offset, uint64_t size, map_access, void** out_data)
+{
+    const auto it = _resources.find(resource.handle);
+    if (it == _resources.end() || it->second.type != resource_type::buffer)
+        return false;
+
+    vector<uint8_t>& memory = _bufferMemory[resource.handle];
+    memory.resize(static_cast<size_t>(it->second.buffer.size));
+
+    if (offset > memory.size() || (size != UINT64_MAX && offset + size > memory.size()))
+        return false;
+
+    *out_data = memory.data() + offset;
+    return true;
+}
+
+void MockDevice::update_buffer_region(const void* data, resource resource, uint64_t offset, uint64_t size)
+{
+    void* mapped = nullptr;
+    if (map_buffer_region(resource, offset, size, map_access::write_only, &mapped))
+        memcpy(mapped, data, static_cast<size_t>(size));
+}
+
+bool MockDevice::create_pipeline(pipeline_layout layout, uint32_t subobject_count, const pipeline_subobject* subobjects, pipeline* out_handle)
+{
+    MockPipeline desc;
+    desc.layout = layout;
+
+    for (uint32_t i = 0; i < subobject_count; i++)
+    {
+        const pipeline_subobject& subobject = subobjects[i];
+
+        switch (subobject.type)
+        {
+        case pipeline_subobject_type::vertex_shader:
+            desc.vs = *static_cast<const shader_desc*>(subobject.data);
+            break;
+        case pipeline_subobject_type::pixel_shader:
+            desc.ps = *static_cast<const shader_desc*>(subobject.data);
+            break;
+        case pipeline_subobject_type::blend_state:
+            desc.hasBlendState = true;
+            desc.blend = *static_cast<const blend_desc*>(subobject.data);
+            break;
+        case pipeline_subobject_type::render_target_formats:
+        {
+            const reshade::api::format* formats = static_cast<const reshade::api::format*>(subobject.data);
+            desc.renderTargetFormats.assign(formats, formats + subobject.count);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    if (_api == device_api::vulkan &&
+        (desc.vs.code == nullptr || desc.ps.code == nullptr || desc.renderTargetFormats.empty() ||
+         any_of(desc.renderTargetFormats.begin(), desc.renderTargetFormats.end(), [](reshade::api::format f) { return f == reshade::api::format::unknown; })))
+    {
+        *out_handle = { 0 };
+        return false;
+    }
+
+    *out_handle = { NextHandle() };
+    _pipelines[out_handle->handle] = std::move(desc);
+    return true;
+}
+
+void MockDevice::destroy_pipeline(pipeline handle)
+{
+    if (_pipelines.erase(handle.handle) == 0)
+        _invalidDestroys++;
+}
+
+bool MockDevice::create_pipeline_layout(uint32_t param_count, const pipeline_layout_param* params, pipeline_layout* out_handle)
+{
+    *out_handle = { NextHandle() };
+    _pipelineLayouts[out_handle->handle].assign(params, params + param_count);
+    return true;
+}
+
+void MockDevice::destroy_pipeline_layout(pipeline_layout handle)
+{
+    if (_pipelineLayouts.erase(handle.handle) == 0)
+        _invalidDestroys++;
+}
+
+const vector<pipeline_layout_param>* MockDevice::GetPipelineLayoutParams(pipeline_layout layout) const
+{
+    const auto it = _pipelineLayouts.find(layout.handle);
+    return it != _pipelineLayouts.end() ? &it->second : nullptr;
+}
+
+void MockDevice::get_descriptor_heap_offset(descriptor_table table, uint32_t binding, uint32_t array_offset, descriptor_heap* out_heap, uint32_t* out_offset) const
+{
+    *out_heap = { table.handle };
+    *out_offset = binding + array_offset;
+}
+
+MockEffectRuntime::MockEffectRuntime(MockDevice* device, MockCommandQueue* queue, CallLog* log, uint32_t width, uint32_t height) :
+    _device(device), _queue(queue), _log(log), _width(width), _height(height)
+{
+    _device->create_resource(resource_desc(width, height, 1, 1, reshade::api::format::r8g8b8a8_unorm, 1, memory_heap::gpu_only, resource_usage::render_target | resource_usage::shader_resource | resource_usage::copy_dest | resource_usage::copy_source),
+        nullptr, resource_usage::render_target, &_backBuffer, nullptr);
+    _device->create_resource_view(_backBuffer, resource_usage::render_target, resource_view_desc(reshade::api::format::r8g8b8a8_unorm), &_backBufferView);
+}
+
+void MockEffectRuntime::AddTechnique(const string& name, const string& effectName, bool enabled)
+{
+    _techniques.push_back({ name, effectName, enabled });
+}
+
+void MockEffectRuntime::AddUniform(const string& source, reshade::api::format type, uint32_t rows, uint32_t columns)
+{
+    MockUniform uniform;
+    uniform.source = source;
+    uniform.type = type;
+    uniform.rows = rows;
+    uniform.columns = columns;
+    uniform.value.resize(rows * columns * 4);
+    _uniforms.push_back(move(uniform));
+}
+
+device* MockEffectRuntime::get_device()
+{
+    return _device;
+}
+
+command_queue* MockEffectRuntime::get_command_queue()
+{
+    return _queue;
+}
+
+void MockEffectRuntime::render_effects(command_list*, resource_view rtv, resource_view)
+{
+    _log->Add(std::format("render_effects rtv={:#x}", rtv.handle));
+}
+
+void MockEffectRuntime::render_technique(effect_technique technique, command_list*, resource_view rtv, resource_view)
+{
+    const MockTechnique* tech = GetTechnique(technique);
+    _log->Add(std::format("render_technique {} rtv={:#x}", tech != nullptr ? tech->name : "<invalid>", rtv.handle));
+}
+
+void MockEffectRuntime::update_texture_bindings(const char* semantic, resource_view srv, resource_view)
+{
+    _log->Add(std::format("update_texture_bindings {} srv={:#x}", semantic, srv.handle));
+}
+
+void MockEffectRuntime::get_screenshot_width_and_height(uint32_t* out_width, uint32_t* out_height) const
+{
+    *out_width = _width;
+    *out_height = _height;
+}
+
+void MockEffectRuntime::enumerate_uniform_variables(const char* effect_name, void(*callback)(effect_runtime* runtime, effect_uniform_variable variable, void* user_data), void* user_data)
+{
+    for (size_t i = 0; i < _uniforms.size(); i++)
+        callback(this, { i + 1 }, user_data);
+}
+
+void MockEffectRuntime::get_uniform_variable_type(effect_uniform_variable variable, reshade::api::format* out_base_type, uint32_t* out_rows, uint32_t* out_columns, uint32_t* out_array_length) const
+{
+    const MockUniform* uniform = GetUniform(variable);
+    if (out_base_type != nullptr)
+        *out_base_type = uniform != nullptr ? uniform->type : reshade::api::format::unknown;
+    if (out_rows != nullptr)
+        *out_rows = uniform != nullptr ? uniform->rows : 0;
+    if (out_columns != nullptr)
+        *out_columns = uniform != nullptr ? uniform->columns : 0;
+    if (out_array_length != nullptr)
+        *out_array_length = 0;
+}
+
+bool MockEffectRuntime::get_annotation_string_from_uniform_variable(effect_uniform_variable variable, const char* name, char* value, size_t* length) const
+{
+    const MockUniform* uniform = GetUniform(variable);
+    if (uniform == nullptr || strcmp(name, "source") != 0 || uniform->source.empty())
+        return false;
+
+    if (value != nullptr && *length > 0)
+    {
+        const size_t count = min(*length - 1, uniform->source.size());
+        memcpy(value, uniform->source.data(), count);
+        value[count] = '\0';
+    }
+    *length = uniform->source.size() + 1;
+    return true;
+}
+
+void MockEffectRuntime::SetUniformValue(effect_uniform_variable variable, const void* values, size_t size, size_t offset)
+{
+    MockUniform* uniform = GetUniform(variable);
+    if (uniform == nullptr)
+        return;
+
+    if (uniform->value.size() < offset + size)
+        uniform->value.resize(offset + size);
+    memcpy(uniform->value.data() + offset, values, size);
+}
+
+void MockEffectRuntime::set_uniform_value_float(effect_uniform_variable variable, const float* values, size_t count, size_t array_index)
+{
+    SetUniformValue(variable, values, count * sizeof(float), array_index * count * sizeof(float));
+}
+
+void MockEffectRuntime::set_uniform_value_int(effect_uniform_variable variable, const int32_t* values, size_t count, size_t array_index)
+{
+    SetUniformValue(variable, values, count * sizeof(int32_t), array_index * count * sizeof(int32_t));
+}
+
+void MockEffectRuntime::set_uniform_value_uint(effect_uniform_variable variable, const uint32_t* values, size_t count, size_t array_index)
+{
+    SetUniformValue(variable, values, count * sizeof(uint32_t), array_index * count * sizeof(uint32_t));
+}
+
+void MockEffectRuntime::enumerate_techniques(const char* effect_name, void(*callback)(effect_runtime* runtime, effect_technique technique, void* user_data), void* user_data)
+{
+    for (size_t i = 0; i < _techniques.size(); i++)
+    {
+        if (effect_name == nullptr || _techniques[i].effectName == effect_name)
+            callback(this, { i + 1 }, user_data);
+    }
+}
+
+static void CopyName(const string& source, char* name, size_t* length)
+{
+    if (name != nullptr && *length > 0)
+    {
+        const size_t count = min(*length - 1, source.size());
+        memcpy(name, source.data(), count);
+        name[count] = '\0';
+    }
+    *length = source.size() + 1;
+}
+
+void MockEffectRuntime::get_technique_name(effect_technique technique, char* name, size_t* length) const
+{
+    const MockTechnique* tech = GetTechnique(technique);
+    CopyName(tech != nullptr ? tech->name : string(), name, length);
+}
+
+void MockEffectRuntime::get_technique_effect_name(effect_technique technique, char* effect_name, size_t* length) const
+{
+    const MockTechnique* tech = GetTechnique(technique);
+    CopyName(tech != nullptr ? tech->effectName : string(), effect_name, length);
+}
+
+bool MockEffectRuntime::get_technique_state(effect_technique technique) const
+{
+    const MockTechnique* tech = GetTechnique(technique);
+    return tech != nullptr && tech->enabled;
+}
+
+void MockEffectRuntime::set_technique_state(effect_technique technique, bool enabled)
+{
+    if (technique.handle > 0 && technique.handle <= _techniques.size())
+        _techniques[technique.handle - 1].enabled = enabled;
+}
+
+const MockTechnique* MockEffectRuntime::GetTechnique(effect_technique technique) const
+{
+    return technique.handle > 0 && technique.handle <= _techniques.size() ? &_techniques[technique.handle - 1] : nullptr;
+}
+
+MockUniform* MockEffectRuntime::GetUniform(effect_uniform_variable variable)
+{
+    return variable.handle > 0 && variable.handle <= _uniforms.size() ? &_uniforms[variable.handle - 1] : nullptr;
+}
+
+const MockUniform* MockEffectRuntime::GetUniform(effect_uniform_variable variable) const
+{
+    return variable.handle > 0 && variable.handle <= _uniforms.size() ? &_uniforms[variable.handle - 1] : nullptr;
+}
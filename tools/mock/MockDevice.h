@@ -0,0 +1,257 @@
+#pragma once
+
+#include <reshade.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Mock
+{
+    // Calls the addon made on the mock objects that matter for what ends up on screen, in order
+    class __declspec(novtable) CallLog final
+    {
+    public:
+        void Add(std::string call) { _calls.push_back(std::move(call)); }
+        void Clear() { _calls.clear(); }
+        const std::vector<std::string>& GetCalls() const { return _calls; }
+        size_t Count(const std::string& prefix) const;
+
+    private:
+        std::vector<std::string> _calls;
+    };
+
+    template <typename T>
+    class __declspec(novtable) MockObject : public T
+    {
+    public:
+        uint64_t get_native() const override { return 0; }
+
+        bool get_private_data(const uint8_t guid[16], uint64_t* data) const override
+        {
+            const auto it = _privateData.find(guid);
+            *data = it != _privateData.end() ? it->second : 0;
+            return it != _privateData.end();
+        }
+
+        void set_private_data(const uint8_t guid[16], const uint64_t data) override
+        {
+            if (data == 0)
+                _privateData.erase(guid);
+            else
+                _privateData[guid] = data;
+        }
+
+    private:
+        std::unordered_map<const uint8_t*, uint64_t> _privateData;
+    };
+
+    class MockDevice;
+
+    // What the addon created a pipeline from. Shader code is kept as the pointer it was passed, which points into the embedded resource.
+    struct MockPipeline
+    {
+        reshade::api::pipeline_layout layout = { 0 };
+        reshade::api::shader_desc vs = {};
+        reshade::api::shader_desc ps = {};
+        bool hasBlendState = false;
+        reshade::api::blend_desc blend = {};
+        std::vector<reshade::api::format> renderTargetFormats;
+    };
+
+    class __declspec(novtable) MockCommandList final : public MockObject<reshade::api::command_list>
+    {
+    public:
+        MockCommandList(MockDevice* device, CallLog* log) : _device(device), _log(log) {}
+
+        reshade::api::device* get_device() override;
+
+        void barrier(uint32_t, const reshade::api::resource*, const reshade::api::resource_usage*, const reshade::api::resource_usage*) override {}
+        void bind_render_targets_and_depth_stencil(uint32_t count, const reshade::api::resource_view* rtvs, reshade::api::resource_view dsv) override;
+        void bind_pipeline(reshade::api::pipeline_stage, reshade::api::pipeline) override {}
+        void bind_pipeline_states(uint32_t, const reshade::api::dynamic_state*, const uint32_t*) override {}
+        void bind_viewports(uint32_t, uint32_t, const reshade::api::viewport*) override {}
+        void bind_scissor_rects(uint32_t, uint32_t, const reshade::api::rect*) override {}
+        void push_constants(reshade::api::shader_stage, reshade::api::pipeline_layout, uint32_t, uint32_t, uint32_t, const void*) override {}
+        void push_descriptors(reshade::api::shader_stage, reshade::api::pipeline_layout, uint32_t, const reshade::api::descriptor_table_update&) override {}
+        void bind_descriptor_tables(reshade::api::shader_stage, reshade::api::pipeline_layout, uint32_t, uint32_t, const reshade::api::descriptor_table*) override {}
+        void bind_vertex_buffers(uint32_t, uint32_t, const reshade::api::resource*, const uint64_t*, const uint32_t*) override {}
+        void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override;
+        void copy_resource(reshade::api::resource source, reshade::api::resource dest) override;
+        void copy_buffer_region(reshade::api::resource source, uint64_t source_offset, reshade::api::resource dest, uint64_t dest_offset, uint64_t size) override;
+        void copy_texture_region(reshade::api::resource source, uint32_t, const reshade::api::subresource_box*, reshade::api::resource dest, uint32_t, const reshade::api::subresource_box*, reshade::api::filter_mode) override;
+        void clear_render_target_view(reshade::api::resource_view rtv, const float color[4], uint32_t, const reshade::api::rect*) override;
+        void begin_query(reshade::api::query_heap, reshade::api::query_type, uint32_t) override {}
+        void end_query(reshade::api::query_heap, reshade::api::query_type, uint32_t) override {}
+
+    private:
+        MockDevice* _device;
+        CallLog* _log;
+    };
+
+    class __declspec(novtable) MockCommandQueue final : public MockObject<reshade::api::command_queue>
+    {
+    public:
+        MockCommandQueue(MockDevice* device, CallLog* log) : _device(device), _immediate(device, log) {}
+
+        reshade::api::device* get_device() override;
+        void wait_idle() const override {}
+        void flush_immediate_command_list() const override {}
+        reshade::api::command_list* get_immediate_command_list() override { return &_immediate; }
+        uint64_t get_timestamp_frequency() const override { return 0; }
+
+    private:
+        MockDevice* _device;
+        MockCommandList _immediate;
+    };
+
+    // Answers descriptions for resources and views the harness registers and creates handles for the addon's own
+    // objects from a separate range, so they never collide with handles taken from a trace
+    class __declspec(novtable) MockDevice final : public MockObject<reshade::api::device>
+    {
+    public:
+        MockDevice(reshade::api::device_api api, CallLog* log) : _api(api), _log(log) {}
+
+        reshade::api::device_api get_api() const override { return _api; }
+
+        void AddResource(reshade::api::resource handle, const reshade::api::resource_desc& desc);
+        void AddResourceView(reshade::api::resource_view handle, reshade::api::resource resource, const reshade::api::resource_view_desc& desc);
+        void RemoveResource(reshade::api::resource handle);
+        void RemoveResourceView(reshade::api::resource_view handle);
+
+        bool create_sampler(const reshade::api::sampler_desc&, reshade::api::sampler* out_handle) override;
+        void destroy_sampler(reshade::api::sampler) override {}
+
+        bool create_resource(const reshade::api::resource_desc& desc, const reshade::api::subresource_data*, reshade::api::resource_usage, reshade::api::resource* out_handle, void** shared_handle) override;
+        void destroy_resource(reshade::api::resource handle) override;
+        reshade::api::resource_desc get_resource_desc(reshade::api::resource resource) const override;
+
+        bool create_resource_view(reshade::api::resource resource, reshade::api::resource_usage usage_type, const reshade::api::resource_view_desc& desc, reshade::api::resource_view* out_handle) override;
+        void destroy_resource_view(reshade::api::resource_view handle) override;
+        reshade::api::resource get_resource_from_view(reshade::api::resource_view view) const override;
+        reshade::api::resource_view_desc get_resource_view_desc(reshade::api::resource_view view) const override;
+
+        bool map_buffer_region(reshade::api::resource resource, uint64_t offset, uint64_t size, reshade::api::map_access access, void** out_data) override;
+        void unmap_buffer_region(reshade::api::resource) override {}
+        bool map_texture_region(reshade::api::resource, uint32_t, const reshade::api::subresource_box*, reshade::api::map_access, reshade::api::subresource_data*) override { return false; }
+        void unmap_texture_region(reshade::api::resource, uint32_t) override {}
+        void update_buffer_region(const void* data, reshade::api::resource resource, uint64_t offset, uint64_t size) override;
+
+        // Like a Vulkan driver, pipelines without both shaders or a known render target format fail to be created on Vulkan
+        bool create_pipeline(reshade::api::pipeline_layout layout, uint32_t subobject_count, const reshade::api::pipeline_subobject* subobjects, reshade::api::pipeline* out_handle) override;
+        void destroy_pipeline(reshade::api::pipeline handle) override;
+        bool create_pipeline_layout(uint32_t param_count, const reshade::api::pipeline_layout_param* params, reshade::api::pipeline_layout* out_handle) override;
+        void destroy_pipeline_layout(reshade::api::pipeline_layout handle) override;
+
+        // Every table is its own heap and bindings are laid out one after another
+        void get_descriptor_heap_offset(reshade::api::descriptor_table table, uint32_t binding, uint32_t array_offset, reshade::api::descriptor_heap* out_heap, uint32_t* out_offset) const override;
+
+        bool create_query_heap(reshade::api::query_type, uint32_t, reshade::api::query_heap*) override { return false; }
+        void destroy_query_heap(reshade::api::query_heap) override {}
+        bool get_query_heap_results(reshade::api::query_heap, uint32_t, uint32_t, void*, uint32_t) override { return false; }
+
+        size_t GetLiveObjectCount() const { return _ownedResources + _ownedViews; }
+        const std::unordered_map<uint64_t, MockPipeline>& GetLivePipelines() const { return _pipelines; }
+        const std::vector<reshade::api::pipeline_layout_param>* GetPipelineLayoutParams(reshade::api::pipeline_layout layout) const;
+        // Destroys of pipelines and layouts that weren't created or were already destroyed
+        size_t GetInvalidDestroyCount() const { return _invalidDestroys; }
+
+    private:
+        uint64_t NextHandle() { return _nextHandle++; }
+
+        struct ViewData
+        {
+            reshade::api::resource resource;
+            reshade::api::resource_view_desc desc;
+        };
+
+        reshade::api::device_api _api;
+        CallLog* _log;
+        uint64_t _nextHandle = 0xA000000000000000;
+        size_t _ownedResources = 0;
+        size_t _ownedViews = 0;
+        size_t _invalidDestroys = 0;
+        std::unordered_map<uint64_t, reshade::api::resource_desc> _resources;
+        std::unordered_map<uint64_t, ViewData> _views;
+        std::unordered_map<uint64_t, std::vector<uint8_t>> _bufferMemory;
+        std::unordered_map<uint64_t, MockPipeline> _pipelines;
+        std::unordered_map<uint64_t, std::vector<reshade::api::pipeline_layout_param>> _pipelineLayouts;
+    };
+
+    struct MockTechnique
+    {
+        std::string name;
+        std::string effectName;
+        bool enabled = true;
+    };
+
+    struct MockUniform
+    {
+        std::string source;
+        reshade::api::format type = reshade::api::format::r32_float;
+        uint32_t rows = 1;
+        uint32_t columns = 1;
+        std::vector<uint8_t> value;
+    };
+
+    // Effect runtime with a fixed list of techniques and uniforms. Rendering only records the call.
+    class __declspec(novtable) MockEffectRuntime final : public MockObject<reshade::api::effect_runtime>
+    {
+    public:
+        MockEffectRuntime(MockDevice* device, MockCommandQueue* queue, CallLog* log, uint32_t width, uint32_t height);
+
+        void AddTechnique(const std::string& name, const std::string& effectName, bool enabled = true);
+        void AddUniform(const std::string& source, reshade::api::format type, uint32_t rows = 1, uint32_t columns = 1);
+        reshade::api::resource_view GetBackBufferView() const { return _backBufferView; }
+
+        reshade::api::device* get_device() override;
+        void* get_hwnd() const override { return nullptr; }
+        reshade::api::resource get_back_buffer(uint32_t) override { return _backBuffer; }
+        uint32_t get_back_buffer_count() const override { return 1; }
+        uint32_t get_current_back_buffer_index() const override { return 0; }
+
+        reshade::api::command_queue* get_command_queue() override;
+
+        void render_effects(reshade::api::command_list* cmd_list, reshade::api::resource_view rtv, reshade::api::resource_view rtv_srgb) override;
+        void render_technique(reshade::api::effect_technique technique, reshade::api::command_list* cmd_list, reshade::api::resource_view rtv, reshade::api::resource_view rtv_srgb) override;
+        void update_texture_bindings(const char* semantic, reshade::api::resource_view srv, reshade::api::resource_view srv_srgb) override;
+
+        void get_screenshot_width_and_height(uint32_t* out_width, uint32_t* out_height) const override;
+        bool get_effects_state() const override { return true; }
+
+        bool is_key_down(uint32_t) const override { return false; }
+        bool is_key_pressed(uint32_t) const override { return false; }
+
+        void enumerate_uniform_variables(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_uniform_variable variable, void* user_data), void* user_data) override;
+        void get_uniform_variable_type(reshade::api::effect_uniform_variable variable, reshade::api::format* out_base_type, uint32_t* out_rows, uint32_t* out_columns, uint32_t* out_array_length) const override;
+        bool get_annotation_string_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, char* value, size_t* length) const override;
+        void set_uniform_value_float(reshade::api::effect_uniform_variable variable, const float* values, size_t count, size_t array_index) override;
+        void set_uniform_value_int(reshade::api::effect_uniform_variable variable, const int32_t* values, size_t count, size_t array_index) override;
+        void set_uniform_value_uint(reshade::api::effect_uniform_variable variable, const uint32_t* values, size_t count, size_t array_index) override;
+
+        void enumerate_techniques(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_technique technique, void* user_data), void* user_data) override;
+        void get_technique_name(reshade::api::effect_technique technique, char* name, size_t* length) const override;
+        void get_technique_effect_name(reshade::api::effect_technique technique, char* effect_name, size_t* length) const override;
+        bool get_annotation_bool_from_technique(reshade::api::effect_technique, const char*, bool*, size_t, size_t) const override { return false; }
+        bool get_annotation_int_from_technique(reshade::api::effect_technique, const char*, int32_t*, size_t, size_t) const override { return false; }
+        bool get_technique_state(reshade::api::effect_technique technique) const override;
+        void set_technique_state(reshade::api::effect_technique technique, bool enabled) override;
+
+    private:
+        const MockTechnique* GetTechnique(reshade::api::effect_technique technique) const;
+        MockUniform* GetUniform(reshade::api::effect_uniform_variable variable);
+        const MockUniform* GetUniform(reshade::api::effect_uniform_variable variable) const;
+        void SetUniformValue(reshade::api::effect_uniform_variable variable, const void* values, size_t size, size_t offset);
+
+        MockDevice* _device;
+        MockCommandQueue* _queue;
+        CallLog* _log;
+        uint32_t _width;
+        uint32_t _height;
+        reshade::api::resource _backBuffer = { 0 };
+        reshade::api::resource_view _backBufferView = { 0 };
+        std::vector<MockTechnique> _techniques;
+        std::vector<MockUniform> _uniforms;
+    };
+}
@@ -0,0 +1,990 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Replays a trace written by Profiling::TraceCapture through the addon's matching, queueing, binding, effect and
+// constant code without ReShade or a GPU. The handlers below mirror the ones in src/Main.cpp; keep them in sync.
+//
+// Usage: trace_replay <trace> [--config <ini>] [--api d3d9|d3d10|d3d11|d3d12|opengl|vulkan] [--size <w>x<h>]
+//                     [--technique <name>[@<effect>]]... [--repeat <n>] [--quiet]
+//
+// Prints the render_technique/copy calls the addon made, per frame, followed by the time spent in every subsystem.
+//
+/////////////////////////////////////////////////////////////////////////
+#include <reshade.hpp>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mock/MockDevice.h"
+#include "AddonUIData.h"
+#include "ConstantHandlerBase.h"
+#include "ConstantCopyGPUReadback.h"
+#include "ConstantCopyMemcpyNested.h"
+#include "ConstantCopyMemcpySingular.h"
+#include "ConstantCopyNierReplicant.h"
+#include "ConstantCopyPersistentMap.h"
+#include "PipelinePrivateData.h"
+#include "ResourceManager.h"
+#include "RenderingManager.h"
+#include "RenderingShaderManager.h"
+#include "RenderingQueueManager.h"
+#include "RenderingEffectManager.h"
+#include "RenderingBindingManager.h"
+#include "RenderingPreviewManager.h"
+#include "ShaderManager.h"
+#include "TechniqueManager.h"
+#include "StateTracking.h"
+#include "DescriptorTracking.h"
+#include "KeyMonitor.h"
+#include "FrameBudgetGovernor.h"
+#include "GroupCostTracker.h"
+
+using namespace reshade::api;
+using namespace ShaderToggler;
+using namespace AddonImGui;
+using namespace Shim::Constants;
+using namespace std;
+
+enum ReplaySubsystem : uint32_t
+{
+    SUBSYSTEM_STATE_TRACKING = 0,
+    SUBSYSTEM_SHADER_MATCHING,
+    SUBSYSTEM_QUEUE,
+    SUBSYSTEM_EFFECTS,
+    SUBSYSTEM_BINDINGS,
+    SUBSYSTEM_PREVIEW,
+    SUBSYSTEM_CONSTANTS,
+    SUBSYSTEM_RESOURCES,
+    SUBSYSTEM_PRESENT,
+    SUBSYSTEM_COUNT
+};
+
+static constexpr const char* SubsystemNames[SUBSYSTEM_COUNT] = {
+    "state tracking",
+    "shader matching",
+    "queue",
+    "effects",
+    "bindings",
+    "preview",
+    "constants",
+    "resources",
+    "present",
+};
+
+struct SubsystemTiming
+{
+    chrono::nanoseconds time{ 0 };
+    uint64_t calls = 0;
+};
+
+static SubsystemTiming g_timings[SUBSYSTEM_COUNT];
+
+class ScopedTiming final
+{
+public:
+    ScopedTiming(ReplaySubsystem subsystem) : _subsystem(subsystem), _start(chrono::steady_clock::now()) {}
+    ~ScopedTiming()
+    {
+        g_timings[_subsystem].time += chrono::steady_clock::now() - _start;
+        g_timings[_subsystem].calls++;
+    }
+
+private:
+    ReplaySubsystem _subsystem;
+    chrono::steady_clock::time_point _start;
+};
+
+#define TIME_SUBSYSTEM_NAME(line) _scopedTiming##line
+#define TIME_SUBSYSTEM_LINE(subsystem, line) ScopedTiming TIME_SUBSYSTEM_NAME(line)(subsystem)
+#define TIME_SUBSYSTEM(subsystem) TIME_SUBSYSTEM_LINE(subsystem, __LINE__)
+
+static ShaderToggler::ShaderManager g_pixelShaderManager;
+static ShaderToggler::ShaderManager g_vertexShaderManager;
+static ShaderToggler::ShaderManager g_computeShaderManager;
+
+static ConstantHandlerBase* constantHandler = nullptr;
+static ConstantCopyBase* constantCopy = nullptr;
+
+static atomic_uint32_t g_activeCollectorFrameCounter = 0;
+static AddonUIData g_addonUIData(&g_pixelShaderManager, &g_vertexShaderManager, &g_computeShaderManager, constantHandler, &g_activeCollectorFrameCounter);
+
+static KeyMonitor keyMonitor;
+static Rendering::ResourceManager resourceManager;
+static Rendering::ToggleGroupResourceManager groupResourceManager;
+static Rendering::RenderingShaderManager renderingShaderManager(g_addonUIData, resourceManager);
+static Rendering::GroupCostTracker groupCostTracker(g_addonUIData);
+static Rendering::RenderingEffectManager renderingEffectManager(g_addonUIData, resourceManager, renderingShaderManager, groupResourceManager, groupCostTracker);
+static Rendering::RenderingBindingManager renderingBindingManager(g_addonUIData, resourceManager, groupResourceManager);
+static Rendering::RenderingPreviewManager renderingPreviewManager(g_addonUIData, resourceManager, renderingShaderManager);
+static Rendering::FrameBudgetGovernor frameBudgetGovernor(g_addonUIData);
+static Rendering::RenderingQueueManager renderingQueueManager(g_addonUIData, resourceManager, frameBudgetGovernor);
+static ShaderToggler::TechniqueManager techniqueManager(keyMonitor);
+
+// Same selection as ConstantManager::Init, minus the FFXIV hook which needs the D3D11 runtime
+static ConstantCopyBase* CreateConstantCopy(const string& type)
+{
+    if (type == "memcpy_singular")
+    {
+        static ConstantCopyMemcpySingular constantTypeMemcpySingular;
+        return &constantTypeMemcpySingular;
+    }
+    if (type == "memcpy_nested")
+    {
+        static ConstantCopyMemcpyNested constantTypeMemcpyNested;
+        return &constantTypeMemcpyNested;
+    }
+    if (type == "nier_replicant")
+    {
+        static ConstantCopyNierReplicant constantTypeNierReplicant;
+        return &constantTypeNierReplicant;
+    }
+    if (type == "gpu_readback")
+    {
+        static ConstantCopyGPUReadback constantTypeGPUReadback(groupResourceManager);
+        return &constantTypeGPUReadback;
+    }
+    if (type == "persistent_map")
+    {
+        static ConstantCopyPersistentMap constantTypePersistentMap;
+        return &constantTypePersistentMap;
+    }
+
+    return nullptr;
+}
+
+static void Init()
+{
+    resourceManager.SetResourceShim(g_addonUIData.GetResourceShim());
+    resourceManager.Init();
+
+    constantCopy = CreateConstantCopy(g_addonUIData.GetConstHookCopyType());
+    ConstantCopyBase::SetInterestSet(g_addonUIData.GetConstBufferInterestSet(), static_cast<uint32_t>(*g_addonUIData.ConstBufferInterestFrames()));
+
+    if (constantCopy != nullptr && constantCopy->Init())
+    {
+        static ConstantHandlerBase constantBase;
+        constantHandler = &constantBase;
+
+        ConstantHandlerBase::SetConstantCopy(constantCopy);
+        g_addonUIData.SetConstantHandler(constantHandler);
+    }
+    else
+    {
+        constantCopy = nullptr;
+    }
+
+    g_addonUIData.AddToggleGroupRemovalCallback(std::bind(&Rendering::ToggleGroupResourceManager::ToggleGroupRemoved, &groupResourceManager, std::placeholders::_1, std::placeholders::_2));
+    if (constantHandler != nullptr)
+    {
+        techniqueManager.AddEffectsReloadingCallback(std::bind(&Shim::Constants::ConstantHandlerBase::OnEffectsReloading, constantHandler, std::placeholders::_1));
+        techniqueManager.AddEffectsReloadedCallback(std::bind(&Shim::Constants::ConstantHandlerBase::OnEffectsReloaded, constantHandler, std::placeholders::_1));
+    }
+    techniqueManager.AddEffectsReloadingCallback(std::bind(&Rendering::ResourceManager::OnEffectsReloading, &resourceManager, std::placeholders::_1));
+    techniqueManager.AddEffectsReloadedCallback(std::bind(&Rendering::ResourceManager::OnEffectsReloaded, &resourceManager, std::placeholders::_1));
+}
+
+static void onInitDevice(device* device)
+{
+    device->create_private_data<DeviceDataContainer>();
+}
+
+static void onDestroyDevice(device* device)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_RESOURCES);
+
+    groupResourceManager.DisposeGroupBuffers(device, g_addonUIData.GetToggleGroups());
+    renderingBindingManager.DisposeTextureBindings(device);
+    resourceManager.OnDestroyDevice(device);
+    renderingShaderManager.DestroyShaders(device);
+    groupCostTracker.OnDestroyDevice(device);
+
+    device->destroy_private_data<DeviceDataContainer>();
+}
+
+static void onInitCommandList(command_list* commandList)
+{
+    commandList->create_private_data<CommandListDataContainer>();
+}
+
+static void onDestroyCommandList(command_list* commandList)
+{
+    commandList->destroy_private_data<CommandListDataContainer>();
+}
+
+static void onResetCommandList(command_list* commandList)
+{
+    CommandListDataContainer& commandListData = commandList->get_private_data<CommandListDataContainer>();
+    commandListData.Reset();
+}
+
+static void onInitResource(device* device, const resource_desc& desc, resource handle)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_RESOURCES);
+
+    resourceManager.OnInitResource(device, desc, nullptr, resource_usage::undefined, handle);
+
+    if (constantCopy != nullptr)
+        constantCopy->OnInitResource(device, desc, nullptr, resource_usage::undefined, handle);
+}
+
+static void onInitResourceView(device* device, resource resource, resource_usage usage_type, const resource_view_desc& desc, resource_view view)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_RESOURCES);
+
+    resourceManager.OnInitResourceView(device, resource, usage_type, desc, view);
+    renderingBindingManager.OnInitResourceView(device, resource, usage_type, view);
+}
+
+static void onReshadeReloadedEffects(effect_runtime* runtime)
+{
+    RuntimeDataContainer& runtimeData = runtime->get_private_data<RuntimeDataContainer>();
+    DeviceDataContainer& deviceData = runtime->get_device()->get_private_data<DeviceDataContainer>();
+
+    techniqueManager.OnReshadeReloadedEffects(runtime);
+    groupCostTracker.OnReshadeReloadedEffects();
+
+    if (deviceData.current_runtime == runtime)
+    {
+        shared_lock<shared_mutex> techLock(runtimeData.technique_mutex);
+        g_addonUIData.AssignPreferredGroupTechniques(runtimeData.allTechniques);
+    }
+}
+
+static void onInitEffectRuntime(effect_runtime* runtime)
+{
+    runtime->create_private_data<RuntimeDataContainer>();
+    DeviceDataContainer& data = runtime->get_device()->get_private_data<DeviceDataContainer>();
+
+    keyMonitor.Init(runtime);
+    renderingShaderManager.InitShaders(runtime->get_device());
+
+    data.current_runtime = runtime;
+
+    renderingBindingManager.InitTextureBingings(runtime);
+
+    if (constantHandler != nullptr)
+    {
+        constantHandler->ReloadConstantVariables(runtime);
+    }
+}
+
+static void onDestroyEffectRuntime(effect_runtime* runtime)
+{
+    DeviceDataContainer& data = runtime->get_device()->get_private_data<DeviceDataContainer>();
+    data.current_runtime = nullptr;
+
+    runtime->destroy_private_data<RuntimeDataContainer>();
+}
+
+static void onInitPipeline(pipeline pipelineHandle, uint32_t vsHash, uint32_t psHash, uint32_t csHash)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_SHADER_MATCHING);
+
+    if (vsHash != 0)
+        g_vertexShaderManager.addHashHandlePair(vsHash, pipelineHandle.handle);
+    if (psHash != 0)
+        g_pixelShaderManager.addHashHandlePair(psHash, pipelineHandle.handle);
+    if (csHash != 0)
+        g_computeShaderManager.addHashHandlePair(csHash, pipelineHandle.handle);
+}
+
+static void onBindPipeline(command_list* commandList, pipeline_stage stages, pipeline pipelineHandle)
+{
+    if (nullptr == commandList || pipelineHandle.handle == 0 || !((uint32_t)(stages & pipeline_stage::pixel_shader) || (uint32_t)(stages & pipeline_stage::vertex_shader) || (uint32_t)(stages & pipeline_stage::compute_shader)))
+    {
+        return;
+    }
+
+    uint32_t handleHasPixelShaderAttached = 0;
+    uint32_t handleHasVertexShaderAttached = 0;
+    uint32_t handleHasComputeShaderAttached = 0;
+
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_SHADER_MATCHING);
+
+        handleHasPixelShaderAttached = (uint32_t)(stages & pipeline_stage::pixel_shader) ? g_pixelShaderManager.safeGetShaderHash(pipelineHandle.handle) : 0;
+        handleHasVertexShaderAttached = (uint32_t)(stages & pipeline_stage::vertex_shader) ? g_vertexShaderManager.safeGetShaderHash(pipelineHandle.handle) : 0;
+        handleHasComputeShaderAttached = (uint32_t)(stages & pipeline_stage::compute_shader) ? g_computeShaderManager.safeGetShaderHash(pipelineHandle.handle) : 0;
+    }
+
+    if (!handleHasPixelShaderAttached && !handleHasVertexShaderAttached && !handleHasComputeShaderAttached)
+    {
+        return;
+    }
+    CommandListDataContainer& commandListData = commandList->get_private_data<CommandListDataContainer>();
+    DeviceDataContainer& deviceData = commandList->get_device()->get_private_data<DeviceDataContainer>();
+
+    if (deviceData.current_runtime == nullptr || !deviceData.current_runtime->get_effects_state())
+    {
+        return;
+    }
+
+    uint32_t pipelineChanged = 0;
+
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_SHADER_MATCHING);
+
+        if ((uint32_t)(stages & pipeline_stage::pixel_shader) && handleHasPixelShaderAttached)
+        {
+            if (commandListData.ps.activeShaderHash != handleHasPixelShaderAttached)
+            {
+                pipelineChanged |= Rendering::MATCH_EFFECT_PS | Rendering::MATCH_BINDING_PS | Rendering::MATCH_PREVIEW_PS | Rendering::MATCH_CONST_PS;
+                commandListData.ps.constantBuffersToUpdate.clear();
+            }
+
+            commandListData.ps.blockedShaderGroups = g_addonUIData.GetToggleGroupsForPixelShaderHash(handleHasPixelShaderAttached);
+            commandListData.ps.activeShaderHash = handleHasPixelShaderAttached;
+        }
+
+        if ((uint32_t)(stages & pipeline_stage::vertex_shader) && handleHasVertexShaderAttached)
+        {
+            if (commandListData.vs.activeShaderHash != handleHasVertexShaderAttached)
+            {
+                pipelineChanged |= Rendering::MATCH_EFFECT_VS | Rendering::MATCH_BINDING_VS | Rendering::MATCH_PREVIEW_VS | Rendering::MATCH_CONST_VS;
+                commandListData.vs.constantBuffersToUpdate.clear();
+            }
+
+            commandListData.vs.blockedShaderGroups = g_addonUIData.GetToggleGroupsForVertexShaderHash(handleHasVertexShaderAttached);
+            commandListData.vs.activeShaderHash = handleHasVertexShaderAttached;
+        }
+
+        if ((uint32_t)(stages & pipeline_stage::compute_shader) && handleHasComputeShaderAttached)
+        {
+            if (commandListData.cs.activeShaderHash != handleHasComputeShaderAttached)
+            {
+                pipelineChanged |= Rendering::MATCH_EFFECT_CS | Rendering::MATCH_BINDING_CS | Rendering::MATCH_PREVIEW_CS | Rendering::MATCH_CONST_CS;
+                commandListData.cs.constantBuffersToUpdate.clear();
+            }
+
+            commandListData.cs.blockedShaderGroups = g_addonUIData.GetToggleGroupsForComputeShaderHash(handleHasComputeShaderAttached);
+            commandListData.cs.activeShaderHash = handleHasComputeShaderAttached;
+        }
+    }
+
+    if (pipelineChanged > 0)
+    {
+        if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_PIPELINE_PREVIEW && !(commandListData.commandQueue & pipelineChanged & Rendering::MATCH_PREVIEW))
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_PREVIEW);
+            renderingPreviewManager.UpdatePreview(commandList, Rendering::CALL_BIND_PIPELINE, pipelineChanged & Rendering::MATCH_PREVIEW);
+        }
+
+        if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_PIPELINE_BINDING && !(commandListData.commandQueue & pipelineChanged & Rendering::MATCH_BINDING))
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+            renderingBindingManager.UpdateTextureBindings(commandList, Rendering::CALL_BIND_PIPELINE, pipelineChanged & Rendering::MATCH_BINDING);
+        }
+
+        if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_PIPELINE_EFFECT && !(commandListData.commandQueue & pipelineChanged & Rendering::MATCH_EFFECT))
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_EFFECTS);
+            renderingEffectManager.RenderEffects(commandList, Rendering::CALL_BIND_PIPELINE, pipelineChanged & Rendering::MATCH_EFFECT);
+        }
+
+        TIME_SUBSYSTEM(SUBSYSTEM_QUEUE);
+        renderingQueueManager.ClearQueue(commandListData, pipelineChanged);
+        renderingQueueManager.CheckCallForCommandList(commandList);
+    }
+}
+
+static void onBindRenderTargetsAndDepthStencil(command_list* cmd_list, uint32_t count, const resource_view* rtvs, resource_view dsv)
+{
+    device* device = cmd_list->get_device();
+    CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
+    DeviceDataContainer& deviceData = device->get_private_data<DeviceDataContainer>();
+
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+        renderingBindingManager.OnRenderTargetsBound(cmd_list, count, rtvs, dsv);
+    }
+
+    if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_RENDERTARGET_PREVIEW && !(commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_PREVIEW))
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_PREVIEW);
+        renderingPreviewManager.UpdatePreview(cmd_list, Rendering::CALL_BIND_RENDER_TARGET, Rendering::MATCH_PREVIEW);
+    }
+
+    if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_RENDERTARGET_BINDING && !(commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_BINDING))
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+        renderingBindingManager.UpdateTextureBindings(cmd_list, Rendering::CALL_BIND_RENDER_TARGET, Rendering::MATCH_BINDING);
+    }
+
+    if (commandListData.commandQueue & Rendering::CHECK_MATCH_BIND_RENDERTARGET_EFFECT && !(commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_EFFECT))
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_EFFECTS);
+        renderingEffectManager.RenderEffects(cmd_list, Rendering::CALL_BIND_RENDER_TARGET, Rendering::MATCH_EFFECT);
+    }
+
+    TIME_SUBSYSTEM(SUBSYSTEM_QUEUE);
+    renderingQueueManager.RescheduleGroups(commandListData, deviceData);
+}
+
+static void onBeginRenderPass(command_list* cmd_list, uint32_t count, const resource_view* rtvs, resource_view dsv)
+{
+    device* device = cmd_list->get_device();
+    CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
+
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            renderingBindingManager.OnResourceViewWritten(device, rtvs[i]);
+        }
+
+        if (dsv.handle != 0)
+        {
+            renderingBindingManager.OnResourceViewWritten(device, dsv);
+        }
+    }
+
+    if (commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_BINDING)
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+        renderingBindingManager.UpdateTextureBindings(cmd_list, Rendering::CALL_DRAW, Rendering::MATCH_BINDING_PS | Rendering::MATCH_BINDING_VS);
+    }
+
+    if (commandListData.commandQueue & Rendering::CHECK_MATCH_DRAW_EFFECT)
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_EFFECTS);
+        renderingEffectManager.RenderEffects(cmd_list, Rendering::CALL_DRAW, Rendering::MATCH_EFFECT_PS | Rendering::MATCH_EFFECT_VS);
+    }
+}
+
+static void CheckDrawCall(command_list* cmd_list, const uint64_t match_modifier = Rendering::MATCH_ALL)
+{
+    CommandListDataContainer& commandListData = cmd_list->get_private_data<CommandListDataContainer>();
+
+    if (commandListData.commandQueue & Rendering::MATCH_ALL & match_modifier)
+    {
+        if (constantHandler != nullptr && (commandListData.commandQueue & Rendering::MATCH_CONST & match_modifier))
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_CONSTANTS);
+            constantHandler->UpdateConstants(cmd_list);
+            commandListData.commandQueue &= ~(Rendering::MATCH_CONST & match_modifier);
+        }
+
+        if (commandListData.commandQueue & Rendering::MATCH_PREVIEW & match_modifier)
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_PREVIEW);
+            renderingPreviewManager.UpdatePreview(cmd_list, Rendering::CALL_DRAW, Rendering::MATCH_PREVIEW & match_modifier);
+        }
+
+        if (commandListData.commandQueue & Rendering::MATCH_BINDING & match_modifier)
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_BINDINGS);
+            renderingBindingManager.UpdateTextureBindings(cmd_list, Rendering::CALL_DRAW, Rendering::MATCH_BINDING & match_modifier);
+        }
+
+        if (commandListData.commandQueue & Rendering::MATCH_EFFECT & match_modifier)
+        {
+            TIME_SUBSYSTEM(SUBSYSTEM_EFFECTS);
+            renderingEffectManager.RenderEffects(cmd_list, Rendering::CALL_DRAW, Rendering::MATCH_EFFECT & match_modifier);
+        }
+    }
+}
+
+static void onMapBufferRegion(device* device, resource resource, uint64_t offset, uint64_t size, map_access access, void** data)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_CONSTANTS);
+
+    if (constantCopy != nullptr)
+        constantCopy->OnMapBufferRegion(device, resource, offset, size, access, data);
+}
+
+static void onPresent(command_queue* queue)
+{
+    device* dev = queue->get_device();
+    DeviceDataContainer& deviceData = dev->get_private_data<DeviceDataContainer>();
+
+    if (deviceData.current_runtime == nullptr)
+    {
+        return;
+    }
+
+    effect_runtime* runtime = deviceData.current_runtime;
+
+    if (queue == runtime->get_command_queue() && runtime->get_effects_state())
+    {
+        TIME_SUBSYSTEM(SUBSYSTEM_EFFECTS);
+        renderingEffectManager.RenderRemainingEffects(runtime);
+    }
+
+    if (dev->get_api() != device_api::d3d12 && dev->get_api() != device_api::vulkan)
+        onResetCommandList(runtime->get_command_queue()->get_immediate_command_list());
+}
+
+static void onReshadePresent(effect_runtime* runtime)
+{
+    TIME_SUBSYSTEM(SUBSYSTEM_PRESENT);
+
+    device* dev = runtime->get_device();
+    DeviceDataContainer& deviceData = dev->get_private_data<DeviceDataContainer>();
+    command_queue* queue = runtime->get_command_queue();
+
+    deviceData.rendered_effects = false;
+
+    g_addonUIData.OnReshadePresent();
+    g_pixelShaderManager.mergeCollectedShaders();
+    g_vertexShaderManager.mergeCollectedShaders();
+    g_computeShaderManager.mergeCollectedShaders();
+    frameBudgetGovernor.OnReshadePresent();
+    groupCostTracker.OnReshadePresent(runtime);
+    renderingBindingManager.OnReshadePresent(dev);
+
+    if (runtime->get_effects_state())
+    {
+        resourceManager.CheckPreview(queue->get_immediate_command_list(), dev);
+        groupResourceManager.CheckGroupBuffers(runtime, g_addonUIData.GetToggleGroups());
+        renderingBindingManager.ClearUnmatchedTextureBindings(runtime->get_command_queue()->get_immediate_command_list());
+        resourceManager.CheckResourceViews(runtime);
+    }
+
+    techniqueManager.OnReshadePresent(runtime);
+
+    if (constantCopy != nullptr)
+        constantCopy->OnPresent();
+
+    deviceData.bindingsUpdated.clear();
+    deviceData.constantsUpdated.clear();
+    deviceData.huntPreview.Reset();
+}
+
+namespace
+{
+    // One line of a trace: <frame> <thread> <event> [<handle>] [key=value...] [<handle>...]
+    struct TraceEvent
+    {
+        uint64_t frame = 0;
+        string name;
+        vector<uint64_t> handles;
+        unordered_map<string, string> values;
+
+        uint64_t GetUInt(const string& key, int base = 10) const
+        {
+            const auto it = values.find(key);
+            return it != values.end() ? stoull(it->second, nullptr, base) : 0;
+        }
+
+        uint64_t GetHandle(size_t index) const { return index < handles.size() ? handles[index] : 0; }
+    };
+
+    bool ParseEvent(const string& line, TraceEvent& event)
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            return false;
+        }
+
+        istringstream tokens(line);
+        uint32_t thread = 0;
+        if (!(tokens >> event.frame >> thread >> event.name))
+        {
+            return false;
+        }
+
+        event.handles.clear();
+        event.values.clear();
+
+        string token;
+        while (tokens >> token)
+        {
+            const size_t separator = token.find('=');
+            if (separator == string::npos)
+                event.handles.push_back(stoull(token, nullptr, 16));
+            else
+                event.values.emplace(token.substr(0, separator), token.substr(separator + 1));
+        }
+
+        return true;
+    }
+
+    // Shader hashes are written as <hash>:<code size> since trace v2, v1 only has the hash
+    uint32_t ParseShaderHash(const TraceEvent& event, const string& key)
+    {
+        const auto it = event.values.find(key);
+        return it != event.values.end() ? static_cast<uint32_t>(stoul(it->second.substr(0, it->second.find(':')), nullptr, 16)) : 0;
+    }
+
+    struct ReplayOptions
+    {
+        string tracePath;
+        string configPath;
+        device_api api = device_api::d3d12;
+        uint32_t width = 1920;
+        uint32_t height = 1080;
+        uint32_t repeat = 1;
+        bool quiet = false;
+        vector<pair<string, string>> techniques;
+    };
+
+    bool ParseOptions(int argc, char** argv, ReplayOptions& options)
+    {
+        static const unordered_map<string, device_api> apis = {
+            { "d3d9", device_api::d3d9 }, { "d3d10", device_api::d3d10 }, { "d3d11", device_api::d3d11 },
+            { "d3d12", device_api::d3d12 }, { "opengl", device_api::opengl }, { "vulkan", device_api::vulkan } };
+
+        for (int i = 1; i < argc; i++)
+        {
+            const string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--config" && hasValue)
+                options.configPath = argv[++i];
+            else if (arg == "--api" && hasValue && apis.contains(argv[i + 1]))
+                options.api = apis.at(argv[++i]);
+            else if (arg == "--size" && hasValue && sscanf(argv[i + 1], "%ux%u", &options.width, &options.height) == 2)
+                i++;
+            else if (arg == "--repeat" && hasValue)
+                options.repeat = max(1u, static_cast<uint32_t>(stoul(argv[++i])));
+            else if (arg == "--technique" && hasValue)
+            {
+                const string technique = argv[++i];
+                const size_t separator = technique.find('@');
+                options.techniques.emplace_back(technique.substr(0, separator), separator != string::npos ? technique.substr(separator + 1) : "Replay.fx");
+            }
+            else if (arg == "--quiet")
+                options.quiet = true;
+            else if (options.tracePath.empty() && arg[0] != '-')
+                options.tracePath = arg;
+            else
+                return false;
+        }
+
+        return !options.tracePath.empty();
+    }
+
+    class Replayer final
+    {
+    public:
+        Replayer(const ReplayOptions& options) :
+            _options(options),
+            _device(options.api, &_log),
+            _queue(&_device, &_log),
+            _runtime(&_device, &_queue, &_log, options.width, options.height)
+        {
+        }
+
+        void Start()
+        {
+            // Every technique a group asks for exists in the mock runtime, plus the ones given on the command line
+            for (const auto& [_, group] : g_addonUIData.GetToggleGroups())
+            {
+                // Stored as "<technique> [<effect>]", see TechniqueManager::OnReshadeReloadedEffects
+                for (const auto& technique : group.preferredTechniques())
+                {
+                    const size_t separator = technique.rfind(" [");
+                    if (separator != string::npos && technique.back() == ']')
+                        _runtime.AddTechnique(technique.substr(0, separator), technique.substr(separator + 2, technique.size() - separator - 3));
+                    else
+                        _runtime.AddTechnique(technique, "Replay.fx");
+                }
+            }
+            for (const auto& [technique, effect] : _options.techniques)
+            {
+                _runtime.AddTechnique(technique, effect);
+            }
+
+            {
+                TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                reshade::stub::invoke<reshade::addon_event::init_device>(static_cast<device*>(&_device));
+                reshade::stub::invoke<reshade::addon_event::init_command_list>(_queue.get_immediate_command_list());
+            }
+            onInitDevice(&_device);
+            onInitCommandList(_queue.get_immediate_command_list());
+
+            resourceManager.OnInitSwapchain(&_runtime);
+            onInitEffectRuntime(&_runtime);
+            onReshadeReloadedEffects(&_runtime);
+        }
+
+        void Replay(const TraceEvent& event)
+        {
+            if (event.frame != _frame)
+            {
+                _frame = event.frame;
+            }
+
+            const string& name = event.name;
+
+            if (name == "init_resource")
+            {
+                resource_desc desc;
+                desc.type = static_cast<resource_type>(event.GetUInt("type"));
+                desc.heap = static_cast<memory_heap>(event.GetUInt("heap"));
+                desc.usage = static_cast<resource_usage>(event.GetUInt("usage", 16));
+                if (desc.type == resource_type::buffer)
+                {
+                    desc.buffer.size = event.GetUInt("size");
+                }
+                else
+                {
+                    desc.texture.width = static_cast<uint32_t>(event.GetUInt("width"));
+                    desc.texture.height = static_cast<uint32_t>(event.GetUInt("height"));
+                    desc.texture.format = static_cast<reshade::api::format>(event.GetUInt("format"));
+                }
+
+                const resource handle = { event.GetHandle(0) };
+                _device.AddResource(handle, desc);
+                onInitResource(&_device, desc, handle);
+            }
+            else if (name == "init_resource_view")
+            {
+                const resource resource = { event.GetUInt("resource", 16) };
+                const resource_usage usage = static_cast<resource_usage>(event.GetUInt("usage", 16));
+                const resource_view_desc desc(static_cast<reshade::api::format>(event.GetUInt("format")));
+                const resource_view view = { event.GetHandle(0) };
+
+                _device.AddResourceView(view, resource, desc);
+                onInitResourceView(&_device, resource, usage, desc, view);
+            }
+            else if (name == "init_pipeline")
+            {
+                onInitPipeline({ event.GetHandle(0) }, ParseShaderHash(event, "vs"), ParseShaderHash(event, "ps"), ParseShaderHash(event, "cs"));
+            }
+            else if (name == "bind_pipeline")
+            {
+                command_list* cmd_list = GetCommandList(event.GetHandle(0));
+                const pipeline_stage stages = static_cast<pipeline_stage>(event.GetUInt("stages", 16));
+                const pipeline pipelineHandle = { event.GetUInt("pipeline", 16) };
+
+                {
+                    TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                    reshade::stub::invoke<reshade::addon_event::bind_pipeline>(cmd_list, stages, pipelineHandle);
+                }
+                onBindPipeline(cmd_list, stages, pipelineHandle);
+            }
+            else if (name == "bind_render_targets" || name == "begin_render_pass")
+            {
+                command_list* cmd_list = GetCommandList(event.GetHandle(0));
+                const vector<resource_view> rtvs = GetViews(event);
+                const resource_view dsv = { event.GetUInt("dsv", 16) };
+
+                if (name == "bind_render_targets")
+                {
+                    {
+                        TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                        reshade::stub::invoke<reshade::addon_event::bind_render_targets_and_depth_stencil>(cmd_list, static_cast<uint32_t>(rtvs.size()), rtvs.data(), dsv);
+                    }
+                    onBindRenderTargetsAndDepthStencil(cmd_list, static_cast<uint32_t>(rtvs.size()), rtvs.data(), dsv);
+                }
+                else
+                {
+                    onBeginRenderPass(cmd_list, static_cast<uint32_t>(rtvs.size()), rtvs.data(), dsv);
+                }
+            }
+            else if (name == "draw" || name == "draw_indexed")
+            {
+                CheckDrawCall(GetCommandList(event.GetHandle(0)), Rendering::MATCH_PS | Rendering::MATCH_VS);
+            }
+            else if (name == "dispatch")
+            {
+                CheckDrawCall(GetCommandList(event.GetHandle(0)), Rendering::MATCH_CS);
+            }
+            else if (name == "draw_or_dispatch_indirect")
+            {
+                const indirect_command type = static_cast<indirect_command>(event.GetUInt("type"));
+                CheckDrawCall(GetCommandList(event.GetHandle(0)), type == indirect_command::dispatch ? Rendering::MATCH_CS :
+                    (type == indirect_command::unknown ? Rendering::MATCH_ALL : Rendering::MATCH_PS | Rendering::MATCH_VS));
+            }
+            else if (name == "map_buffer_region")
+            {
+                const resource resource = { event.GetHandle(0) };
+                void* data = nullptr;
+                if (_device.map_buffer_region(resource, event.GetUInt("offset"), event.GetUInt("size"), static_cast<map_access>(event.GetUInt("access")), &data))
+                {
+                    onMapBufferRegion(&_device, resource, event.GetUInt("offset"), event.GetUInt("size"), static_cast<map_access>(event.GetUInt("access")), &data);
+                }
+            }
+            else if (name == "update_descriptor_tables")
+            {
+                // Only the layout of an update is traced, so the descriptors themselves are null handles
+                descriptor_table_update update;
+                update.table = { event.GetUInt("table", 16) };
+                update.binding = static_cast<uint32_t>(event.GetUInt("binding"));
+                update.array_offset = static_cast<uint32_t>(event.GetUInt("offset"));
+                update.count = static_cast<uint32_t>(event.GetUInt("count"));
+                update.type = static_cast<descriptor_type>(event.GetUInt("type"));
+
+                _descriptorScratch.assign(static_cast<size_t>(update.count) * sizeof(sampler_with_resource_view), 0);
+                update.descriptors = _descriptorScratch.data();
+
+                TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                reshade::stub::invoke<reshade::addon_event::update_descriptor_tables>(static_cast<device*>(&_device), 1u, static_cast<const descriptor_table_update*>(&update));
+            }
+            else if (name == "copy_descriptor_tables")
+            {
+                descriptor_table_copy copy;
+                copy.source_table = { event.GetUInt("src", 16) };
+                copy.source_binding = static_cast<uint32_t>(event.GetUInt("src_binding"));
+                copy.dest_table = { event.GetUInt("dst", 16) };
+                copy.dest_binding = static_cast<uint32_t>(event.GetUInt("dst_binding"));
+                copy.count = static_cast<uint32_t>(event.GetUInt("count"));
+
+                TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                reshade::stub::invoke<reshade::addon_event::copy_descriptor_tables>(static_cast<device*>(&_device), 1u, static_cast<const descriptor_table_copy*>(&copy));
+            }
+            else if (name == "present")
+            {
+                onPresent(&_queue);
+                {
+                    TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                    reshade::stub::invoke<reshade::addon_event::reshade_present>(static_cast<effect_runtime*>(&_runtime));
+                }
+                onReshadePresent(&_runtime);
+                FlushCalls();
+                _presentedFrames++;
+            }
+        }
+
+        void Finish()
+        {
+            FlushCalls();
+
+            for (auto& [_, cmd_list] : _commandLists)
+            {
+                onDestroyCommandList(cmd_list.get());
+                reshade::stub::invoke<reshade::addon_event::destroy_command_list>(static_cast<command_list*>(cmd_list.get()));
+            }
+            _commandLists.clear();
+
+            onDestroyEffectRuntime(&_runtime);
+            onDestroyCommandList(_queue.get_immediate_command_list());
+            reshade::stub::invoke<reshade::addon_event::destroy_command_list>(_queue.get_immediate_command_list());
+            onDestroyDevice(&_device);
+            reshade::stub::invoke<reshade::addon_event::destroy_device>(static_cast<device*>(&_device));
+        }
+
+        uint64_t GetPresentedFrames() const { return _presentedFrames; }
+        uint64_t GetTechniqueCalls() const { return _techniqueCalls; }
+        uint64_t GetCopyCalls() const { return _copyCalls; }
+        size_t GetLiveObjectCount() const { return _device.GetLiveObjectCount(); }
+
+    private:
+        command_list* GetCommandList(uint64_t handle)
+        {
+            auto it = _commandLists.find(handle);
+            if (it == _commandLists.end())
+            {
+                it = _commandLists.emplace(handle, make_unique<Mock::MockCommandList>(&_device, &_log)).first;
+
+                {
+                    TIME_SUBSYSTEM(SUBSYSTEM_STATE_TRACKING);
+                    reshade::stub::invoke<reshade::addon_event::init_command_list>(static_cast<command_list*>(it->second.get()));
+                }
+                onInitCommandList(it->second.get());
+            }
+
+            return it->second.get();
+        }
+
+        static vector<resource_view> GetViews(const TraceEvent& event)
+        {
+            vector<resource_view> views;
+            for (size_t i = 1; i < event.handles.size(); i++)
+            {
+                views.push_back({ event.handles[i] });
+            }
+
+            return views;
+        }
+
+        void FlushCalls()
+        {
+            _techniqueCalls += _log.Count("render_technique");
+            _copyCalls += _log.Count("copy_");
+
+            if (!_options.quiet)
+            {
+                for (const auto& call : _log.GetCalls())
+                {
+                    cout << "frame " << _frame << ": " << call << '\n';
+                }
+            }
+
+            _log.Clear();
+        }
+
+        const ReplayOptions& _options;
+        Mock::CallLog _log;
+        Mock::MockDevice _device;
+        Mock::MockCommandQueue _queue;
+        Mock::MockEffectRuntime _runtime;
+        unordered_map<uint64_t, unique_ptr<Mock::MockCommandList>> _commandLists;
+        vector<uint8_t> _descriptorScratch;
+        uint64_t _frame = 0;
+        uint64_t _presentedFrames = 0;
+        uint64_t _techniqueCalls = 0;
+        uint64_t _copyCalls = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        cerr << "usage: trace_replay <trace> [--config <ini>] [--api d3d9|d3d10|d3d11|d3d12|opengl|vulkan] [--size <w>x<h>] [--technique <name>[@<effect>]]... [--repeat <n>] [--quiet]\n";
+        return 2;
+    }
+
+    vector<TraceEvent> events;
+    {
+        ifstream trace(options.tracePath);
+        if (!trace.is_open())
+        {
+            cerr << "could not open trace \"" << options.tracePath << "\"\n";
+            return 1;
+        }
+
+        string line;
+        TraceEvent event;
+        while (getline(trace, line))
+        {
+            if (ParseEvent(line, event))
+                events.push_back(event);
+        }
+    }
+
+    if (!options.configPath.empty())
+    {
+        const filesystem::path config(options.configPath);
+        g_addonUIData.SetBasePath(config.parent_path());
+        g_addonUIData.LoadShaderTogglerIniFile(config.filename().string());
+    }
+
+    state_tracking::register_events(g_addonUIData.GetTrackDescriptors());
+    Init();
+
+    Replayer replayer(options);
+    replayer.Start();
+
+    const auto start = chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < options.repeat; pass++)
+    {
+        for (const auto& event : events)
+        {
+            replayer.Replay(event);
+        }
+    }
+    const auto total = chrono::steady_clock::now() - start;
+
+    replayer.Finish();
+    state_tracking::unregister_events();
+
+    cout << std::format("replayed {} events, {} frames in {:.3f} ms\n", events.size() * options.repeat, replayer.GetPresentedFrames(), chrono::duration<double, milli>(total).count());
+    cout << std::format("emitted {} render_technique and {} copy calls\n", replayer.GetTechniqueCalls(), replayer.GetCopyCalls());
+    for (uint32_t i = 0; i < SUBSYSTEM_COUNT; i++)
+    {
+        const double ms = chrono::duration<double, milli>(g_timings[i].time).count();
+        cout << std::format("  {:<16} {:>10.3f} ms {:>10} calls {:>10.3f} us/call\n", SubsystemNames[i], ms, g_timings[i].calls, g_timings[i].calls > 0 ? ms * 1000.0 / g_timings[i].calls : 0.0);
+    }
+    cout << std::format("live addon objects after teardown: {}\n", replayer.GetLiveObjectCount());
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * Minimal stand-in for MinHook, see windows.h. Hooks are never installed outside of the game process.
+ */
+
+#pragma once
+
+#include "windows.h"
+
+typedef enum MH_STATUS
+{
+    MH_UNKNOWN = -1,
+    MH_OK = 0,
+    MH_ERROR_ALREADY_INITIALIZED,
+    MH_ERROR_NOT_INITIALIZED,
+    MH_ERROR_UNSUPPORTED_FUNCTION = 8
+} MH_STATUS;
+
+#define MH_ALL_HOOKS nullptr
+
+inline MH_STATUS MH_Initialize() { return MH_ERROR_UNSUPPORTED_FUNCTION; }
+inline MH_STATUS MH_Uninitialize() { return MH_ERROR_NOT_INITIALIZED; }
+inline MH_STATUS MH_CreateHook(LPVOID, LPVOID, LPVOID*) { return MH_ERROR_UNSUPPORTED_FUNCTION; }
+inline MH_STATUS MH_CreateHookApi(LPCWSTR, LPCSTR, LPVOID, LPVOID*) { return MH_ERROR_UNSUPPORTED_FUNCTION; }
+inline MH_STATUS MH_EnableHook(LPVOID) { return MH_ERROR_NOT_INITIALIZED; }
+inline MH_STATUS MH_DisableHook(LPVOID) { return MH_ERROR_NOT_INITIALIZED; }
@@ -0,0 +1,19 @@
+/*
+ * Minimal stand-in for the PPL concurrent_unordered_map, see concurrent_vector.h.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+namespace concurrency
+{
+    template <typename K, typename V, typename Hash = std::hash<K>>
+    class concurrent_unordered_map : public std::unordered_map<K, V, Hash>
+    {
+    public:
+        using std::unordered_map<K, V, Hash>::unordered_map;
+
+        size_t unsafe_erase(const K& key) { return std::unordered_map<K, V, Hash>::erase(key); }
+    };
+}
@@ -0,0 +1,28 @@
+/*
+ * Minimal stand-in for the PPL concurrent_vector, see windows.h. Like the original, growing keeps references to
+ * existing elements valid. The harness drives one command stream at a time, so no locking is done.
+ */
+
+#pragma once
+
+#include <deque>
+
+namespace concurrency
+{
+    template <typename T>
+    class concurrent_vector : private std::deque<T>
+    {
+    public:
+        using std::deque<T>::size;
+        using std::deque<T>::operator[];
+        using std::deque<T>::begin;
+        using std::deque<T>::end;
+        using std::deque<T>::push_back;
+
+        void grow_to_at_least(size_t size)
+        {
+            if (size > std::deque<T>::size())
+                std::deque<T>::resize(size);
+        }
+    };
+}
@@ -0,0 +1,9 @@
+/*
+ * Forced into every translation unit of the harness when not building with MSVC, drops the MSVC specific
+ * declaration specifiers the addon sources use.
+ */
+
+#pragma once
+
+#define __declspec(x)
+#define __fastcall __attribute__((fastcall))
@@ -0,0 +1,41 @@
+/*
+ * Minimal stand-in for sigmatch, see windows.h. Searches never match outside of the game process.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sigmatch
+{
+    class signature
+    {
+    public:
+        signature() = default;
+        signature(const char*) {}
+    };
+
+    class search_result
+    {
+    public:
+        const std::vector<const std::byte*>& matches() const { return _matches; }
+
+    private:
+        std::vector<const std::byte*> _matches;
+    };
+
+    class this_process_target
+    {
+    public:
+        this_process_target& in_module(const std::string&) { return *this; }
+        search_result search(const signature&) const { return {}; }
+    };
+
+}
+
+namespace sigmatch_literals
+{
+    inline sigmatch::signature operator""_sig(const char* str, size_t) { return sigmatch::signature(str); }
+}
@@ -0,0 +1,110 @@
+/*
+ * Minimal stand-in for the Win32 declarations the addon sources use, so they build outside of Windows. Module lookups
+ * always fail and resource lookups only find what a harness registered with stub::register_resource, the sources already
+ * handle both failing.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <unordered_map>
+
+typedef int BOOL;
+typedef uint32_t DWORD;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* HRSRC;
+typedef void* HGLOBAL;
+typedef const char* LPCSTR;
+typedef const char* LPCTSTR;
+typedef const wchar_t* LPCWSTR;
+typedef void* LPVOID;
+typedef long HRESULT;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define MAX_PATH 260
+#define WINAPI
+#define APIENTRY
+#define DLL_PROCESS_ATTACH 1
+#define DLL_PROCESS_DETACH 0
+#define GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS 0x4
+#define MAKEINTRESOURCE(i) (reinterpret_cast<LPCSTR>(static_cast<uintptr_t>(static_cast<uint16_t>(i))))
+#define RT_RCDATA MAKEINTRESOURCE(10)
+#define ARRAYSIZE(a) (sizeof(a) / sizeof(*(a)))
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+
+#define VK_SHIFT 0x10
+#define VK_CONTROL 0x11
+#define VK_MENU 0x12
+#define VK_CAPITAL 0x14
+#define VK_XBUTTON2 0x06
+#define VK_NUMPAD1 0x61
+#define VK_NUMPAD2 0x62
+#define VK_NUMPAD3 0x63
+#define VK_NUMPAD4 0x64
+#define VK_NUMPAD5 0x65
+#define VK_NUMPAD6 0x66
+#define VK_NUMPAD7 0x67
+#define VK_NUMPAD8 0x68
+#define VK_ADD 0x6B
+#define VK_SUBTRACT 0x6D
+
+// The secure CRT overloads taking a fixed size array
+#define _snprintf_s(buffer, count, ...) snprintf(buffer, sizeof(buffer), __VA_ARGS__)
+#define _vsnprintf_s(buffer, count, format, args) vsnprintf(buffer, sizeof(buffer), format, args)
+#define strtok_s strtok_r
+
+inline DWORD GetModuleFileNameA(HMODULE, char* name, DWORD size)
+{
+    if (size > 0)
+        name[0] = '\0';
+    return 0;
+}
+inline BOOL GetModuleHandleEx(DWORD, LPCTSTR, HMODULE* module)
+{
+    *module = nullptr;
+    return FALSE;
+}
+
+namespace stub
+{
+    struct embedded_resource
+    {
+        const void* data;
+        DWORD size;
+    };
+
+    inline std::unordered_map<uintptr_t, embedded_resource>& resource_table()
+    {
+        static std::unordered_map<uintptr_t, embedded_resource> table;
+        return table;
+    }
+
+    // Makes FindResource find data under the id, as if it was compiled into the module. The data has to outlive its use.
+    inline void register_resource(uint16_t id, const void* data, DWORD size)
+    {
+        resource_table()[id] = { data, size };
+    }
+}
+
+inline HRSRC FindResource(HMODULE, LPCSTR name, LPCSTR)
+{
+    const auto it = stub::resource_table().find(reinterpret_cast<uintptr_t>(name));
+    return it != stub::resource_table().end() ? &it->second : nullptr;
+}
+inline DWORD SizeofResource(HMODULE, HRSRC res) { return static_cast<stub::embedded_resource*>(res)->size; }
+inline HGLOBAL LoadResource(HMODULE, HRSRC res) { return res; }
+inline void* LockResource(HGLOBAL res) { return const_cast<void*>(static_cast<stub::embedded_resource*>(res)->data); }
+
+inline int _stricmp(const char* a, const char* b) { return strcasecmp(a, b); }
+inline int _strnicmp(const char* a, const char* b, size_t n) { return strncasecmp(a, b, n); }
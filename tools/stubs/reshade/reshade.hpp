@@ -0,0 +1,204 @@
+/*
+ * Minimal stand-in for the ReShade add-on API, see reshade_api_format.hpp.
+ *
+ * Events registered through register_event are kept in a process wide table so the harness can raise them with
+ * reshade::stub::invoke, the same way ReShade would call every registered add-on in turn.
+ */
+
+#pragma once
+
+#include "reshade_api.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace reshade
+{
+    enum class log_level
+    {
+        error = 1,
+        warning = 2,
+        info = 3,
+        debug = 4
+    };
+
+    inline void log_message(log_level level, const char* message)
+    {
+        if (level <= log_level::warning)
+            std::fprintf(stderr, "%s | %s\n", level == log_level::error ? "ERROR" : "WARN ", message);
+    }
+
+    inline bool get_config_value(api::effect_runtime*, const char*, const char*, char*, size_t* size)
+    {
+        if (size != nullptr)
+            *size = 0;
+        return false;
+    }
+
+    inline bool register_addon(void*) { return true; }
+    inline void unregister_addon(void*) {}
+    inline void register_overlay(const char*, void(*)(api::effect_runtime*)) {}
+    inline void unregister_overlay(const char*, void(*)(api::effect_runtime*)) {}
+
+    enum class addon_event : uint32_t
+    {
+        init_device,
+        destroy_device,
+        init_command_list,
+        destroy_command_list,
+        init_swapchain,
+        create_swapchain,
+        destroy_swapchain,
+        init_effect_runtime,
+        destroy_effect_runtime,
+        init_resource,
+        create_resource,
+        destroy_resource,
+        init_resource_view,
+        create_resource_view,
+        destroy_resource_view,
+        map_buffer_region,
+        unmap_buffer_region,
+        map_texture_region,
+        unmap_texture_region,
+        update_buffer_region,
+        update_texture_region,
+        init_pipeline,
+        destroy_pipeline,
+        init_pipeline_layout,
+        destroy_pipeline_layout,
+        copy_descriptor_tables,
+        update_descriptor_tables,
+        barrier,
+        begin_render_pass,
+        bind_render_targets_and_depth_stencil,
+        bind_pipeline,
+        bind_pipeline_states,
+        bind_viewports,
+        bind_scissor_rects,
+        push_constants,
+        push_descriptors,
+        bind_descriptor_tables,
+        draw,
+        draw_indexed,
+        dispatch,
+        draw_or_dispatch_indirect,
+        copy_resource,
+        copy_buffer_to_texture,
+        copy_texture_region,
+        resolve_texture_region,
+        clear_render_target_view,
+        clear_depth_stencil_view,
+        reset_command_list,
+        present,
+        reshade_present,
+        reshade_overlay,
+        reshade_reloaded_effects,
+        reshade_set_technique_state,
+        reshade_reorder_techniques,
+        max
+    };
+
+    template <addon_event ev>
+    struct addon_event_traits;
+
+#define RESHADE_DEFINE_ADDON_EVENT_TRAITS(ev, ret, ...) \
+    template <> \
+    struct addon_event_traits<ev> { using decl = ret(*)(__VA_ARGS__); using type = ret; }
+
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_device, void, api::device* device);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_device, void, api::device* device);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_command_list, void, api::command_list* cmd_list);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_command_list, void, api::command_list* cmd_list);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_swapchain, void, api::swapchain* swapchain);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_swapchain, void, api::swapchain* swapchain);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_effect_runtime, void, api::effect_runtime* runtime);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_effect_runtime, void, api::effect_runtime* runtime);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_resource, void, api::device* device, const api::resource_desc& desc, const api::subresource_data* initial_data, api::resource_usage initial_state, api::resource resource);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::create_resource, bool, api::device* device, api::resource_desc& desc, api::subresource_data* initial_data, api::resource_usage initial_state);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_resource, void, api::device* device, api::resource resource);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_resource_view, void, api::device* device, api::resource resource, api::resource_usage usage_type, const api::resource_view_desc& desc, api::resource_view view);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::create_resource_view, bool, api::device* device, api::resource resource, api::resource_usage usage_type, api::resource_view_desc& desc);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_resource_view, void, api::device* device, api::resource_view view);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::map_buffer_region, void, api::device* device, api::resource resource, uint64_t offset, uint64_t size, api::map_access access, void** data);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::unmap_buffer_region, void, api::device* device, api::resource resource);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::map_texture_region, void, api::device* device, api::resource resource, uint32_t subresource, const api::subresource_box* box, api::map_access access, api::subresource_data* data);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::unmap_texture_region, void, api::device* device, api::resource resource, uint32_t subresource);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::update_buffer_region, bool, api::device* device, const void* data, api::resource resource, uint64_t offset, uint64_t size);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::update_texture_region, bool, api::device* device, const api::subresource_data& data, api::resource resource, uint32_t subresource, const api::subresource_box* box);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_pipeline, void, api::device* device, api::pipeline_layout layout, uint32_t subobject_count, const api::pipeline_subobject* subobjects, api::pipeline pipeline);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_pipeline, void, api::device* device, api::pipeline pipeline);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::init_pipeline_layout, void, api::device* device, uint32_t param_count, const api::pipeline_layout_param* params, api::pipeline_layout layout);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::destroy_pipeline_layout, void, api::device* device, api::pipeline_layout layout);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::copy_descriptor_tables, bool, api::device* device, uint32_t count, const api::descriptor_table_copy* copies);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::update_descriptor_tables, bool, api::device* device, uint32_t count, const api::descriptor_table_update* updates);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::barrier, void, api::command_list* cmd_list, uint32_t count, const api::resource* resources, const api::resource_usage* old_states, const api::resource_usage* new_states);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::begin_render_pass, void, api::command_list* cmd_list, uint32_t count, const api::render_pass_render_target_desc* rts, const api::render_pass_depth_stencil_desc* ds);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_render_targets_and_depth_stencil, void, api::command_list* cmd_list, uint32_t count, const api::resource_view* rtvs, api::resource_view dsv);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_pipeline, void, api::command_list* cmd_list, api::pipeline_stage stages, api::pipeline pipeline);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_pipeline_states, void, api::command_list* cmd_list, uint32_t count, const api::dynamic_state* states, const uint32_t* values);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_viewports, void, api::command_list* cmd_list, uint32_t first, uint32_t count, const api::viewport* viewports);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_scissor_rects, void, api::command_list* cmd_list, uint32_t first, uint32_t count, const api::rect* rects);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::push_constants, void, api::command_list* cmd_list, api::shader_stage stages, api::pipeline_layout layout, uint32_t layout_param, uint32_t first, uint32_t count, const void* values);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::push_descriptors, void, api::command_list* cmd_list, api::shader_stage stages, api::pipeline_layout layout, uint32_t layout_param, const api::descriptor_table_update& update);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::bind_descriptor_tables, void, api::command_list* cmd_list, api::shader_stage stages, api::pipeline_layout layout, uint32_t first, uint32_t count, const api::descriptor_table* tables);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::draw, bool, api::command_list* cmd_list, uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::draw_indexed, bool, api::command_list* cmd_list, uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::dispatch, bool, api::command_list* cmd_list, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::draw_or_dispatch_indirect, bool, api::command_list* cmd_list, api::indirect_command type, api::resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::copy_resource, bool, api::command_list* cmd_list, api::resource source, api::resource dest);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::copy_buffer_to_texture, bool, api::command_list* cmd_list, api::resource source, uint64_t source_offset, uint32_t row_length, uint32_t slice_height, api::resource dest, uint32_t dest_subresource, const api::subresource_box* dest_box);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::copy_texture_region, bool, api::command_list* cmd_list, api::resource source, uint32_t source_subresource, const api::subresource_box* source_box, api::resource dest, uint32_t dest_subresource, const api::subresource_box* dest_box, api::filter_mode filter);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::resolve_texture_region, bool, api::command_list* cmd_list, api::resource source, uint32_t source_subresource, const api::subresource_box* source_box, api::resource dest, uint32_t dest_subresource, int32_t dest_x, int32_t dest_y, int32_t dest_z, api::format format);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::clear_render_target_view, bool, api::command_list* cmd_list, api::resource_view rtv, const float color[4], uint32_t rect_count, const api::rect* rects);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::clear_depth_stencil_view, bool, api::command_list* cmd_list, api::resource_view dsv, const float* depth, const uint8_t* stencil, uint32_t rect_count, const api::rect* rects);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reset_command_list, void, api::command_list* cmd_list);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::present, void, api::command_queue* queue, api::swapchain* swapchain, const api::rect* source_rect, const api::rect* dest_rect, uint32_t dirty_rect_count, const api::rect* dirty_rects);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_present, void, api::effect_runtime* runtime);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_overlay, void, api::effect_runtime* runtime);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_reloaded_effects, void, api::effect_runtime* runtime);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_set_technique_state, bool, api::effect_runtime* runtime, api::effect_technique technique, bool enabled);
+    RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_reorder_techniques, bool, api::effect_runtime* runtime, size_t count, api::effect_technique* techniques);
+
+#undef RESHADE_DEFINE_ADDON_EVENT_TRAITS
+
+    namespace stub
+    {
+        inline std::vector<void*>& event_table(addon_event ev)
+        {
+            static std::vector<void*> table[static_cast<size_t>(addon_event::max)];
+            return table[static_cast<size_t>(ev)];
+        }
+
+        // Calls every callback registered for the event, stopping at the first one that returns true like ReShade does
+        template <addon_event ev, typename... Args>
+        inline bool invoke(Args&&... args)
+        {
+            for (void* callback : event_table(ev))
+            {
+                if constexpr (std::is_same_v<typename addon_event_traits<ev>::type, bool>)
+                {
+                    if (reinterpret_cast<typename addon_event_traits<ev>::decl>(callback)(args...))
+                        return true;
+                }
+                else
+                {
+                    reinterpret_cast<typename addon_event_traits<ev>::decl>(callback)(args...);
+                }
+            }
+            return false;
+        }
+    }
+
+    template <addon_event ev>
+    inline void register_event(typename addon_event_traits<ev>::decl callback)
+    {
+        stub::event_table(ev).push_back(reinterpret_cast<void*>(callback));
+    }
+
+    template <addon_event ev>
+    inline void unregister_event(typename addon_event_traits<ev>::decl callback)
+    {
+        std::vector<void*>& table = stub::event_table(ev);
+        std::erase(table, reinterpret_cast<void*>(callback));
+    }
+}
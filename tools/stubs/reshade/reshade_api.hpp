@@ -0,0 +1,61 @@
+/*
+ * Minimal stand-in for the ReShade add-on API, see reshade_api_format.hpp.
+ */
+
+#pragma once
+
+#include "reshade_api_device.hpp"
+#include <cstring>
+
+namespace reshade::api
+{
+    RESHADE_DEFINE_HANDLE(effect_technique);
+    RESHADE_DEFINE_HANDLE(effect_uniform_variable);
+    RESHADE_DEFINE_HANDLE(effect_texture_variable);
+
+    struct __declspec(novtable) effect_runtime : public swapchain
+    {
+        virtual command_queue* get_command_queue() = 0;
+
+        virtual void render_effects(command_list* cmd_list, resource_view rtv, resource_view rtv_srgb = { 0 }) = 0;
+        virtual void render_technique(effect_technique technique, command_list* cmd_list, resource_view rtv, resource_view rtv_srgb = { 0 }) = 0;
+        virtual void update_texture_bindings(const char* semantic, resource_view srv, resource_view srv_srgb = { 0 }) = 0;
+
+        virtual void get_screenshot_width_and_height(uint32_t* out_width, uint32_t* out_height) const = 0;
+        virtual bool get_effects_state() const = 0;
+
+        virtual bool is_key_down(uint32_t keycode) const = 0;
+        virtual bool is_key_pressed(uint32_t keycode) const = 0;
+
+        virtual void enumerate_uniform_variables(const char* effect_name, void(*callback)(effect_runtime* runtime, effect_uniform_variable variable, void* user_data), void* user_data) = 0;
+        template <typename F>
+        inline void enumerate_uniform_variables(const char* effect_name, F lambda)
+        {
+            enumerate_uniform_variables(effect_name, [](effect_runtime* runtime, effect_uniform_variable variable, void* user_data) { static_cast<F*>(user_data)->operator()(runtime, variable); }, &lambda);
+        }
+        virtual void get_uniform_variable_type(effect_uniform_variable variable, format* out_base_type, uint32_t* out_rows = nullptr, uint32_t* out_columns = nullptr, uint32_t* out_array_length = nullptr) const = 0;
+        virtual bool get_annotation_string_from_uniform_variable(effect_uniform_variable variable, const char* name, char* value, size_t* length) const = 0;
+        template <size_t SIZE>
+        inline bool get_annotation_string_from_uniform_variable(effect_uniform_variable variable, const char* name, char(&value)[SIZE]) const
+        {
+            size_t length = SIZE;
+            return get_annotation_string_from_uniform_variable(variable, name, value, &length);
+        }
+        virtual void set_uniform_value_float(effect_uniform_variable variable, const float* values, size_t count, size_t array_index = 0) = 0;
+        virtual void set_uniform_value_int(effect_uniform_variable variable, const int32_t* values, size_t count, size_t array_index = 0) = 0;
+        virtual void set_uniform_value_uint(effect_uniform_variable variable, const uint32_t* values, size_t count, size_t array_index = 0) = 0;
+
+        virtual void enumerate_techniques(const char* effect_name, void(*callback)(effect_runtime* runtime, effect_technique technique, void* user_data), void* user_data) = 0;
+        template <typename F>
+        inline void enumerate_techniques(const char* effect_name, F lambda)
+        {
+            enumerate_techniques(effect_name, [](effect_runtime* runtime, effect_technique technique, void* user_data) { static_cast<F*>(user_data)->operator()(runtime, technique); }, &lambda);
+        }
+        virtual void get_technique_name(effect_technique technique, char* name, size_t* length) const = 0;
+        virtual void get_technique_effect_name(effect_technique technique, char* effect_name, size_t* length) const = 0;
+        virtual bool get_annotation_bool_from_technique(effect_technique technique, const char* name, bool* values, size_t count, size_t array_index = 0) const = 0;
+        virtual bool get_annotation_int_from_technique(effect_technique technique, const char* name, int32_t* values, size_t count, size_t array_index = 0) const = 0;
+        virtual bool get_technique_state(effect_technique technique) const = 0;
+        virtual void set_technique_state(effect_technique technique, bool enabled) = 0;
+    };
+}
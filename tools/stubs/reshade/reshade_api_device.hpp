@@ -0,0 +1,160 @@
+/*
+ * Minimal stand-in for the ReShade add-on API, see reshade_api_format.hpp.
+ */
+
+#pragma once
+
+#include "reshade_api_pipeline.hpp"
+
+namespace reshade::api
+{
+    enum class device_api
+    {
+        d3d9 = 0x9000,
+        d3d10 = 0xa000,
+        d3d11 = 0xb000,
+        d3d12 = 0xc000,
+        opengl = 0x10000,
+        vulkan = 0x20000
+    };
+
+    // Private data is keyed by a per-type address instead of __uuidof, which only exists on MSVC
+    template <typename T>
+    struct private_data_key
+    {
+        static inline const uint8_t guid[16] = {};
+    };
+
+    struct __declspec(novtable) api_object
+    {
+        virtual ~api_object() = default;
+
+        virtual uint64_t get_native() const = 0;
+
+        virtual bool get_private_data(const uint8_t guid[16], uint64_t* data) const = 0;
+        virtual void set_private_data(const uint8_t guid[16], const uint64_t data) = 0;
+
+        template <typename T>
+        inline T& get_private_data() const
+        {
+            uint64_t res = 0;
+            get_private_data(private_data_key<T>::guid, &res);
+            return *reinterpret_cast<T*>(static_cast<uintptr_t>(res));
+        }
+        template <typename T>
+        inline T& create_private_data()
+        {
+            uint64_t res = reinterpret_cast<uintptr_t>(new T());
+            set_private_data(private_data_key<T>::guid, res);
+            return *reinterpret_cast<T*>(static_cast<uintptr_t>(res));
+        }
+        template <typename T>
+        inline void destroy_private_data()
+        {
+            uint64_t res = 0;
+            get_private_data(private_data_key<T>::guid, &res);
+            delete reinterpret_cast<T*>(static_cast<uintptr_t>(res));
+            set_private_data(private_data_key<T>::guid, 0);
+        }
+    };
+
+    struct __declspec(novtable) device : public api_object
+    {
+        virtual device_api get_api() const = 0;
+
+        virtual bool create_sampler(const sampler_desc& desc, sampler* out_handle) = 0;
+        virtual void destroy_sampler(sampler handle) = 0;
+
+        virtual bool create_resource(const resource_desc& desc, const subresource_data* initial_data, resource_usage initial_state, resource* out_handle, void** shared_handle = nullptr) = 0;
+        virtual void destroy_resource(resource handle) = 0;
+        virtual resource_desc get_resource_desc(resource resource) const = 0;
+
+        virtual bool create_resource_view(resource resource, resource_usage usage_type, const resource_view_desc& desc, resource_view* out_handle) = 0;
+        virtual void destroy_resource_view(resource_view handle) = 0;
+        virtual resource get_resource_from_view(resource_view view) const = 0;
+        virtual resource_view_desc get_resource_view_desc(resource_view view) const = 0;
+
+        virtual bool map_buffer_region(resource resource, uint64_t offset, uint64_t size, map_access access, void** out_data) = 0;
+        virtual void unmap_buffer_region(resource resource) = 0;
+        virtual bool map_texture_region(resource resource, uint32_t subresource, const subresource_box* box, map_access access, subresource_data* out_data) = 0;
+        virtual void unmap_texture_region(resource resource, uint32_t subresource) = 0;
+        virtual void update_buffer_region(const void* data, resource resource, uint64_t offset, uint64_t size) = 0;
+
+        virtual bool create_pipeline(pipeline_layout layout, uint32_t subobject_count, const pipeline_subobject* subobjects, pipeline* out_handle) = 0;
+        virtual void destroy_pipeline(pipeline handle) = 0;
+
+        virtual bool create_pipeline_layout(uint32_t param_count, const pipeline_layout_param* params, pipeline_layout* out_handle) = 0;
+        virtual void destroy_pipeline_layout(pipeline_layout handle) = 0;
+
+        virtual void get_descriptor_heap_offset(descriptor_table table, uint32_t binding, uint32_t array_offset, descriptor_heap* out_heap, uint32_t* out_offset) const = 0;
+
+        virtual bool create_query_heap(query_type type, uint32_t size, query_heap* out_handle) = 0;
+        virtual void destroy_query_heap(query_heap handle) = 0;
+        virtual bool get_query_heap_results(query_heap heap, uint32_t first, uint32_t count, void* results, uint32_t stride) = 0;
+    };
+
+    struct __declspec(novtable) device_object : public api_object
+    {
+        virtual device* get_device() = 0;
+    };
+
+    struct __declspec(novtable) command_list : public device_object
+    {
+        virtual void barrier(uint32_t count, const resource* resources, const resource_usage* old_states, const resource_usage* new_states) = 0;
+        inline void barrier(resource resource, resource_usage old_state, resource_usage new_state) { barrier(1, &resource, &old_state, &new_state); }
+
+        virtual void bind_render_targets_and_depth_stencil(uint32_t count, const resource_view* rtvs, resource_view dsv = { 0 }) = 0;
+
+        virtual void bind_pipeline(pipeline_stage stages, pipeline pipeline) = 0;
+        virtual void bind_pipeline_states(uint32_t count, const dynamic_state* states, const uint32_t* values) = 0;
+        inline void bind_pipeline_state(dynamic_state state, uint32_t value) { bind_pipeline_states(1, &state, &value); }
+        virtual void bind_viewports(uint32_t first, uint32_t count, const viewport* viewports) = 0;
+        virtual void bind_scissor_rects(uint32_t first, uint32_t count, const rect* rects) = 0;
+
+        virtual void push_constants(shader_stage stages, pipeline_layout layout, uint32_t layout_param, uint32_t first, uint32_t count, const void* values) = 0;
+        virtual void push_descriptors(shader_stage stages, pipeline_layout layout, uint32_t layout_param, const descriptor_table_update& update) = 0;
+        virtual void bind_descriptor_tables(shader_stage stages, pipeline_layout layout, uint32_t first, uint32_t count, const descriptor_table* tables) = 0;
+
+        virtual void bind_vertex_buffers(uint32_t first, uint32_t count, const resource* buffers, const uint64_t* offsets, const uint32_t* strides) = 0;
+        inline void bind_vertex_buffer(uint32_t index, resource buffer, uint64_t offset, uint32_t stride) { bind_vertex_buffers(index, 1, &buffer, &offset, &stride); }
+
+        virtual void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) = 0;
+
+        virtual void copy_resource(resource source, resource dest) = 0;
+        virtual void copy_buffer_region(resource source, uint64_t source_offset, resource dest, uint64_t dest_offset, uint64_t size) = 0;
+        virtual void copy_texture_region(resource source, uint32_t source_subresource, const subresource_box* source_box, resource dest, uint32_t dest_subresource, const subresource_box* dest_box, filter_mode filter = filter_mode::min_mag_mip_point) = 0;
+
+        virtual void clear_render_target_view(resource_view rtv, const float color[4], uint32_t rect_count = 0, const rect* rects = nullptr) = 0;
+
+        virtual void begin_query(query_heap heap, query_type type, uint32_t index) = 0;
+        virtual void end_query(query_heap heap, query_type type, uint32_t index) = 0;
+    };
+
+    struct __declspec(novtable) command_queue : public device_object
+    {
+        virtual void wait_idle() const = 0;
+        virtual void flush_immediate_command_list() const = 0;
+        virtual command_list* get_immediate_command_list() = 0;
+        virtual uint64_t get_timestamp_frequency() const = 0;
+    };
+
+    struct swapchain_desc
+    {
+        resource_desc back_buffer;
+        uint32_t back_buffer_count = 0;
+        uint32_t present_mode = 0;
+        uint32_t present_flags = 0;
+        bool fullscreen_state = false;
+        uint32_t fullscreen_refresh_rate = 0;
+        uint32_t sync_interval = UINT32_MAX;
+    };
+
+    struct __declspec(novtable) swapchain : public device_object
+    {
+        virtual void* get_hwnd() const = 0;
+        virtual resource get_back_buffer(uint32_t index) = 0;
+        virtual uint32_t get_back_buffer_count() const = 0;
+        virtual uint32_t get_current_back_buffer_index() const = 0;
+        inline resource get_current_back_buffer() { return get_back_buffer(get_current_back_buffer_index()); }
+    };
+}
@@ -0,0 +1,295 @@
+/*
+ * Minimal stand-in for the ReShade add-on API, only declaring what the addon sources use so they can be built
+ * and exercised without ReShade or a GPU. Names, values and signatures follow the ReShade 5.8 headers.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace reshade::api
+{
+    enum class format : uint32_t
+    {
+        unknown = 0,
+
+        r1_unorm = 66,
+        l8_unorm = 0x3030384C,
+        a8_unorm = 65,
+        r8_typeless = 60,
+        r8_uint = 62,
+        r8_sint = 64,
+        r8_unorm = 61,
+        r8_snorm = 63,
+        l8a8_unorm = 0x3038414C,
+        r8g8_typeless = 48,
+        r8g8_uint = 50,
+        r8g8_sint = 52,
+        r8g8_unorm = 49,
+        r8g8_snorm = 51,
+        r8g8b8a8_typeless = 27,
+        r8g8b8a8_uint = 30,
+        r8g8b8a8_sint = 32,
+        r8g8b8a8_unorm = 28,
+        r8g8b8a8_unorm_srgb = 29,
+        r8g8b8a8_snorm = 31,
+        r8g8b8x8_unorm = 0x424757B8,
+        r8g8b8x8_unorm_srgb = 0x424757B9,
+        b8g8r8a8_typeless = 90,
+        b8g8r8a8_unorm = 87,
+        b8g8r8a8_unorm_srgb = 91,
+        b8g8r8x8_typeless = 92,
+        b8g8r8x8_unorm = 88,
+        b8g8r8x8_unorm_srgb = 93,
+        r10g10b10a2_typeless = 23,
+        r10g10b10a2_uint = 25,
+        r10g10b10a2_unorm = 24,
+        r10g10b10a2_xr_bias = 89,
+        b10g10r10a2_typeless = 0x3A30315B,
+        b10g10r10a2_uint = 0x3A30315C,
+        b10g10r10a2_unorm = 0x3A30315D,
+        l16_unorm = 0x3036314C,
+        r16_typeless = 53,
+        r16_uint = 57,
+        r16_sint = 59,
+        r16_unorm = 56,
+        r16_snorm = 58,
+        r16_float = 54,
+        l16a16_unorm = 0x3631414C,
+        r16g16_typeless = 33,
+        r16g16_uint = 36,
+        r16g16_sint = 38,
+        r16g16_unorm = 35,
+        r16g16_snorm = 37,
+        r16g16_float = 34,
+        r16g16b16a16_typeless = 9,
+        r16g16b16a16_uint = 12,
+        r16g16b16a16_sint = 14,
+        r16g16b16a16_unorm = 11,
+        r16g16b16a16_snorm = 13,
+        r16g16b16a16_float = 10,
+        r32_typeless = 39,
+        r32_uint = 42,
+        r32_sint = 43,
+        r32_float = 41,
+        r32g32_typeless = 15,
+        r32g32_uint = 17,
+        r32g32_sint = 18,
+        r32g32_float = 16,
+        r32g32b32_typeless = 5,
+        r32g32b32_uint = 7,
+        r32g32b32_sint = 8,
+        r32g32b32_float = 6,
+        r32g32b32a32_typeless = 1,
+        r32g32b32a32_uint = 3,
+        r32g32b32a32_sint = 4,
+        r32g32b32a32_float = 2,
+        r9g9b9e5 = 67,
+        r11g11b10_float = 26,
+        b5g6r5_unorm = 85,
+        b5g5r5a1_unorm = 86,
+        b5g5r5x1_unorm = 0x31354258,
+        b4g4r4a4_unorm = 115,
+        a4b4g4r4_unorm = 191,
+
+        s8_uint = 0x30303853,
+        d16_unorm = 55,
+        d16_unorm_s8_uint = 0x38363144,
+        d24_unorm_x8_uint = 0x38343244,
+        d24_unorm_s8_uint = 45,
+        d32_float = 40,
+        d32_float_s8_uint = 20,
+
+        r24_g8_typeless = 44,
+        r24_unorm_x8_uint = 46,
+        x24_unorm_g8_uint = 47,
+        r32_g8_typeless = 19,
+        r32_float_x8_uint = 21,
+        x32_float_g8_uint = 22,
+
+        intz = 0x5A544E49,
+    };
+
+    inline format format_to_typeless(format value)
+    {
+        switch (value)
+        {
+        case format::l8_unorm:
+        case format::r8_typeless:
+        case format::r8_uint:
+        case format::r8_sint:
+        case format::r8_unorm:
+        case format::r8_snorm:
+            return format::r8_typeless;
+        case format::l8a8_unorm:
+        case format::r8g8_typeless:
+        case format::r8g8_uint:
+        case format::r8g8_sint:
+        case format::r8g8_unorm:
+        case format::r8g8_snorm:
+            return format::r8g8_typeless;
+        case format::r8g8b8a8_typeless:
+        case format::r8g8b8a8_uint:
+        case format::r8g8b8a8_sint:
+        case format::r8g8b8a8_unorm:
+        case format::r8g8b8a8_unorm_srgb:
+        case format::r8g8b8a8_snorm:
+        case format::r8g8b8x8_unorm:
+        case format::r8g8b8x8_unorm_srgb:
+            return format::r8g8b8a8_typeless;
+        case format::b8g8r8a8_typeless:
+        case format::b8g8r8a8_unorm:
+        case format::b8g8r8a8_unorm_srgb:
+            return format::b8g8r8a8_typeless;
+        case format::b8g8r8x8_typeless:
+        case format::b8g8r8x8_unorm:
+        case format::b8g8r8x8_unorm_srgb:
+            return format::b8g8r8x8_typeless;
+        case format::r10g10b10a2_typeless:
+        case format::r10g10b10a2_uint:
+        case format::r10g10b10a2_unorm:
+        case format::r10g10b10a2_xr_bias:
+            return format::r10g10b10a2_typeless;
+        case format::b10g10r10a2_typeless:
+        case format::b10g10r10a2_uint:
+        case format::b10g10r10a2_unorm:
+            return format::b10g10r10a2_typeless;
+        case format::l16_unorm:
+        case format::d16_unorm:
+        case format::r16_typeless:
+        case format::r16_uint:
+        case format::r16_sint:
+        case format::r16_float:
+        case format::r16_unorm:
+        case format::r16_snorm:
+            return format::r16_typeless;
+        case format::l16a16_unorm:
+        case format::r16g16_typeless:
+        case format::r16g16_uint:
+        case format::r16g16_sint:
+        case format::r16g16_float:
+        case format::r16g16_unorm:
+        case format::r16g16_snorm:
+            return format::r16g16_typeless;
+        case format::r16g16b16a16_typeless:
+        case format::r16g16b16a16_uint:
+        case format::r16g16b16a16_sint:
+        case format::r16g16b16a16_float:
+        case format::r16g16b16a16_unorm:
+        case format::r16g16b16a16_snorm:
+            return format::r16g16b16a16_typeless;
+        case format::d32_float:
+        case format::r32_typeless:
+        case format::r32_uint:
+        case format::r32_sint:
+        case format::r32_float:
+            return format::r32_typeless;
+        case format::r32g32_typeless:
+        case format::r32g32_uint:
+        case format::r32g32_sint:
+        case format::r32g32_float:
+            return format::r32g32_typeless;
+        case format::r32g32b32_typeless:
+        case format::r32g32b32_uint:
+        case format::r32g32b32_sint:
+        case format::r32g32b32_float:
+            return format::r32g32b32_typeless;
+        case format::r32g32b32a32_typeless:
+        case format::r32g32b32a32_uint:
+        case format::r32g32b32a32_sint:
+        case format::r32g32b32a32_float:
+            return format::r32g32b32a32_typeless;
+        case format::d32_float_s8_uint:
+        case format::r32_g8_typeless:
+        case format::r32_float_x8_uint:
+        case format::x32_float_g8_uint:
+            return format::r32_g8_typeless;
+        case format::d24_unorm_s8_uint:
+        case format::r24_g8_typeless:
+        case format::r24_unorm_x8_uint:
+        case format::x24_unorm_g8_uint:
+            return format::r24_g8_typeless;
+        default:
+            return value;
+        }
+    }
+
+    inline format format_to_default_typed(format value, int srgb_variant = -1)
+    {
+        switch (value)
+        {
+        case format::r8_typeless:
+            return format::r8_unorm;
+        case format::r8g8_typeless:
+            return format::r8g8_unorm;
+        case format::r8g8b8a8_typeless:
+        case format::r8g8b8a8_unorm:
+        case format::r8g8b8a8_unorm_srgb:
+            return srgb_variant == 1 ? format::r8g8b8a8_unorm_srgb : (srgb_variant == 0 ? format::r8g8b8a8_unorm : (value == format::r8g8b8a8_typeless ? format::r8g8b8a8_unorm : value));
+        case format::r8g8b8x8_unorm:
+        case format::r8g8b8x8_unorm_srgb:
+            return srgb_variant == 1 ? format::r8g8b8x8_unorm_srgb : (srgb_variant == 0 ? format::r8g8b8x8_unorm : value);
+        case format::b8g8r8a8_typeless:
+        case format::b8g8r8a8_unorm:
+        case format::b8g8r8a8_unorm_srgb:
+            return srgb_variant == 1 ? format::b8g8r8a8_unorm_srgb : (srgb_variant == 0 ? format::b8g8r8a8_unorm : (value == format::b8g8r8a8_typeless ? format::b8g8r8a8_unorm : value));
+        case format::b8g8r8x8_typeless:
+        case format::b8g8r8x8_unorm:
+        case format::b8g8r8x8_unorm_srgb:
+            return srgb_variant == 1 ? format::b8g8r8x8_unorm_srgb : (srgb_variant == 0 ? format::b8g8r8x8_unorm : (value == format::b8g8r8x8_typeless ? format::b8g8r8x8_unorm : value));
+        case format::r10g10b10a2_typeless:
+            return format::r10g10b10a2_unorm;
+        case format::b10g10r10a2_typeless:
+            return format::b10g10r10a2_unorm;
+        case format::r16_typeless:
+            return format::r16_float;
+        case format::r16g16_typeless:
+            return format::r16g16_float;
+        case format::r16g16b16a16_typeless:
+            return format::r16g16b16a16_float;
+        case format::r32_typeless:
+            return format::r32_float;
+        case format::r32g32_typeless:
+            return format::r32g32_float;
+        case format::r32g32b32_typeless:
+            return format::r32g32b32_float;
+        case format::r32g32b32a32_typeless:
+            return format::r32g32b32a32_float;
+        case format::r32_g8_typeless:
+            return format::r32_float_x8_uint;
+        case format::r24_g8_typeless:
+            return format::r24_unorm_x8_uint;
+        default:
+            return value;
+        }
+    }
+
+    inline uint32_t format_row_pitch(format value, uint32_t width)
+    {
+        switch (format_to_typeless(value))
+        {
+        case format::r8_typeless:
+        case format::a8_unorm:
+        case format::r1_unorm:
+            return width;
+        case format::r8g8_typeless:
+        case format::r16_typeless:
+        case format::b5g6r5_unorm:
+        case format::b5g5r5a1_unorm:
+        case format::b5g5r5x1_unorm:
+        case format::b4g4r4a4_unorm:
+        case format::a4b4g4r4_unorm:
+            return 2 * width;
+        case format::r16g16b16a16_typeless:
+        case format::r32g32_typeless:
+        case format::r32_g8_typeless:
+            return 8 * width;
+        case format::r32g32b32_typeless:
+            return 12 * width;
+        case format::r32g32b32a32_typeless:
+            return 16 * width;
+        default:
+            return 4 * width;
+        }
+    }
+}
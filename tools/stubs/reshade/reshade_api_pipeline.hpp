@@ -0,0 +1,367 @@
+/*
+ * Minimal stand-in for the ReShade add-on API, see reshade_api_format.hpp.
+ */
+
+#pragma once
+
+#include "reshade_api_resource.hpp"
+
+namespace reshade::api
+{
+    enum class shader_stage : uint32_t
+    {
+        vertex = 0x1,
+        hull = 0x2,
+        domain = 0x4,
+        geometry = 0x8,
+        pixel = 0x10,
+        compute = 0x20,
+        amplification = 0x40,
+        mesh = 0x80,
+
+        all = 0x7FFFFFFF,
+        all_compute = compute,
+        all_graphics = vertex | hull | domain | geometry | pixel
+    };
+    RESHADE_DEFINE_ENUM_FLAG_OPERATORS(shader_stage);
+
+    enum class pipeline_stage : uint32_t
+    {
+        vertex_shader = 0x8,
+        hull_shader = 0x10,
+        domain_shader = 0x20,
+        geometry_shader = 0x40,
+        pixel_shader = 0x80,
+        compute_shader = 0x800,
+        amplification_shader = 0x80000,
+        mesh_shader = 0x100000,
+
+        input_assembler = 0x2,
+        stream_output = 0x4,
+        rasterizer = 0x100,
+        depth_stencil = 0x200,
+        output_merger = 0x400,
+
+        all = 0x7FFFFFFF,
+        all_compute = compute_shader,
+        all_graphics = vertex_shader | hull_shader | domain_shader | geometry_shader | pixel_shader | input_assembler | stream_output | rasterizer | depth_stencil | output_merger,
+        all_shader_stages = vertex_shader | hull_shader | domain_shader | geometry_shader | pixel_shader | compute_shader
+    };
+    RESHADE_DEFINE_ENUM_FLAG_OPERATORS(pipeline_stage);
+
+    enum class descriptor_type : uint32_t
+    {
+        sampler = 0,
+        sampler_with_resource_view = 1,
+        shader_resource_view = 2,
+        unordered_access_view = 3,
+        buffer_shader_resource_view = 4,
+        buffer_unordered_access_view = 5,
+        constant_buffer = 6,
+        shader_storage_buffer = 7,
+        acceleration_structure = 8
+    };
+
+    RESHADE_DEFINE_HANDLE(descriptor_heap);
+    RESHADE_DEFINE_HANDLE(descriptor_table);
+    RESHADE_DEFINE_HANDLE(pipeline_layout);
+    RESHADE_DEFINE_HANDLE(pipeline);
+    RESHADE_DEFINE_HANDLE(query_heap);
+
+    struct constant_range
+    {
+        uint32_t offset = 0;
+        uint32_t binding = 0;
+        uint32_t dx_register_index = 0;
+        uint32_t dx_register_space = 0;
+        uint32_t count = 0;
+        shader_stage visibility = shader_stage::all;
+    };
+
+    struct descriptor_range
+    {
+        uint32_t binding = 0;
+        uint32_t dx_register_index = 0;
+        uint32_t dx_register_space = 0;
+        uint32_t count = 0;
+        shader_stage visibility = shader_stage::all;
+        uint32_t array_size = 1;
+        descriptor_type type = descriptor_type::sampler;
+    };
+
+    enum class pipeline_layout_param_type : uint32_t
+    {
+        push_constants = 1,
+        descriptor_table = 0,
+        push_descriptors = 2,
+        push_descriptors_with_ranges = 3
+    };
+
+    struct pipeline_layout_param
+    {
+        constexpr pipeline_layout_param() : push_descriptors() {}
+        constexpr pipeline_layout_param(const constant_range& push_constants) : type(pipeline_layout_param_type::push_constants), push_constants(push_constants) {}
+        constexpr pipeline_layout_param(const descriptor_range& push_descriptors) : type(pipeline_layout_param_type::push_descriptors), push_descriptors(push_descriptors) {}
+        constexpr pipeline_layout_param(uint32_t count, const descriptor_range* ranges) : type(pipeline_layout_param_type::descriptor_table), descriptor_table({ count, ranges }) {}
+
+        pipeline_layout_param_type type = pipeline_layout_param_type::push_descriptors;
+
+        union
+        {
+            constant_range push_constants;
+            descriptor_range push_descriptors;
+
+            struct
+            {
+                uint32_t count;
+                const descriptor_range* ranges;
+            } descriptor_table;
+        };
+    };
+
+    enum class blend_factor : uint32_t
+    {
+        zero = 0,
+        one = 1,
+        source_color = 2,
+        one_minus_source_color = 3,
+        dest_color = 4,
+        one_minus_dest_color = 5,
+        source_alpha = 6,
+        one_minus_source_alpha = 7,
+        dest_alpha = 8,
+        one_minus_dest_alpha = 9
+    };
+
+    enum class blend_op : uint32_t
+    {
+        add = 0,
+        subtract = 1,
+        reverse_subtract = 2,
+        min = 3,
+        max = 4
+    };
+
+    struct blend_desc
+    {
+        bool alpha_to_coverage_enable = false;
+        bool blend_enable[8] = { false, false, false, false, false, false, false, false };
+        bool logic_op_enable[8] = { false, false, false, false, false, false, false, false };
+        blend_factor source_color_blend_factor[8] = { blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one };
+        blend_factor dest_color_blend_factor[8] = {};
+        blend_op color_blend_op[8] = {};
+        blend_factor source_alpha_blend_factor[8] = { blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one, blend_factor::one };
+        blend_factor dest_alpha_blend_factor[8] = {};
+        blend_op alpha_blend_op[8] = {};
+        float blend_constant[4] = {};
+        uint8_t render_target_write_mask[8] = { 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF };
+    };
+
+    enum class fill_mode : uint32_t
+    {
+        solid = 0,
+        wireframe = 1,
+        point = 2
+    };
+
+    enum class cull_mode : uint32_t
+    {
+        none = 0,
+        front = 1,
+        back = 2,
+        front_and_back = front | back
+    };
+
+    struct rasterizer_desc
+    {
+        reshade::api::fill_mode fill_mode = reshade::api::fill_mode::solid;
+        reshade::api::cull_mode cull_mode = reshade::api::cull_mode::back;
+        bool front_counter_clockwise = false;
+        float depth_bias = 0.0f;
+        float depth_bias_clamp = 0.0f;
+        float slope_scaled_depth_bias = 0.0f;
+        bool depth_clip_enable = true;
+        bool scissor_enable = false;
+        bool multisample_enable = false;
+        bool antialiased_line_enable = false;
+    };
+
+    struct input_element
+    {
+        uint32_t location = 0;
+        const char* semantic = nullptr;
+        uint32_t semantic_index = 0;
+        reshade::api::format format = reshade::api::format::unknown;
+        uint32_t buffer_binding = 0;
+        uint32_t offset = UINT32_MAX;
+        uint32_t stride = 0;
+        uint32_t instance_step_rate = 0;
+    };
+
+    struct shader_desc
+    {
+        const void* code = nullptr;
+        size_t code_size = 0;
+        const char* entry_point = nullptr;
+    };
+
+    enum class primitive_topology : uint32_t
+    {
+        undefined = 0,
+        point_list = 1,
+        line_list = 2,
+        line_strip = 3,
+        triangle_list = 4,
+        triangle_strip = 5,
+        triangle_fan = 6
+    };
+
+    enum class pipeline_subobject_type : uint32_t
+    {
+        unknown,
+        vertex_shader,
+        hull_shader,
+        domain_shader,
+        geometry_shader,
+        pixel_shader,
+        compute_shader,
+        input_layout,
+        stream_output_state,
+        blend_state,
+        rasterizer_state,
+        depth_stencil_state,
+        primitive_topology,
+        depth_stencil_format,
+        render_target_formats,
+        sample_mask,
+        sample_count,
+        viewport_count,
+        dynamic_pipeline_states,
+        max_vertex_count,
+        amplification_shader,
+        mesh_shader
+    };
+
+    struct pipeline_subobject
+    {
+        pipeline_subobject_type type = pipeline_subobject_type::unknown;
+        uint32_t count = 0;
+        void* data = nullptr;
+    };
+
+    enum class dynamic_state : uint32_t
+    {
+        unknown = 0,
+        alpha_test_enable = 15,
+        alpha_reference_value = 24,
+        alpha_func = 25,
+        srgb_write_enable = 194,
+        primitive_topology = 1000,
+        blend_constant = 193,
+        sample_mask = 162,
+        front_stencil_reference_value = 57,
+        back_stencil_reference_value = 1001
+    };
+
+    enum class query_type
+    {
+        occlusion = 0,
+        binary_occlusion = 1,
+        timestamp = 2,
+        pipeline_statistics = 3
+    };
+
+    enum class indirect_command
+    {
+        unknown,
+        draw,
+        draw_indexed,
+        dispatch,
+        dispatch_mesh,
+        dispatch_rays
+    };
+
+    enum class render_pass_load_op : uint32_t
+    {
+        load,
+        clear,
+        discard,
+        no_access
+    };
+
+    enum class render_pass_store_op : uint32_t
+    {
+        store,
+        discard,
+        no_access
+    };
+
+    struct render_pass_render_target_desc
+    {
+        resource_view view = { 0 };
+        render_pass_load_op load_op = render_pass_load_op::load;
+        render_pass_store_op store_op = render_pass_store_op::store;
+        float clear_color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    };
+
+    struct render_pass_depth_stencil_desc
+    {
+        resource_view view = { 0 };
+        render_pass_load_op depth_load_op = render_pass_load_op::load;
+        render_pass_store_op depth_store_op = render_pass_store_op::store;
+        render_pass_load_op stencil_load_op = render_pass_load_op::load;
+        render_pass_store_op stencil_store_op = render_pass_store_op::store;
+        float clear_depth = 0.0f;
+        uint8_t clear_stencil = 0;
+    };
+
+    struct buffer_range
+    {
+        resource buffer = { 0 };
+        uint64_t offset = 0;
+        uint64_t size = UINT64_MAX;
+    };
+
+    struct sampler_with_resource_view
+    {
+        reshade::api::sampler sampler = { 0 };
+        resource_view view = { 0 };
+    };
+
+    struct descriptor_table_copy
+    {
+        descriptor_table source_table = { 0 };
+        uint32_t source_binding = 0;
+        uint32_t source_array_offset = 0;
+        descriptor_table dest_table = { 0 };
+        uint32_t dest_binding = 0;
+        uint32_t dest_array_offset = 0;
+        uint32_t count = 0;
+    };
+
+    struct descriptor_table_update
+    {
+        descriptor_table table = { 0 };
+        uint32_t binding = 0;
+        uint32_t array_offset = 0;
+        uint32_t count = 0;
+        descriptor_type type = descriptor_type::sampler;
+        const void* descriptors = nullptr;
+    };
+
+    struct viewport
+    {
+        float x, y;
+        float width, height;
+        float min_depth, max_depth;
+    };
+
+    struct rect
+    {
+        int32_t left, top;
+        int32_t right, bottom;
+
+        constexpr uint32_t width() const { return right - left; }
+        constexpr uint32_t height() const { return bottom - top; }
+    };
+}
@@ -0,0 +1,14 @@
+/*
+ * Fallback for tsl::robin_map when the robin-map submodule is not checked out, see the platform stubs. Lookups behave the
+ * same, only the probing scheme and so the performance differ.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+namespace tsl
+{
+    template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    using robin_map = std::unordered_map<Key, T, Hash, KeyEqual>;
+}
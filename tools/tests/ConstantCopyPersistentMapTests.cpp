@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Tests for Shim::Constants::ConstantCopyPersistentMap. The upload heap is simulated by the mock device's buffer memory,
+// which the tests write through the pointers map_buffer_region hands out, the same way a game writes its constants.
+//
+/////////////////////////////////////////////////////////////////////////
+#include <reshade.hpp>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "mock/MockDevice.h"
+#include "ConstantCopyPersistentMap.h"
+
+using namespace reshade::api;
+using namespace Shim::Constants;
+using namespace std;
+
+static uint32_t g_failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { cerr << __FILE__ << ":" << __LINE__ << ": expected " << #condition << endl; g_failures++; } } while (0)
+
+static constexpr resource UploadHeap = { 0x100 };
+static constexpr uint64_t UploadHeapSize = 4096;
+static constexpr size_t WindowSize = 256;
+
+struct PersistentMapTest
+{
+    Mock::CallLog log;
+    Mock::MockDevice device;
+    ConstantCopyPersistentMap copy;
+    uint8_t* memory = nullptr;
+
+    PersistentMapTest(device_api api, uint64_t heapSize = UploadHeapSize) : device(api, &log)
+    {
+        device.AddResource(UploadHeap, resource_desc(heapSize, memory_heap::cpu_to_gpu, resource_usage::constant_buffer));
+
+        void* data = nullptr;
+        device.map_buffer_region(UploadHeap, 0, UINT64_MAX, map_access::write_only, &data);
+        memory = static_cast<uint8_t*>(data);
+    }
+
+    // Maps the range like the game would and lets the strategy see the map
+    uint8_t* Map(uint64_t offset, uint64_t size)
+    {
+        void* data = nullptr;
+        EXPECT(device.map_buffer_region(UploadHeap, offset, size, map_access::write_only, &data));
+        copy.OnMapBufferRegion(&device, UploadHeap, offset, size, map_access::write_only, &data);
+        return static_cast<uint8_t*>(data);
+    }
+
+    void Unmap()
+    {
+        copy.OnUnmapBufferRegion(&device, UploadHeap);
+    }
+
+    void Fill(uint64_t offset, size_t size, uint8_t value)
+    {
+        memset(memory + offset, value, size);
+    }
+
+    // Reads a window into a buffer prefilled with a marker, so reads that don't copy anything stand out
+    vector<uint8_t> Read(uint64_t offset, uint64_t size, size_t destSize = WindowSize)
+    {
+        vector<uint8_t> dest(destSize, 0xCD);
+        copy.GetHostConstantBufferRange(nullptr, nullptr, dest, destSize, buffer_range{ UploadHeap, offset, size });
+        return dest;
+    }
+};
+
+static bool AllEqual(const vector<uint8_t>& data, uint8_t value)
+{
+    for (uint8_t b : data)
+    {
+        if (b != value)
+        {
+            return false;
+        }
+    }
+
+    return !data.empty();
+}
+
+static void ReadsThroughPersistentBasePointer()
+{
+    PersistentMapTest t(device_api::d3d12);
+
+    // Mapping a sub range still tracks the buffer from its start
+    uint8_t* mapped = t.Map(1024, 2048);
+    EXPECT(mapped == t.memory + 1024);
+
+    t.Fill(0, WindowSize, 0x11);
+    t.Fill(1280, WindowSize, 0x22);
+    t.Fill(3840, WindowSize, 0x33);
+
+    EXPECT(AllEqual(t.Read(0, WindowSize), 0x11));
+    EXPECT(AllEqual(t.Read(1280, WindowSize), 0x22));
+    EXPECT(AllEqual(t.Read(3840, WindowSize), 0x33));
+
+    // Unmapping a persistent mapping forgets the buffer
+    t.Unmap();
+    EXPECT(AllEqual(t.Read(1280, WindowSize), 0xCD));
+}
+
+static void ReadsSubAllocatedWindows()
+{
+    PersistentMapTest t(device_api::d3d12);
+    t.Map(0, UINT64_MAX);
+
+    for (uint64_t i = 0; i < UploadHeapSize / WindowSize; i++)
+    {
+        t.Fill(i * WindowSize, WindowSize, static_cast<uint8_t>(i + 1));
+    }
+
+    for (uint64_t i = 0; i < UploadHeapSize / WindowSize; i++)
+    {
+        EXPECT(AllEqual(t.Read(i * WindowSize, WindowSize), static_cast<uint8_t>(i + 1)));
+    }
+
+    // Views smaller than the alignment still cover a whole window
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 512, 100 }) == WindowSize);
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 512, WindowSize + 1 }) == 2 * WindowSize);
+
+    // A read shorter than the destination only fills what the window holds
+    const vector<uint8_t> partial = t.Read(UploadHeapSize - 128, WindowSize);
+    EXPECT(partial[0] == 16 && partial[127] == 16 && partial[128] == 0xCD);
+}
+
+static void WindowIsReadOncePerFrame()
+{
+    PersistentMapTest t(device_api::d3d12);
+    t.Map(0, UINT64_MAX);
+
+    t.Fill(512, WindowSize, 0x01);
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x01));
+
+    // Rewriting the window within the same frame is only seen from the next frame on
+    t.Fill(512, WindowSize, 0x02);
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x01));
+
+    t.copy.OnPresent();
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x02));
+
+    t.Fill(512, WindowSize, 0x03);
+    t.copy.OnPresent();
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x03));
+
+    // Other windows of the buffer are cached separately
+    t.Fill(768, WindowSize, 0x04);
+    EXPECT(AllEqual(t.Read(768, WindowSize), 0x04));
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x03));
+}
+
+static void SnapshotsMappedRangeOnUnmap()
+{
+    PersistentMapTest t(device_api::d3d11);
+
+    uint8_t* mapped = t.Map(256, 512);
+    memset(mapped, 0x55, 512);
+
+    // Nothing to read before the game is done writing
+    EXPECT(AllEqual(t.Read(256, WindowSize), 0xCD));
+
+    t.Unmap();
+    EXPECT(AllEqual(t.Read(256, WindowSize), 0x55));
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x55));
+
+    // Outside the mapped range the snapshot holds zeros
+    EXPECT(AllEqual(t.Read(0, WindowSize), 0x00));
+    EXPECT(AllEqual(t.Read(768, WindowSize), 0x00));
+
+    // Writes after the unmap aren't seen until the next map and unmap
+    t.Fill(256, WindowSize, 0x66);
+    t.copy.OnPresent();
+    EXPECT(AllEqual(t.Read(256, WindowSize), 0x55));
+
+    mapped = t.Map(256, WindowSize);
+    memset(mapped, 0x77, WindowSize);
+    t.Unmap();
+    EXPECT(AllEqual(t.Read(256, WindowSize), 0x77));
+    EXPECT(AllEqual(t.Read(512, WindowSize), 0x55));
+}
+
+static void RejectsRangesPastTheEnd()
+{
+    PersistentMapTest t(device_api::d3d12, 1000);
+    t.Map(0, UINT64_MAX);
+    t.Fill(0, 1000, 0x42);
+
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 1000, WindowSize }) == 0);
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 4096, UINT64_MAX }) == 0);
+    EXPECT(AllEqual(t.Read(1000, WindowSize), 0xCD));
+    EXPECT(AllEqual(t.Read(UINT64_MAX, WindowSize), 0xCD));
+
+    // Rounding up to the alignment never runs past the end of the buffer
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 768, WindowSize }) == 232);
+}
+
+static void WholeBufferRanges()
+{
+    PersistentMapTest t(device_api::d3d12, 1000);
+    t.Map(0, UINT64_MAX);
+    t.Fill(0, 1000, 0x42);
+
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 0, UINT64_MAX }) == 1000);
+    EXPECT(t.copy.GetConstantBufferRangeSize(&t.device, buffer_range{ UploadHeap, 512, UINT64_MAX }) == 488);
+
+    const vector<uint8_t> tail = t.Read(512, UINT64_MAX, 488);
+    EXPECT(AllEqual(tail, 0x42));
+
+    vector<uint8_t> whole(1000, 0xCD);
+    t.copy.GetHostConstantBuffer(nullptr, nullptr, whole, whole.size(), UploadHeap.handle);
+    EXPECT(AllEqual(whole, 0x42));
+
+    // Maps with an open ended size on other APIs snapshot the rest of the buffer
+    PersistentMapTest d3d11(device_api::d3d11, 1000);
+    uint8_t* mapped = d3d11.Map(512, UINT64_MAX);
+    memset(mapped, 0x24, 488);
+    d3d11.Unmap();
+
+    EXPECT(AllEqual(d3d11.Read(512, UINT64_MAX, 488), 0x24));
+    EXPECT(AllEqual(d3d11.Read(0, UINT64_MAX, 512), 0x00));
+}
+
+int main()
+{
+    const pair<const char*, function<void()>> tests[] = {
+        { "ReadsThroughPersistentBasePointer", ReadsThroughPersistentBasePointer },
+        { "ReadsSubAllocatedWindows", ReadsSubAllocatedWindows },
+        { "WindowIsReadOncePerFrame", WindowIsReadOncePerFrame },
+        { "SnapshotsMappedRangeOnUnmap", SnapshotsMappedRangeOnUnmap },
+        { "RejectsRangesPastTheEnd", RejectsRangesPastTheEnd },
+        { "WholeBufferRanges", WholeBufferRanges },
+    };
+
+    for (const auto& [name, test] : tests)
+    {
+        const uint32_t failures = g_failures;
+        test();
+        cout << (g_failures == failures ? "[PASS] " : "[FAIL] ") << name << endl;
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,375 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Tests for Rendering::GroupCostTracker, driven through a fake TimestampBackend installed with SetBackend. Plain
+// checks instead of a test framework so the tools build needs nothing beyond a compiler.
+//
+/////////////////////////////////////////////////////////////////////////
+#include <reshade.hpp>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mock/MockDevice.h"
+#include "AddonUIData.h"
+#include "GroupCostTracker.h"
+#include "PipelinePrivateData.h"
+#include "ShaderManager.h"
+
+using namespace reshade::api;
+using namespace ShaderToggler;
+using namespace AddonImGui;
+using namespace Rendering;
+using namespace std;
+
+static uint32_t g_failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { cerr << __FILE__ << ":" << __LINE__ << ": expected " << #condition << endl; g_failures++; } } while (0)
+#define EXPECT_MS(value, expected) EXPECT(std::fabs((value) - (expected)) < 0.0001f)
+
+// Every timestamp is its index times TicksPerIndex, so a scope's begin/end pair always measures one step no matter
+// how threads interleave. Counts the writes per index to catch command lists sharing a range.
+class FakeTimestampBackend final : public TimestampBackend
+{
+public:
+    static constexpr uint64_t Frequency = 1000000000;
+    static constexpr uint64_t TicksPerIndex = 500000;
+
+    struct State
+    {
+        mutex writeMutex;
+        vector<uint64_t> ticks;
+        vector<uint32_t> writes;
+        vector<command_list*> writers;
+        bool failResolve = false;
+        bool destroyed = false;
+        uint32_t conflicts = 0;
+    };
+
+    FakeTimestampBackend(shared_ptr<State> state) : _state(std::move(state)) {}
+
+    bool Init(device*, command_queue*, uint32_t count) override
+    {
+        unique_lock<mutex> lock(_state->writeMutex);
+        _state->ticks.assign(count, 0);
+        _state->writes.assign(count, 0);
+        _state->writers.assign(count, nullptr);
+        return true;
+    }
+
+    void Destroy(device*) override { _state->destroyed = true; }
+
+    void Write(command_list* cmd_list, uint32_t index) override
+    {
+        unique_lock<mutex> lock(_state->writeMutex);
+        if (index >= _state->ticks.size())
+        {
+            _state->conflicts++;
+            return;
+        }
+
+        if (_state->writers[index] != nullptr && _state->writers[index] != cmd_list)
+        {
+            _state->conflicts++;
+        }
+
+        _state->ticks[index] = static_cast<uint64_t>(index) * TicksPerIndex;
+        _state->writes[index]++;
+        _state->writers[index] = cmd_list;
+    }
+
+    bool Resolve(device*, uint32_t first, uint32_t count, uint64_t* results) override
+    {
+        unique_lock<mutex> lock(_state->writeMutex);
+
+        if (_state->failResolve || first + count > _state->ticks.size())
+        {
+            return false;
+        }
+
+        std::copy_n(_state->ticks.begin() + first, count, results);
+
+        // Ranges are reused by later frames
+        std::fill_n(_state->writers.begin() + first, count, nullptr);
+        return true;
+    }
+
+    uint64_t GetFrequency() const override { return Frequency; }
+    bool IsGPU() const override { return true; }
+
+private:
+    shared_ptr<State> _state;
+};
+
+class GroupCostTrackerTest final
+{
+public:
+    static constexpr float ScopeMs = 1000.0f * FakeTimestampBackend::TicksPerIndex / FakeTimestampBackend::Frequency;
+
+    GroupCostTrackerTest() :
+        uiData(&pixelShaderManager, &vertexShaderManager, &computeShaderManager, nullptr, &activeCollectorFrameCounter),
+        device(device_api::d3d12, &log),
+        queue(&device, &log),
+        runtime(&device, &queue, &log, 1920, 1080),
+        tracker(uiData),
+        groupA("A", 1),
+        groupB("B", 2),
+        backendState(make_shared<FakeTimestampBackend::State>())
+    {
+        uiData.SetGroupCostTiming(true);
+
+        auto backend = make_unique<FakeTimestampBackend>(backendState);
+        backend->Init(&device, &queue, GroupCostTracker::FramesInFlight * GroupCostTracker::TimestampsPerFrame);
+        tracker.SetBackend(std::move(backend), &device);
+    }
+
+    ~GroupCostTrackerTest()
+    {
+        for (auto& cmd_list : commandLists)
+        {
+            cmd_list->destroy_private_data<CommandListDataContainer>();
+        }
+
+        tracker.OnDestroyDevice(&device);
+    }
+
+    command_list* CreateCommandList()
+    {
+        commandLists.push_back(make_unique<Mock::MockCommandList>(&device, &log));
+        commandLists.back()->create_private_data<CommandListDataContainer>();
+        return commandLists.back().get();
+    }
+
+    void Present(uint32_t count = 1)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            tracker.OnReshadePresent(&runtime);
+        }
+    }
+
+    const GroupCost* FindCost(const vector<GroupCost>& costs, int groupId)
+    {
+        for (const auto& cost : costs)
+        {
+            if (cost.groupId == groupId)
+            {
+                return &cost;
+            }
+        }
+
+        return nullptr;
+    }
+
+    ShaderManager pixelShaderManager;
+    ShaderManager vertexShaderManager;
+    ShaderManager computeShaderManager;
+    atomic_uint32_t activeCollectorFrameCounter = 0;
+    AddonUIData uiData;
+    Mock::CallLog log;
+    Mock::MockDevice device;
+    Mock::MockCommandQueue queue;
+    Mock::MockEffectRuntime runtime;
+    GroupCostTracker tracker;
+    ToggleGroup groupA;
+    ToggleGroup groupB;
+    shared_ptr<FakeTimestampBackend::State> backendState;
+    vector<unique_ptr<Mock::MockCommandList>> commandLists;
+};
+
+static void AttributesScopesToGroupsAndTechniques(GroupCostTrackerTest& t)
+{
+    command_list* cmd_list = t.CreateCommandList();
+
+    {
+        GroupCostTimer group(t.tracker, cmd_list, &t.groupA, SCOPE_GROUP);
+        GroupCostTimer alpha(t.tracker, cmd_list, &t.groupA, SCOPE_ALPHA);
+    }
+    {
+        GroupCostTimer technique(t.tracker, cmd_list, &t.groupB, SCOPE_TECHNIQUE, 42);
+    }
+
+    // Results are read once the slot comes around again
+    t.Present(GroupCostTracker::FramesInFlight - 1);
+    EXPECT(t.tracker.GetCosts().empty());
+
+    t.Present();
+    const vector<GroupCost> costs = t.tracker.GetCosts();
+    EXPECT(costs.size() == 2);
+
+    const GroupCost* a = t.FindCost(costs, t.groupA.getId());
+    const GroupCost* b = t.FindCost(costs, t.groupB.getId());
+    EXPECT(a != nullptr && b != nullptr);
+    if (a == nullptr || b == nullptr)
+    {
+        return;
+    }
+
+    EXPECT_MS(a->totalMs, GroupCostTrackerTest::ScopeMs);
+    EXPECT_MS(a->alphaMs, GroupCostTrackerTest::ScopeMs);
+    EXPECT_MS(b->totalMs, 0.0f);
+    EXPECT(b->techniqueMs.contains(42));
+    EXPECT(b->techniqueMs.contains(42) && std::fabs(b->techniqueMs.at(42) - GroupCostTrackerTest::ScopeMs) < 0.0001f);
+}
+
+static void CommandListsRecordIntoSeparateChunks(GroupCostTrackerTest& t)
+{
+    constexpr uint32_t ThreadCount = 4;
+    constexpr uint32_t ScopesPerThread = GroupCostTracker::TimestampsPerChunk / 2;
+
+    vector<command_list*> cmd_lists;
+    for (uint32_t i = 0; i < ThreadCount; i++)
+    {
+        cmd_lists.push_back(t.CreateCommandList());
+    }
+
+    vector<thread> threads;
+    for (uint32_t i = 0; i < ThreadCount; i++)
+    {
+        threads.emplace_back([&, i]() {
+            for (uint32_t s = 0; s < ScopesPerThread; s++)
+            {
+                GroupCostTimer timer(t.tracker, cmd_lists[i], (i & 1) ? &t.groupB : &t.groupA, SCOPE_GROUP);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT(t.backendState->conflicts == 0);
+
+    uint32_t written = 0;
+    for (uint32_t count : t.backendState->writes)
+    {
+        EXPECT(count <= 1);
+        written += count;
+    }
+    EXPECT(written == ThreadCount * ScopesPerThread * 2);
+
+    t.Present(GroupCostTracker::FramesInFlight);
+
+    const vector<GroupCost> costs = t.tracker.GetCosts();
+    const GroupCost* a = t.FindCost(costs, t.groupA.getId());
+    const GroupCost* b = t.FindCost(costs, t.groupB.getId());
+    EXPECT(a != nullptr && b != nullptr);
+    if (a == nullptr || b == nullptr)
+    {
+        return;
+    }
+
+    EXPECT_MS(a->totalMs, GroupCostTrackerTest::ScopeMs * ScopesPerThread * (ThreadCount / 2));
+    EXPECT_MS(b->totalMs, GroupCostTrackerTest::ScopeMs * ScopesPerThread * (ThreadCount / 2));
+}
+
+static void FullChunkDropsFurtherScopes(GroupCostTrackerTest& t)
+{
+    command_list* cmd_list = t.CreateCommandList();
+
+    for (uint32_t s = 0; s < GroupCostTracker::TimestampsPerChunk; s++)
+    {
+        GroupCostTimer timer(t.tracker, cmd_list, &t.groupA, SCOPE_GROUP);
+    }
+
+    uint32_t written = 0;
+    for (uint32_t count : t.backendState->writes)
+    {
+        written += count;
+    }
+    EXPECT(written == GroupCostTracker::TimestampsPerChunk);
+}
+
+static void FailedResolveCountsAsDroppedFrame(GroupCostTrackerTest& t)
+{
+    command_list* cmd_list = t.CreateCommandList();
+
+    {
+        GroupCostTimer timer(t.tracker, cmd_list, &t.groupA, SCOPE_GROUP);
+    }
+
+    t.backendState->failResolve = true;
+    t.Present(GroupCostTracker::FramesInFlight);
+
+    EXPECT(t.tracker.GetDroppedFrames() == 1);
+    EXPECT(t.tracker.GetCosts().empty());
+}
+
+static void ReloadDiscardsFramesInFlight(GroupCostTrackerTest& t)
+{
+    command_list* cmd_list = t.CreateCommandList();
+
+    {
+        GroupCostTimer timer(t.tracker, cmd_list, &t.groupA, SCOPE_TECHNIQUE, 7);
+    }
+
+    t.tracker.OnReshadeReloadedEffects();
+    t.Present(GroupCostTracker::FramesInFlight);
+    EXPECT(t.tracker.GetCosts().empty());
+
+    {
+        GroupCostTimer timer(t.tracker, cmd_list, &t.groupA, SCOPE_TECHNIQUE, 8);
+    }
+
+    t.Present(GroupCostTracker::FramesInFlight);
+    const vector<GroupCost> costs = t.tracker.GetCosts();
+    EXPECT(costs.size() == 1);
+    EXPECT(!costs.empty() && !costs[0].techniqueMs.contains(7) && costs[0].techniqueMs.contains(8));
+}
+
+static void DisablingTimingStopsRecording(GroupCostTrackerTest& t)
+{
+    command_list* cmd_list = t.CreateCommandList();
+
+    t.uiData.SetGroupCostTiming(false);
+    t.Present();
+    EXPECT(!t.tracker.IsActive());
+    EXPECT(!t.backendState->destroyed);
+    EXPECT(t.tracker.Begin(cmd_list, &t.groupA, SCOPE_GROUP) == UINT32_MAX);
+
+    t.uiData.SetGroupCostTiming(true);
+    t.Present();
+    EXPECT(t.tracker.IsActive());
+
+    const uint32_t scope = t.tracker.Begin(cmd_list, &t.groupA, SCOPE_GROUP);
+    EXPECT(scope != UINT32_MAX);
+    t.tracker.End(cmd_list, scope);
+}
+
+static void OtherDevicesAreIgnored(GroupCostTrackerTest& t)
+{
+    Mock::MockDevice otherDevice(device_api::d3d12, &t.log);
+    Mock::MockCommandList otherList(&otherDevice, &t.log);
+
+    EXPECT(t.tracker.Begin(&otherList, &t.groupA, SCOPE_GROUP) == UINT32_MAX);
+}
+
+int main()
+{
+    const pair<const char*, function<void(GroupCostTrackerTest&)>> tests[] = {
+        { "AttributesScopesToGroupsAndTechniques", AttributesScopesToGroupsAndTechniques },
+        { "CommandListsRecordIntoSeparateChunks", CommandListsRecordIntoSeparateChunks },
+        { "FullChunkDropsFurtherScopes", FullChunkDropsFurtherScopes },
+        { "FailedResolveCountsAsDroppedFrame", FailedResolveCountsAsDroppedFrame },
+        { "ReloadDiscardsFramesInFlight", ReloadDiscardsFramesInFlight },
+        { "DisablingTimingStopsRecording", DisablingTimingStopsRecording },
+        { "OtherDevicesAreIgnored", OtherDevicesAreIgnored },
+    };
+
+    for (const auto& [name, test] : tests)
+    {
+        const uint32_t failures = g_failures;
+        {
+            GroupCostTrackerTest fixture;
+            test(fixture);
+        }
+        cout << (g_failures == failures ? "[PASS] " : "[FAIL] ") << name << endl;
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Tests for the copy and alpha pipelines of Rendering::RenderingShaderManager on Vulkan, where they are created per render
+// target format. The SPIR-V shaders are stand-in blobs registered as embedded resources, the mock device keeps what every
+// pipeline was created from.
+//
+/////////////////////////////////////////////////////////////////////////
+#include <reshade.hpp>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "mock/MockDevice.h"
+#include "AddonUIData.h"
+#include "RenderingShaderManager.h"
+#include "ResourceManager.h"
+#include "ShaderManager.h"
+#include "StateTracking.h"
+#include "resource.h"
+
+using namespace reshade::api;
+using namespace AddonImGui;
+using namespace Rendering;
+using namespace std;
+
+static uint32_t g_failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { cerr << __FILE__ << ":" << __LINE__ << ": expected " << #condition << endl; g_failures++; } } while (0)
+
+static const char FullscreenVs[] = "fullscreen_vs_spirv";
+static const char PreviewCopyPs[] = "preview_copy_ps_spirv";
+static const char AlphaExtractPs[] = "alpha_extract_ps_spirv";
+static const char AlphaRestorePs[] = "alpha_restore_ps_spirv";
+
+static constexpr resource Target = { 0x100 };
+static constexpr resource Mask = { 0x200 };
+static constexpr resource_view TargetRtv = { 0x101 };
+static constexpr resource_view TargetSrv = { 0x102 };
+static constexpr resource_view MaskRtv = { 0x201 };
+static constexpr resource_view MaskSrv = { 0x202 };
+static constexpr resource_view OtherRtv = { 0x301 };
+
+struct RenderingShaderManagerTest
+{
+    Mock::CallLog log;
+    Mock::MockDevice device;
+    Mock::MockCommandList cmd_list;
+    ShaderToggler::ShaderManager pixelShaderManager;
+    ShaderToggler::ShaderManager vertexShaderManager;
+    ShaderToggler::ShaderManager computeShaderManager;
+    atomic_uint32_t activeCollectorFrameCounter = 0;
+    AddonUIData uiData;
+    ResourceManager resourceManager;
+    RenderingShaderManager shaderManager;
+
+    RenderingShaderManagerTest() : device(device_api::vulkan, &log), cmd_list(&device, &log),
+        uiData(&pixelShaderManager, &vertexShaderManager, &computeShaderManager, nullptr, &activeCollectorFrameCounter), shaderManager(uiData, resourceManager)
+    {
+        stub::register_resource(SHADER_FULLSCREEN_VS_SPIRV, FullscreenVs, sizeof(FullscreenVs));
+        stub::register_resource(SHADER_PREVIEW_COPY_PS_SPIRV, PreviewCopyPs, sizeof(PreviewCopyPs));
+        stub::register_resource(SHADER_ALPHA_EXTRACT_PS_SPIRV, AlphaExtractPs, sizeof(AlphaExtractPs));
+        stub::register_resource(SHADER_ALPHA_RESTORE_PS_SPIRV, AlphaRestorePs, sizeof(AlphaRestorePs));
+
+        device.AddResource(Target, resource_desc(1920, 1080, 1, 1, reshade::api::format::r8g8b8a8_typeless, 1, memory_heap::gpu_only, resource_usage::render_target | resource_usage::shader_resource));
+        device.AddResource(Mask, resource_desc(1920, 1080, 1, 1, reshade::api::format::r8_unorm, 1, memory_heap::gpu_only, resource_usage::render_target | resource_usage::shader_resource));
+        device.AddResourceView(TargetRtv, Target, resource_view_desc(reshade::api::format::r8g8b8a8_unorm));
+        device.AddResourceView(TargetSrv, Target, resource_view_desc(reshade::api::format::r8g8b8a8_unorm));
+        device.AddResourceView(MaskRtv, Mask, resource_view_desc(reshade::api::format::r8_unorm));
+        device.AddResourceView(MaskSrv, Mask, resource_view_desc(reshade::api::format::r8_unorm));
+
+        cmd_list.create_private_data<state_tracking>();
+    }
+
+    ~RenderingShaderManagerTest()
+    {
+        cmd_list.destroy_private_data<state_tracking>();
+    }
+
+    // Live pipelines grouped by the render target format they were created for
+    map<reshade::api::format, vector<Mock::MockPipeline>> PipelinesByFormat() const
+    {
+        map<reshade::api::format, vector<Mock::MockPipeline>> pipelines;
+        for (const auto& [_, pipeline] : device.GetLivePipelines())
+        {
+            pipelines[pipeline.renderTargetFormats.empty() ? reshade::api::format::unknown : pipeline.renderTargetFormats[0]].push_back(pipeline);
+        }
+
+        return pipelines;
+    }
+};
+
+static size_t CountPipelines(const vector<Mock::MockPipeline>& pipelines, const char* ps, uint8_t writeMask, bool blend)
+{
+    return count_if(pipelines.begin(), pipelines.end(), [&](const Mock::MockPipeline& pipeline) {
+        return pipeline.ps.code == ps && pipeline.hasBlendState && pipeline.blend.render_target_write_mask[0] == writeMask && pipeline.blend.blend_enable[0] == blend;
+        });
+}
+
+// Checks the subobjects of the pipelines created for one render target format
+static void ExpectPipelineSet(const Mock::MockDevice& device, const vector<Mock::MockPipeline>& pipelines, reshade::api::format rt_format)
+{
+    EXPECT(pipelines.size() == 4);
+
+    for (const Mock::MockPipeline& pipeline : pipelines)
+    {
+        EXPECT(pipeline.vs.code == FullscreenVs && pipeline.vs.code_size == sizeof(FullscreenVs));
+        EXPECT(pipeline.ps.code_size > 0);
+        EXPECT(pipeline.renderTargetFormats.size() == 1 && pipeline.renderTargetFormats[0] == rt_format);
+
+        // A sampler and the source texture, both pushed
+        const vector<pipeline_layout_param>* params = device.GetPipelineLayoutParams(pipeline.layout);
+        EXPECT(params != nullptr && params->size() == 2);
+        if (params != nullptr && params->size() == 2)
+        {
+            EXPECT((*params)[0].type == pipeline_layout_param_type::push_descriptors && (*params)[0].push_descriptors.type == descriptor_type::sampler);
+            EXPECT((*params)[1].type == pipeline_layout_param_type::push_descriptors && (*params)[1].push_descriptors.type == descriptor_type::shader_resource_view);
+        }
+    }
+
+    EXPECT(CountPipelines(pipelines, PreviewCopyPs, 0xF, true) == 1);
+    EXPECT(CountPipelines(pipelines, PreviewCopyPs, 0x7, true) == 1);
+    EXPECT(CountPipelines(pipelines, AlphaExtractPs, 0xF, true) == 1);
+    EXPECT(CountPipelines(pipelines, AlphaRestorePs, 0x8, false) == 1);
+}
+
+static void CreatesPipelinesPerFormatOnFirstUse(RenderingShaderManagerTest& t)
+{
+    t.shaderManager.InitShaders(&t.device);
+    EXPECT(t.device.GetLivePipelines().empty());
+    EXPECT(t.shaderManager.IsCopyAvailable());
+
+    EXPECT(t.shaderManager.IsAlphaMaskAvailable(&t.device, TargetRtv, MaskRtv));
+
+    const auto pipelines = t.PipelinesByFormat();
+    EXPECT(pipelines.size() == 2);
+    ExpectPipelineSet(t.device, pipelines.at(reshade::api::format::r8g8b8a8_unorm), reshade::api::format::r8g8b8a8_unorm);
+    ExpectPipelineSet(t.device, pipelines.at(reshade::api::format::r8_unorm), reshade::api::format::r8_unorm);
+
+    // Every pipeline shares the one layout
+    EXPECT(pipelines.at(reshade::api::format::r8g8b8a8_unorm)[0].layout == pipelines.at(reshade::api::format::r8_unorm)[0].layout);
+
+    t.shaderManager.DestroyShaders(&t.device);
+}
+
+static void ReusesPipelinesForViewsOfTheSameFormat(RenderingShaderManagerTest& t)
+{
+    t.shaderManager.InitShaders(&t.device);
+
+    t.shaderManager.CopyResource(&t.cmd_list, MaskSrv, TargetRtv, 1920, 1080);
+    EXPECT(t.device.GetLivePipelines().size() == 4);
+
+    t.device.AddResourceView(OtherRtv, Target, resource_view_desc(reshade::api::format::r8g8b8a8_unorm));
+    t.shaderManager.CopyResourceMaskAlpha(&t.cmd_list, MaskSrv, OtherRtv, 1920, 1080);
+    t.shaderManager.ExtractAlpha(&t.cmd_list, TargetSrv, MaskRtv, 1920, 1080);
+    t.shaderManager.RestoreAlpha(&t.cmd_list, MaskSrv, TargetRtv, 1920, 1080);
+    EXPECT(t.device.GetLivePipelines().size() == 8);
+    EXPECT(t.log.Count("draw") == 4);
+
+    t.shaderManager.DestroyShaders(&t.device);
+}
+
+static void DestroyedViewDropsCachedPipelines(RenderingShaderManagerTest& t)
+{
+    t.shaderManager.InitShaders(&t.device);
+
+    t.device.AddResourceView(OtherRtv, Target, resource_view_desc(reshade::api::format::r8g8b8a8_unorm));
+    t.shaderManager.CopyResource(&t.cmd_list, TargetSrv, OtherRtv, 1920, 1080);
+    EXPECT(t.PipelinesByFormat().size() == 1);
+
+    // The handle comes back for a view of another format, which needs its own pipelines
+    t.shaderManager.OnDestroyResourceView(OtherRtv);
+    t.device.RemoveResourceView(OtherRtv);
+    t.device.AddResourceView(OtherRtv, Target, resource_view_desc(reshade::api::format::r16g16b16a16_float));
+    t.shaderManager.CopyResource(&t.cmd_list, TargetSrv, OtherRtv, 1920, 1080);
+
+    const auto pipelines = t.PipelinesByFormat();
+    EXPECT(pipelines.size() == 2);
+    EXPECT(pipelines.contains(reshade::api::format::r16g16b16a16_float));
+    if (pipelines.contains(reshade::api::format::r16g16b16a16_float))
+    {
+        ExpectPipelineSet(t.device, pipelines.at(reshade::api::format::r16g16b16a16_float), reshade::api::format::r16g16b16a16_float);
+    }
+
+    t.shaderManager.DestroyShaders(&t.device);
+}
+
+static void DestroyShadersReleasesEverything(RenderingShaderManagerTest& t)
+{
+    t.shaderManager.InitShaders(&t.device);
+    EXPECT(t.shaderManager.IsAlphaMaskAvailable(&t.device, TargetRtv, MaskRtv));
+    EXPECT(t.device.GetLivePipelines().size() == 8);
+
+    const pipeline_layout layout = t.device.GetLivePipelines().begin()->second.layout;
+
+    t.shaderManager.DestroyShaders(&t.device);
+    EXPECT(t.device.GetLivePipelines().empty());
+    EXPECT(t.device.GetPipelineLayoutParams(layout) == nullptr);
+    EXPECT(t.device.GetInvalidDestroyCount() == 0);
+    EXPECT(!t.shaderManager.IsCopyAvailable());
+
+    // Nothing cached per view survives, a new device gets new pipelines
+    t.shaderManager.InitShaders(&t.device);
+    t.shaderManager.CopyResource(&t.cmd_list, MaskSrv, TargetRtv, 1920, 1080);
+    EXPECT(t.device.GetLivePipelines().size() == 4);
+    for (const auto& [_, pipeline] : t.device.GetLivePipelines())
+    {
+        EXPECT(pipeline.layout != layout);
+    }
+
+    t.shaderManager.DestroyShaders(&t.device);
+    EXPECT(t.device.GetLivePipelines().empty());
+    EXPECT(t.device.GetInvalidDestroyCount() == 0);
+}
+
+int main()
+{
+    const pair<const char*, function<void(RenderingShaderManagerTest&)>> tests[] = {
+        { "CreatesPipelinesPerFormatOnFirstUse", CreatesPipelinesPerFormatOnFirstUse },
+        { "ReusesPipelinesForViewsOfTheSameFormat", ReusesPipelinesForViewsOfTheSameFormat },
+        { "DestroyedViewDropsCachedPipelines", DestroyedViewDropsCachedPipelines },
+        { "DestroyShadersReleasesEverything", DestroyShadersReleasesEverything },
+    };
+
+    for (const auto& [name, test] : tests)
+    {
+        const uint32_t failures = g_failures;
+        {
+            RenderingShaderManagerTest fixture;
+            test(fixture);
+        }
+        cout << (g_failures == failures ? "[PASS] " : "[FAIL] ") << name << endl;
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}